@@ -63,6 +63,7 @@ using namespace nlohmann;
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/Time.hpp"
 #include "libslic3r/Thread.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 #include "libslic3r/FlushVolCalc.hpp"
 
@@ -150,6 +151,8 @@ typedef struct  _sliced_plate_info{
     size_t sliced_time_with_cache {0};
     size_t triangle_count{0};
     std::string warning_message;
+    // Memory estimates of the plate if requested by --memory-stats or --memory-budget.
+    json memory_stats;
 }sliced_plate_info_t;
 
 typedef struct _sliced_info {
@@ -420,6 +423,8 @@ void record_exit_reson(std::string outputdir, int code, int plate_id, std::strin
             plate_json["sliced_time_with_cache"] = sliced_info.sliced_plates[index].sliced_time_with_cache;
             plate_json["triangle_count"] = sliced_info.sliced_plates[index].triangle_count;
             plate_json["warning_message"] = sliced_info.sliced_plates[index].warning_message;
+            if (! sliced_info.sliced_plates[index].memory_stats.is_null())
+                plate_json["memory"] = sliced_info.sliced_plates[index].memory_stats;
             j["sliced_plates"].push_back(plate_json);
         }
         for (auto& iter: key_values)
@@ -436,6 +441,41 @@ void record_exit_reson(std::string outputdir, int code, int plate_id, std::strin
 #endif
 }
 
+// Memory estimates in bytes of the objects of a plate sampled after their steps, see MemoryStats.hpp.
+// The G-code processor result is sampled once, after the G-code export.
+static json memory_stats_json(const Print &print, const GCodeProcessorResult *gcode_result)
+{
+    auto usage_json = [](const MemoryUsage &usage) {
+        json j;
+        for (size_t i = 0; i < size_t(MemoryCategory::Count); ++ i)
+            if (MemoryCategory(i) != MemoryCategory::GCodeProcessorResult)
+                j[memory_category_name(MemoryCategory(i))] = usage.bytes[i];
+        j["total"] = usage.total();
+        return j;
+    };
+    json j;
+    j["peak"]   = print.memory_peak();
+    j["budget"] = print.memory_budget();
+    if (gcode_result != nullptr)
+        j[memory_category_name(MemoryCategory::GCodeProcessorResult)] = memory_used(*gcode_result);
+    j["objects"] = json::array();
+    for (const PrintObject *object : print.objects()) {
+        const ObjectMemoryStats &stats = object->memory_stats();
+        json object_json;
+        object_json["name"]            = object->model_object()->name;
+        object_json["peak"]            = usage_json(stats.peak);
+        object_json["released_caches"] = stats.released_caches;
+        object_json["steps"]           = json::array();
+        for (const auto &[step_name, usage] : stats.steps) {
+            json step_json = usage_json(usage);
+            step_json["step"] = step_name;
+            object_json["steps"].push_back(std::move(step_json));
+        }
+        j["objects"].push_back(std::move(object_json));
+    }
+    return j;
+}
+
 static int decode_png_to_thumbnail(std::string png_file, ThumbnailData& thumbnail_data)
 {
     if (!boost::filesystem::exists(png_file))
@@ -1023,6 +1063,16 @@ int CLI::run(int argc, char **argv)
     global_begin_time = (long long)Slic3r::Utils::get_current_time_utc();
     BOOST_LOG_TRIVIAL(warning) << boost::format("cli mode, Current OrcaSlicer Version %1%")%SLIC3R_VERSION;
 
+    // The trace is written on any return from the CLI, including the error paths.
+    Slic3r::ScopeGuard trace_guard;
+    if (const ConfigOptionString *opt_trace = m_config.opt<ConfigOptionString>("trace"); opt_trace != nullptr && ! opt_trace->value.empty()) {
+        Trace::set_enabled(true);
+        trace_guard = Slic3r::ScopeGuard([trace_file = opt_trace->value]() {
+            if (Trace::export_chrome_trace(trace_file))
+                BOOST_LOG_TRIVIAL(warning) << "Trace of " << Trace::num_events() << " events written to " << trace_file;
+        });
+    }
+
     //BBS: add plate data related logic
     PlateDataPtrs plate_data_src;
     int arrange_option;
@@ -3128,21 +3178,32 @@ int CLI::run(int argc, char **argv)
     BOOST_LOG_TRIVIAL(info) << "finished model pre-process commands\n";
     bool oriented_or_arranged = false;
     //BBS: add orient and arrange logic here
-    for (auto& model : m_models)
     {
-        for (ModelObject* o : model.objects)
+        ModelObjectPtrs objects_to_orient;
+        for (auto& model : m_models)
         {
-            if (orients_requirement[o->id().id])
-            {
-                BOOST_LOG_TRIVIAL(info) << "Before process command, Orient object, name=" << o->name <<",id="<<o->id().id<<std::endl;
-                orientation::orient(o);
-                oriented_or_arranged = true;
-            }
-            else
+            for (ModelObject* o : model.objects)
             {
-                BOOST_LOG_TRIVIAL(info) << "Before process command, no need to orient, object id :" << o->id().id<<std::endl;
+                if (orients_requirement[o->id().id])
+                {
+                    BOOST_LOG_TRIVIAL(info) << "Before process command, Orient object, name=" << o->name <<",id="<<o->id().id<<std::endl;
+                    objects_to_orient.emplace_back(o);
+                }
+                else
+                {
+                    BOOST_LOG_TRIVIAL(info) << "Before process command, no need to orient, object id :" << o->id().id<<std::endl;
+                }
             }
         }
+        if (!objects_to_orient.empty())
+        {
+            orientation::OrientParams orient_params;
+            orient_params.parallel = true;
+            if (const ConfigOptionFloat* opt = m_config.option<ConfigOptionFloat>("orient_time_limit"))
+                orient_params.max_time_per_object = float(opt->value);
+            orientation::orient(objects_to_orient, orient_params);
+            oriented_or_arranged = true;
+        }
     }
     //BBS: clear the orient objects lists
     orients_requirement.clear();
@@ -4332,6 +4393,16 @@ int CLI::run(int argc, char **argv)
                                     BOOST_LOG_TRIVIAL(info) << boost::format("new_printer_name: %1%, current_printer_system_name %2%, is_bbl_vendor_preset %3%")%new_printer_name %current_printer_system_name %is_bbl_vendor_preset;
                                 }
                                 (dynamic_cast<Print*>(print))->is_BBL_printer() = is_bbl_vendor_preset;
+                                if (print_fff != nullptr) {
+                                    const int memory_budget = m_config.opt_int("memory_budget");
+                                    print_fff->set_memory_accounting(m_config.opt_bool("memory_stats"), size_t(std::max(memory_budget, 0)) << 20);
+                                    // Nothing previews the moves from the command line, keep the print statistics only.
+                                    // The slicing data exported after the G-code need the extrusions, which the streaming export releases.
+                                    if (m_config.opt_bool("streaming_gcode_export") && export_slicedata)
+                                        BOOST_LOG_TRIVIAL(warning) << "--streaming-gcode-export is ignored, as --export-slicedata needs the extrusions of all the layers.";
+                                    print_fff->set_streaming_gcode_export(m_config.opt_bool("streaming_gcode_export") && ! export_slicedata, false);
+                                    print_fff->set_export_gcode_index(m_config.opt_bool("gcode_index"));
+                                }
 
                                 //update information for brim
                                 const PrintConfig& print_config = print_fff->config();
@@ -4413,6 +4484,8 @@ int CLI::run(int argc, char **argv)
                                     BOOST_LOG_TRIVIAL(info) << "process finished, will export gcode temporily to " << outfile << std::endl;
                                     temp_time = (long long)Slic3r::Utils::get_current_time_utc();
                                     outfile = print_fff->export_gcode(outfile, gcode_result, nullptr);
+                                    if (print_fff->memory_accounting())
+                                        sliced_plate_info.memory_stats = memory_stats_json(*print_fff, gcode_result);
                                     time_using_cache = time_using_cache + ((long long)Slic3r::Utils::get_current_time_utc() - temp_time);
                                     BOOST_LOG_TRIVIAL(info) << "export_gcode finished: time_using_cache update to " << time_using_cache << " secs.";
 
@@ -591,6 +591,7 @@ void SkeletalTrapezoidation::constructFromPolygons(const Polygons& polys)
     vd_node_to_he_node.clear();
 
     std::vector<Segment> segments;
+    segments.reserve(count_points(polys));
     for (size_t poly_idx = 0; poly_idx < polys.size(); poly_idx++)
         for (size_t point_idx = 0; point_idx < polys[poly_idx].size(); point_idx++)
             segments.emplace_back(&polys, poly_idx, point_idx);
@@ -646,6 +647,9 @@ void SkeletalTrapezoidation::constructFromPolygons(const Polygons& polys)
 
 process_voronoi_diagram:
     assert(this->graph.edges.empty() && this->graph.nodes.empty() && this->vd_edge_to_he_edge.empty() && this->vd_node_to_he_node.empty());
+    // Size the lookup tables once instead of rehashing them while the graph grows.
+    this->vd_edge_to_he_edge.reserve(voronoi_diagram.num_edges());
+    this->vd_node_to_he_node.reserve(voronoi_diagram.num_vertices());
     for (vd_t::cell_type cell : voronoi_diagram.cells()) {
         if (!cell.incident_edge())
             continue; // There is no spoon
@@ -17,6 +17,7 @@
 #include "Utils.hpp"
 
 #include <boost/log/trivial.hpp>
+#include <tbb/parallel_for.h>
 
 //#define ARACHNE_STITCH_PATCH_DEBUG
 
@@ -522,17 +523,39 @@ const std::vector<VariableWidthLines> &WallToolPaths::generate()
         );
     const coord_t transition_filter_dist   = scaled<coord_t>(100.f);
     const coord_t allowed_filter_deviation = wall_transition_filter_deviation;
-    SkeletalTrapezoidation wall_maker
-    (
-        prepared_outline,
-        *beading_strat,
-        beading_strat->getTransitioningAngle(),
-        discretization_step_size,
-        transition_filter_dist,
-        allowed_filter_deviation,
-        wall_transition_length
-    );
-    wall_maker.generateToolpaths(toolpaths);
+    auto generate_walls = [&](const Polygons &polys, std::vector<VariableWidthLines> &out) {
+        SkeletalTrapezoidation wall_maker
+        (
+            polys,
+            *beading_strat,
+            beading_strat->getTransitioningAngle(),
+            discretization_step_size,
+            transition_filter_dist,
+            allowed_filter_deviation,
+            wall_transition_length
+        );
+        wall_maker.generateToolpaths(out);
+    };
+
+    // The skeleton of an island only depends on the boundary of that island, thus disjoint islands of a large outline
+    // get their own graphs, which are built in parallel. Small outlines are not worth splitting.
+    ExPolygons islands;
+    if (count_points(prepared_outline) >= parallel_islands_min_points)
+        islands = union_ex(prepared_outline);
+    if (islands.size() > 1) {
+        std::vector<std::vector<VariableWidthLines>> island_toolpaths(islands.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, islands.size(), 1), [&islands, &island_toolpaths, &generate_walls](const tbb::blocked_range<size_t> &range) {
+            for (size_t island_idx = range.begin(); island_idx < range.end(); ++ island_idx)
+                generate_walls(to_polygons(std::move(islands[island_idx])), island_toolpaths[island_idx]);
+        });
+        for (std::vector<VariableWidthLines> &paths : island_toolpaths) {
+            if (toolpaths.size() < paths.size())
+                toolpaths.resize(paths.size());
+            for (size_t inset_idx = 0; inset_idx < paths.size(); ++ inset_idx)
+                append(toolpaths[inset_idx], std::move(paths[inset_idx]));
+        }
+    } else
+        generate_walls(prepared_outline, toolpaths);
 
     stitchToolPaths(toolpaths, this->bead_width_x);
 
@@ -19,6 +19,8 @@ constexpr bool    fill_outline_gaps                        = true;
 constexpr coord_t meshfix_maximum_resolution               = scaled<coord_t>(0.5);
 constexpr coord_t meshfix_maximum_deviation                = scaled<coord_t>(0.025);
 constexpr coord_t meshfix_maximum_extrusion_area_deviation = scaled<coord_t>(2.);
+// Outlines with at least this many points are split into islands, which are processed in parallel.
+constexpr size_t  parallel_islands_min_points              = 2000;
 
 class WallToolPathsParams
 {
@@ -8,6 +8,8 @@
 #include <list>
 #include <cassert>
 
+#include <oneapi/tbb/scalable_allocator.h>
+
 
 
 #include "HalfEdge.hpp"
@@ -21,8 +23,12 @@ class HalfEdgeGraph
 public:
     using edge_t = derived_edge_t;
     using node_t = derived_node_t;
-    std::list<edge_t> edges;
-    std::list<node_t> nodes;
+    // Graphs of hundreds of thousands of nodes are built and torn down for every island of every layer.
+    // The TBB allocator keeps the released list nodes in per thread caches, so they are recycled
+    // by the graph of the next island processed by the same worker instead of going back to the system heap.
+    template<class T> using list_t = std::list<T, tbb::scalable_allocator<T>>;
+    list_t<edge_t> edges;
+    list_t<node_t> nodes;
 };
 
 } // namespace Slic3r::Arachne
@@ -5,6 +5,7 @@
 ///|/
 #include "clipper/clipper_z.hpp"
 
+#include "AABBTreeIndirect.hpp"
 #include "ClipperUtils.hpp"
 #include "EdgeGrid.hpp"
 #include "Layer.hpp"
@@ -853,6 +854,233 @@ static ExPolygons make_brim_ears(ExPolygons& obj_expoly, coord_t size_ear, coord
 }
 
 //BBS: create all brims
+using AABBTreeBBoxes = AABBTreeIndirect::Tree<2, coord_t>;
+
+static AABBTreeBBoxes build_aabb_tree_over_expolygons(const ExPolygons &expolygons)
+{
+    std::vector<AABBTreeIndirect::BoundingBoxWrapper> bboxes;
+    bboxes.reserve(expolygons.size());
+    for (size_t i = 0; i < expolygons.size(); ++ i)
+        bboxes.emplace_back(i, get_extents(expolygons[i].contour));
+    AABBTreeBBoxes out;
+    out.build_modify_input(bboxes);
+    return out;
+}
+
+// Indices of expolygons indexed by aabb_tree, whose bounding boxes overlap bbox, in their original order.
+static std::vector<size_t> expolygons_overlapping(const AABBTreeBBoxes &aabb_tree, const BoundingBox &bbox)
+{
+    std::vector<size_t> out;
+    AABBTreeIndirect::traverse(aabb_tree,
+        AABBTreeIndirect::intersecting(AABBTreeBBoxes::BoundingBox(bbox.min, bbox.max)),
+        [&out](const AABBTreeBBoxes::Node &node) {
+            out.emplace_back(node.idx);
+            return true;
+        });
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static ExPolygons expolygons_overlapping(const ExPolygons &expolygons, const AABBTreeBBoxes &aabb_tree, const BoundingBox &bbox)
+{
+    ExPolygons out;
+    for (size_t idx : expolygons_overlapping(aabb_tree, bbox))
+        out.emplace_back(expolygons[idx]);
+    return out;
+}
+
+// Brim areas accumulated over the plate together with their bounding boxes, so that a new brim is clipped
+// only by the brims placed in its neighbourhood.
+struct PlacedBrimAreas {
+    ExPolygons               expolygons;
+    std::vector<BoundingBox> bboxes;
+
+    void append(const ExPolygons &src) {
+        for (const ExPolygon &expoly : src) {
+            this->expolygons.emplace_back(expoly);
+            this->bboxes.emplace_back(get_extents(expoly.contour));
+        }
+    }
+    ExPolygons overlapping(const BoundingBox &bbox) const {
+        ExPolygons out;
+        for (size_t i = 0; i < this->expolygons.size(); ++ i)
+            if (this->bboxes[i].overlap(bbox))
+                out.emplace_back(this->expolygons[i]);
+        return out;
+    }
+};
+
+static void append_and_translate(const PlacedBrimAreas &placed, const ExPolygons &src, const PrintInstance &instance, std::map<ObjectID, ExPolygons> &brimAreaMap)
+{
+    ExPolygons srcShifted = src;
+    Point instance_shift = instance.shift_without_plate_offset();
+    for (size_t src_idx = 0; src_idx < srcShifted.size(); ++src_idx)
+        srcShifted[src_idx].translate(instance_shift);
+    srcShifted = diff_ex(srcShifted, placed.overlapping(get_extents(srcShifted)));
+    expolygons_append(brimAreaMap[instance.print_object->id()], std::move(srcShifted));
+}
+
+// Brim and no brim areas of a single object or of its support, before being placed by the object instances.
+struct ObjectBrimAreas {
+    ExPolygons brim_area;
+    ExPolygons no_brim_area;
+    Polygons   holes;
+    ExPolygons islands;
+};
+
+// The brim areas of an object only depend on the object itself, they are calculated for all the objects in parallel.
+static void object_brim_areas(const Print &print, const PrintObject *object, const float no_brim_offset, ObjectBrimAreas &out_object, ObjectBrimAreas &out_support)
+{
+    Flow flow = print.brim_flow();
+    const BrimType     brim_type = object->config().brim_type.value;
+    float              brim_offset = scale_(object->config().brim_object_gap.value);
+    double             flowWidth = print.brim_flow().scaled_spacing() * SCALING_FACTOR;
+    float              brim_width = scale_(floor(object->config().brim_width.value / flowWidth / 2) * flowWidth * 2);
+    const float        scaled_flow_width = print.brim_flow().scaled_spacing();
+    const float        scaled_additional_brim_width = scale_(floor(5 / flowWidth / 2) * flowWidth * 2);
+    const float        scaled_half_min_adh_length = scale_(1.1);
+    bool               has_brim_auto = object->config().brim_type == btAutoBrim;
+    const bool         use_brim_ears = object->config().brim_type == btEar;
+    const bool         has_inner_brim = brim_type == btInnerOnly || brim_type == btOuterAndInner || use_brim_ears;
+    const bool         has_outer_brim = brim_type == btOuterOnly || brim_type == btOuterAndInner || brim_type == btAutoBrim || use_brim_ears;
+    coord_t            ear_detection_length = scale_(object->config().brim_ears_detection_length.value);
+    coordf_t           brim_ears_max_angle = object->config().brim_ears_max_angle.value;
+
+    ExPolygons        &brim_area_object = out_object.brim_area;
+    ExPolygons        &no_brim_area_object = out_object.no_brim_area;
+    Polygons          &holes_object = out_object.holes;
+    ExPolygons        &no_brim_area_support = out_support.no_brim_area;
+    Polygons          &holes_support = out_support.holes;
+    {
+        double             deltaT = getTemperatureFromExtruder(object);
+        double             adhension = getadhesionCoeff(object);
+        double             maxSpeed = Model::findMaxSpeed(object->model_object());
+        // BBS: brims are generated by volume groups
+        for (const auto& volumeGroup : object->firstLayerObjGroups()) {
+            // find volumePtrs included in this group
+            std::vector<ModelVolume*> groupVolumePtrs;
+            for (auto& volumeID : volumeGroup.volume_ids) {
+                ModelVolume* currentModelVolumePtr = nullptr;
+                //BBS: support shared object logic
+                const PrintObject* shared_object = object->get_shared_object();
+                if (!shared_object)
+                    shared_object = object;
+                for (auto volumePtr : shared_object->model_object()->volumes) {
+                    if (volumePtr->id() == volumeID) {
+                        currentModelVolumePtr = volumePtr;
+                        break;
+                    }
+                }
+                if (currentModelVolumePtr != nullptr) groupVolumePtrs.push_back(currentModelVolumePtr);
+            }
+            if (groupVolumePtrs.empty()) continue;
+            double groupHeight = 0.;
+            // config brim width in auto-brim mode
+            if (has_brim_auto) {
+                double brimWidthRaw = configBrimWidthByVolumeGroups(adhension, maxSpeed, groupVolumePtrs, volumeGroup.slices, groupHeight);
+                brim_width = scale_(floor(brimWidthRaw / flowWidth / 2) * flowWidth * 2);
+            }
+            for (const ExPolygon& ex_poly : volumeGroup.slices) {
+                // BBS: additional brim width will be added if part's adhension area is too small and brim is not generated
+                float brim_width_mod;
+                if (brim_width < scale_(5.) && has_brim_auto && groupHeight > 10.) {
+                    brim_width_mod = ex_poly.area() / ex_poly.contour.length() < scaled_half_min_adh_length
+                        && brim_width < scaled_flow_width ? brim_width + scaled_additional_brim_width : brim_width;
+                }
+                else {
+                    brim_width_mod = brim_width;
+                }
+                //BBS: brim width should be limited to the 1.5*boundingboxSize of a single polygon.
+                if (has_brim_auto) {
+                    BoundingBox bbox2 = ex_poly.contour.bounding_box();
+                    brim_width_mod = std::min(brim_width_mod, float(std::max(bbox2.size()(0), bbox2.size()(1))));
+                }
+                brim_width_mod = floor(brim_width_mod / scaled_flow_width / 2) * scaled_flow_width * 2;
+
+                Polygons ex_poly_holes_reversed = ex_poly.holes;
+                polygons_reverse(ex_poly_holes_reversed);
+
+                if (has_outer_brim) {
+                    // BBS: inner and outer boundary are offset from the same polygon incase of round off error.
+                    auto innerExpoly = offset_ex(ex_poly.contour, brim_offset, jtRound, SCALED_RESOLUTION);
+                    auto &clipExpoly = innerExpoly;
+
+                    if (use_brim_ears) {
+                        coord_t size_ear = (brim_width_mod - brim_offset - flow.scaled_spacing());
+                        append(brim_area_object, diff_ex(make_brim_ears(innerExpoly, size_ear, ear_detection_length, brim_ears_max_angle, true), clipExpoly));
+                    } else {
+                        // Normal brims
+                        append(brim_area_object, diff_ex(offset_ex(innerExpoly, brim_width_mod, jtRound, SCALED_RESOLUTION), clipExpoly));
+                    }
+                }
+                if (has_inner_brim) {
+                    auto outerExpoly = offset_ex(ex_poly_holes_reversed, -brim_offset);
+                    auto clipExpoly = offset_ex(ex_poly_holes_reversed, -brim_width - brim_offset);
+
+                    if (use_brim_ears) {
+                        coord_t size_ear = (brim_width - brim_offset - flow.scaled_spacing());
+                        append(brim_area_object, diff_ex(make_brim_ears(outerExpoly, size_ear, ear_detection_length, brim_ears_max_angle, false), clipExpoly));
+                    } else {
+                        // Normal brims
+                        append(brim_area_object, diff_ex(outerExpoly, clipExpoly));
+                    }
+                }
+                if (!has_inner_brim) {
+                    // BBS: brim should be apart from holes
+                    append(no_brim_area_object, diff_ex(ex_poly_holes_reversed, offset_ex(ex_poly_holes_reversed, -scale_(5.))));
+                }
+                if (!has_outer_brim)
+                    append(no_brim_area_object, diff_ex(offset(ex_poly.contour, no_brim_offset), ex_poly_holes_reversed));
+                if (!has_inner_brim && !has_outer_brim)
+                    append(no_brim_area_object, offset_ex(ex_poly_holes_reversed, -no_brim_offset));
+                append(holes_object, ex_poly_holes_reversed);
+            }
+        }
+        out_object.islands = offset_ex(object->layers().front()->lslices, brim_offset, jtRound, SCALED_RESOLUTION);
+        append(no_brim_area_object, out_object.islands);
+    }
+    {
+        if (!object->support_layers().empty() && object->support_layers().front()->support_type==stInnerNormal) {
+            for (const Polygon& support_contour : object->support_layers().front()->support_fills.polygons_covered_by_spacing()) {
+                // Brim will not be generated for supports
+                /*
+                if (has_outer_brim) {
+                    append(brim_area_support, diff_ex(offset_ex(support_contour, brim_width + brim_offset, jtRound, SCALED_RESOLUTION), offset_ex(support_contour, brim_offset)));
+                }
+                if (has_inner_brim || has_outer_brim)
+                    append(no_brim_area_support, offset_ex(support_contour, 0));
+                */
+                no_brim_area_support.emplace_back(support_contour);
+            }
+        }
+        // BBS
+        if (!object->support_layers().empty() && object->support_layers().front()->support_type == stInnerTree) {
+            for (const ExPolygon &ex_poly : object->support_layers().front()->lslices) {
+                // BBS: additional brim width will be added if adhension area is too small without brim
+                float brim_width_mod = ex_poly.area() / ex_poly.contour.length() < scaled_half_min_adh_length
+                    && brim_width < scaled_flow_width ? brim_width + scaled_additional_brim_width : brim_width;
+                brim_width_mod = floor(brim_width_mod / scaled_flow_width / 2) * scaled_flow_width * 2;
+                // Brim will not be generated for supports
+                /*
+                if (has_outer_brim) {
+                    append(brim_area_support, diff_ex(offset_ex(ex_poly.contour, brim_width_mod + brim_offset, jtRound, SCALED_RESOLUTION), offset_ex(ex_poly.contour, brim_offset)));
+                }
+                if (has_inner_brim)
+                    append(brim_area_support, diff_ex(offset_ex(ex_poly.holes, -brim_offset), offset_ex(ex_poly.holes, -brim_width - brim_offset)));
+                */
+                if (!has_outer_brim)
+                    append(no_brim_area_support, diff_ex(offset(ex_poly.contour, no_brim_offset), ex_poly.holes));
+                if (!has_inner_brim && !has_outer_brim)
+                    append(no_brim_area_support, offset_ex(ex_poly.holes, -no_brim_offset));
+                append(holes_support, ex_poly.holes);
+                if (has_inner_brim || has_outer_brim)
+                    append(no_brim_area_support, offset_ex(ex_poly.contour, 0));
+                no_brim_area_support.emplace_back(ex_poly.contour);
+            }
+        }
+    }
+}
+
 static ExPolygons outer_inner_brim_area(const Print& print,
     const float no_brim_offset, std::map<ObjectID, ExPolygons>& brimAreaMap,
     std::map<ObjectID, ExPolygons>& supportBrimAreaMap,
@@ -860,9 +1088,9 @@ static ExPolygons outer_inner_brim_area(const Print& print,
     std::vector<unsigned int>& printExtruders)
 {
     unsigned int support_material_extruder = printExtruders.front() + 1;
-    Flow flow = print.brim_flow();
 
-    ExPolygons brim_area;
+    // Brims placed so far, a brim of an object instance is clipped by the brims of the instances placed before it.
+    PlacedBrimAreas placed_brim_area;
     ExPolygons no_brim_area;
     Polygons   holes;
 
@@ -874,133 +1102,37 @@ static ExPolygons outer_inner_brim_area(const Print& print,
     for (const auto& objectWithExtruder : objPrintVec)
         brimToWrite.insert({ objectWithExtruder.first, {true,true} });
 
+    // Brim areas of the objects, independent of the placement of the other objects.
+    std::vector<ObjectBrimAreas> object_areas(objPrintVec.size());
+    std::vector<ObjectBrimAreas> support_areas(objPrintVec.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, objPrintVec.size(), 1),
+        [&print, &objPrintVec, no_brim_offset, &object_areas, &support_areas](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                object_brim_areas(print, print.get_object(objPrintVec[i].first), no_brim_offset, object_areas[i], support_areas[i]);
+        });
+
     ExPolygons objectIslands;
     auto bedPoly = Model::getBedPolygon();
     auto bedExPoly = diff_ex((offset(bedPoly, scale_(30.), jtRound, SCALED_RESOLUTION)), { bedPoly });
 
     for (unsigned int extruderNo : printExtruders) {
         ++extruderNo;
-        for (const auto& objectWithExtruder : objPrintVec) {
+        for (size_t object_idx = 0; object_idx < objPrintVec.size(); ++ object_idx) {
+            const auto&        objectWithExtruder = objPrintVec[object_idx];
             const PrintObject* object = print.get_object(objectWithExtruder.first);
-            const BrimType     brim_type = object->config().brim_type.value;
-            float              brim_offset = scale_(object->config().brim_object_gap.value);
-            double             flowWidth = print.brim_flow().scaled_spacing() * SCALING_FACTOR;
-            float              brim_width = scale_(floor(object->config().brim_width.value / flowWidth / 2) * flowWidth * 2);
-            const float        scaled_flow_width = print.brim_flow().scaled_spacing();
-            const float        scaled_additional_brim_width = scale_(floor(5 / flowWidth / 2) * flowWidth * 2);
-            const float        scaled_half_min_adh_length = scale_(1.1);
-            bool               has_brim_auto = object->config().brim_type == btAutoBrim;
-            const bool         use_brim_ears = object->config().brim_type == btEar;
-            const bool         has_inner_brim = brim_type == btInnerOnly || brim_type == btOuterAndInner || use_brim_ears;
-            const bool         has_outer_brim = brim_type == btOuterOnly || brim_type == btOuterAndInner || brim_type == btAutoBrim || use_brim_ears;
-            coord_t            ear_detection_length = scale_(object->config().brim_ears_detection_length.value);
-            coordf_t           brim_ears_max_angle = object->config().brim_ears_max_angle.value;
-
-            ExPolygons         brim_area_object;
-            ExPolygons         no_brim_area_object;
-            ExPolygons         brim_area_support;
-            ExPolygons         no_brim_area_support;
-            Polygons           holes_object;
-            Polygons           holes_support;
             if (objectWithExtruder.second == extruderNo && brimToWrite.at(object->id()).obj) {
-                double             deltaT = getTemperatureFromExtruder(object);
-                double             adhension = getadhesionCoeff(object);
-                double             maxSpeed = Model::findMaxSpeed(object->model_object());
-                // BBS: brims are generated by volume groups
-                for (const auto& volumeGroup : object->firstLayerObjGroups()) {
-                    // find volumePtrs included in this group
-                    std::vector<ModelVolume*> groupVolumePtrs;
-                    for (auto& volumeID : volumeGroup.volume_ids) {
-                        ModelVolume* currentModelVolumePtr = nullptr;
-                        //BBS: support shared object logic
-                        const PrintObject* shared_object = object->get_shared_object();
-                        if (!shared_object)
-                            shared_object = object;
-                        for (auto volumePtr : shared_object->model_object()->volumes) {
-                            if (volumePtr->id() == volumeID) {
-                                currentModelVolumePtr = volumePtr;
-                                break;
-                            }
-                        }
-                        if (currentModelVolumePtr != nullptr) groupVolumePtrs.push_back(currentModelVolumePtr);
-                    }
-                    if (groupVolumePtrs.empty()) continue;
-                    double groupHeight = 0.;
-                    // config brim width in auto-brim mode
-                    if (has_brim_auto) {
-                        double brimWidthRaw = configBrimWidthByVolumeGroups(adhension, maxSpeed, groupVolumePtrs, volumeGroup.slices, groupHeight);
-                        brim_width = scale_(floor(brimWidthRaw / flowWidth / 2) * flowWidth * 2);
-                    }
-                    for (const ExPolygon& ex_poly : volumeGroup.slices) {
-                        // BBS: additional brim width will be added if part's adhension area is too small and brim is not generated
-                        float brim_width_mod;
-                        if (brim_width < scale_(5.) && has_brim_auto && groupHeight > 10.) {
-                            brim_width_mod = ex_poly.area() / ex_poly.contour.length() < scaled_half_min_adh_length
-                                && brim_width < scaled_flow_width ? brim_width + scaled_additional_brim_width : brim_width;
-                        }
-                        else {
-                            brim_width_mod = brim_width;
-                        }
-                        //BBS: brim width should be limited to the 1.5*boundingboxSize of a single polygon.
-                        if (has_brim_auto) {
-                            BoundingBox bbox2 = ex_poly.contour.bounding_box();
-                            brim_width_mod = std::min(brim_width_mod, float(std::max(bbox2.size()(0), bbox2.size()(1))));
-                        }
-                        brim_width_mod = floor(brim_width_mod / scaled_flow_width / 2) * scaled_flow_width * 2;
-
-                        Polygons ex_poly_holes_reversed = ex_poly.holes;
-                        polygons_reverse(ex_poly_holes_reversed);
-
-                        if (has_outer_brim) {
-                            // BBS: inner and outer boundary are offset from the same polygon incase of round off error.
-                            auto innerExpoly = offset_ex(ex_poly.contour, brim_offset, jtRound, SCALED_RESOLUTION);
-                            auto &clipExpoly = innerExpoly;
-
-                            if (use_brim_ears) {
-                                coord_t size_ear = (brim_width_mod - brim_offset - flow.scaled_spacing());
-                                append(brim_area_object, diff_ex(make_brim_ears(innerExpoly, size_ear, ear_detection_length, brim_ears_max_angle, true), clipExpoly));
-                            } else {
-                                // Normal brims
-                                append(brim_area_object, diff_ex(offset_ex(innerExpoly, brim_width_mod, jtRound, SCALED_RESOLUTION), clipExpoly));
-                            }
-                        }
-                        if (has_inner_brim) {
-                            auto outerExpoly = offset_ex(ex_poly_holes_reversed, -brim_offset);
-                            auto clipExpoly = offset_ex(ex_poly_holes_reversed, -brim_width - brim_offset);
-
-                            if (use_brim_ears) {
-                                coord_t size_ear = (brim_width - brim_offset - flow.scaled_spacing());
-                                append(brim_area_object, diff_ex(make_brim_ears(outerExpoly, size_ear, ear_detection_length, brim_ears_max_angle, false), clipExpoly));
-                            } else {
-                                // Normal brims
-                                append(brim_area_object, diff_ex(outerExpoly, clipExpoly));
-                            }
-                        }
-                        if (!has_inner_brim) {
-                            // BBS: brim should be apart from holes
-                            append(no_brim_area_object, diff_ex(ex_poly_holes_reversed, offset_ex(ex_poly_holes_reversed, -scale_(5.))));
-                        }
-                        if (!has_outer_brim)
-                            append(no_brim_area_object, diff_ex(offset(ex_poly.contour, no_brim_offset), ex_poly_holes_reversed));
-                        if (!has_inner_brim && !has_outer_brim)
-                            append(no_brim_area_object, offset_ex(ex_poly_holes_reversed, -no_brim_offset));
-                        append(holes_object, ex_poly_holes_reversed);
-                    }
-                }
-                auto objectIsland = offset_ex(object->layers().front()->lslices, brim_offset, jtRound, SCALED_RESOLUTION);
-                append(no_brim_area_object, objectIsland);
-
+                const ObjectBrimAreas &areas = object_areas[object_idx];
                 brimToWrite.at(object->id()).obj = false;
                 for (const PrintInstance& instance : object->instances()) {
-                    if (!brim_area_object.empty())
-                        append_and_translate(brim_area, brim_area_object, instance, print, brimAreaMap);
-                    append_and_translate(no_brim_area, no_brim_area_object, instance);
-                    append_and_translate(holes, holes_object, instance);
-                    append_and_translate(objectIslands, objectIsland, instance);
+                    if (!areas.brim_area.empty())
+                        append_and_translate(placed_brim_area, areas.brim_area, instance, brimAreaMap);
+                    append_and_translate(no_brim_area, areas.no_brim_area, instance);
+                    append_and_translate(holes, areas.holes, instance);
+                    append_and_translate(objectIslands, areas.islands, instance);
 
                 }
                 if (brimAreaMap.find(object->id()) != brimAreaMap.end())
-                    expolygons_append(brim_area, brimAreaMap[object->id()]);
+                    placed_brim_area.append(brimAreaMap[object->id()]);
             }
             support_material_extruder = object->config().support_filament;
             if (support_material_extruder == 0 && object->has_support_material()) {
@@ -1010,101 +1142,99 @@ static ExPolygons outer_inner_brim_area(const Print& print,
                     support_material_extruder = printExtruders.front() + 1;
             }
             if (support_material_extruder == extruderNo && brimToWrite.at(object->id()).sup) {
-                if (!object->support_layers().empty() && object->support_layers().front()->support_type==stInnerNormal) {
-                    for (const Polygon& support_contour : object->support_layers().front()->support_fills.polygons_covered_by_spacing()) {
-                        // Brim will not be generated for supports
-                        /*
-                        if (has_outer_brim) {
-                            append(brim_area_support, diff_ex(offset_ex(support_contour, brim_width + brim_offset, jtRound, SCALED_RESOLUTION), offset_ex(support_contour, brim_offset)));
-                        }
-                        if (has_inner_brim || has_outer_brim)
-                            append(no_brim_area_support, offset_ex(support_contour, 0));
-                        */
-                        no_brim_area_support.emplace_back(support_contour);
-                    }
-                }
-                // BBS
-                if (!object->support_layers().empty() && object->support_layers().front()->support_type == stInnerTree) {
-                    for (const ExPolygon &ex_poly : object->support_layers().front()->lslices) {
-                        // BBS: additional brim width will be added if adhension area is too small without brim
-                        float brim_width_mod = ex_poly.area() / ex_poly.contour.length() < scaled_half_min_adh_length
-                            && brim_width < scaled_flow_width ? brim_width + scaled_additional_brim_width : brim_width;
-                        brim_width_mod = floor(brim_width_mod / scaled_flow_width / 2) * scaled_flow_width * 2;
-                        // Brim will not be generated for supports
-                        /*
-                        if (has_outer_brim) {
-                            append(brim_area_support, diff_ex(offset_ex(ex_poly.contour, brim_width_mod + brim_offset, jtRound, SCALED_RESOLUTION), offset_ex(ex_poly.contour, brim_offset)));
-                        }
-                        if (has_inner_brim)
-                            append(brim_area_support, diff_ex(offset_ex(ex_poly.holes, -brim_offset), offset_ex(ex_poly.holes, -brim_width - brim_offset)));
-                        */
-                        if (!has_outer_brim)
-                            append(no_brim_area_support, diff_ex(offset(ex_poly.contour, no_brim_offset), ex_poly.holes));
-                        if (!has_inner_brim && !has_outer_brim)
-                            append(no_brim_area_support, offset_ex(ex_poly.holes, -no_brim_offset));
-                        append(holes_support, ex_poly.holes);
-                        if (has_inner_brim || has_outer_brim)
-                            append(no_brim_area_support, offset_ex(ex_poly.contour, 0));
-                        no_brim_area_support.emplace_back(ex_poly.contour);
-                    }
-                }
+                const ObjectBrimAreas &areas = support_areas[object_idx];
                 brimToWrite.at(object->id()).sup = false;
                 for (const PrintInstance& instance : object->instances()) {
-                    if (!brim_area_support.empty())
-                        append_and_translate(brim_area, brim_area_support, instance, print, supportBrimAreaMap);
-                    append_and_translate(no_brim_area, no_brim_area_support, instance);
-                    append_and_translate(holes, holes_support, instance);
+                    if (!areas.brim_area.empty())
+                        append_and_translate(placed_brim_area, areas.brim_area, instance, supportBrimAreaMap);
+                    append_and_translate(no_brim_area, areas.no_brim_area, instance);
+                    append_and_translate(holes, areas.holes, instance);
                 }
                 if (supportBrimAreaMap.find(object->id()) != supportBrimAreaMap.end())
-                    expolygons_append(brim_area, supportBrimAreaMap[object->id()]);
+                    placed_brim_area.append(supportBrimAreaMap[object->id()]);
             }
         }
     }
     if (!bedExPoly.empty()){
         no_brim_area.push_back(bedExPoly.front());
     }
-    for (const PrintObject* object : print.objects()) {
-        if (brimAreaMap.find(object->id()) != brimAreaMap.end())
-        {
-            brimAreaMap[object->id()] = diff_ex(brimAreaMap[object->id()], no_brim_area);
+    {
+        // Clip each brim by the no brim areas in its neighbourhood only.
+        const AABBTreeBBoxes no_brim_area_tree = build_aabb_tree_over_expolygons(no_brim_area);
+        std::vector<ExPolygons*> brims;
+        for (const PrintObject* object : print.objects()) {
+            if (auto it = brimAreaMap.find(object->id()); it != brimAreaMap.end())
+                brims.emplace_back(&it->second);
+            if (auto it = supportBrimAreaMap.find(object->id()); it != supportBrimAreaMap.end())
+                brims.emplace_back(&it->second);
         }
-
-        if (supportBrimAreaMap.find(object->id()) != supportBrimAreaMap.end())
-            supportBrimAreaMap[object->id()] = diff_ex(supportBrimAreaMap[object->id()], no_brim_area);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, brims.size(), 1),
+            [&brims, &no_brim_area, &no_brim_area_tree](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    if (ExPolygons &brim = *brims[i]; ! brim.empty())
+                        brim = diff_ex(brim, expolygons_overlapping(no_brim_area, no_brim_area_tree, get_extents(brim)));
+            });
     }
 
-    brim_area.clear();
-    for (const PrintObject* object : print.objects()) {
-        // BBS: brim should be contacted to at least one object's island or brim area
-        if (brimAreaMap.find(object->id()) != brimAreaMap.end()) {
-            // find other objects' brim area
-            ExPolygons otherExPolys;
-            for (const PrintObject* otherObject : print.objects()) {
-                if ((otherObject->id() != object->id()) && (brimAreaMap.find(otherObject->id()) != brimAreaMap.end())) {
-                    expolygons_append(otherExPolys, brimAreaMap[otherObject->id()]);
-                }
-            }
-
-            auto tempArea = brimAreaMap[object->id()];
-            brimAreaMap[object->id()].clear();
-
-            for (int ia = 0; ia != tempArea.size(); ++ia) {
-                // find this object's other brim area
-                ExPolygons otherExPoly;
-                for (int iao = 0; iao != tempArea.size(); ++iao)
-                    if (iao != ia) otherExPoly.push_back(tempArea[iao]);
+    // BBS: brim should be contacted to at least one object's island or brim area
+    // All the brim pieces of all the objects, indexed by their bounding boxes.
+    std::vector<const PrintObject*> brim_objects;
+    ExPolygons                      pieces;
+    std::vector<size_t>             piece_object;
+    std::vector<size_t>             object_first_piece;
+    for (const PrintObject* object : print.objects())
+        if (auto it = brimAreaMap.find(object->id()); it != brimAreaMap.end()) {
+            object_first_piece.emplace_back(pieces.size());
+            piece_object.insert(piece_object.end(), it->second.size(), brim_objects.size());
+            append(pieces, it->second);
+            brim_objects.emplace_back(object);
+        }
+    object_first_piece.emplace_back(pieces.size());
+    std::vector<ExPolygons> offseted_pieces(pieces.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, pieces.size()),
+        [&print, &pieces, &offseted_pieces](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                offseted_pieces[i] = offset_ex(pieces[i], print.brim_flow().scaled_spacing() * 2, jtRound, SCALED_RESOLUTION);
+        });
+    const AABBTreeBBoxes islands_tree = build_aabb_tree_over_expolygons(objectIslands);
+    const AABBTreeBBoxes pieces_tree  = build_aabb_tree_over_expolygons(pieces);
+    // Pieces dropped from an object no longer support the brims of the objects processed after it.
+    std::vector<char> piece_dropped(pieces.size(), false);
 
-                auto offsetedTa = offset_ex(tempArea[ia], print.brim_flow().scaled_spacing() * 2, jtRound, SCALED_RESOLUTION);
-                if (!intersection_ex(offsetedTa, objectIslands).empty() ||
-                    !intersection_ex(offsetedTa, otherExPoly).empty() ||
-                    !intersection_ex(offsetedTa, otherExPolys).empty())
-                    brimAreaMap[object->id()].push_back(tempArea[ia]);
+    ExPolygons brim_area;
+    for (size_t object_idx = 0; object_idx < brim_objects.size(); ++ object_idx) {
+        ExPolygons &object_brim = brimAreaMap[brim_objects[object_idx]->id()];
+        object_brim.clear();
+        for (size_t ia = object_first_piece[object_idx]; ia < object_first_piece[object_idx + 1]; ++ ia) {
+            const ExPolygons &offsetedTa = offseted_pieces[ia];
+            bool              contacts   = false;
+            if (! offsetedTa.empty()) {
+                const BoundingBox bbox = get_extents(offsetedTa);
+                contacts = !intersection_ex(offsetedTa, expolygons_overlapping(objectIslands, islands_tree, bbox)).empty();
+                if (! contacts) {
+                    // this object's other brim area and other objects' brim area
+                    ExPolygons otherExPoly;
+                    ExPolygons otherExPolys;
+                    for (size_t iao : expolygons_overlapping(pieces_tree, bbox))
+                        if (piece_object[iao] == object_idx) {
+                            if (iao != ia)
+                                otherExPoly.emplace_back(pieces[iao]);
+                        } else if (! piece_dropped[iao])
+                            otherExPolys.emplace_back(pieces[iao]);
+                    contacts = !intersection_ex(offsetedTa, otherExPoly).empty() ||
+                               !intersection_ex(offsetedTa, otherExPolys).empty();
+                }
             }
-            expolygons_append(brim_area, brimAreaMap[object->id()]);
+            if (contacts)
+                object_brim.push_back(pieces[ia]);
+            else
+                piece_dropped[ia] = true;
         }
+        expolygons_append(brim_area, object_brim);
     }
     return brim_area;
 }
+
 // Flip orientation of open polylines to minimize travel distance.
 static void optimize_polylines_by_reversing(Polylines *polylines)
 {
@@ -1667,32 +1797,37 @@ void make_brim(const Print& print, PrintTryCancel try_cancel, Polygons& islands_
         float(flow.scaled_spacing()), brimAreaMap, supportBrimAreaMap, objPrintVec, printExtruders);
 
     // BBS: Find boundingbox of the first layer
-    for (const ObjectID printObjID : print.print_object_ids()) {
-        BoundingBox bbx;
-        PrintObject* object = const_cast<PrintObject*>(print.get_object(printObjID));
-        for (const ExPolygon& ex_poly : object->layers().front()->lslices)
-            for (const PrintInstance& instance : object->instances()) {
-                auto ex_poly_translated = ex_poly;
-                ex_poly_translated.translate(instance.shift_without_plate_offset());
-                bbx.merge(get_extents(ex_poly_translated.contour));
-            }
-        if (!object->support_layers().empty())
-        for (const Polygon& support_contour : object->support_layers().front()->support_fills.polygons_covered_by_spacing())
-            for (const PrintInstance& instance : object->instances()) {
-                auto ex_poly_translated = support_contour;
-                ex_poly_translated.translate(instance.shift_without_plate_offset());
-                bbx.merge(get_extents(ex_poly_translated));
+    const std::vector<ObjectID> print_object_ids = print.print_object_ids();
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, print_object_ids.size()),
+        [&print, &print_object_ids, &brimAreaMap, &supportBrimAreaMap](const tbb::blocked_range<size_t> &range) {
+            for (size_t object_idx = range.begin(); object_idx < range.end(); ++ object_idx) {
+                const ObjectID printObjID = print_object_ids[object_idx];
+                BoundingBox bbx;
+                PrintObject* object = const_cast<PrintObject*>(print.get_object(printObjID));
+                for (const ExPolygon& ex_poly : object->layers().front()->lslices)
+                    for (const PrintInstance& instance : object->instances()) {
+                        auto ex_poly_translated = ex_poly;
+                        ex_poly_translated.translate(instance.shift_without_plate_offset());
+                        bbx.merge(get_extents(ex_poly_translated.contour));
+                    }
+                if (!object->support_layers().empty())
+                for (const Polygon& support_contour : object->support_layers().front()->support_fills.polygons_covered_by_spacing())
+                    for (const PrintInstance& instance : object->instances()) {
+                        auto ex_poly_translated = support_contour;
+                        ex_poly_translated.translate(instance.shift_without_plate_offset());
+                        bbx.merge(get_extents(ex_poly_translated));
+                    }
+                if (supportBrimAreaMap.find(printObjID) != supportBrimAreaMap.end()) {
+                    for (const ExPolygon& ex_poly : supportBrimAreaMap.at(printObjID))
+                        bbx.merge(get_extents(ex_poly.contour));
+                }
+                if (brimAreaMap.find(printObjID) != brimAreaMap.end()) {
+                    for (const ExPolygon& ex_poly : brimAreaMap.at(printObjID))
+                        bbx.merge(get_extents(ex_poly.contour));
+                }
+                object->firstLayerObjectBrimBoundingBox = bbx;
             }
-        if (supportBrimAreaMap.find(printObjID) != supportBrimAreaMap.end()) {
-            for (const ExPolygon& ex_poly : supportBrimAreaMap.at(printObjID))
-                bbx.merge(get_extents(ex_poly.contour));
-        }
-        if (brimAreaMap.find(printObjID) != brimAreaMap.end()) {
-            for (const ExPolygon& ex_poly : brimAreaMap.at(printObjID))
-                bbx.merge(get_extents(ex_poly.contour));
-        }
-        object->firstLayerObjectBrimBoundingBox = bbx;
-    }
+        });
 
     islands_area = to_polygons(islands_area_ex);
 
@@ -1702,16 +1837,23 @@ void make_brim(const Print& print, PrintTryCancel try_cancel, Polygons& islands_
     for (size_t iia = 0; iia < islands_area.size(); ++iia)
         islands_area[iia].translate(plate_shift);
 
-    for (auto iter = brimAreaMap.begin(); iter != brimAreaMap.end(); ++iter) {
-        if (!iter->second.empty()) {
-            brimMap.insert(std::make_pair(iter->first, makeBrimInfill(iter->second, print, islands_area)));
-        };
-    }
-    for (auto iter = supportBrimAreaMap.begin(); iter != supportBrimAreaMap.end(); ++iter) {
-        if (!iter->second.empty()) {
-            supportBrimMap.insert(std::make_pair(iter->first, makeBrimInfill(iter->second, print, islands_area)));
-        };
-    }
+    // The brim extrusions of the objects are independent, generate them in parallel.
+    auto make_brim_infills = [&print, &islands_area](const std::map<ObjectID, ExPolygons> &areas, std::map<ObjectID, ExtrusionEntityCollection> &out) {
+        std::vector<std::pair<ObjectID, const ExPolygons*>> jobs;
+        for (auto iter = areas.begin(); iter != areas.end(); ++iter)
+            if (!iter->second.empty())
+                jobs.emplace_back(iter->first, &iter->second);
+        std::vector<ExtrusionEntityCollection> brims(jobs.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, jobs.size(), 1),
+            [&print, &islands_area, &jobs, &brims](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    brims[i] = makeBrimInfill(*jobs[i].second, print, islands_area);
+            });
+        for (size_t i = 0; i < jobs.size(); ++ i)
+            out.insert(std::make_pair(jobs[i].first, std::move(brims[i])));
+    };
+    make_brim_infills(brimAreaMap, brimMap);
+    make_brim_infills(supportBrimAreaMap, supportBrimMap);
 
     size_t          num_loops = size_t(floor(brim_width_max / flow.spacing()));
     BOOST_LOG_TRIVIAL(debug) << "brim_width_max, num_loops: " << brim_width_max << ", " << num_loops;
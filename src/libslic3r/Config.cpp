@@ -5,6 +5,9 @@
 #include "Preset.hpp"
 
 #include <assert.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -316,18 +319,130 @@ ConfigOption* ConfigOptionDef::create_default_option() const
     return this->create_empty_option();
 }
 
+// Open addressing hash table of the interned keys. The lookups are lock free: A table is never modified once it becomes full,
+// it is replaced by a larger one, while the smaller one is kept alive for the readers still accessing it.
+// The interned keys are never released, there are just a few thousands of them.
+namespace {
+struct InternedKey
+{
+    t_config_option_key key;
+    size_t              hash;
+    t_config_option_id  id;
+};
+
+struct InternedKeyTable
+{
+    explicit InternedKeyTable(size_t capacity) : mask(capacity - 1), slots(new std::atomic<const InternedKey*>[capacity]) {
+        assert((capacity & mask) == 0);
+        for (size_t i = 0; i < capacity; ++ i)
+            slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    const InternedKey* find(const t_config_option_key &key, size_t hash) const {
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const InternedKey *entry = slots[i].load(std::memory_order_acquire);
+            if (entry == nullptr)
+                return nullptr;
+            if (entry->hash == hash && entry->key == key)
+                return entry;
+        }
+    }
+
+    // Only called with ConfigOptionKeyRegistry::mutex locked.
+    void insert(const InternedKey *entry) {
+        size_t i = entry->hash & mask;
+        while (slots[i].load(std::memory_order_relaxed) != nullptr)
+            i = (i + 1) & mask;
+        slots[i].store(entry, std::memory_order_release);
+    }
+
+    size_t                                          mask;
+    std::unique_ptr<std::atomic<const InternedKey*>[]> slots;
+};
+
+struct ConfigOptionKeyRegistry
+{
+    ConfigOptionKeyRegistry() {
+        tables.emplace_back(std::make_unique<InternedKeyTable>(4096));
+        table.store(tables.back().get(), std::memory_order_release);
+    }
+
+    std::mutex                                      mutex;
+    std::atomic<const InternedKeyTable*>            table;
+    // All the tables ever published, as readers may still access the older ones.
+    std::vector<std::unique_ptr<InternedKeyTable>>  tables;
+    // Stable addresses of the interned keys.
+    std::deque<InternedKey>                         keys;
+    std::atomic<size_t>                             num_keys { 0 };
+};
+
+// Constructed on first use, the ConfigDefs intern their keys during the static initialization.
+ConfigOptionKeyRegistry& config_option_key_registry()
+{
+    static ConfigOptionKeyRegistry registry;
+    return registry;
+}
+} // namespace
+
+t_config_option_id ConfigOptionKeys::find(const t_config_option_key &key)
+{
+    const InternedKey *entry = config_option_key_registry().table.load(std::memory_order_acquire)->find(key, std::hash<t_config_option_key>{}(key));
+    return entry == nullptr ? invalid_id : entry->id;
+}
+
+t_config_option_id ConfigOptionKeys::intern(const t_config_option_key &key)
+{
+    ConfigOptionKeyRegistry &registry = config_option_key_registry();
+    const size_t             hash     = std::hash<t_config_option_key>{}(key);
+    if (const InternedKey *entry = registry.table.load(std::memory_order_acquire)->find(key, hash); entry != nullptr)
+        return entry->id;
+    std::scoped_lock<std::mutex> lock(registry.mutex);
+    const InternedKeyTable *table = registry.table.load(std::memory_order_relaxed);
+    if (const InternedKey *entry = table->find(key, hash); entry != nullptr)
+        // Interned by another thread in the meantime.
+        return entry->id;
+    if (2 * (registry.keys.size() + 1) > table->mask + 1) {
+        // Keep the load factor below 1/2. Publish a new table with twice the capacity.
+        auto new_table = std::make_unique<InternedKeyTable>(2 * (table->mask + 1));
+        for (const InternedKey &entry : registry.keys)
+            new_table->insert(&entry);
+        table = new_table.get();
+        registry.tables.emplace_back(std::move(new_table));
+        registry.table.store(table, std::memory_order_release);
+    }
+    registry.keys.push_back({ key, hash, t_config_option_id(registry.keys.size()) });
+    const_cast<InternedKeyTable*>(table)->insert(&registry.keys.back());
+    registry.num_keys.store(registry.keys.size(), std::memory_order_release);
+    return registry.keys.back().id;
+}
+
+size_t ConfigOptionKeys::size()
+{
+    return config_option_key_registry().num_keys.load(std::memory_order_acquire);
+}
+
 // Assignment of the serialization IDs is not thread safe. The Defs shall be initialized from the main thread!
 ConfigOptionDef* ConfigDef::add(const t_config_option_key &opt_key, ConfigOptionType type)
 {
 	static size_t serialization_key_ordinal_last = 0;
     ConfigOptionDef *opt = &this->options[opt_key];
     opt->opt_key = opt_key;
+    opt->id = ConfigOptionKeys::intern(opt_key);
     opt->type = type;
     opt->serialization_key_ordinal = ++ serialization_key_ordinal_last;
     this->by_serialization_key_ordinal[opt->serialization_key_ordinal] = opt;
+    this->index(*opt);
     return opt;
 }
 
+void ConfigDef::index(const ConfigOptionDef &def)
+{
+    assert(def.id != ConfigOptionKeys::invalid_id);
+    if (size_t(def.id) >= this->by_id.size())
+        this->by_id.resize(def.id + 1, nullptr);
+    this->by_id[def.id] = &def;
+}
+
 ConfigOptionDef* ConfigDef::add_nullable(const t_config_option_key &opt_key, ConfigOptionType type)
 {
 	ConfigOptionDef *def = this->add(opt_key, type);
@@ -466,6 +581,8 @@ void ConfigBase::apply_only(const ConfigBase &other, const t_config_option_keys
 //BBS: add skipped keys logic
 bool ConfigBase::equals(const ConfigBase &other, const std::set<std::string>* skipped_keys) const
 {
+    if (auto *l = dynamic_cast<const DynamicConfig*>(this), *r = dynamic_cast<const DynamicConfig*>(&other); l && r)
+        return l->equals(*r, skipped_keys);
     for (const t_config_option_key &opt_key : this->keys()) {
         if (skipped_keys && (skipped_keys->count(opt_key) != 0))
             continue;
@@ -480,6 +597,8 @@ bool ConfigBase::equals(const ConfigBase &other, const std::set<std::string>* sk
 // Returns options differing in the two configs, ignoring options not present in both configs.
 t_config_option_keys ConfigBase::diff(const ConfigBase &other) const
 {
+    if (auto *l = dynamic_cast<const DynamicConfig*>(this), *r = dynamic_cast<const DynamicConfig*>(&other); l && r)
+        return l->diff(*r);
     t_config_option_keys diff;
     for (const t_config_option_key &opt_key : this->keys()) {
         const ConfigOption *this_opt  = this->option(opt_key);
@@ -493,6 +612,8 @@ t_config_option_keys ConfigBase::diff(const ConfigBase &other) const
 // Returns options being equal in the two configs, ignoring options not present in both configs.
 t_config_option_keys ConfigBase::equal(const ConfigBase &other) const
 {
+    if (auto *l = dynamic_cast<const DynamicConfig*>(this), *r = dynamic_cast<const DynamicConfig*>(&other); l && r)
+        return l->equal(*r);
     t_config_option_keys equal;
     for (const t_config_option_key &opt_key : this->keys()) {
         const ConfigOption *this_opt  = this->option(opt_key);
@@ -1436,42 +1557,57 @@ void ConfigBase::null_nullables()
 
 DynamicConfig::DynamicConfig(const ConfigBase& rhs, const t_config_option_keys& keys)
 {
-	for (const t_config_option_key& opt_key : keys)
-		this->options[opt_key] = std::unique_ptr<ConfigOption>(rhs.option(opt_key)->clone());
+    // Collect the options first, then sort them by their ids at once.
+    std::vector<std::pair<t_config_option_id, size_t>> order;
+    order.reserve(keys.size());
+    for (const t_config_option_key& opt_key : keys)
+        order.emplace_back(ConfigOptionKeys::intern(opt_key), order.size());
+    std::sort(order.begin(), order.end());
+    order.erase(std::unique(order.begin(), order.end(), [](const auto &l, const auto &r) { return l.first == r.first; }), order.end());
+    this->options.reserve(order.size());
+    this->option_ids.reserve(order.size());
+    for (const auto &[id, idx] : order) {
+        this->options.emplace_back(keys[idx], rhs.option(keys[idx])->clone());
+        this->option_ids.emplace_back(id);
+    }
 }
 
 bool DynamicConfig::operator==(const DynamicConfig &rhs) const
 {
-    auto it1     = this->options.begin();
-    auto it1_end = this->options.end();
-    auto it2     = rhs.options.begin();
-    auto it2_end = rhs.options.end();
-    for (; it1 != it1_end && it2 != it2_end; ++ it1, ++ it2)
-		if (it1->first != it2->first || *it1->second != *it2->second)
-			// key or value differ
+    if (this->option_ids != rhs.option_ids)
+        // keys differ
+        return false;
+    for (size_t i = 0; i < this->options.size(); ++ i)
+		if (*this->options[i].second != *rhs.options[i].second)
+			// value differ
 			return false;
-    return it1 == it1_end && it2 == it2_end;
+    return true;
 }
 
 // Remove options with all nil values, those are optional and it does not help to hold them.
 size_t DynamicConfig::remove_nil_options()
 {
-	size_t cnt_removed = 0;
-	for (auto it = options.begin(); it != options.end();)
-		if (it->second->is_nil()) {
-			it = options.erase(it);
-			++ cnt_removed;
-		} else
-			++ it;
+	size_t j = 0;
+	for (size_t i = 0; i < options.size(); ++ i)
+		if (! options[i].second->is_nil()) {
+			if (i != j) {
+				options[j]    = std::move(options[i]);
+				option_ids[j] = option_ids[i];
+			}
+			++ j;
+		}
+	size_t cnt_removed = options.size() - j;
+	options.erase(options.begin() + j, options.end());
+	option_ids.erase(option_ids.begin() + j, option_ids.end());
 	return cnt_removed;
 }
 
 ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key, bool create)
 {
-    auto it = options.find(opt_key);
-    if (it != options.end())
+    t_config_option_id id = ConfigOptionKeys::find(opt_key);
+    if (size_t idx = this->find_index(id); idx != size_t(-1))
         // Option was found.
-        return it->second.get();
+        return options[idx].second.get();
     if (! create)
         // Option was not found and a new option shall not be created.
         return nullptr;
@@ -1485,14 +1621,13 @@ ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key, bool cre
         // Let the parent decide what to do if the opt_key is not defined by this->def().
         return nullptr;
     ConfigOption *opt = optdef->create_default_option();
-    this->options.emplace_hint(it, opt_key, std::unique_ptr<ConfigOption>(opt));
+    this->emplace(optdef->id, opt_key).reset(opt);
     return opt;
 }
 
 const ConfigOption* DynamicConfig::optptr(const t_config_option_key &opt_key) const
 {
-    auto it = options.find(opt_key);
-    return (it == options.end()) ? nullptr : it->second.get();
+    return this->optptr(ConfigOptionKeys::find(opt_key));
 }
 
 bool DynamicConfig::read_cli(int argc, const char* const argv[], t_config_option_keys* extra, t_config_option_keys* keys)
@@ -1625,6 +1760,8 @@ t_config_option_keys DynamicConfig::keys() const
     keys.reserve(this->options.size());
     for (const auto &opt : this->options)
         keys.emplace_back(opt.first);
+    // The options are sorted by their ids, while the keys are expected in alphabetical order, for example when saving a config file.
+    std::sort(keys.begin(), keys.end());
     return keys;
 }
 
@@ -1658,12 +1795,13 @@ t_config_option_keys StaticConfig::keys() const
 template<typename Fn>
 static inline bool dynamic_config_iterate(const DynamicConfig &lhs, const DynamicConfig &rhs, Fn fn, const std::set<std::string>* skipped_keys = nullptr)
 {
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>>::const_iterator i = lhs.cbegin();
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>>::const_iterator j = rhs.cbegin();
+    // Both configs are sorted by the option ids, merge them comparing just the ids.
+    DynamicConfig::const_iterator i = lhs.cbegin();
+    DynamicConfig::const_iterator j = rhs.cbegin();
     while (i != lhs.cend() && j != rhs.cend())
-        if (i->first < j->first)
+        if (lhs.id(i) < rhs.id(j))
             ++ i;
-        else if (i->first > j->first)
+        else if (lhs.id(i) > rhs.id(j))
             ++ j;
         else {
             assert(i->first == j->first);
@@ -1701,6 +1839,8 @@ t_config_option_keys DynamicConfig::diff(const DynamicConfig &other) const
             // Continue iterating.
             return false;
         });
+    // The options are iterated in the order of their ids, while the keys are presented to the user in alphabetical order.
+    std::sort(diff.begin(), diff.end());
     return diff;
 }
 
@@ -1715,6 +1855,8 @@ t_config_option_keys DynamicConfig::equal(const DynamicConfig &other) const
             // Continue iterating.
             return false;
         });
+    // The options are iterated in the order of their ids, while the keys are presented to the user in alphabetical order.
+    std::sort(equal.begin(), equal.end());
     return equal;
 }
 
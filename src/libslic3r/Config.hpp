@@ -2,6 +2,7 @@
 #define slic3r_Config_hpp_
 
 #include <assert.h>
+#include <algorithm>
 #include <map>
 #include <climits>
 #include <cstdio>
@@ -72,6 +73,26 @@ namespace Slic3r {
 // Name of the configuration option.
 typedef std::string                 t_config_option_key;
 typedef std::vector<std::string>    t_config_option_keys;
+// Dense integer identifier of an interned configuration option key, see ConfigOptionKeys.
+typedef int                         t_config_option_id;
+
+// Process wide registry interning the configuration option keys to dense integer ids.
+// The keys of a ConfigDef are interned when the ConfigDef is constructed, the keys not defined by any ConfigDef
+// (for example the PlaceholderParser variables) are interned when first stored into a DynamicConfig.
+// The ids are assigned in the order of interning, they are only valid during the lifetime of the process.
+// Lookups are lock free, interning a new key is serialized by a mutex.
+class ConfigOptionKeys
+{
+public:
+    static constexpr t_config_option_id invalid_id = -1;
+
+    // Id of an interned key, invalid_id if the key was never interned.
+    static t_config_option_id   find(const t_config_option_key &key);
+    // Id of a key, the key is interned if it was not interned yet.
+    static t_config_option_id   intern(const t_config_option_key &key);
+    // Number of keys interned, all the ids are lower than this number.
+    static size_t               size();
+};
 
 extern std::string  escape_string_cstyle(const std::string &str);
 extern std::string  escape_strings_cstyle(const std::vector<std::string> &strs);
@@ -1772,6 +1793,8 @@ public:
 
 	// Identifier of this option. It is stored here so that it is accessible through the by_serialization_key_ordinal map.
 	t_config_option_key 				opt_key;
+	// opt_key interned by ConfigOptionKeys.
+	t_config_option_id 					id              = ConfigOptionKeys::invalid_id;
     // What type? bool, int, string etc.
     ConfigOptionType                    type            = coNone;
 	// If a type is nullable, then it accepts a "nil" value (scalar) or "nil" values (vector).
@@ -1960,12 +1983,13 @@ class ConfigDef
 public:
     t_optiondef_map         					options;
     std::map<size_t, const ConfigOptionDef*>	by_serialization_key_ordinal;
+    // Indexed by ConfigOptionDef::id, nullptr for the keys not defined here.
+    std::vector<const ConfigOptionDef*>         by_id;
 
-    bool                    has(const t_config_option_key &opt_key) const { return this->options.count(opt_key) > 0; }
-    const ConfigOptionDef*  get(const t_config_option_key &opt_key) const {
-        t_optiondef_map::iterator it = const_cast<ConfigDef*>(this)->options.find(opt_key);
-        return (it == this->options.end()) ? nullptr : &it->second;
-    }
+    bool                    has(const t_config_option_key &opt_key) const { return this->get(opt_key) != nullptr; }
+    const ConfigOptionDef*  get(const t_config_option_key &opt_key) const { return this->get(ConfigOptionKeys::find(opt_key)); }
+    const ConfigOptionDef*  get(t_config_option_id id) const
+        { return id >= 0 && size_t(id) < this->by_id.size() ? this->by_id[id] : nullptr; }
     std::vector<std::string> keys() const {
         std::vector<std::string> out;
         out.reserve(options.size());
@@ -1982,6 +2006,8 @@ public:
 protected:
     ConfigOptionDef*        add(const t_config_option_key &opt_key, ConfigOptionType type);
     ConfigOptionDef*        add_nullable(const t_config_option_key &opt_key, ConfigOptionType type);
+    // Register an option definition stored into this->options into this->by_id.
+    void                    index(const ConfigOptionDef &def);
 };
 
 // A pure interface to resolving ConfigOptions.
@@ -2181,7 +2207,7 @@ class DynamicConfig : public virtual ConfigBase
 public:
     DynamicConfig() = default;
     DynamicConfig(const DynamicConfig &rhs) { *this = rhs; }
-    DynamicConfig(DynamicConfig &&rhs) noexcept : options(std::move(rhs.options)) { rhs.options.clear(); }
+    DynamicConfig(DynamicConfig &&rhs) noexcept : options(std::move(rhs.options)), option_ids(std::move(rhs.option_ids)) { rhs.clear(); }
 	explicit DynamicConfig(const ConfigBase &rhs, const t_config_option_keys &keys);
 	explicit DynamicConfig(const ConfigBase& rhs) : DynamicConfig(rhs, rhs.keys()) {}
 	virtual ~DynamicConfig() override = default;
@@ -2192,8 +2218,10 @@ public:
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
         this->clear();
+        this->options.reserve(rhs.options.size());
         for (const auto &kvp : rhs.options)
-            this->options[kvp.first].reset(kvp.second->clone());
+            this->options.emplace_back(kvp.first, kvp.second->clone());
+        this->option_ids = rhs.option_ids;
         return *this;
     }
 
@@ -2203,8 +2231,9 @@ public:
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
         this->clear();
-        this->options = std::move(rhs.options);
-        rhs.options.clear();
+        this->options    = std::move(rhs.options);
+        this->option_ids = std::move(rhs.option_ids);
+        rhs.clear();
         return *this;
     }
 
@@ -2213,16 +2242,17 @@ public:
     DynamicConfig& operator+=(const DynamicConfig &rhs)
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
-        for (const auto &kvp : rhs.options) {
-            auto it = this->options.find(kvp.first);
-            if (it == this->options.end())
-                this->options[kvp.first].reset(kvp.second->clone());
+        for (size_t i = 0; i < rhs.options.size(); ++ i) {
+            std::unique_ptr<ConfigOption> &opt = this->emplace(rhs.option_ids[i], rhs.options[i].first);
+            const ConfigOption            *src = rhs.options[i].second.get();
+            if (! opt)
+                opt.reset(src->clone());
             else {
-                assert(it->second->type() == kvp.second->type());
-                if (it->second->type() == kvp.second->type())
-                    *it->second = *kvp.second;
+                assert(opt->type() == src->type());
+                if (opt->type() == src->type())
+                    *opt = *src;
                 else
-                    it->second.reset(kvp.second->clone());
+                    opt.reset(src->clone());
             }
         }
         return *this;
@@ -2233,16 +2263,12 @@ public:
     DynamicConfig& operator+=(DynamicConfig &&rhs)
     {
         assert(this->def() == nullptr || this->def() == rhs.def());
-        for (auto &kvp : rhs.options) {
-            auto it = this->options.find(kvp.first);
-            if (it == this->options.end()) {
-                this->options.insert(std::make_pair(kvp.first, std::move(kvp.second)));
-            } else {
-                assert(it->second->type() == kvp.second->type());
-                it->second = std::move(kvp.second);
-            }
+        for (size_t i = 0; i < rhs.options.size(); ++ i) {
+            std::unique_ptr<ConfigOption> &opt = this->emplace(rhs.option_ids[i], rhs.options[i].first);
+            assert(! opt || opt->type() == rhs.options[i].second->type());
+            opt = std::move(rhs.options[i].second);
         }
-        rhs.options.clear();
+        rhs.clear();
         return *this;
     }
 
@@ -2252,19 +2278,22 @@ public:
     void swap(DynamicConfig &other)
     {
         std::swap(this->options, other.options);
+        std::swap(this->option_ids, other.option_ids);
     }
 
     void clear()
     {
         this->options.clear();
+        this->option_ids.clear();
     }
 
     bool erase(const t_config_option_key &opt_key)
     {
-        auto it = this->options.find(opt_key);
-        if (it == this->options.end())
+        size_t idx = this->find_index(ConfigOptionKeys::find(opt_key));
+        if (idx == size_t(-1))
             return false;
-        this->options.erase(it);
+        this->options.erase(this->options.begin() + idx);
+        this->option_ids.erase(this->option_ids.begin() + idx);
         return true;
     }
 
@@ -2280,9 +2309,12 @@ public:
         { return dynamic_cast<const T*>(this->option(opt_key)); }
     // Overrides ConfigResolver::optptr().
     const ConfigOption*     optptr(const t_config_option_key &opt_key) const override;
+    // Lookup by a key interned by ConfigOptionKeys, saving the hashing of the key.
+    const ConfigOption*     optptr(t_config_option_id id) const
+        { size_t idx = this->find_index(id); return idx == size_t(-1) ? nullptr : this->options[idx].second.get(); }
     // Overrides ConfigBase::optptr(). Find ando/or create a ConfigOption instance for a given name.
     ConfigOption*           optptr(const t_config_option_key &opt_key, bool create = false) override;
-    // Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store.
+    // Overrides ConfigBase::keys(). Collect names of all configuration values maintained by this configuration store, sorted alphabetically.
     t_config_option_keys    keys() const override;
     bool                    empty() const { return options.empty(); }
 
@@ -2291,14 +2323,10 @@ public:
     // Be careful, as this method does not test the existence of opt_key in this->def().
     bool                    set_key_value(const std::string &opt_key, ConfigOption *opt)
     {
-        auto it = this->options.find(opt_key);
-        if (it == this->options.end()) {
-            this->options[opt_key].reset(opt);
-            return true;
-        } else {
-            it->second.reset(opt);
-            return false;
-        }
+        std::unique_ptr<ConfigOption> &dst = this->emplace(ConfigOptionKeys::intern(opt_key), opt_key);
+        bool                           inserted = ! dst;
+        dst.reset(opt);
+        return inserted;
     }
 
     // Are the two configs equal? Ignoring options not present in both configs.
@@ -2337,15 +2365,56 @@ public:
     // Command line processing
     bool                read_cli(int argc, const char* const argv[], t_config_option_keys* extra, t_config_option_keys* keys = nullptr);
 
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>>::const_iterator cbegin() const { return options.cbegin(); }
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>>::const_iterator cend()   const { return options.cend(); }
-    size_t                        												 size()   const { return options.size(); }
+    // Iterate over (key, option) pairs, sorted by ConfigOptionKeys ids.
+    using value_type     = std::pair<t_config_option_key, std::unique_ptr<ConfigOption>>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+    const_iterator          cbegin() const { return options.cbegin(); }
+    const_iterator          cend()   const { return options.cend(); }
+    size_t                  size()   const { return options.size(); }
+    // ConfigOptionKeys id of the option pointed to by it.
+    t_config_option_id      id(const_iterator it) const { return option_ids[it - options.cbegin()]; }
 
 private:
-    std::map<t_config_option_key, std::unique_ptr<ConfigOption>> options;
+    // Index of the option with the given id in this->options, size_t(-1) if not found.
+    size_t                  find_index(t_config_option_id id) const {
+        auto it = std::lower_bound(option_ids.begin(), option_ids.end(), id);
+        return it == option_ids.end() || *it != id ? size_t(-1) : size_t(it - option_ids.begin());
+    }
+    // Find an option by id, insert an empty slot if not found. Returns the slot to be filled by the caller if empty.
+    std::unique_ptr<ConfigOption>& emplace(t_config_option_id id, const t_config_option_key &opt_key) {
+        assert(id != ConfigOptionKeys::invalid_id);
+        auto   it  = std::lower_bound(option_ids.begin(), option_ids.end(), id);
+        size_t idx = it - option_ids.begin();
+        if (it == option_ids.end() || *it != id) {
+            option_ids.insert(it, id);
+            options.insert(options.begin() + idx, value_type(opt_key, nullptr));
+        }
+        return options[idx].second;
+    }
+
+    // Options sorted by their ConfigOptionKeys ids. A sorted vector is more compact than a map and the lookup
+    // by a binary search over the integer ids is cheaper than a lookup by string.
+    std::vector<value_type>         options;
+    // ConfigOptionKeys ids of this->options.
+    std::vector<t_config_option_id> option_ids;
 
 	friend class cereal::access;
-	template<class Archive> void serialize(Archive &ar) { ar(options); }
+	template<class Archive> void save(Archive &ar) const {
+        ar(this->options.size());
+        for (const value_type &kvp : this->options)
+            ar(kvp.first, kvp.second);
+    }
+	template<class Archive> void load(Archive &ar) {
+        size_t cnt;
+        ar(cnt);
+        this->clear();
+        for (size_t i = 0; i < cnt; ++ i) {
+            t_config_option_key           opt_key;
+            std::unique_ptr<ConfigOption> opt;
+            ar(opt_key, opt);
+            this->emplace(ConfigOptionKeys::intern(opt_key), opt_key) = std::move(opt);
+        }
+    }
 };
 
 // Configuration store with a static definition of configuration values.
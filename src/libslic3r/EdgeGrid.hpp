@@ -114,6 +114,12 @@ public:
 
 	const std::vector<Contour>& contours() const { return m_contours; }
 
+	// Heap memory allocated by the grid itself, the referenced source contours are not counted.
+	size_t memory_used() const {
+		return m_contours.capacity() * sizeof(Contour) + m_cell_data.capacity() * sizeof(std::pair<size_t, size_t>) +
+			   m_cells.capacity() * sizeof(Cell) + m_signed_distance_field.capacity() * sizeof(float);
+	}
+
 #if 0
 	// Test, whether the edges inside the grid intersect with the polygons provided.
 	bool intersect(const MultiPoint &polyline, bool closed);
@@ -8,9 +8,23 @@
 #include <limits>
 #include <sstream>
 
+#include <oneapi/tbb/scalable_allocator.h>
+
 #define L(s) (s)
 
 namespace Slic3r {
+
+void* ExtrusionEntity::operator new(size_t size)
+{
+    if (void *ptr = scalable_malloc(size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void ExtrusionEntity::operator delete(void *ptr) noexcept
+{
+    scalable_free(ptr);
+}
     
 void ExtrusionPath::intersect_expolygons(const ExPolygons &collection, ExtrusionEntityCollection* retval) const
 {
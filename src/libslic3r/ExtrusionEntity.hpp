@@ -115,6 +115,11 @@ public:
     // Create a new object, initialize it with this object using the move semantics.
     virtual ExtrusionEntity* clone_move() = 0;
     virtual ~ExtrusionEntity() {}
+    // Extrusion entities are allocated by the million from all the worker threads and released together
+    // with their layer. Serve them from the thread caching TBB pool instead of the contended system heap.
+    // Derived classes inherit these, the virtual destructor routes deletion through the base class.
+    static void* operator new(size_t size);
+    static void  operator delete(void *ptr) noexcept;
     virtual void reverse() = 0;
     virtual const Point& first_point() const = 0;
     virtual const Point& last_point() const = 0;
@@ -273,6 +273,23 @@ void OctreeDeleter::operator()(Octree *p) {
     delete p;
 }
 
+size_t octree_memory_used(const Octree *octree)
+{
+    if (octree == nullptr)
+        return 0;
+    size_t num_cubes = 0;
+    std::vector<const Cube*> stack { octree->root_cube };
+    while (! stack.empty()) {
+        const Cube *cube = stack.back();
+        stack.pop_back();
+        ++ num_cubes;
+        for (const Cube *child : cube->children)
+            if (child != nullptr)
+                stack.emplace_back(child);
+    }
+    return sizeof(Octree) + num_cubes * sizeof(Cube) + octree->cubes_properties.capacity() * sizeof(CubeProperties);
+}
+
 std::pair<double, double> adaptive_fill_line_spacing(const PrintObject &print_object)
 {
     // Output, spacing for icAdaptiveCubic and icSupportCubic
@@ -26,6 +26,8 @@ struct Octree;
 // To keep the definition of Octree opaque, we have to define a custom deleter.
 struct OctreeDeleter { void operator()(Octree *p); };
 using  OctreePtr = std::unique_ptr<Octree, OctreeDeleter>;
+// Estimated memory of the octree, zero for nullptr.
+size_t octree_memory_used(const Octree *octree);
 
 // Calculate line spacing for
 // 1) adaptive cubic infill
@@ -26,6 +26,11 @@ void GeneratorDeleter::operator()(Generator *p) {
     delete p;
 }
 
+size_t generator_memory_used(const Generator *generator)
+{
+    return generator == nullptr ? 0 : generator->memory_used();
+}
+
 GeneratorPtr build_generator(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
 {
     return GeneratorPtr(new Generator(print_object, throw_on_cancel_callback));
@@ -13,6 +13,8 @@ class Generator;
 // To keep the definition of Octree opaque, we have to define a custom deleter.
 struct GeneratorDeleter { void operator()(Generator *p); };
 using  GeneratorPtr = std::unique_ptr<Generator, GeneratorDeleter>;
+// Estimated memory of the generator, zero for nullptr.
+size_t generator_memory_used(const Generator *generator);
 
 GeneratorPtr build_generator(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
 
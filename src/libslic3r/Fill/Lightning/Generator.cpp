@@ -156,6 +156,23 @@ const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
     return m_lightning_layers[layer_id];
 }
 
+size_t Generator::memory_used() const
+{
+    size_t out = sizeof(Generator) + m_overhang_per_layer.capacity() * sizeof(Polygons) +
+        m_lightning_layers.capacity() * sizeof(Layer) + bboxs.capacity() * sizeof(BoundingBox);
+    for (const Polygons &polygons : m_overhang_per_layer) {
+        out += polygons.capacity() * sizeof(Polygon);
+        for (const Polygon &polygon : polygons)
+            out += polygon.points.capacity() * sizeof(Point);
+    }
+    // Each node is referenced either by the tree roots of its layer or by its parent.
+    size_t num_nodes = 0;
+    for (const Layer &layer : m_lightning_layers)
+        for (const NodeSPtr &root : layer.tree_roots)
+            root->visitNodes([&num_nodes](NodeSPtr) { ++ num_nodes; });
+    return out + num_nodes * (sizeof(Node) + sizeof(NodeSPtr));
+}
+
 void Generator::generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
 {
     m_lightning_layers.resize(print_object.layers().size());
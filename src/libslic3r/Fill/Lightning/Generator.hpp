@@ -61,6 +61,11 @@ public:
 
     float infilll_extrusion_width() const { return m_infill_extrusion_width; }
 
+    /*!
+     * Estimated memory of the overhangs and of the trees of all layers.
+     */
+    size_t memory_used() const;
+
     Generator(PrintObject* m_object, std::vector<Polygons>& contours, std::vector<Polygons>& overhangs, const std::function<void()> &throw_on_cancel_callback, float density = 0.15);
 
 protected:
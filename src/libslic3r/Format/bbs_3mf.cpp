@@ -12,6 +12,7 @@
 #include "../GCode.hpp"
 #include "../Geometry.hpp"
 #include "../GCode/ThumbnailData.hpp"
+#include "../GCode/Thumbnails.hpp"
 #include "../Semver.hpp"
 #include "../Time.hpp"
 
@@ -5262,7 +5263,9 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
 
         bool _add_content_types_file_to_archive(mz_zip_archive& archive);
 
-        bool _add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, const char* local_path, int index, bool generate_small_thumbnail = false);
+        // png is the thumbnail_data already compressed, it is compressed here if not provided.
+        bool _add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, const char* local_path, int index, bool generate_small_thumbnail = false,
+                                            GCodeThumbnails::CompressedImageBufferPtr png = nullptr);
         bool _add_calibration_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, int index);
         bool _add_bbox_file_to_archive(mz_zip_archive& archive, const PlateBBoxData& id_bboxes, int index);
         bool _add_relationships_file_to_archive(mz_zip_archive &                archive,
@@ -5506,11 +5509,20 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                     return false;
             }
 
+            // Compress all the thumbnails in parallel, thumbnails already compressed by the G-code export are reused.
+            std::vector<const ThumbnailData*> to_compress;
+            for (const std::vector<ThumbnailData*> *list : { &thumbnail_data, &top_thumbnail_data, &pick_thumbnail_data })
+                to_compress.insert(to_compress.end(), list->begin(), list->end());
+            std::vector<GCodeThumbnails::CompressedImageBufferPtr> compressed = GCodeThumbnails::compress_thumbnails(to_compress, GCodeThumbnailsFormat::PNG);
+            const GCodeThumbnails::CompressedImageBufferPtr *compressed_plate = compressed.data();
+            const GCodeThumbnails::CompressedImageBufferPtr *compressed_top   = compressed_plate + thumbnail_data.size();
+            const GCodeThumbnails::CompressedImageBufferPtr *compressed_pick  = compressed_top + top_thumbnail_data.size();
+
             for (unsigned int index = 0; index < thumbnail_data.size(); index++)
             {
                 if (thumbnail_data[index]->is_valid())
                 {
-                    if (!_add_thumbnail_file_to_archive(archive, *thumbnail_data[index], "Metadata/plate", index, true)) {
+                    if (!_add_thumbnail_file_to_archive(archive, *thumbnail_data[index], "Metadata/plate", index, true, compressed_plate[index])) {
                         return false;
                     }
 
@@ -5525,7 +5537,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 if (top_thumbnail_data[index]->is_valid())
                 {
                     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add top thumbnail %1%'s data into 3mf")%(index+1);
-                    if (!_add_thumbnail_file_to_archive(archive, *top_thumbnail_data[index], "Metadata/top", index)) {
+                    if (!_add_thumbnail_file_to_archive(archive, *top_thumbnail_data[index], "Metadata/top", index, false, compressed_top[index])) {
                         return false;
                     }
                     top_thumbnail_status[index] = true;
@@ -5534,7 +5546,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
                 if (pick_thumbnail_data[index]->is_valid())
                 {
                     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ":" <<__LINE__ << boost::format(",add pick thumbnail %1%'s data into 3mf")%(index+1);
-                    if (!_add_thumbnail_file_to_archive(archive, *pick_thumbnail_data[index], "Metadata/pick", index)) {
+                    if (!_add_thumbnail_file_to_archive(archive, *pick_thumbnail_data[index], "Metadata/pick", index, false, compressed_pick[index])) {
                         return false;
                     }
                     pick_thumbnail_status[index] = true;
@@ -5886,16 +5898,16 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
         return true;
     }
 
-    bool _BBS_3MF_Exporter::_add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, const char* local_path, int index, bool generate_small_thumbnail)
+    bool _BBS_3MF_Exporter::_add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data, const char* local_path, int index, bool generate_small_thumbnail,
+                                                           GCodeThumbnails::CompressedImageBufferPtr png)
     {
         bool res = false;
 
-        size_t png_size = 0;
-        void* png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)thumbnail_data.pixels.data(), thumbnail_data.width, thumbnail_data.height, 4, &png_size, MZ_DEFAULT_COMPRESSION, 1);
-        if (png_data != nullptr) {
+        if (! png)
+            png = GCodeThumbnails::compress_thumbnail_cached(thumbnail_data, GCodeThumbnailsFormat::PNG);
+        if (png->data != nullptr) {
             std::string thumbnail_name = (boost::format("%1%_%2%.png")%local_path % (index + 1)).str();
-            res = mz_zip_writer_add_mem(&archive, thumbnail_name.c_str(), (const void*)png_data, png_size, MZ_NO_COMPRESSION);
-            mz_free(png_data);
+            res = mz_zip_writer_add_mem(&archive, thumbnail_name.c_str(), (const void*)png->data, png->size, MZ_NO_COMPRESSION);
         }
 
         if (!res) {
@@ -5937,7 +5949,7 @@ void PlateData::parse_filament_info(GCodeProcessorResult *result)
             }
             size_t small_png_size = 0;
             void* small_png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)small_pixels.data(), PLATE_THUMBNAIL_SMALL_WIDTH, PLATE_THUMBNAIL_SMALL_HEIGHT, 4, &small_png_size, MZ_DEFAULT_COMPRESSION, 1);
-            if (png_data != nullptr) {
+            if (small_png_data != nullptr) {
                 std::string thumbnail_name = (boost::format("%1%_%2%_small.png") % local_path % (index + 1)).str();
                 res = mz_zip_writer_add_mem(&archive, thumbnail_name.c_str(), (const void*)small_png_data, small_png_size, MZ_NO_COMPRESSION);
                 mz_free(small_png_data);
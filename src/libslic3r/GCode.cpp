@@ -8,6 +8,7 @@
 #include "ExtrusionEntity.hpp"
 #include "EdgeGrid.hpp"
 #include "Geometry/ConvexHull.hpp"
+#include "GCode/GCodeIndex.hpp"
 #include "GCode/PrintExtents.hpp"
 #include "GCode/Thumbnails.hpp"
 #include "GCode/WipeTower.hpp"
@@ -87,6 +88,8 @@ namespace Slic3r {
 static const float g_min_purge_volume = 100.f;
 static const float g_purge_volume_one_time = 135.f;
 static const int g_max_flush_count = 4;
+// Number of the G-code moves kept in memory by the streaming G-code export, see Print::set_streaming_gcode_export().
+static const size_t g_streaming_export_moves_window = 1 << 16;
 // static const size_t g_max_label_object = 64;
 
 Vec2d travel_point_1;
@@ -1445,6 +1448,23 @@ namespace DoExport {
 
         return ret;
     }
+
+    // The G-code is generated into a spool file first, which is then streamed into the output file by the GCodeProcessor
+    // with the time estimates inserted. The spool is placed into the local temp directory, so that an output on a network
+    // storage is written just once. Falls back to a spool next to the output if the temp directory is not writable.
+    static FILE* open_gcode_spool(const std::string &path, std::string &path_spool)
+    {
+        boost::system::error_code ec;
+        boost::filesystem::path   temp_dir = boost::filesystem::temp_directory_path(ec);
+        if (! ec) {
+            path_spool = (temp_dir / boost::filesystem::unique_path("orca_gcode_%%%%-%%%%-%%%%-%%%%.spool")).string();
+            if (FILE *f = boost::nowide::fopen(path_spool.c_str(), "wb"); f != nullptr)
+                return f;
+            BOOST_LOG_TRIVIAL(warning) << "Cannot open G-code spool " << path_spool << ", spooling next to the output file";
+        }
+        path_spool = path + ".spool";
+        return boost::nowide::fopen(path_spool.c_str(), "wb");
+    }
 } // namespace DoExport
 
 bool GCode::is_BBL_Printer()
@@ -1502,9 +1522,10 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     std::string path_tmp(path);
     path_tmp += ".tmp";
+    std::string path_spool;
 
-    m_processor.initialize(path_tmp);
-    GCodeOutputStream file(boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor);
+    GCodeOutputStream file(DoExport::open_gcode_spool(path_tmp, path_spool), m_processor);
+    m_processor.initialize(path_spool);
     if (! file.is_open()) {
         BOOST_LOG_TRIVIAL(error) << std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n" << std::endl;
         if (!fs::exists(folder)) {
@@ -1515,23 +1536,29 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
     }
 
     try {
+        SLIC3R_TRACE_SPAN("GCode::_do_export", "gcode");
         this->_do_export(*print, file, thumbnail_cb);
         file.flush();
         if (file.is_error()) {
             file.close();
-            boost::nowide::remove(path_tmp.c_str());
+            boost::nowide::remove(path_spool.c_str());
             throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed\nIs the disk full?\n");
         }
     } catch (std::exception & /* ex */) {
         // Rethrow on any exception. std::runtime_exception and CanceledException are expected to be thrown.
         // Close and remove the file.
         file.close();
-        boost::nowide::remove(path_tmp.c_str());
+        boost::nowide::remove(path_spool.c_str());
         throw;
     }
     file.close();
 
-    check_placeholder_parser_failed();
+    try {
+        check_placeholder_parser_failed();
+    } catch (std::exception & /* ex */) {
+        boost::nowide::remove(path_spool.c_str());
+        throw;
+    }
 
     BOOST_LOG_TRIVIAL(debug) << "Start processing gcode, " << log_memory_info();
     // Post-process the G-code to update time stamps.
@@ -1566,7 +1593,17 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         }
     }
 
-    m_processor.finalize(true);
+    // Stream the spooled G-code into the output file, inserting the time estimates, then drop the spool.
+    try {
+        SLIC3R_TRACE_SPAN("GCodeProcessor::finalize", "gcode");
+        m_processor.finalize(true, path_tmp);
+    } catch (std::exception & /* ex */) {
+        boost::nowide::remove(path_spool.c_str());
+        boost::nowide::remove(path_tmp.c_str());
+        throw;
+    }
+    boost::nowide::remove(path_spool.c_str());
+    std::shared_ptr<GCodeIndex> gcode_index = m_processor.result().gcode_index;
 //    DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     DoExport::update_print_estimated_stats(m_processor, m_writer.extruders(), print->m_print_statistics, print->config());
     if (result != nullptr) {
@@ -1588,6 +1625,15 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         BOOST_LOG_TRIVIAL(info) << boost::format("rename_file from %1% to %2% successfully")% path_tmp % path;
     }
 
+    if (gcode_index) {
+        // The index is a cache of the G-code, the export does not fail without it.
+        try {
+            gcode_index->save(GCodeIndex::path_for(path), path);
+        } catch (const Slic3r::RuntimeError &ex) {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to write the G-code index: " << ex.what();
+        }
+    }
+
     BOOST_LOG_TRIVIAL(info) << "Exporting G-code finished" << log_memory_info();
     print->set_done(psGCodeExport);
     
@@ -1610,6 +1656,21 @@ namespace DoExport {
         processor.enable_stealth_time_estimator(silent_time_estimator_enabled);
     }
 
+    // Metadata of a binary G-code, written by the processor in front of the G-code blocks.
+    static void init_binary_data(const Print &print, BinaryGCode::BinaryData &binary_data)
+    {
+        const DynamicPrintConfig &cfg = print.full_print_config();
+        binary_data.reset();
+        binary_data.file_metadata.emplace_back("Producer", Slic3r::header_slic3r_generated());
+        binary_data.printer_metadata.emplace_back("printer_model", print.config().printer_model.value);
+        binary_data.printer_metadata.emplace_back("nozzle_diameter", print.config().nozzle_diameter.serialize());
+        binary_data.printer_metadata.emplace_back("filament_type", print.config().filament_type.serialize());
+        // The full config, so that the G-code viewer restores it the same way as from the config block of a text G-code.
+        for (const std::string &key : cfg.keys())
+            if (key != "compatible_printers" && key != "compatible_prints" && ! cfg.option(key)->is_nil())
+                binary_data.slicer_metadata.emplace_back(key, cfg.opt_serialize(key));
+    }
+
 #if 0
 	static double autospeed_volumetric_limit(const Print &print)
 	{
@@ -1835,6 +1896,12 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
 
     // modifies m_silent_time_estimator_enabled
     DoExport::init_gcode_processor(print.config(), m_processor, m_silent_time_estimator_enabled);
+    const bool is_binary_gcode = m_processor.is_binary_gcode();
+    if (is_binary_gcode)
+        DoExport::init_binary_data(print, m_processor.binary_data());
+    if (print.streaming_gcode_export())
+        m_processor.set_moves_window(g_streaming_export_moves_window, print.m_streaming_gcode_spill_moves);
+    m_processor.enable_gcode_index(print.export_gcode_index());
     const bool is_bbl_printers = print.is_BBL_printer();
     m_calib_config.clear();
     // resets analyzer's tracking data
@@ -1913,15 +1980,21 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
     } else
 	    m_enable_extrusion_role_markers = false;
 
+    // The thumbnails are compressed in the background while the layers are generated. A text G-code gets a placeholder,
+    // which is replaced by the thumbnails when post processing, a binary G-code stores them into blocks of their own.
+    // BTT_TFT is a text format, a binary G-code stores PNG instead.
+    const GCodeThumbnailsFormat m_gcode_thumbnail_format = print.full_print_config().opt_enum<GCodeThumbnailsFormat>("thumbnails_format");
+    GCodeThumbnails::ThumbnailsCompressor thumbnails;
+    // BBL printers get just the BTT_TFT thumbnails into a text G-code.
+    if (is_binary_gcode || m_gcode_thumbnail_format == GCodeThumbnailsFormat::BTT_TFT || ! is_bbl_printers)
+        thumbnails.start(thumbnail_cb, print.get_plate_index(), print.full_print_config().option<ConfigOptionPoints>("thumbnails")->values,
+            is_binary_gcode && m_gcode_thumbnail_format == GCodeThumbnailsFormat::BTT_TFT ? GCodeThumbnailsFormat::PNG : m_gcode_thumbnail_format);
+    print.throw_if_canceled();
+    const bool thumbnails_placeholder = ! is_binary_gcode && ! thumbnails.empty();
     // if thumbnail type of BTT_TFT, insert above header
     // if not, it is inserted under the header in its normal spot
-    const GCodeThumbnailsFormat m_gcode_thumbnail_format = print.full_print_config().opt_enum<GCodeThumbnailsFormat>("thumbnails_format");
-    if (m_gcode_thumbnail_format == GCodeThumbnailsFormat::BTT_TFT)
-        GCodeThumbnails::export_thumbnails_to_file(
-            thumbnail_cb, print.get_plate_index(), print.full_print_config().option<ConfigOptionPoints>("thumbnails")->values,
-            m_gcode_thumbnail_format,
-            [&file](const char *sz) { file.write(sz); },
-            [&print]() { print.throw_if_canceled(); });
+    if (m_gcode_thumbnail_format == GCodeThumbnailsFormat::BTT_TFT && thumbnails_placeholder)
+        file.write_format(";%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Thumbnails_Placeholder).c_str());
 
     file.write_format("; HEADER_BLOCK_START\n");
     // Write information on the generator.
@@ -1998,12 +2071,8 @@ void GCode::_do_export(Print& print, GCodeOutputStream &file, ThumbnailsGenerato
             print.config().nozzle_temperature_initial_layer.get_at(0));
         file.write("; CONFIG_BLOCK_END\n\n");
       } else {
-        if (m_gcode_thumbnail_format != GCodeThumbnailsFormat::BTT_TFT)
-          GCodeThumbnails::export_thumbnails_to_file(
-              thumbnail_cb, print.get_plate_index(), print.full_print_config().option<ConfigOptionPoints>("thumbnails")->values,
-              m_gcode_thumbnail_format,
-              [&file](const char *sz) { file.write(sz); },
-              [&print]() { print.throw_if_canceled(); });
+        if (m_gcode_thumbnail_format != GCodeThumbnailsFormat::BTT_TFT && thumbnails_placeholder)
+          file.write_format(";%s\n", GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Thumbnails_Placeholder).c_str());
       }
     }
 
@@ -2546,6 +2615,9 @@ this->placeholder_parser().set("z_offset", new ConfigOptionFloat(m_config.z_offs
             // Process all layers of all objects (non-sequential mode) with a parallel pipeline:
             // Generate G-code, run the filters (vase mode, cooling buffer), run the G-code analyser
             // and export G-code into file.
+            // Each layer is exported once in the non-sequential mode, thus the streaming export may release it right away.
+            if (print.streaming_gcode_export())
+                print.m_exported_layers_released = true;
             this->process_layers(print, tool_ordering, print_object_instances_ordering, layers_to_print, file);
             //BBS: close powerlost recovery
             {
@@ -2669,6 +2741,12 @@ this->placeholder_parser().set("z_offset", new ConfigOptionFloat(m_config.z_offs
     file.write("\n");
 
     print.throw_if_canceled();
+
+    // All the layers are generated, hand the compressed thumbnails over to the post processing.
+    if (is_binary_gcode)
+        m_processor.binary_data().thumbnails = thumbnails.binary();
+    else if (thumbnails_placeholder)
+        m_processor.set_thumbnails_gcode(thumbnails.gcode());
 }
 
 //BBS
@@ -2717,7 +2795,17 @@ void GCode::process_layers(
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                SLIC3R_TRACE_SPAN("process_layer", "gcode");
+                LayerResult result = this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                if (print.streaming_gcode_export())
+                    // The G-code of the layer was generated, its extrusions are no more needed.
+                    for (const LayerToPrint &layer_to_print : layer.second) {
+                        if (layer_to_print.object_layer != nullptr)
+                            const_cast<Layer*>(layer_to_print.object_layer)->release_extrusions();
+                        if (layer_to_print.support_layer != nullptr)
+                            const_cast<SupportLayer*>(layer_to_print.support_layer)->release_extrusions();
+                    }
+                return result;
             }
         });
    
@@ -2737,10 +2825,11 @@ void GCode::process_layers(
         [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in) -> std::string {
         	if (in.nop_layer_result)
                 return in.gcode;
+            SLIC3R_TRACE_SPAN("cooling_buffer", "gcode");
             return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) { SLIC3R_TRACE_SPAN("write_and_process", "gcode"); output_stream.write(s); }
     );
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
@@ -2799,6 +2888,7 @@ void GCode::process_layers(
                 //BBS
                 check_placeholder_parser_failed();
                 print.throw_if_canceled();
+                SLIC3R_TRACE_SPAN("process_layer", "gcode");
                 return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx, prime_extruder);
             }
         });
@@ -2809,10 +2899,11 @@ void GCode::process_layers(
         });
     const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [&cooling_buffer = *this->m_cooling_buffer.get()](LayerResult in)->std::string {
+            SLIC3R_TRACE_SPAN("cooling_buffer", "gcode");
             return cooling_buffer.process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) { SLIC3R_TRACE_SPAN("write_and_process", "gcode"); output_stream.write(s); }
     );
 
     const auto fan_mover = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
@@ -4628,6 +4719,7 @@ static std::map<int, std::string> overhang_speed_key_map =
 
 std::string GCode::_extrude(const ExtrusionPath &path, std::string description, double speed)
 {
+    static const std::string empty_comment;
     std::string gcode;
 
     if (is_bridge(path.role()))
@@ -5027,14 +5119,17 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
             }
             // BBS: use G1 if not enable arc fitting or has no arc fitting result or in spiral_mode mode
             // Attention: G2 and G3 is not supported in spiral_mode mode
+            const std::string &line_comment = GCodeWriter::full_gcode_comment ? description : empty_comment;
+            // Moves are appended straight into gcode, roughly 40 characters per point.
+            gcode.reserve(gcode.size() + path.polyline.points.size() * 40);
             if (!m_config.enable_arc_fitting || path.polyline.fitting_result.empty() || m_config.spiral_mode) {
                 for (const Line& line : path.polyline.lines()) {
                     const double line_length = line.length() * SCALING_FACTOR;
                     path_length += line_length;
-                    gcode += m_writer.extrude_to_xy(
+                    m_writer.extrude_to_xy(gcode,
                         this->point_to_gcode(line.b),
                         e_per_mm * line_length,
-                        GCodeWriter::full_gcode_comment ? description : "", path.is_force_no_extrusion());
+                        line_comment, path.is_force_no_extrusion());
                 }
             } else {
                 // BBS: start to generate gcode from arc fitting data which includes line and arc
@@ -5048,10 +5143,10 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                             const Line line = Line(path.polyline.points[point_index - 1], path.polyline.points[point_index]);
                             const double line_length = line.length() * SCALING_FACTOR;
                             path_length += line_length;
-                            gcode += m_writer.extrude_to_xy(
+                            m_writer.extrude_to_xy(gcode,
                                 this->point_to_gcode(line.b),
                                 e_per_mm * line_length,
-                                GCodeWriter::full_gcode_comment ? description : "", path.is_force_no_extrusion());
+                                line_comment, path.is_force_no_extrusion());
                         }
                         break;
                     }
@@ -5061,12 +5156,12 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                         const double arc_length = fitting_result[fitting_index].arc_data.length * SCALING_FACTOR;
                         const Vec2d center_offset = this->point_to_gcode(arc.center) - this->point_to_gcode(arc.start_point);
                         path_length += arc_length;
-                        gcode += m_writer.extrude_arc_to_xy(
+                        m_writer.extrude_arc_to_xy(gcode,
                             this->point_to_gcode(arc.end_point),
                             center_offset,
                             e_per_mm * arc_length,
                             arc.direction == ArcDirection::Arc_Dir_CCW,
-                            GCodeWriter::full_gcode_comment ? description : "", path.is_force_no_extrusion());
+                            line_comment, path.is_force_no_extrusion());
                         break;
                     }
                     default:
@@ -5084,6 +5179,8 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
         Vec2d prev = this->point_to_gcode_quantized(new_points[0].p);
         bool pre_fan_enabled = false;
         bool cur_fan_enabled = false;
+        const std::string &line_comment = GCodeWriter::full_gcode_comment ? description : empty_comment;
+        gcode.reserve(gcode.size() + new_points.size() * 40);
         if( m_enable_cooling_markers && enable_overhang_bridge_fan)
             pre_fan_enabled = check_overhang_fan(new_points[0].overlap, path.role());
 
@@ -5126,8 +5223,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, std::string description,
                 gcode += m_writer.set_speed(new_speed, "", comment);
                 last_set_speed = new_speed;
             }
-            gcode +=
-                m_writer.extrude_to_xy(p, e_per_mm * line_length, GCodeWriter::full_gcode_comment ? description : "");
+            m_writer.extrude_to_xy(gcode, p, e_per_mm * line_length, line_comment);
 
             prev = p;
 
@@ -5299,7 +5395,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
                 Vec3d dest3d(dest2d(0), dest2d(1), m_nominal_z);
                 gcode += m_writer.travel_to_xyz(dest3d, comment+" travel_to_xyz");
             } else {
-                gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), comment+" travel_to_xy");
+                m_writer.travel_to_xy(gcode, this->point_to_gcode(travel.points[i]), comment+" travel_to_xy");
             }
         }
         this->set_last_pos(travel.points.back());
@@ -0,0 +1,372 @@
+#include "BinaryGCode.hpp"
+#include "../Exception.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include <boost/nowide/cstdio.hpp>
+
+#include <miniz.h>
+
+namespace Slic3r::BinaryGCode {
+
+static constexpr const char     MAGIC[4]      = { 'O', 'B', 'G', 'C' };
+// Magic of the bgcode of libbgcode.
+static constexpr const char     BGCODE_MAGIC[4] = { 'G', 'C', 'D', 'E' };
+static constexpr uint32_t       VERSION       = 1;
+static constexpr uint16_t       CHECKSUM_CRC32 = 1;
+// Metadata are stored as "key=value" lines.
+static constexpr uint16_t       METADATA_ENCODING_INI = 0;
+
+// Characters packed into a single nibble, the 16th nibble value escapes a full character.
+static constexpr const char     NIBBLE_TABLE[15] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '.', ' ', '\n', 'G', 'X' };
+static constexpr uint8_t        NIBBLE_ESCAPE    = 0xF;
+
+static const std::array<uint8_t, 256> s_nibble_lookup = []() {
+    std::array<uint8_t, 256> lookup;
+    lookup.fill(NIBBLE_ESCAPE);
+    for (uint8_t i = 0; i < 15; ++ i)
+        lookup[uint8_t(NIBBLE_TABLE[i])] = i;
+    return lookup;
+}();
+
+std::string pack_nibbles(const std::string &src)
+{
+    std::string out;
+    // Most of the G-code characters are in the table.
+    out.reserve(src.size() * 5 / 8 + 16);
+    uint8_t nibble_lo = 0;
+    bool    has_lo    = false;
+    auto put = [&out, &nibble_lo, &has_lo](uint8_t nibble) {
+        if (has_lo)
+            out.push_back(char(nibble_lo | (nibble << 4)));
+        else
+            nibble_lo = nibble;
+        has_lo = ! has_lo;
+    };
+    for (char c : src) {
+        uint8_t code = s_nibble_lookup[uint8_t(c)];
+        put(code);
+        if (code == NIBBLE_ESCAPE) {
+            put(uint8_t(c) & 0xF);
+            put(uint8_t(c) >> 4);
+        }
+    }
+    if (has_lo)
+        // Pad with an escape, the decoder stops at the decoded size before reading it.
+        out.push_back(char(nibble_lo | (NIBBLE_ESCAPE << 4)));
+    return out;
+}
+
+std::string unpack_nibbles(const std::string &src, size_t decoded_size)
+{
+    std::string out;
+    out.reserve(decoded_size);
+    const size_t num_nibbles = src.size() * 2;
+    size_t       i           = 0;
+    auto get = [&src, &i]() { uint8_t nibble = (uint8_t(src[i >> 1]) >> ((i & 1) * 4)) & 0xF; ++ i; return nibble; };
+    while (out.size() < decoded_size) {
+        if (i == num_nibbles)
+            throw Slic3r::RuntimeError("Binary G-code: truncated nibble packed data");
+        uint8_t nibble = get();
+        if (nibble != NIBBLE_ESCAPE)
+            out.push_back(NIBBLE_TABLE[nibble]);
+        else {
+            if (i + 2 > num_nibbles)
+                throw Slic3r::RuntimeError("Binary G-code: truncated nibble packed data");
+            uint8_t lo = get();
+            uint8_t hi = get();
+            out.push_back(char(lo | (hi << 4)));
+        }
+    }
+    return out;
+}
+
+template<typename T> static void append_le(std::string &out, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++ i)
+        out.push_back(char((uint64_t(value) >> (8 * i)) & 0xFF));
+}
+
+template<typename T> static T read_le(const char *data)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < sizeof(T); ++ i)
+        value |= uint64_t(uint8_t(data[i])) << (8 * i);
+    return T(value);
+}
+
+static std::string encode_metadata(const Metadata &metadata)
+{
+    std::string out;
+    for (const auto &[key, value] : metadata) {
+        out += key;
+        out += '=';
+        out += value;
+        out += '\n';
+    }
+    return out;
+}
+
+static Metadata decode_metadata(const std::string &data)
+{
+    Metadata out;
+    for (size_t begin = 0; begin < data.size();) {
+        size_t end = data.find('\n', begin);
+        if (end == std::string::npos)
+            end = data.size();
+        size_t eq = data.find('=', begin);
+        if (eq < end)
+            out.emplace_back(data.substr(begin, eq - begin), data.substr(eq + 1, end - eq - 1));
+        begin = end + 1;
+    }
+    return out;
+}
+
+static bool has_magic(FILE *file, const char (&expected)[4])
+{
+    char magic[4];
+    long pos = ::ftell(file);
+    bool ret = ::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, expected, sizeof(magic)) == 0;
+    ::fseek(file, pos, SEEK_SET);
+    return ret;
+}
+
+static bool has_magic(const std::string &path, const char (&expected)[4])
+{
+    FILE *file = boost::nowide::fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+    bool ret = has_magic(file, expected);
+    ::fclose(file);
+    return ret;
+}
+
+bool is_binary_gcode(FILE *file) { return has_magic(file, MAGIC); }
+bool is_binary_gcode(const std::string &path) { return has_magic(path, MAGIC); }
+bool is_bgcode(const std::string &path) { return has_magic(path, BGCODE_MAGIC); }
+
+void Writer::open(FILE *file, const BinaryData &data, const Config &config)
+{
+    m_file   = file;
+    m_config = config;
+    m_gcode_buffer.clear();
+    m_gcode_buffer.reserve(gcode_block_size * 2);
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    append_le(header, VERSION);
+    append_le(header, CHECKSUM_CRC32);
+    if (::fwrite(header.data(), 1, header.size(), m_file) != header.size())
+        throw Slic3r::RuntimeError("Binary G-code export failed.\nIs the disk full?\n");
+
+    std::string metadata_params;
+    append_le(metadata_params, METADATA_ENCODING_INI);
+    auto write_metadata = [this, &metadata_params](EBlockType type, const Metadata &metadata) {
+        if (! metadata.empty())
+            this->write_block(type, m_config.metadata_compression, metadata_params, encode_metadata(metadata));
+    };
+    write_metadata(EBlockType::FileMetadata, data.file_metadata);
+    write_metadata(EBlockType::PrinterMetadata, data.printer_metadata);
+    for (const Thumbnail &thumbnail : data.thumbnails) {
+        std::string params;
+        append_le(params, uint16_t(thumbnail.format));
+        append_le(params, thumbnail.width);
+        append_le(params, thumbnail.height);
+        this->write_block(EBlockType::Thumbnail, m_config.thumbnails_compression, params, thumbnail.data);
+    }
+    write_metadata(EBlockType::PrintMetadata, data.print_metadata);
+    write_metadata(EBlockType::SlicerMetadata, data.slicer_metadata);
+}
+
+void Writer::append_gcode(const std::string &gcode)
+{
+    assert(this->is_open());
+    m_gcode_buffer += gcode;
+    // Write blocks of whole lines.
+    const char *begin = m_gcode_buffer.data();
+    const char *end   = begin + m_gcode_buffer.size();
+    while (size_t(end - begin) >= gcode_block_size) {
+        const char *block_end = begin + gcode_block_size;
+        while (block_end != begin && block_end[-1] != '\n')
+            -- block_end;
+        if (block_end == begin) {
+            // A single line longer than a block is written as a whole.
+            block_end = std::find(begin + gcode_block_size, end, '\n');
+            if (block_end == end)
+                // Incomplete line, wait for more data.
+                break;
+            ++ block_end;
+        }
+        this->write_gcode_block(begin, block_end);
+        begin = block_end;
+    }
+    m_gcode_buffer.erase(0, begin - m_gcode_buffer.data());
+}
+
+void Writer::finalize()
+{
+    if (! m_gcode_buffer.empty())
+        this->write_gcode_block(m_gcode_buffer.data(), m_gcode_buffer.data() + m_gcode_buffer.size());
+    m_gcode_buffer.clear();
+    m_file = nullptr;
+}
+
+void Writer::write_gcode_block(const char *begin, const char *end)
+{
+    std::string gcode(begin, end);
+    std::string params;
+    append_le(params, uint16_t(m_config.gcode_encoding));
+    append_le(params, uint32_t(gcode.size()));
+    this->write_block(EBlockType::GCode, m_config.gcode_compression, params,
+        m_config.gcode_encoding == EGCodeEncoding::NibblePacked ? pack_nibbles(gcode) : gcode);
+}
+
+void Writer::write_block(EBlockType type, ECompression compression, const std::string &params, const std::string &data)
+{
+    std::string compressed;
+    if (compression == ECompression::Deflate) {
+        mz_ulong compressed_size = mz_compressBound(mz_ulong(data.size()));
+        compressed.resize(compressed_size);
+        if (mz_compress2((unsigned char*)compressed.data(), &compressed_size, (const unsigned char*)data.data(), mz_ulong(data.size()), MZ_DEFAULT_LEVEL) != MZ_OK)
+            throw Slic3r::RuntimeError("Binary G-code export failed.\nCompression error.\n");
+        if (compressed_size < data.size())
+            compressed.resize(compressed_size);
+        else
+            // Incompressible, store the data as they are.
+            compression = ECompression::None;
+    }
+
+    std::string block;
+    block.reserve(16 + params.size() + (compression == ECompression::None ? data.size() : compressed.size()));
+    append_le(block, uint16_t(type));
+    append_le(block, uint16_t(compression));
+    append_le(block, uint32_t(data.size()));
+    if (compression != ECompression::None)
+        append_le(block, uint32_t(compressed.size()));
+    block += params;
+    block += compression == ECompression::None ? data : compressed;
+    append_le(block, uint32_t(mz_crc32(MZ_CRC32_INIT, (const unsigned char*)block.data(), block.size())));
+    if (::fwrite(block.data(), 1, block.size(), m_file) != block.size())
+        throw Slic3r::RuntimeError("Binary G-code export failed.\nIs the disk full?\n");
+}
+
+Reader::Reader(const std::string &path) : m_path(path)
+{
+    m_file = boost::nowide::fopen(path.c_str(), "rb");
+    if (m_file == nullptr)
+        throw Slic3r::RuntimeError("Binary G-code: cannot open file " + path);
+    char header[sizeof(MAGIC) + 4 + 2];
+    if (::fread(header, 1, sizeof(header), m_file) != sizeof(header) || memcmp(header, MAGIC, sizeof(MAGIC)) != 0)
+        throw Slic3r::RuntimeError("Binary G-code: invalid header of file " + path);
+    if (read_le<uint32_t>(header + 4) != VERSION || read_le<uint16_t>(header + 8) != CHECKSUM_CRC32)
+        throw Slic3r::RuntimeError("Binary G-code: unsupported version of file " + path);
+
+    Block block;
+    while (this->read_block(block)) {
+        switch (block.type) {
+        case EBlockType::FileMetadata:    m_data.file_metadata    = decode_metadata(this->decompress(block)); break;
+        case EBlockType::PrinterMetadata: m_data.printer_metadata = decode_metadata(this->decompress(block)); break;
+        case EBlockType::PrintMetadata:   m_data.print_metadata   = decode_metadata(this->decompress(block)); break;
+        case EBlockType::SlicerMetadata:  m_data.slicer_metadata  = decode_metadata(this->decompress(block)); break;
+        case EBlockType::Thumbnail:
+        {
+            Thumbnail thumbnail;
+            thumbnail.format = EThumbnailFormat(read_le<uint16_t>(block.params.data()));
+            thumbnail.width  = read_le<uint16_t>(block.params.data() + 2);
+            thumbnail.height = read_le<uint16_t>(block.params.data() + 4);
+            thumbnail.data   = this->decompress(block);
+            m_data.thumbnails.emplace_back(std::move(thumbnail));
+            break;
+        }
+        case EBlockType::GCode:
+            m_first_gcode_block     = std::move(block);
+            m_has_first_gcode_block = true;
+            return;
+        }
+    }
+}
+
+Reader::~Reader()
+{
+    if (m_file != nullptr)
+        ::fclose(m_file);
+}
+
+bool Reader::read_block(Block &block)
+{
+    char header[12];
+    size_t cnt = ::fread(header, 1, 8, m_file);
+    if (cnt == 0 && ::feof(m_file))
+        return false;
+    if (cnt != 8)
+        throw Slic3r::RuntimeError("Binary G-code: truncated block in file " + m_path);
+    block.type              = EBlockType(read_le<uint16_t>(header));
+    block.compression       = ECompression(read_le<uint16_t>(header + 2));
+    block.uncompressed_size = read_le<uint32_t>(header + 4);
+    if (block.type > EBlockType::Thumbnail || block.compression > ECompression::Deflate)
+        throw Slic3r::RuntimeError("Binary G-code: invalid block in file " + m_path);
+    size_t header_size = 8;
+    size_t data_size   = block.uncompressed_size;
+    if (block.compression != ECompression::None) {
+        if (::fread(header + 8, 1, 4, m_file) != 4)
+            throw Slic3r::RuntimeError("Binary G-code: truncated block in file " + m_path);
+        header_size = 12;
+        data_size   = read_le<uint32_t>(header + 8);
+    }
+    size_t params_size = block.type == EBlockType::Thumbnail ? 6 : block.type == EBlockType::GCode ? 6 : 2;
+    std::string payload(params_size + data_size + 4, '\0');
+    if (::fread(payload.data(), 1, payload.size(), m_file) != payload.size())
+        throw Slic3r::RuntimeError("Binary G-code: truncated block in file " + m_path);
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, (const unsigned char*)header, header_size);
+    crc = mz_crc32(crc, (const unsigned char*)payload.data(), payload.size() - 4);
+    if (uint32_t(crc) != read_le<uint32_t>(payload.data() + payload.size() - 4))
+        throw Slic3r::RuntimeError("Binary G-code: checksum mismatch in file " + m_path);
+    block.params = payload.substr(0, params_size);
+    block.data   = payload.substr(params_size, data_size);
+    return true;
+}
+
+std::string Reader::decompress(const Block &block) const
+{
+    if (block.compression == ECompression::None)
+        return block.data;
+    std::string out(block.uncompressed_size, '\0');
+    mz_ulong    out_size = block.uncompressed_size;
+    if (mz_uncompress((unsigned char*)out.data(), &out_size, (const unsigned char*)block.data.data(), mz_ulong(block.data.size())) != MZ_OK ||
+        out_size != block.uncompressed_size)
+        throw Slic3r::RuntimeError("Binary G-code: decompression failed in file " + m_path);
+    return out;
+}
+
+void Reader::read_gcode(const std::function<void(const std::string &gcode)> &callback)
+{
+    auto decode = [this](const Block &block) {
+        std::string data     = this->decompress(block);
+        auto        encoding = EGCodeEncoding(read_le<uint16_t>(block.params.data()));
+        size_t      size     = read_le<uint32_t>(block.params.data() + 2);
+        if (encoding == EGCodeEncoding::NibblePacked)
+            return unpack_nibbles(data, size);
+        if (encoding != EGCodeEncoding::None || data.size() != size)
+            throw Slic3r::RuntimeError("Binary G-code: invalid G-code block in file " + m_path);
+        return data;
+    };
+    if (m_has_first_gcode_block) {
+        callback(decode(m_first_gcode_block));
+        m_first_gcode_block     = Block();
+        m_has_first_gcode_block = false;
+    }
+    for (Block block; this->read_block(block);)
+        if (block.type == EBlockType::GCode)
+            callback(decode(block));
+}
+
+std::string Reader::read_gcode()
+{
+    std::string out;
+    this->read_gcode([&out](const std::string &gcode) { out += gcode; });
+    return out;
+}
+
+} // namespace Slic3r::BinaryGCode
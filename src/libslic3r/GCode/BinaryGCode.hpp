@@ -0,0 +1,171 @@
+#ifndef slic3r_GCode_BinaryGCode_hpp_
+#define slic3r_GCode_BinaryGCode_hpp_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Block structured, compressed binary G-code.
+//
+// It is written only when enabled through GCodeProcessor::enable_binary_gcode(), there is no printer option for it
+// and the files are not offered by the file dialogs.
+//
+// The block structure follows the bgcode format of libbgcode, however the file is not a bgcode and it is not
+// readable by the printer firmwares: the magic differs, the G-code block parameters store the size of the decoded
+// G-code and the G-code encoding is a nibble packing of its own instead of MeatPack.
+//
+// File layout:
+//   file header: magic "OBGC", uint32 version, uint16 checksum type (CRC32)
+//   blocks:      file metadata, printer metadata, thumbnails, print metadata, slicer metadata, G-code blocks
+// Block layout:
+//   uint16 type, uint16 compression, uint32 uncompressed size, [uint32 compressed size if compressed],
+//   parameters (metadata: uint16 encoding, G-code: uint16 encoding, uint32 size of the decoded G-code,
+//   thumbnails: uint16 format, uint16 width, uint16 height),
+//   data, uint32 CRC32 of all the preceding bytes of the block.
+// All the numbers are little endian.
+//
+// Metadata are stored as "key=value" lines. The G-code is stored in blocks of whole lines, optionally
+// nibble packed and then deflated. The nibble packing keeps the comments and whitespaces,
+// so that the decoded G-code is byte identical to the text G-code.
+namespace Slic3r::BinaryGCode {
+
+enum class EBlockType : uint16_t
+{
+    FileMetadata,
+    GCode,
+    SlicerMetadata,
+    PrinterMetadata,
+    PrintMetadata,
+    Thumbnail,
+};
+
+enum class ECompression : uint16_t
+{
+    None,
+    Deflate,
+};
+
+enum class EGCodeEncoding : uint16_t
+{
+    None,
+    NibblePacked,
+};
+
+enum class EThumbnailFormat : uint16_t
+{
+    PNG,
+    JPG,
+    QOI,
+};
+
+using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+struct Thumbnail
+{
+    EThumbnailFormat format { EThumbnailFormat::PNG };
+    uint16_t         width  { 0 };
+    uint16_t         height { 0 };
+    std::string      data;
+};
+
+struct BinaryData
+{
+    Metadata               file_metadata;
+    Metadata               printer_metadata;
+    Metadata               print_metadata;
+    Metadata               slicer_metadata;
+    std::vector<Thumbnail> thumbnails;
+
+    void reset() { file_metadata.clear(); printer_metadata.clear(); print_metadata.clear(); slicer_metadata.clear(); thumbnails.clear(); }
+};
+
+struct Config
+{
+    ECompression   metadata_compression   { ECompression::None };
+    ECompression   thumbnails_compression { ECompression::None };
+    ECompression   gcode_compression      { ECompression::Deflate };
+    EGCodeEncoding gcode_encoding         { EGCodeEncoding::None };
+};
+
+// Is the file a binary G-code? Only the magic number is checked.
+bool is_binary_gcode(FILE *file);
+bool is_binary_gcode(const std::string &path);
+// Is the file a bgcode of libbgcode, which is not supported? Only the magic number is checked.
+bool is_bgcode(const std::string &path);
+
+// Packing of the characters most frequent in G-code into 4 bits, other characters are escaped.
+std::string pack_nibbles(const std::string &src);
+// Throws Slic3r::RuntimeError if the data is corrupted.
+std::string unpack_nibbles(const std::string &src, size_t decoded_size);
+
+// Writes a binary G-code into an already open file: the metadata and thumbnails are written by open(),
+// the G-code passed to append_gcode() is buffered and written in blocks of whole lines.
+// Throws Slic3r::RuntimeError on write errors.
+class Writer
+{
+public:
+    // Maximum size of the uncompressed G-code of a single block.
+    static constexpr size_t gcode_block_size = 65536;
+
+    Writer() = default;
+    Writer(const Writer &) = delete;
+    Writer& operator=(const Writer &) = delete;
+
+    void open(FILE *file, const BinaryData &data, const Config &config = Config());
+    void append_gcode(const std::string &gcode);
+    // Write the G-code still buffered.
+    void finalize();
+    bool is_open() const { return m_file != nullptr; }
+
+private:
+    void write_gcode_block(const char *begin, const char *end);
+    void write_block(EBlockType type, ECompression compression, const std::string &params, const std::string &data);
+
+    FILE       *m_file { nullptr };
+    Config      m_config;
+    std::string m_gcode_buffer;
+};
+
+// Reads a binary G-code, verifying the checksums. Throws Slic3r::RuntimeError if the file is not a valid binary G-code.
+class Reader
+{
+public:
+    explicit Reader(const std::string &path);
+    ~Reader();
+    Reader(const Reader &) = delete;
+    Reader& operator=(const Reader &) = delete;
+
+    // All the blocks preceding the G-code, read by the constructor.
+    const BinaryData& data() const { return m_data; }
+    // Decode the G-code blocks one by one. The callback receives whole lines of G-code.
+    void              read_gcode(const std::function<void(const std::string &gcode)> &callback);
+    // Decode the whole G-code.
+    std::string       read_gcode();
+
+private:
+    struct Block
+    {
+        EBlockType   type;
+        ECompression compression;
+        uint32_t     uncompressed_size;
+        std::string  params;
+        std::string  data;
+    };
+    // Returns false at the end of file.
+    bool        read_block(Block &block);
+    std::string decompress(const Block &block) const;
+
+    FILE       *m_file { nullptr };
+    std::string m_path;
+    BinaryData  m_data;
+    // Block read by the constructor after the last block preceding the G-code.
+    Block       m_first_gcode_block;
+    bool        m_has_first_gcode_block { false };
+};
+
+} // namespace Slic3r::BinaryGCode
+
+#endif // slic3r_GCode_BinaryGCode_hpp_
@@ -6,6 +6,7 @@
 #include <map>
 #include <functional>
 #include <atomic>
+#include <numeric>
 
 namespace Slic3r {
 
@@ -89,10 +90,37 @@ inline Grids line_rasterization(const Line &line, int64_t xdist = RasteXDistance
 }
 } // namespace RasterizationImpl
 
+// Sweep line along X over the bounding boxes, marking those which overlap a bounding box with a different id.
+// Lines of the unmarked boxes can't intersect lines of any other object, thus they don't need to be checked at all.
+static std::vector<bool> overlapping_with_other_ids(const std::vector<std::pair<BoundingBox, const void *>> &boxes)
+{
+    std::vector<size_t> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&boxes](size_t l, size_t r) { return boxes[l].first.min.x() < boxes[r].first.min.x(); });
+
+    std::vector<bool>   overlapping(boxes.size(), false);
+    std::vector<size_t> active;
+    for (size_t i : order) {
+        const BoundingBox &bbox = boxes[i].first;
+        if (!bbox.defined) continue;
+        active.erase(std::remove_if(active.begin(), active.end(), [&boxes, &bbox](size_t j) { return boxes[j].first.max.x() < bbox.min.x(); }), active.end());
+        for (size_t j : active)
+            if (boxes[j].second != boxes[i].second && boxes[j].first.min.y() <= bbox.max.y() && bbox.min.y() <= boxes[j].first.max.y())
+                overlapping[i] = overlapping[j] = true;
+        active.emplace_back(i);
+    }
+    return overlapping;
+}
+
 void LinesBucketQueue::emplace_back_bucket(ExtrusionLayers &&els, const void *objPtr, Point offset)
+{
+    emplace_back_bucket(LinesBucket(std::move(els), objPtr, offset));
+}
+
+void LinesBucketQueue::emplace_back_bucket(LinesBucket &&bucket)
 {
     auto oldSize = line_buckets.capacity();
-    line_buckets.emplace_back(std::move(els), objPtr, offset);
+    line_buckets.emplace_back(std::move(bucket));
     line_bucket_ptr_queue.push(&line_buckets.back());
     auto newSize = line_buckets.capacity();
     if (oldSize != newSize) { // pointers change
@@ -135,18 +163,30 @@ LineWithIDs LinesBucketQueue::getCurLines() const
     return lines;
 }
 
-void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths)
+LinesBucketSlices LinesBucketQueue::getCurSlices() const
 {
-    std::function<void(const ExtrusionEntityCollection *, ExtrusionPaths &)> getExtrusionPathImpl = [&](const ExtrusionEntityCollection *entity, ExtrusionPaths &paths) {
+    LinesBucketSlices slices;
+    for (const LinesBucket &bucket : line_buckets) {
+        if (bucket.valid()) {
+            auto [b, e] = bucket.curRange();
+            slices.push_back({&bucket, b, e});
+        }
+    }
+    return slices;
+}
+
+void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ConstExtrusionPathPtrs &paths)
+{
+    std::function<void(const ExtrusionEntityCollection *, ConstExtrusionPathPtrs &)> getExtrusionPathImpl = [&](const ExtrusionEntityCollection *entity, ConstExtrusionPathPtrs &paths) {
         for (auto entityPtr : entity->entities) {
             if (const ExtrusionEntityCollection *collection = dynamic_cast<ExtrusionEntityCollection *>(entityPtr)) {
                 getExtrusionPathImpl(collection, paths);
             } else if (const ExtrusionPath *path = dynamic_cast<ExtrusionPath *>(entityPtr)) {
-                paths.push_back(*path);
+                paths.push_back(path);
             } else if (const ExtrusionMultiPath *multipath = dynamic_cast<ExtrusionMultiPath *>(entityPtr)) {
-                for (const ExtrusionPath &path : multipath->paths) { paths.push_back(path); }
+                for (const ExtrusionPath &path : multipath->paths) { paths.push_back(&path); }
             } else if (const ExtrusionLoop *loop = dynamic_cast<ExtrusionLoop *>(entityPtr)) {
-                for (const ExtrusionPath &path : loop->paths) { paths.push_back(path); }
+                for (const ExtrusionPath &path : loop->paths) { paths.push_back(&path); }
             }
         }
     };
@@ -185,7 +225,7 @@ ObjectExtrusions getAllLayersExtrusionPathsFromObject(PrintObject *obj)
 
     for (auto layerPtr : obj->layers()) {
         auto perimeters = getExtrusionPathsFromLayer(layerPtr->regions());
-        oe.perimeters.insert(oe.perimeters.end(), perimeters.begin(), perimeters.end());
+        oe.perimeters.insert(oe.perimeters.end(), std::make_move_iterator(perimeters.begin()), std::make_move_iterator(perimeters.end()));
     }
 
     for (auto supportLayerPtr : obj->support_layers()) { oe.support.push_back(getExtrusionPathsFromSupportLayer(supportLayerPtr)); }
@@ -213,56 +253,92 @@ ConflictComputeOpt ConflictChecker::find_inter_of_lines(const LineWithIDs &lines
     return {};
 }
 
+ConflictComputeOpt ConflictChecker::find_inter_of_slices(const LinesBucketSlices &slices)
+{
+    // Generate the lines of this layer only, and only of those buckets, which overlap a bucket of another object in this layer.
+    std::vector<LineWithIDs>                           slice_lines(slices.size());
+    std::vector<std::pair<BoundingBox, const void *>> slice_bboxes(slices.size());
+    for (size_t i = 0; i < slices.size(); ++i)
+        slice_bboxes[i] = {slices[i].bucket->appendLines(slices[i].begin, slices[i].end, slice_lines[i]), slices[i].bucket->_id};
+
+    std::vector<bool> overlapping = overlapping_with_other_ids(slice_bboxes);
+    LineWithIDs       lines;
+    for (size_t i = 0; i < slices.size(); ++i)
+        if (overlapping[i])
+            append(lines, std::move(slice_lines[i]));
+    return find_inter_of_lines(lines);
+}
+
 ConflictResultOpt ConflictChecker::find_inter_of_lines_in_diff_objs(PrintObjectPtrs                      objs,
                                                                     std::optional<const FakeWipeTower *> wtdptr) // find the first intersection point of lines in different objects
 {
     if (objs.size() <= 1 && !wtdptr) { return {}; }
-    LinesBucketQueue conflictQueue;
+    std::vector<LinesBucket> buckets;
+    // Owns the fake wipe tower paths referenced by the wipe tower bucket.
+    std::vector<ExtrusionPaths> wtpaths;
     if (wtdptr.has_value()) { // wipe tower at 0 by default
-        auto            wtpaths = wtdptr.value()->getFakeExtrusionPathsFromWipeTower();
+        wtpaths = wtdptr.value()->getFakeExtrusionPathsFromWipeTower();
         ExtrusionLayers wtels;
         wtels.type = ExtrusionLayersType::WIPE_TOWER;
         for (int i = 0; i < wtpaths.size(); ++i) { // assume that wipe tower always has same height
             ExtrusionLayer el;
-            el.paths    = wtpaths[i];
+            for (const ExtrusionPath &path : wtpaths[i]) { el.paths.push_back(&path); }
             el.bottom_z = wtpaths[i].front().height * (float) i;
             el.layer    = nullptr;
-            wtels.push_back(el);
+            wtels.push_back(std::move(el));
         }
-        conflictQueue.emplace_back_bucket(std::move(wtels), wtdptr.value(), {wtdptr.value()->plate_origin.x(), wtdptr.value()->plate_origin.y()});
+        Point wtoffset = {wtdptr.value()->plate_origin.x(), wtdptr.value()->plate_origin.y()};
+        buckets.emplace_back(std::move(wtels), wtdptr.value(), wtoffset);
     }
     for (PrintObject *obj : objs) {
         auto layers = getAllLayersExtrusionPathsFromObject(obj);
-        conflictQueue.emplace_back_bucket(std::move(layers.perimeters), obj, obj->instances().front().shift);
-        conflictQueue.emplace_back_bucket(std::move(layers.support), obj, obj->instances().front().shift);
+        buckets.emplace_back(std::move(layers.perimeters), obj, obj->instances().front().shift);
+        buckets.emplace_back(std::move(layers.support), obj, obj->instances().front().shift);
     }
 
-    std::vector<LineWithIDs> layersLines;
-    std::vector<float>       bottomZs;
+    // Only objects whose XY bounding boxes overlap may collide, drop all the others before walking the layers.
+    std::vector<std::pair<BoundingBox, const void *>> bucket_bboxes;
+    for (const LinesBucket &bucket : buckets)
+        bucket_bboxes.emplace_back(bucket._bbox, bucket._id);
+    std::vector<bool> overlapping = overlapping_with_other_ids(bucket_bboxes);
+    LinesBucketQueue  conflictQueue;
+    for (size_t i = 0; i < buckets.size(); ++i)
+        if (overlapping[i])
+            conflictQueue.emplace_back_bucket(std::move(buckets[i]));
+    buckets.clear();
+    if (!conflictQueue.valid()) { return {}; }
+
+    // Only the references to the piles of each layer are collected here, the lines are generated on the fly
+    // by the parallel check below, so the extrusion lines of the whole plate are never held in memory at once.
+    std::vector<LinesBucketSlices> layersSlices;
+    std::vector<float>             bottomZs;
     while (conflictQueue.valid()) {
-        LineWithIDs lines = conflictQueue.getCurLines();
+        LinesBucketSlices slices = conflictQueue.getCurSlices();
         float curBottomZ = conflictQueue.getCurrBottomZ();
         bottomZs.push_back(curBottomZ);
-        layersLines.push_back(std::move(lines));
+        layersSlices.push_back(std::move(slices));
     }
 
-    bool                                                          find = false;
-    tbb::concurrent_vector<std::pair<ConflictComputeResult, float>> conflict;
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersLines.size()), [&](tbb::blocked_range<size_t> range) {
-        for (size_t i = range.begin(); i < range.end(); i++) {
-            auto interRes = find_inter_of_lines(layersLines[i]);
+    // Report the lowest conflicting layer. Layers above an already found conflict are skipped.
+    std::atomic<size_t>                                             lowest_conflict_layer(layersSlices.size());
+    tbb::concurrent_vector<std::pair<ConflictComputeResult, size_t>> conflict;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layersSlices.size()), [&](tbb::blocked_range<size_t> range) {
+        for (size_t i = range.begin(); i < range.end() && i < lowest_conflict_layer; i++) {
+            auto interRes = find_inter_of_slices(layersSlices[i]);
             if (interRes.has_value()) {
-                find = true;
-                conflict.emplace_back(interRes.value(), bottomZs[i]);
+                conflict.emplace_back(interRes.value(), i);
+                for (size_t lowest = lowest_conflict_layer; i < lowest && !lowest_conflict_layer.compare_exchange_weak(lowest, i);) ;
                 break;
             }
         }
     });
 
+    bool find = !conflict.empty();
     if (find) {
-        const void *ptr1           = conflict[0].first._obj1;
-        const void *ptr2           = conflict[0].first._obj2;
-        float       conflictPrintZ = conflict[0].second;
+        auto it_conflict = std::min_element(conflict.begin(), conflict.end(), [](const auto &l, const auto &r) { return l.second < r.second; });
+        const void *ptr1           = it_conflict->first._obj1;
+        const void *ptr2           = it_conflict->first._obj2;
+        float       conflictPrintZ = bottomZs[it_conflict->second];
         if (wtdptr.has_value()) {
             const FakeWipeTower *wtdp = wtdptr.value();
             if (ptr1 == wtdp || ptr2 == wtdp) {
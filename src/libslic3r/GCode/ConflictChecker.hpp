@@ -23,9 +23,13 @@ struct LineWithID
 
 using LineWithIDs = std::vector<LineWithID>;
 
+// Paths are referenced, not copied: they are owned by the layers of the print objects
+// or by the fake wipe tower paths, which outlive the conflict check.
+using ConstExtrusionPathPtrs = std::vector<const ExtrusionPath *>;
+
 struct ExtrusionLayer
 {
-    ExtrusionPaths paths;
+    ConstExtrusionPathPtrs paths;
     const Layer *  layer;
     float          bottom_z;
     float          height;
@@ -59,9 +63,19 @@ public:
     ExtrusionLayers _piles;
     const void*     _id;
     Point           _offset;
+    // XY bounding box of all the piles, offset included.
+    BoundingBox     _bbox;
 
 public:
-    LinesBucket(ExtrusionLayers &&paths, const void* id, Point offset) : _piles(paths), _id(id), _offset(offset) {}
+    LinesBucket(ExtrusionLayers &&paths, const void* id, Point offset) : _piles(std::move(paths)), _id(id), _offset(offset)
+    {
+        for (const ExtrusionLayer &pile : _piles)
+            for (const ExtrusionPath *path : pile.paths)
+                if (!path->is_force_no_extrusion())
+                    _bbox.merge(get_extents(path->polyline));
+        if (_bbox.defined)
+            _bbox.translate(_offset.x(), _offset.y());
+    }
     LinesBucket(LinesBucket &&) = default;
 
     std::pair<int, int> curRange() const
@@ -83,17 +97,25 @@ public:
     {
         auto [b, e] = curRange();
         LineWithIDs lines;
-        for (int i = b; i < e; ++i) {
-            for (const ExtrusionPath &path : _piles[i].paths) {
-                if (path.is_force_no_extrusion() == false) {
-                    Polyline check_polyline = path.polyline;
+        appendLines(b, e, lines);
+        return lines;
+    }
+    // Append lines of piles [begin, end) to lines, return their bounding box.
+    BoundingBox appendLines(int begin, int end, LineWithIDs &lines) const
+    {
+        BoundingBox bbox;
+        for (int i = begin; i < end; ++i) {
+            for (const ExtrusionPath *path : _piles[i].paths) {
+                if (path->is_force_no_extrusion() == false) {
+                    Polyline check_polyline = path->polyline;
                     check_polyline.translate(_offset);
+                    bbox.merge(get_extents(check_polyline));
                     Lines tmpLines = check_polyline.lines();
-                    for (const Line &line : tmpLines) { lines.emplace_back(line, _id, path.role()); }
+                    for (const Line &line : tmpLines) { lines.emplace_back(line, _id, path->role()); }
                 }
             }
         }
-        return lines;
+        return bbox;
     }
 
     friend bool operator>(const LinesBucket &left, const LinesBucket &right) { return left._curBottomZ > right._curBottomZ; }
@@ -106,6 +128,16 @@ struct LinesBucketPtrComp
     bool operator()(const LinesBucket *left, const LinesBucket *right) { return *left > *right; }
 };
 
+// Piles [begin, end) of a bucket printed at the same bottom z. Lines are generated from it only when its layer gets checked.
+struct LinesBucketSlice
+{
+    const LinesBucket *bucket;
+    int                begin;
+    int                end;
+};
+
+using LinesBucketSlices = std::vector<LinesBucketSlice>;
+
 class LinesBucketQueue
 {
 public:
@@ -114,12 +146,14 @@ public:
 
 public:
     void        emplace_back_bucket(ExtrusionLayers &&els, const void *objPtr, Point offset);
+    void        emplace_back_bucket(LinesBucket &&bucket);
     bool        valid() const { return line_bucket_ptr_queue.empty() == false; }
     float       getCurrBottomZ();
     LineWithIDs getCurLines() const;
+    LinesBucketSlices getCurSlices() const;
 };
 
-void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ExtrusionPaths &paths);
+void getExtrusionPathsFromEntity(const ExtrusionEntityCollection *entity, ConstExtrusionPathPtrs &paths);
 
 ExtrusionLayers getExtrusionPathsFromLayer(const LayerRegionPtrs layerRegionPtrs);
 
@@ -144,6 +178,7 @@ struct ConflictChecker
 {
     static ConflictResultOpt  find_inter_of_lines_in_diff_objs(PrintObjectPtrs objs, std::optional<const FakeWipeTower *> wtdptr);
     static ConflictComputeOpt find_inter_of_lines(const LineWithIDs &lines);
+    static ConflictComputeOpt find_inter_of_slices(const LinesBucketSlices &slices);
     static ConflictComputeOpt line_intersect(const LineWithID &l1, const LineWithID &l2);
 };
 
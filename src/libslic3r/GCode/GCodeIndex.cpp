@@ -0,0 +1,421 @@
+#include "GCodeIndex.hpp"
+#include "../Exception.hpp"
+#include "../PrintConfig.hpp"
+#include "../Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+namespace Slic3r {
+
+static_assert(std::is_trivially_copyable<GCodeIndex::ProcessorState>::value, "GCodeIndex::ProcessorState is stored as is");
+
+static constexpr const char     Index_Magic[8] = { 'O', 'R', 'C', 'A', 'G', 'I', 'D', 'X' };
+static constexpr const uint32_t Index_Version  = 2;
+// Size of the tail of the G-code hashed to detect an index not matching its G-code. The config block is at the end of the G-code.
+static constexpr const size_t   Signature_Tail = 65536;
+
+static bool seek(FILE *f, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(f, int64_t(offset), SEEK_SET) == 0;
+#else
+    return fseeko(f, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+static constexpr const uint64_t Fnv_Offset_Basis = 14695981039346656037ull;
+static constexpr const uint64_t Fnv_Prime        = 1099511628211ull;
+
+static inline uint64_t fnv1a(uint64_t hash, const void *data, size_t size)
+{
+    for (const unsigned char *p = static_cast<const unsigned char*>(data), *end = p + size; p != end; ++ p)
+        hash = (hash ^ *p) * Fnv_Prime;
+    return hash;
+}
+
+// Size of the G-code and FNV-1a hash of its tail.
+static bool gcode_signature(const std::string &gcode_path, uint64_t &size, uint64_t &hash)
+{
+    FilePtr f{ boost::nowide::fopen(gcode_path.c_str(), "rb") };
+    if (f.f == nullptr || fseek(f.f, 0, SEEK_END) != 0)
+        return false;
+#ifdef _WIN32
+    const int64_t end = _ftelli64(f.f);
+#else
+    const int64_t end = int64_t(ftello(f.f));
+#endif
+    if (end < 0)
+        return false;
+    size = uint64_t(end);
+    const uint64_t tail_start = size > Signature_Tail ? size - Signature_Tail : 0;
+    std::vector<unsigned char> tail(size_t(size - tail_start));
+    if (! seek(f.f, tail_start) || fread(tail.data(), 1, tail.size(), f.f) != tail.size())
+        return false;
+    hash = fnv1a(Fnv_Offset_Basis, tail.data(), tail.size());
+    return true;
+}
+
+void GCodeIndex::add_line_end(uint64_t offset)
+{
+    if (++ m_lines_count % LinesStride == 0)
+        m_line_starts.emplace_back(offset);
+    m_file_size = offset;
+}
+
+void GCodeIndex::finish_lines(uint64_t file_size)
+{
+    assert(file_size >= m_file_size);
+    if (file_size > m_file_size)
+        // The last line has no line end.
+        ++ m_lines_count;
+    m_file_size = file_size;
+}
+
+void GCodeIndex::add_move_line(uint32_t line)
+{
+    if (m_moves_count % MovesStride == 0) {
+        m_move_lines.emplace_back(line);
+        m_move_deltas_offsets.emplace_back(m_move_deltas.size());
+    } else {
+        const int64_t delta = int64_t(line) - int64_t(m_last_move_line);
+        uint64_t zigzag = delta < 0 ? (uint64_t(-delta) << 1) - 1 : uint64_t(delta) << 1;
+        for (; zigzag >= 0x80; zigzag >>= 7)
+            m_move_deltas.emplace_back(uint8_t(zigzag | 0x80));
+        m_move_deltas.emplace_back(uint8_t(zigzag));
+    }
+    m_last_move_line = line;
+    ++ m_moves_count;
+}
+
+void GCodeIndex::clear_moves()
+{
+    m_moves_count    = 0;
+    m_last_move_line = 0;
+    m_move_lines.clear();
+    m_move_deltas_offsets.clear();
+    m_move_deltas.clear();
+}
+
+uint32_t GCodeIndex::move_line(size_t move_id) const
+{
+    if (move_id >= m_moves_count)
+        return 0;
+    const size_t   checkpoint = move_id / MovesStride;
+    int64_t        line       = m_move_lines[checkpoint];
+    const uint8_t *p          = m_move_deltas.data() + m_move_deltas_offsets[checkpoint];
+    const uint8_t *end        = m_move_deltas.data() + m_move_deltas.size();
+    for (size_t i = checkpoint * MovesStride; i < move_id; ++ i) {
+        uint64_t zigzag = 0;
+        for (int shift = 0;; shift += 7) {
+            if (p == end || shift >= 64)
+                // Damaged deltas, treat the move as not indexed.
+                return 0;
+            const uint8_t b = *p ++;
+            zigzag |= uint64_t(b & 0x7f) << shift;
+            if ((b & 0x80) == 0)
+                break;
+        }
+        line += (zigzag & 1) ? - int64_t((zigzag + 1) >> 1) : int64_t(zigzag >> 1);
+    }
+    return uint32_t(line);
+}
+
+size_t GCodeIndex::line_layer(size_t line) const
+{
+    auto it = std::upper_bound(m_layers.begin(), m_layers.end(), line, [](size_t line, const Layer &layer) { return line < layer.first_line; });
+    return it == m_layers.begin() ? 0 : size_t(it - m_layers.begin()) - 1;
+}
+
+uint64_t GCodeIndex::line_offset(FILE *gcode_file, size_t line) const
+{
+    assert(line > 0);
+    if (line > m_lines_count)
+        return m_file_size;
+    const size_t checkpoint = (line - 1) / LinesStride;
+    size_t       to_skip    = (line - 1) % LinesStride;
+    uint64_t     offset     = m_line_starts[checkpoint];
+    if (to_skip == 0)
+        return offset;
+    if (! seek(gcode_file, offset))
+        throw Slic3r::RuntimeError("Failed to seek in the G-code file.");
+    char buffer[16384];
+    for (;;) {
+        const size_t cnt = fread(buffer, 1, sizeof(buffer), gcode_file);
+        if (cnt == 0)
+            throw Slic3r::RuntimeError("The G-code file does not match its index.");
+        for (size_t i = 0; i < cnt; ++ i)
+            if (buffer[i] == '\n' && -- to_skip == 0)
+                return offset + i + 1;
+        offset += cnt;
+    }
+}
+
+std::string GCodeIndex::read_lines(const std::string &gcode_path, size_t first_line, size_t count) const
+{
+    std::string out;
+    this->read_lines(gcode_path, first_line, first_line + count, [&out](const std::string &lines) { out += lines; });
+    return out;
+}
+
+void GCodeIndex::read_lines(const std::string &gcode_path, size_t first_line, size_t end_line, const std::function<void(const std::string&)> &callback) const
+{
+    first_line = std::max<size_t>(first_line, 1);
+    end_line   = std::min<size_t>(end_line, m_lines_count + 1);
+    if (first_line >= end_line)
+        return;
+    FilePtr f{ boost::nowide::fopen(gcode_path.c_str(), "rb") };
+    if (f.f == nullptr)
+        throw Slic3r::RuntimeError("Failed to open the G-code file " + gcode_path);
+    const uint64_t end    = this->line_offset(f.f, end_line);
+    uint64_t       offset = this->line_offset(f.f, first_line);
+    if (! seek(f.f, offset))
+        throw Slic3r::RuntimeError("Failed to read the G-code file " + gcode_path);
+    // Read 4MB at a time, pass the whole lines read, keep the rest for the next chunk.
+    static constexpr size_t chunk_size = 4 << 20;
+    std::string chunk;
+    std::string rest;
+    while (offset < end) {
+        const size_t cnt = size_t(std::min<uint64_t>(chunk_size, end - offset));
+        chunk.swap(rest);
+        const size_t rest_size = chunk.size();
+        chunk.resize(rest_size + cnt);
+        if (fread(chunk.data() + rest_size, 1, cnt, f.f) != cnt)
+            throw Slic3r::RuntimeError("Failed to read the G-code file " + gcode_path);
+        offset += cnt;
+        rest.clear();
+        if (offset < end) {
+            const size_t last_eol = chunk.rfind('\n');
+            if (last_eol == std::string::npos) {
+                // A line longer than the chunk.
+                rest.swap(chunk);
+                continue;
+            }
+            rest.assign(chunk, last_eol + 1, std::string::npos);
+            chunk.resize(last_eol + 1);
+        }
+        callback(chunk);
+    }
+}
+
+bool GCodeIndex::load_config(const std::string &gcode_path, DynamicPrintConfig &config) const
+{
+    if (m_config_end <= m_config_begin)
+        return false;
+    FilePtr f{ boost::nowide::fopen(gcode_path.c_str(), "rb") };
+    std::string block(size_t(m_config_end - m_config_begin), '\0');
+    if (f.f == nullptr || ! seek(f.f, m_config_begin) || fread(block.data(), 1, block.size(), f.f) != block.size())
+        throw Slic3r::RuntimeError("Failed to read the config of the G-code file " + gcode_path);
+    // Same as ConfigBase::load_from_gcode_file(): each line is a "; key = value" pair, unknown keys are ignored.
+    config.apply(FullPrintConfig::defaults());
+    ConfigSubstitutionContext substitutions_ctxt(ForwardCompatibilitySubstitutionRule::EnableSilent);
+    std::string key, value;
+    for (size_t begin = 0; begin < block.size();) {
+        size_t end = block.find('\n', begin);
+        if (end == std::string::npos)
+            end = block.size();
+        const std::string_view line(block.data() + begin, end - begin);
+        const size_t pos = line.find('=');
+        if (pos != std::string_view::npos && pos > 1 && line.front() == ';') {
+            key   = std::string(line.substr(1, pos - 1));
+            value = std::string(line.substr(pos + 1));
+            boost::trim(key);
+            boost::trim(value);
+            try {
+                config.set_deserialize(key, value, substitutions_ctxt);
+            } catch (UnknownOptionException & /* e */) {
+                // ignore
+            }
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+namespace {
+
+// The data following the magic are hashed by FNV-1a, the hash is stored at the end of the index.
+struct Writer
+{
+    FILE    *f;
+    bool     ok   { true };
+    uint64_t hash { Fnv_Offset_Basis };
+
+    template<typename T> void pod(const T &value) {
+        ok &= fwrite(&value, sizeof(T), 1, f) == 1;
+        hash = fnv1a(hash, &value, sizeof(T));
+    }
+    template<typename T> void vec(const std::vector<T> &v) {
+        this->pod(uint64_t(v.size()));
+        if (! v.empty()) {
+            ok &= fwrite(v.data(), sizeof(T), v.size(), f) == v.size();
+            hash = fnv1a(hash, v.data(), sizeof(T) * v.size());
+        }
+    }
+    void checksum() { uint64_t value = hash; ok &= fwrite(&value, sizeof(value), 1, f) == 1; }
+};
+
+struct Reader
+{
+    FILE    *f;
+    bool     ok   { true };
+    uint64_t hash { Fnv_Offset_Basis };
+
+    template<typename T> void pod(T &value) {
+        ok = ok && fread(&value, sizeof(T), 1, f) == 1;
+        if (ok)
+            hash = fnv1a(hash, &value, sizeof(T));
+    }
+    template<typename T> void vec(std::vector<T> &v) {
+        uint64_t size = 0;
+        this->pod(size);
+        // Sanity check against a damaged file: no vector is bigger than 4G items.
+        ok = ok && size < (uint64_t(1) << 32);
+        if (ok) {
+            v.resize(size_t(size));
+            ok = v.empty() || fread(v.data(), sizeof(T), v.size(), f) == v.size();
+            if (ok)
+                hash = fnv1a(hash, v.data(), sizeof(T) * v.size());
+        }
+    }
+    // Compare the hash of the data read against the hash stored at the end of the index.
+    void checksum() {
+        uint64_t value = 0;
+        ok = ok && fread(&value, sizeof(value), 1, f) == 1 && value == hash;
+    }
+};
+
+} // namespace
+
+void GCodeIndex::save(const std::string &path, const std::string &gcode_path) const
+{
+    uint64_t gcode_size = 0;
+    uint64_t gcode_hash = 0;
+    if (! gcode_signature(gcode_path, gcode_size, gcode_hash))
+        throw Slic3r::RuntimeError("Failed to read the G-code file " + gcode_path + " to be indexed.");
+    FilePtr f{ boost::nowide::fopen(path.c_str(), "wb") };
+    if (f.f == nullptr)
+        throw Slic3r::RuntimeError("Failed to create the G-code index " + path);
+    Writer w{ f.f };
+    w.ok = fwrite(Index_Magic, 1, sizeof(Index_Magic), f.f) == sizeof(Index_Magic);
+    w.pod(Index_Version);
+    w.pod(uint32_t(sizeof(ProcessorState)));
+    w.pod(gcode_size);
+    w.pod(gcode_hash);
+    w.pod(m_lines_count);
+    w.pod(m_file_size);
+    w.pod(m_config_begin);
+    w.pod(m_config_end);
+    w.vec(m_line_starts);
+    w.pod(uint64_t(m_layers.size()));
+    for (const Layer &layer : m_layers) {
+        w.pod(layer.first_line);
+        w.pod(layer.first_move);
+        w.pod(layer.duration);
+        w.pod(layer.state);
+        w.vec(layer.extruder_temps);
+        w.vec(layer.extruder_colors);
+    }
+    w.pod(m_moves_count);
+    w.vec(m_move_lines);
+    w.vec(m_move_deltas_offsets);
+    w.vec(m_move_deltas);
+    w.pod(m_last_move_line);
+    w.checksum();
+    f.close();
+    if (! w.ok) {
+        boost::nowide::remove(path.c_str());
+        throw Slic3r::RuntimeError("Failed to write the G-code index " + path + "\nIs the disk full?\n");
+    }
+}
+
+// The values are verified before being used to index the vectors of the index or to restore the processor state,
+// the checksum does not protect against an index written by a buggy or a malicious writer.
+bool GCodeIndex::valid(uint64_t gcode_size) const
+{
+    if (m_file_size != gcode_size || m_line_starts.empty() || m_config_begin > m_config_end || m_config_end > gcode_size ||
+        (m_lines_count > 0 && (m_lines_count - 1) / LinesStride >= m_line_starts.size()) ||
+        ! std::is_sorted(m_line_starts.begin(), m_line_starts.end()) || m_line_starts.back() > gcode_size)
+        return false;
+    for (size_t i = 0; i < m_layers.size(); ++ i) {
+        const Layer &layer = m_layers[i];
+        // GCodeProcessor::restore_gcode_index_layer() resumes after the move preceding the first move of the layer,
+        // the first move is the dummy move.
+        if (layer.first_line < 1 || layer.first_line > m_lines_count + 1 || layer.first_move < 1 ||
+            (i > 0 && (layer.first_line < m_layers[i - 1].first_line || layer.first_move < m_layers[i - 1].first_move)))
+            return false;
+    }
+    if (m_move_lines.size() != (m_moves_count + MovesStride - 1) / MovesStride ||
+        m_move_deltas_offsets.size() != m_move_lines.size() ||
+        ! std::is_sorted(m_move_deltas_offsets.begin(), m_move_deltas_offsets.end()) ||
+        (! m_move_deltas_offsets.empty() && m_move_deltas_offsets.back() > m_move_deltas.size()))
+        return false;
+    return true;
+}
+
+std::unique_ptr<GCodeIndex> GCodeIndex::load(const std::string &path, const std::string &gcode_path)
+{
+    FilePtr f{ boost::nowide::fopen(path.c_str(), "rb") };
+    if (f.f == nullptr)
+        return nullptr;
+    Reader   r{ f.f };
+    char     magic[sizeof(Index_Magic)];
+    uint32_t version = 0;
+    uint32_t sizeof_state = 0;
+    uint64_t gcode_size = 0;
+    uint64_t gcode_hash = 0;
+    r.ok = fread(magic, 1, sizeof(magic), f.f) == sizeof(magic) && memcmp(magic, Index_Magic, sizeof(magic)) == 0;
+    r.pod(version);
+    r.pod(sizeof_state);
+    r.pod(gcode_size);
+    r.pod(gcode_hash);
+    if (! r.ok || version != Index_Version || sizeof_state != sizeof(ProcessorState)) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring the G-code index " << path << " of an unknown format";
+        return nullptr;
+    }
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    if (! gcode_signature(gcode_path, size, hash) || size != gcode_size || hash != gcode_hash) {
+        BOOST_LOG_TRIVIAL(info) << "Ignoring the G-code index " << path << ", the G-code " << gcode_path << " was modified";
+        return nullptr;
+    }
+    auto     index = std::make_unique<GCodeIndex>();
+    uint64_t num_layers = 0;
+    r.pod(index->m_lines_count);
+    r.pod(index->m_file_size);
+    r.pod(index->m_config_begin);
+    r.pod(index->m_config_end);
+    r.vec(index->m_line_starts);
+    r.pod(num_layers);
+    r.ok = r.ok && num_layers < (uint64_t(1) << 32);
+    if (r.ok) {
+        index->m_layers.resize(size_t(num_layers));
+        for (Layer &layer : index->m_layers) {
+            r.pod(layer.first_line);
+            r.pod(layer.first_move);
+            r.pod(layer.duration);
+            r.pod(layer.state);
+            r.vec(layer.extruder_temps);
+            r.vec(layer.extruder_colors);
+        }
+    }
+    r.pod(index->m_moves_count);
+    r.vec(index->m_move_lines);
+    r.vec(index->m_move_deltas_offsets);
+    r.vec(index->m_move_deltas);
+    r.pod(index->m_last_move_line);
+    r.checksum();
+    if (! r.ok || ! index->valid(gcode_size)) {
+        BOOST_LOG_TRIVIAL(warning) << "Ignoring the damaged G-code index " << path;
+        return nullptr;
+    }
+    return index;
+}
+
+} // namespace Slic3r
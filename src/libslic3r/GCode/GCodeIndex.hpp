@@ -0,0 +1,147 @@
+#ifndef slic3r_GCode_GCodeIndex_hpp_
+#define slic3r_GCode_GCodeIndex_hpp_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Random access index of a text G-code, written next to the exported G-code (see GCodeIndex::path_for()),
+// so that a window of lines or the moves of a range of layers may be loaded without parsing the whole file.
+// The index contains:
+//  - the file offset of every LinesStride-th line, a line is found by reading at most LinesStride lines,
+//  - the state of the G-code processor at the start of each layer, GCodeProcessor::process_layers() resumes parsing there,
+//  - the line of each move (GCodeProcessorResult::MoveVertex::gcode_id), delta encoded with a full value every MovesStride moves.
+// The lines are numbered from 1 as in GCodeProcessorResult::MoveVertex::gcode_id, the moves from 0 including the dummy first move.
+namespace Slic3r {
+
+class DynamicPrintConfig;
+
+class GCodeIndex
+{
+public:
+    static constexpr size_t LinesStride = 128;
+    static constexpr size_t MovesStride = 128;
+
+    // Part of the GCodeProcessor state modified by the G-code itself, captured before the first line of a layer is processed.
+    // The state derived from the print config is restored by loading the config from the G-code.
+    // Stored into the index file as is, the index is a cache of the G-code on the same machine.
+    struct ProcessorState
+    {
+        uint8_t               units                            { 0 };
+        uint8_t               global_positioning_type          { 0 };
+        uint8_t               e_local_positioning_type         { 0 };
+        uint8_t               extrusion_role                   { 0 };
+        uint8_t               extruder_id                      { 0 };
+        uint8_t               last_extruder_id                 { 0 };
+        uint8_t               cp_color_counter                 { 0 };
+        uint8_t               cp_color_current                 { 0 };
+        uint8_t               wiping                           { 0 };
+        uint8_t               flushing                         { 0 };
+        uint8_t               wipe_tower                       { 0 };
+        uint8_t               spiral_vase_active               { 0 };
+        uint8_t               processing_start_custom_gcode    { 0 };
+        uint8_t               seams_detector_active            { 0 };
+        uint8_t               seams_detector_has_first_vertex  { 0 };
+        double                end_position[4]                  { 0., 0., 0., 0. };
+        double                origin[4]                        { 0., 0., 0., 0. };
+        double                cached_position[4]               { 0., 0., 0., 0. };
+        float                 cached_feedrate                  { 0.f };
+        float                 seams_detector_first_vertex[3]   { 0.f, 0.f, 0.f };
+        // Position of the last move, referenced by the seams detector.
+        float                 last_move_position[3]            { 0.f, 0.f, 0.f };
+        float                 feedrate                         { 0.f };
+        float                 width                            { 0.f };
+        float                 height                           { 0.f };
+        float                 forced_width                     { 0.f };
+        float                 forced_height                    { 0.f };
+        float                 mm3_per_mm                       { 0.f };
+        float                 fan_speed                        { 0.f };
+        float                 extruded_last_z                  { 0.f };
+        float                 remaining_volume                 { 0.f };
+        uint32_t              last_line_id                     { 0 };
+        uint32_t              g1_line_id                       { 0 };
+        uint32_t              last_default_color_id            { 0 };
+    };
+
+    struct Layer
+    {
+        // First line of the layer, the line following the layer change.
+        uint32_t              first_line { 1 };
+        // Index of the first move of the layer.
+        uint64_t              first_move { 0 };
+        // Layer time in the normal mode as stored into GCodeProcessorResult::MoveVertex::layer_duration, seconds.
+        float                 duration   { 0.f };
+        ProcessorState        state;
+        // Per extruder part of the processor state.
+        std::vector<float>    extruder_temps;
+        std::vector<uint8_t>  extruder_colors;
+    };
+
+    // Index file of a G-code file.
+    static std::string path_for(const std::string &gcode_path) { return gcode_path + ".index"; }
+
+    // Write the index of gcode_path into path. Throws Slic3r::RuntimeError on failure.
+    void save(const std::string &path, const std::string &gcode_path) const;
+    // Load the index from path. Returns nullptr if the file does not exist, is damaged or if it does not match the G-code file.
+    static std::unique_ptr<GCodeIndex> load(const std::string &path, const std::string &gcode_path);
+
+    size_t                lines_count() const { return m_lines_count; }
+    size_t                moves_count() const { return m_moves_count; }
+    // Layer 0 contains the moves preceding the first layer change, the layers are numbered as GCodeProcessor::m_layer_id.
+    const std::vector<Layer>& layers() const { return m_layers; }
+    // Line of a move. Returns 0 if the moves were not indexed.
+    uint32_t              move_line(size_t move_id) const;
+    // Layer containing a line.
+    size_t                line_layer(size_t line) const;
+    // File offset of the start of a line of the G-code, lines_count() + 1 for the end of the file.
+    // Throws Slic3r::RuntimeError if the file cannot be read.
+    uint64_t              line_offset(FILE *gcode_file, size_t line) const;
+    // Read the lines [first_line, first_line + count) including their line ends. Throws Slic3r::RuntimeError on failure.
+    std::string           read_lines(const std::string &gcode_path, size_t first_line, size_t count) const;
+    // Load the config block of the G-code found by the export, so that the G-code is not searched for it.
+    // Returns false if the G-code has no config block. Throws Slic3r::RuntimeError if the G-code cannot be read.
+    bool                  load_config(const std::string &gcode_path, DynamicPrintConfig &config) const;
+    // Read the lines [first_line, end_line) in chunks of whole lines passed to callback. Throws Slic3r::RuntimeError on failure.
+    void                  read_lines(const std::string &gcode_path, size_t first_line, size_t end_line, const std::function<void(const std::string&)> &callback) const;
+
+    // Filled in by the GCodeProcessor.
+    void                  add_layer(Layer &&layer) { m_layers.emplace_back(std::move(layer)); }
+    std::vector<Layer>&   layers_mutable() { return m_layers; }
+    // Called with the file offset following each line end written into the G-code, in order.
+    void                  add_line_end(uint64_t offset);
+    // Called with the size of the G-code file once all the line ends were added. Counts the last line without a line end.
+    void                  finish_lines(uint64_t file_size);
+    // Called with the line of each move, in order.
+    void                  add_move_line(uint32_t line);
+    // Drop the lines of the moves if not all the moves were indexed.
+    void                  clear_moves();
+    // File offsets of the lines between "; CONFIG_BLOCK_START" and "; CONFIG_BLOCK_END".
+    void                  set_config_block(uint64_t begin, uint64_t end) { m_config_begin = begin; m_config_end = end; }
+
+private:
+    // Are the values loaded from an index file consistent with each other and with the G-code?
+    bool                  valid(uint64_t gcode_size) const;
+
+    uint64_t              m_lines_count     { 0 };
+    uint64_t              m_file_size       { 0 };
+    uint64_t              m_config_begin    { 0 };
+    uint64_t              m_config_end      { 0 };
+    // Offset of the lines 1, LinesStride + 1, 2 * LinesStride + 1...
+    std::vector<uint64_t> m_line_starts     { 0 };
+    std::vector<Layer>    m_layers;
+    uint64_t              m_moves_count     { 0 };
+    // Line of the moves 0, MovesStride, 2 * MovesStride... and the offset of the following move into m_move_deltas.
+    std::vector<uint32_t> m_move_lines;
+    std::vector<uint64_t> m_move_deltas_offsets;
+    // Zig-zag LEB128 encoded differences of the lines of the consecutive moves. The lines of the moves are not monotonic,
+    // the moves marking a color change or a pause are moved after the next Z move.
+    std::vector<uint8_t>  m_move_deltas;
+    uint32_t              m_last_move_line  { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_GCodeIndex_hpp_
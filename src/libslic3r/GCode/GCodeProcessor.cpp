@@ -5,13 +5,17 @@
 #include "libslic3r/Print.hpp"
 #include "libslic3r/LocalesUtils.hpp"
 #include "libslic3r/format.hpp"
+#include "libslic3r/Trace.hpp"
 #include "GCodeProcessor.hpp"
+#include "GCodeIndex.hpp"
+#include "MovesSpill.hpp"
 
 #include <boost/log/trivial.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include <fast_float/fast_float.h>
@@ -67,7 +71,8 @@ const std::vector<std::string> GCodeProcessor::Reserved_Tags = {
     " MANUAL_TOOL_CHANGE ",
     "_DURING_PRINT_EXHAUST_FAN",
     " WIPE_TOWER_START",
-    " WIPE_TOWER_END"
+    " WIPE_TOWER_END",
+    "_GP_THUMBNAILS_PLACEHOLDER"
 };
 
 const std::vector<std::string> GCodeProcessor::Reserved_Tags_compatible = {
@@ -87,7 +92,8 @@ const std::vector<std::string> GCodeProcessor::Reserved_Tags_compatible = {
     " MANUAL_TOOL_CHANGE ",
     "_DURING_PRINT_EXHAUST_FAN",
     " WIPE_TOWER_START",
-    " WIPE_TOWER_END"
+    " WIPE_TOWER_END",
+    "_GP_THUMBNAILS_PLACEHOLDER"
 };
 
 
@@ -389,7 +395,7 @@ void GCodeProcessor::TimeProcessor::reset()
     machine_limits = MachineEnvelopeConfig();
     filament_load_times = 0.0f;
     filament_unload_times = 0.0f;
-
+    thumbnails_gcode.clear();
 
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
         machines[i].reset();
@@ -397,7 +403,8 @@ void GCodeProcessor::TimeProcessor::reset()
     machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].enabled = true;
 }
 
-void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, std::vector<GCodeProcessorResult::MoveVertex>& moves, std::vector<size_t>& lines_ends, size_t total_layer_num)
+void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, const std::string& out_filename, std::vector<GCodeProcessorResult::MoveVertex>& moves,
+    MovesSpill* moves_spill, std::vector<size_t>* lines_ends, GCodeIndex* index, size_t total_layer_num, const BinaryGCode::BinaryData* binary_data)
 {
     FilePtr in{ boost::nowide::fopen(filename.c_str(), "rb") };
     if (in.f == nullptr)
@@ -406,13 +413,26 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
     const bool disable_m73 = this->disable_m73;
 
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ <<  boost::format(":  before process %1%")%filename.c_str();
-    // temporary file to contain modified gcode
-    std::string out_path = filename + ".postprocess";
+    // temporary file to contain modified gcode, unless the modified gcode is streamed into its final destination
+    const bool  in_place = out_filename.empty();
+    std::string out_path = in_place ? filename + ".postprocess" : out_filename;
     FilePtr out{ boost::nowide::fopen(out_path.c_str(), "wb") };
     if (out.f == nullptr) {
         throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nCannot open file for writing.\n"));
     }
 
+    // The binary G-code starts with the metadata and thumbnails, the G-code blocks follow.
+    BinaryGCode::Writer binary_writer;
+    if (binary_data != nullptr) {
+        try {
+            binary_writer.open(out.f, *binary_data);
+        } catch (const Slic3r::RuntimeError &) {
+            out.close();
+            boost::nowide::remove(out_path.c_str());
+            throw;
+        }
+    }
+
     auto time_in_minutes = [](float time_in_seconds) {
         assert(time_in_seconds >= 0.f);
         return int((time_in_seconds + 0.5f) / 60.0f);
@@ -536,6 +556,15 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
                 sprintf(buf, "; total layer number: %zd\n", total_layer_num);
                 ret += buf;
             }
+            else if (line == reserved_tag(ETags::Thumbnails_Placeholder)) {
+                if (thumbnails_gcode.empty()) {
+                    // Remove current line
+                    gcode_line = "";
+                    return std::tuple(true, -1);
+                }
+                ret = thumbnails_gcode;
+                extra_lines_count = int(std::count(ret.begin(), ret.end(), '\n'));
+            }
         }
 
         if (! ret.empty())
@@ -640,23 +669,41 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
 
     // helper function to write to disk
     size_t out_file_pos = 0;
-    lines_ends.clear();
-    auto write_string = [&export_line, &out, &out_path, &out_file_pos, &lines_ends](const std::string& str) {
-        fwrite((const void*)export_line.c_str(), 1, export_line.length(), out.f);
-        if (ferror(out.f)) {
+    if (lines_ends != nullptr)
+        lines_ends->clear();
+    auto write_string = [&export_line, &out, &out_path, &out_file_pos, &lines_ends, index, &binary_writer](const std::string& str) {
+        bool failed = false;
+        if (binary_writer.is_open()) {
+            try {
+                binary_writer.append_gcode(export_line);
+            } catch (const Slic3r::RuntimeError &) {
+                failed = true;
+            }
+        } else {
+            fwrite((const void*)export_line.c_str(), 1, export_line.length(), out.f);
+            failed = ferror(out.f);
+        }
+        if (failed) {
             out.close();
             boost::nowide::remove(out_path.c_str());
             throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
         }
-        for (size_t i = 0; i < export_line.size(); ++ i)
-            if (export_line[i] == '\n')
-                lines_ends.emplace_back(out_file_pos + i + 1);
+        if (lines_ends != nullptr || index != nullptr)
+            for (size_t i = 0; i < export_line.size(); ++ i)
+                if (export_line[i] == '\n') {
+                    if (lines_ends != nullptr)
+                        lines_ends->emplace_back(out_file_pos + i + 1);
+                    if (index != nullptr)
+                        index->add_line_end(out_file_pos + i + 1);
+                }
         out_file_pos += export_line.size();
         export_line.clear();
     };
 
     unsigned int line_id = 0;
     std::vector<std::pair<unsigned int, unsigned int>> offsets;
+    // The config block is indexed, so that GCodeProcessor::process_layers() does not search the G-code for it.
+    size_t config_block_begin = 0;
 
     {
         // Read the input stream 64kB at a time, extract lines and process them.
@@ -706,6 +753,14 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
                         offsets.push_back({line_id, -1});
                     }
 
+                    if (index != nullptr && boost::starts_with(gcode_line, "; CONFIG_BLOCK_")) {
+                        const size_t line_pos = out_file_pos + export_line.size();
+                        if (boost::starts_with(gcode_line, "; CONFIG_BLOCK_START"))
+                            config_block_begin = line_pos + gcode_line.size();
+                        else if (config_block_begin > 0 && boost::starts_with(gcode_line, "; CONFIG_BLOCK_END"))
+                            index->set_config_block(config_block_begin, line_pos);
+                    }
+
                     export_line += gcode_line;
                     if (export_line.length() > 65535)
                         write_string(export_line);
@@ -725,23 +780,53 @@ void GCodeProcessor::TimeProcessor::post_process(const std::string& filename, st
 
     if (!export_line.empty())
         write_string(export_line);
+    if (binary_writer.is_open()) {
+        try {
+            binary_writer.finalize();
+        } catch (const Slic3r::RuntimeError &) {
+            out.close();
+            boost::nowide::remove(out_path.c_str());
+            throw Slic3r::RuntimeError(std::string("Time estimator post process export failed.\nIs the disk full?\n"));
+        }
+    }
 
     out.close();
     in.close();
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ <<  boost::format(":  after process %1%")%filename.c_str();
 
+    if (index != nullptr) {
+        index->finish_lines(out_file_pos);
+        // The layers resume parsing after the line changing the layer, the lines inserted in front of the following line are parsed, too.
+        unsigned int curr_offset_id = 0;
+        unsigned int total_offset = 0;
+        for (GCodeIndex::Layer& layer : index->layers_mutable()) {
+            const unsigned int layer_change_line_id = layer.first_line - 1;
+            while (curr_offset_id < static_cast<unsigned int>(offsets.size()) && offsets[curr_offset_id].first <= layer_change_line_id) {
+                total_offset += offsets[curr_offset_id].second;
+                ++curr_offset_id;
+            }
+            layer.first_line = layer_change_line_id + total_offset + 1;
+        }
+    }
+
     // updates moves' gcode ids which have been modified by the insertion of the M73 lines
     unsigned int curr_offset_id = 0;
     unsigned int total_offset = 0;
-    for (GCodeProcessorResult::MoveVertex& move : moves) {
+    auto update_gcode_id = [&offsets, &curr_offset_id, &total_offset, index](GCodeProcessorResult::MoveVertex& move) {
         while (curr_offset_id < static_cast<unsigned int>(offsets.size()) && offsets[curr_offset_id].first <= move.gcode_id) {
             total_offset += offsets[curr_offset_id].second;
             ++curr_offset_id;
         }
         move.gcode_id += total_offset;
-    }
+        if (index != nullptr)
+            index->add_move_line(move.gcode_id);
+    };
+    if (moves_spill != nullptr)
+        moves_spill->update(update_gcode_id);
+    for (GCodeProcessorResult::MoveVertex& move : moves)
+        update_gcode_id(move);
 
-    if (rename_file(out_path, filename)) {
+    if (in_place && rename_file(out_path, filename)) {
         BOOST_LOG_TRIVIAL(info) << __FUNCTION__ <<  boost::format(":  Failed to rename the output G-code file from %1% to %2%")%out_path.c_str() % filename.c_str();
         throw Slic3r::RuntimeError(std::string("Failed to rename the output G-code file from ") + out_path + " to " + filename + '\n' +
             "Is " + out_path + " locked?" + '\n');
@@ -851,6 +936,8 @@ void GCodeProcessorResult::reset() {
     lock();
 
     moves = std::vector<GCodeProcessorResult::MoveVertex>();
+    moves_spill.reset();
+    gcode_index.reset();
     printable_area = Pointfs();
     //BBS: add bed exclude area
     bed_exclude_area = Pointfs();
@@ -878,6 +965,8 @@ void GCodeProcessorResult::reset() {
     lock();
 
     moves.clear();
+    moves_spill.reset();
+    gcode_index.reset();
     lines_ends.clear();
     printable_area = Pointfs();
     //BBS: add bed exclude area
@@ -907,6 +996,13 @@ void GCodeProcessorResult::reset() {
 }
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
+void GCodeProcessorResult::load_spilled_moves(size_t begin, size_t end)
+{
+    moves.clear();
+    if (moves_spill)
+        moves_spill->read(begin, end, moves);
+}
+
 const std::vector<std::pair<GCodeProcessor::EProducer, std::string>> GCodeProcessor::Producers = {
     //BBS: OrcaSlicer is also "bambu". Otherwise the time estimation didn't work.
     //FIXME: Workaround and should be handled when do removing-bambu
@@ -1379,6 +1475,8 @@ void GCodeProcessor::enable_stealth_time_estimator(bool enabled)
 
 void GCodeProcessor::reset()
 {
+    m_binary_gcode = false;
+    m_binary_data.reset();
     m_units = EUnits::Millimeters;
     m_global_positioning_type = EPositioningType::Absolute;
     m_e_local_positioning_type = EPositioningType::Absolute;
@@ -1437,6 +1535,8 @@ void GCodeProcessor::reset()
 
     m_result.reset();
     m_result.id = ++s_result_id;
+    m_moves_window = 0;
+    m_moves_offset = 0;
 
     m_last_default_color_id = 0;
 
@@ -1461,54 +1561,64 @@ static inline const char* remove_eols(const char *begin, const char *end) {
     return end;
 }
 
+void GCodeProcessor::apply_config_from_file(const std::string& filename)
+{
+    // parse the gcode file to detect its producer
+    m_parser.parse_file_raw(filename, [this](GCodeReader& reader, const char *begin, const char *end) {
+        begin = skip_whitespaces(begin, end);
+        if (begin != end && *begin == ';') {
+            // Comment.
+            begin = skip_whitespaces(++ begin, end);
+            end   = remove_eols(begin, end);
+            if (begin != end) {
+                if (m_producer == EProducer::Unknown) {
+                    if (detect_producer(std::string_view(begin, end - begin))) {
+                        m_parser.quit_parsing();
+                    }
+                } else if (std::string(begin, end).find("CONFIG_BLOCK_END") != std::string::npos) {
+                    m_parser.quit_parsing();
+                }
+            }
+        }
+    });
+    m_parser.reset();
+
+    // if the gcode was produced by OrcaSlicer,
+    // extract the config from it
+    if (m_producer == EProducer::OrcaSlicer || m_producer == EProducer::Slic3rPE || m_producer == EProducer::Slic3r) {
+        DynamicPrintConfig config;
+        config.apply(FullPrintConfig::defaults());
+        // Silently substitute unknown values by new ones for loading configurations from OrcaSlicer's own G-code.
+        // Showing substitution log or errors may make sense, but we are not really reading many values from the G-code config,
+        // thus a probability of incorrect substitution is low and the G-code viewer is a consumer-only anyways.
+        config.load_from_gcode_file(filename, ForwardCompatibilitySubstitutionRule::EnableSilent);
+        apply_config(config);
+    }
+    else if (m_producer == EProducer::Simplify3D)
+        apply_config_simplify3d(filename);
+    else if (m_producer == EProducer::SuperSlicer)
+        apply_config_superslicer(filename);
+}
+
 // Load a G-code into a stand-alone G-code viewer.
 // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
 void GCodeProcessor::process_file(const std::string& filename, std::function<void()> cancel_callback)
 {
     CNumericLocalesSetter locales_setter;
 
+    if (BinaryGCode::is_binary_gcode(filename)) {
+        this->process_binary_file(filename, cancel_callback);
+        return;
+    }
+    if (BinaryGCode::is_bgcode(filename))
+        throw Slic3r::RuntimeError("The binary G-code (.bgcode) of libbgcode is not supported: " + filename);
+
 #if ENABLE_GCODE_VIEWER_STATISTICS
     m_start_time = std::chrono::high_resolution_clock::now();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
     // pre-processing
-    // parse the gcode file to detect its producer
-    {
-        m_parser.parse_file_raw(filename, [this](GCodeReader& reader, const char *begin, const char *end) {
-            begin = skip_whitespaces(begin, end);
-            if (begin != end && *begin == ';') {
-                // Comment.
-                begin = skip_whitespaces(++ begin, end);
-                end   = remove_eols(begin, end);
-                if (begin != end) {
-                    if (m_producer == EProducer::Unknown) {
-                        if (detect_producer(std::string_view(begin, end - begin))) {
-                            m_parser.quit_parsing();
-                        }
-                    } else if (std::string(begin, end).find("CONFIG_BLOCK_END") != std::string::npos) {
-                        m_parser.quit_parsing();
-                    }
-                }
-            }
-        });
-        m_parser.reset();
-
-        // if the gcode was produced by OrcaSlicer,
-        // extract the config from it
-        if (m_producer == EProducer::OrcaSlicer || m_producer == EProducer::Slic3rPE || m_producer == EProducer::Slic3r) {
-            DynamicPrintConfig config;
-            config.apply(FullPrintConfig::defaults());
-            // Silently substitute unknown values by new ones for loading configurations from OrcaSlicer's own G-code.
-            // Showing substitution log or errors may make sense, but we are not really reading many values from the G-code config,
-            // thus a probability of incorrect substitution is low and the G-code viewer is a consumer-only anyways.
-            config.load_from_gcode_file(filename, ForwardCompatibilitySubstitutionRule::EnableSilent);
-            apply_config(config);
-        }
-        else if (m_producer == EProducer::Simplify3D)
-            apply_config_simplify3d(filename);
-        else if (m_producer == EProducer::SuperSlicer)
-            apply_config_superslicer(filename);
-    }
+    this->apply_config_from_file(filename);
 
     // process gcode
     m_result.filename = filename;
@@ -1530,6 +1640,217 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     this->finalize(false);
 }
 
+void GCodeProcessor::process_binary_file(const std::string& filename, std::function<void()> cancel_callback)
+{
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    m_start_time = std::chrono::high_resolution_clock::now();
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+
+    BinaryGCode::Reader reader(filename);
+    // The lines of a binary G-code are not accessible by their file offsets.
+    m_result.gcode_index.reset();
+
+    // The producer is stored into the file metadata, the config into the slicer metadata.
+    for (const auto &[key, value] : reader.data().file_metadata)
+        if (key == "Producer")
+            detect_producer(value);
+    if (m_producer == EProducer::OrcaSlicer || m_producer == EProducer::Slic3rPE || m_producer == EProducer::Slic3r) {
+        DynamicPrintConfig config;
+        config.apply(FullPrintConfig::defaults());
+        ConfigSubstitutionContext substitution_context(ForwardCompatibilitySubstitutionRule::EnableSilent);
+        for (const auto &[key, value] : reader.data().slicer_metadata)
+            if (print_config_def.has(key))
+                config.set_deserialize(key, value, substitution_context);
+        apply_config(config);
+    }
+
+    // process gcode
+    m_result.filename = filename;
+    m_result.id = ++s_result_id;
+    // 1st move must be a dummy move
+    m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
+    // Line ends are positions in the decoded G-code.
+    size_t gcode_pos = 0;
+    m_result.lines_ends.clear();
+    reader.read_gcode([this, &cancel_callback, &gcode_pos](const std::string &gcode) {
+        if (cancel_callback)
+            cancel_callback();
+        for (size_t i = 0; i < gcode.size(); ++ i)
+            if (gcode[i] == '\n')
+                m_result.lines_ends.emplace_back(gcode_pos + i + 1);
+        gcode_pos += gcode.size();
+        m_parser.parse_buffer(gcode, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
+            this->process_gcode_line(line, true);
+        });
+    });
+
+    // Don't post-process the G-code to update time stamps.
+    this->finalize(false);
+}
+
+size_t GCodeProcessor::process_layers(const std::string& filename, const GCodeIndex& index, size_t first_layer, size_t last_layer)
+{
+    const std::vector<GCodeIndex::Layer>& layers = index.layers();
+    if (first_layer > last_layer || last_layer >= layers.size())
+        throw Slic3r::RuntimeError("Invalid range of layers to be loaded from the G-code index.");
+    const size_t end_line = last_layer + 1 < layers.size() ? layers[last_layer + 1].first_line : index.lines_count() + 1;
+    return this->process_gcode_index_range(filename, index, first_layer, layers[first_layer].first_line, end_line);
+}
+
+size_t GCodeProcessor::process_lines(const std::string& filename, const GCodeIndex& index, size_t first_line, size_t last_line)
+{
+    if (first_line == 0 || first_line > last_line || index.layers().empty())
+        throw Slic3r::RuntimeError("Invalid range of lines to be loaded from the G-code index.");
+    return this->process_gcode_index_range(filename, index, index.line_layer(first_line), first_line, std::min<size_t>(last_line, index.lines_count()) + 1);
+}
+
+size_t GCodeProcessor::process_gcode_index_range(const std::string& filename, const GCodeIndex& index, size_t layer_id, size_t first_line, size_t end_line)
+{
+    CNumericLocalesSetter locales_setter;
+
+    DynamicPrintConfig config;
+    if (index.load_config(filename, config)) {
+        // The G-code was exported by OrcaSlicer with its index.
+        m_producer = EProducer::OrcaSlicer;
+        apply_config(config);
+    } else
+        this->apply_config_from_file(filename);
+    m_result.filename = filename;
+    m_result.id = ++s_result_id;
+    // Only the moves are loaded, the time estimates need the whole G-code.
+    for (TimeMachine& machine : m_time_processor.machines)
+        machine.enabled = false;
+    this->restore_gcode_index_layer(index, layer_id);
+
+    const std::vector<GCodeIndex::Layer>& layers = index.layers();
+    index.read_lines(filename, layers[layer_id].first_line, end_line, [this](const std::string& lines) {
+        m_parser.parse_buffer(lines, [this](GCodeReader&, const GCodeReader::GCodeLine& line) {
+            this->process_gcode_line(line, true);
+        });
+    });
+
+    for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
+        if (move.type == EMoveType::Wipe) {
+            move.width = Wipe_Width;
+            move.height = Wipe_Height;
+        }
+        // field layer_duration contains the layer id of the move, see store_move_vertex().
+        const size_t move_layer_id = size_t(move.layer_duration);
+        move.layer_duration = move_layer_id < layers.size() ? layers[move_layer_id].duration : 0.f;
+    }
+
+    // Drop the last move of the preceding layer and the moves of the lines preceding first_line, parsed to get the processor state at first_line.
+    auto it = std::find_if(m_result.moves.begin(), m_result.moves.end(), [first_line](const GCodeProcessorResult::MoveVertex& move) { return move.gcode_id >= first_line; });
+    m_moves_offset += size_t(it - m_result.moves.begin());
+    m_result.moves.erase(m_result.moves.begin(), it);
+    return m_moves_offset;
+}
+
+void GCodeProcessor::enable_gcode_index(bool enabled)
+{
+    m_result.gcode_index = enabled ? std::make_shared<GCodeIndex>() : nullptr;
+}
+
+void GCodeProcessor::store_gcode_index_layer()
+{
+    GCodeIndex::Layer layer;
+    // The line changing the layer was processed, the layer is resumed at the following line.
+    layer.first_line = m_line_id + 1;
+    layer.first_move = this->moves_count();
+    GCodeIndex::ProcessorState& state = layer.state;
+    state.units                         = uint8_t(m_units);
+    state.global_positioning_type       = uint8_t(m_global_positioning_type);
+    state.e_local_positioning_type      = uint8_t(m_e_local_positioning_type);
+    state.extrusion_role                = uint8_t(m_extrusion_role);
+    state.extruder_id                   = m_extruder_id;
+    state.last_extruder_id              = m_last_extruder_id;
+    state.cp_color_counter              = m_cp_color.counter;
+    state.cp_color_current              = m_cp_color.current;
+    state.wiping                        = m_wiping;
+    state.flushing                      = m_flushing;
+    state.wipe_tower                    = m_wipe_tower;
+    state.spiral_vase_active            = m_spiral_vase_active;
+    state.processing_start_custom_gcode = m_processing_start_custom_gcode;
+    state.seams_detector_active         = m_seams_detector.is_active();
+    state.seams_detector_has_first_vertex = m_seams_detector.has_first_vertex();
+    if (m_seams_detector.has_first_vertex()) {
+        const Vec3f first_vertex = *m_seams_detector.get_first_vertex();
+        std::copy(first_vertex.data(), first_vertex.data() + 3, state.seams_detector_first_vertex);
+    }
+    if (! m_result.moves.empty())
+        std::copy(m_result.moves.back().position.data(), m_result.moves.back().position.data() + 3, state.last_move_position);
+    std::copy(m_end_position.begin(), m_end_position.end(), state.end_position);
+    std::copy(m_origin.begin(), m_origin.end(), state.origin);
+    std::copy(m_cached_position.position.begin(), m_cached_position.position.end(), state.cached_position);
+    state.cached_feedrate               = m_cached_position.feedrate;
+    state.feedrate                      = m_feedrate;
+    state.width                         = m_width;
+    state.height                        = m_height;
+    state.forced_width                  = m_forced_width;
+    state.forced_height                 = m_forced_height;
+    state.mm3_per_mm                    = m_mm3_per_mm;
+    state.fan_speed                     = m_fan_speed;
+    state.extruded_last_z               = m_extruded_last_z;
+    state.remaining_volume              = m_remaining_volume;
+    state.last_line_id                  = m_last_line_id;
+    state.g1_line_id                    = m_g1_line_id;
+    state.last_default_color_id         = uint32_t(m_last_default_color_id);
+    layer.extruder_temps                = m_extruder_temps;
+    layer.extruder_colors               = m_extruder_colors;
+    m_result.gcode_index->add_layer(std::move(layer));
+}
+
+void GCodeProcessor::restore_gcode_index_layer(const GCodeIndex& index, size_t layer_id)
+{
+    const GCodeIndex::Layer&          layer = index.layers()[layer_id];
+    const GCodeIndex::ProcessorState& state = layer.state;
+    m_units                         = EUnits(state.units);
+    m_global_positioning_type       = EPositioningType(state.global_positioning_type);
+    m_e_local_positioning_type      = EPositioningType(state.e_local_positioning_type);
+    m_extrusion_role                = ExtrusionRole(state.extrusion_role);
+    m_extruder_id                   = state.extruder_id;
+    m_last_extruder_id              = state.last_extruder_id;
+    m_cp_color.counter              = state.cp_color_counter;
+    m_cp_color.current              = state.cp_color_current;
+    m_wiping                        = state.wiping != 0;
+    m_flushing                      = state.flushing != 0;
+    m_wipe_tower                    = state.wipe_tower != 0;
+    m_spiral_vase_active            = state.spiral_vase_active != 0;
+    m_processing_start_custom_gcode = state.processing_start_custom_gcode != 0;
+    m_seams_detector                = SeamsDetector();
+    m_seams_detector.activate(state.seams_detector_active != 0);
+    if (state.seams_detector_has_first_vertex)
+        m_seams_detector.set_first_vertex(Vec3f(state.seams_detector_first_vertex[0], state.seams_detector_first_vertex[1], state.seams_detector_first_vertex[2]));
+    std::copy(state.end_position, state.end_position + 4, m_end_position.begin());
+    m_start_position                = m_end_position;
+    std::copy(state.origin, state.origin + 4, m_origin.begin());
+    std::copy(state.cached_position, state.cached_position + 4, m_cached_position.position.begin());
+    m_cached_position.feedrate      = state.cached_feedrate;
+    m_feedrate                      = state.feedrate;
+    m_width                         = state.width;
+    m_height                        = state.height;
+    m_forced_width                  = state.forced_width;
+    m_forced_height                 = state.forced_height;
+    m_mm3_per_mm                    = state.mm3_per_mm;
+    m_fan_speed                     = state.fan_speed;
+    m_extruded_last_z               = state.extruded_last_z;
+    m_remaining_volume              = state.remaining_volume;
+    m_last_line_id                  = state.last_line_id;
+    m_g1_line_id                    = state.g1_line_id;
+    m_last_default_color_id         = size_t(state.last_default_color_id);
+    if (! layer.extruder_temps.empty())
+        m_extruder_temps = layer.extruder_temps;
+    if (! layer.extruder_colors.empty())
+        m_extruder_colors = layer.extruder_colors;
+    m_line_id                       = layer.first_line - 1;
+    m_layer_id                      = (unsigned int)layer_id;
+    // The processing refers to the last move, which precedes the first move of the layer.
+    m_moves_offset                  = size_t(layer.first_move) - 1;
+    GCodeProcessorResult::MoveVertex& last_move = m_result.moves.emplace_back();
+    last_move.gcode_id              = m_line_id;
+    last_move.position              = Vec3f(state.last_move_position[0], state.last_move_position[1], state.last_move_position[2]);
+}
+
 void GCodeProcessor::initialize(const std::string& filename)
 {
     assert(is_decimal_separator_point());
@@ -1545,6 +1866,24 @@ void GCodeProcessor::initialize(const std::string& filename)
     m_result.moves.emplace_back(GCodeProcessorResult::MoveVertex());
 }
 
+void GCodeProcessor::set_moves_window(size_t moves_window, bool spill_moves)
+{
+    // Keep enough moves for the G-code lines referring to the preceding moves.
+    m_moves_window = moves_window == 0 ? 0 : std::max<size_t>(moves_window, 64);
+    m_result.moves_spill = m_moves_window > 0 && spill_moves ? std::make_shared<MovesSpill>() : nullptr;
+}
+
+void GCodeProcessor::release_moves(size_t keep_last_n)
+{
+    if (m_result.moves.size() <= keep_last_n)
+        return;
+    const size_t num_released = m_result.moves.size() - keep_last_n;
+    if (m_result.moves_spill)
+        m_result.moves_spill->append(m_result.moves.data(), m_result.moves.data() + num_released);
+    m_result.moves.erase(m_result.moves.begin(), m_result.moves.begin() + num_released);
+    m_moves_offset += num_released;
+}
+
 void GCodeProcessor::process_buffer(const std::string &buffer)
 {
     //FIXME maybe cache GCodeLine gline to be over multiple parse_buffer() invocations.
@@ -1553,15 +1892,14 @@ void GCodeProcessor::process_buffer(const std::string &buffer)
     });
 }
 
-void GCodeProcessor::finalize(bool post_process)
+void GCodeProcessor::finalize(bool post_process, const std::string& post_process_output)
 {
-    // update width/height of wipe moves
-    for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
-        if (move.type == EMoveType::Wipe) {
-            move.width = Wipe_Width;
-            move.height = Wipe_Height;
-        }
-    }
+    if (m_moves_window > 0)
+        // The bounded memory export keeps all the moves spilled, they are finalized in place.
+        this->release_moves(0);
+    if (m_binary_gcode)
+        // The lines of a binary G-code are not accessible by their file offsets.
+        m_result.gcode_index.reset();
 
     // process the time blocks
     for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
@@ -1581,15 +1919,30 @@ void GCodeProcessor::finalize(bool post_process)
     auto prepare_time = (it != time_mode.roles_times.end()) ? it->second : 0.0f;
 
     //update times for results
-    for (size_t i = 0; i < m_result.moves.size(); i++) {
-        //field layer_duration contains the layer id for the move in which the layer_duration has to be set.
-        size_t layer_id = size_t(m_result.moves[i].layer_duration);
-        std::vector<float>& layer_times = m_result.print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].layers_times;
+    const std::vector<float>& layer_times = m_result.print_statistics.modes[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Normal)].layers_times;
+    auto layer_duration = [&layer_times, prepare_time](size_t layer_id) {
         if (layer_times.size() > layer_id - 1 && layer_id > 0)
-            m_result.moves[i].layer_duration = layer_id == 1 ? std::max(0.f,layer_times[layer_id - 1] - prepare_time) : layer_times[layer_id - 1];
+            return layer_id == 1 ? std::max(0.f,layer_times[layer_id - 1] - prepare_time) : layer_times[layer_id - 1];
         else
-            m_result.moves[i].layer_duration = 0;
-    }
+            return 0.f;
+    };
+    auto finalize_move = [&layer_duration](GCodeProcessorResult::MoveVertex& move) {
+        // update width/height of wipe moves
+        if (move.type == EMoveType::Wipe) {
+            move.width = Wipe_Width;
+            move.height = Wipe_Height;
+        }
+        //field layer_duration contains the layer id for the move in which the layer_duration has to be set.
+        move.layer_duration = layer_duration(size_t(move.layer_duration));
+    };
+    if (m_result.moves_spill)
+        m_result.moves_spill->update(finalize_move);
+    for (GCodeProcessorResult::MoveVertex& move : m_result.moves)
+        finalize_move(move);
+    GCodeIndex *index = m_result.gcode_index.get();
+    if (index != nullptr)
+        for (size_t layer_id = 0; layer_id < index->layers().size(); ++ layer_id)
+            index->layers_mutable()[layer_id].duration = layer_duration(layer_id);
     
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
     std::cout << "\n";
@@ -1598,8 +1951,38 @@ void GCodeProcessor::finalize(bool post_process)
     m_width_compare.output();
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
     if (post_process){
-        m_time_processor.post_process(m_result.filename, m_result.moves, m_result.lines_ends, m_layer_id);
-    }
+        if (m_binary_gcode) {
+            // The estimates are known now, fill in the print metadata stored in front of the G-code blocks.
+            BinaryGCode::Metadata &print_metadata = m_binary_data.print_metadata;
+            print_metadata.clear();
+            for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+                const TimeMachine &machine = m_time_processor.machines[i];
+                if (machine.enabled)
+                    print_metadata.emplace_back(std::string("estimated printing time (") +
+                        (static_cast<PrintEstimatedStatistics::ETimeMode>(i) == PrintEstimatedStatistics::ETimeMode::Normal ? "normal" : "silent") + " mode)",
+                        get_time_dhms(machine.time));
+            }
+            print_metadata.emplace_back("total layer number", std::to_string(m_layer_id));
+        }
+        Trace::counter("moves", int64_t(this->moves_count()));
+        SLIC3R_TRACE_SPAN("TimeProcessor::post_process", "gcode");
+        m_time_processor.post_process(m_result.filename, post_process_output, m_result.moves, m_result.moves_spill.get(),
+            m_moves_window > 0 ? nullptr : &m_result.lines_ends, index, m_layer_id, m_binary_gcode ? &m_binary_data : nullptr);
+    } else if (index != nullptr) {
+        // A G-code loaded by process_file(), its lines and the lines of its moves are final.
+        for (size_t line_end : m_result.lines_ends)
+            index->add_line_end(line_end);
+        boost::system::error_code ec;
+        const uintmax_t file_size = boost::filesystem::file_size(m_result.filename, ec);
+        index->finish_lines(ec ? (m_result.lines_ends.empty() ? 0 : m_result.lines_ends.back()) : uint64_t(file_size));
+        if (m_result.moves_spill)
+            m_result.moves_spill->update([index](GCodeProcessorResult::MoveVertex& move) { index->add_move_line(move.gcode_id); });
+        for (const GCodeProcessorResult::MoveVertex& move : m_result.moves)
+            index->add_move_line(move.gcode_id);
+    }
+    if (index != nullptr && m_moves_window > 0 && ! m_result.moves_spill)
+        // The moves were dropped.
+        index->clear_moves();
 #if ENABLE_GCODE_VIEWER_STATISTICS
     m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_start_time).count();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
@@ -1798,6 +2181,10 @@ void GCodeProcessor::process_gcode_line(const GCodeReader::GCodeLine& line, bool
 {
 /* std::cout << line.raw() << std::endl; */
 
+    if (m_result.gcode_index && m_result.gcode_index->layers().size() <= m_layer_id)
+        // The first line of the G-code or the first line following a layer change.
+        this->store_gcode_index_layer();
+
     ++m_line_id;
 
     // update start position
@@ -2312,7 +2699,7 @@ void GCodeProcessor::process_tags(const std::string_view comment, bool producers
                 // add a placeholder for layer height. the actual value will be set inside process_G1() method
                 m_result.spiral_vase_layers.push_back({ FLT_MAX, { 0, 0 } });
             else {
-                const size_t move_id = m_result.moves.size() - 1;
+                const size_t move_id = this->moves_count() - 1;
                 if (!m_result.spiral_vase_layers.empty())
                     m_result.spiral_vase_layers.back().second.second = move_id;
                 // add a placeholder for layer height. the actual value will be set inside process_G1() method
@@ -3218,7 +3605,7 @@ void GCodeProcessor::process_G1(const GCodeReader::GCodeLine& line)
             // replace layer height placeholder with correct value
             m_result.spiral_vase_layers.back().first = static_cast<float>(m_end_position[Z]);
         if (!m_result.moves.empty())
-            m_result.spiral_vase_layers.back().second.second = m_result.moves.size() - 1;
+            m_result.spiral_vase_layers.back().second.second = this->moves_count() - 1;
     }
 
     // store move
@@ -4222,7 +4609,7 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
         m_mm3_per_mm,
         m_fan_speed,
         m_extruder_temps[m_extruder_id],
-        static_cast<float>(m_result.moves.size()),
+        static_cast<float>(this->moves_count()),
         static_cast<float>(m_layer_id), //layer_duration: set later
         //BBS: add arc move related data
         path_type,
@@ -4240,6 +4627,10 @@ void GCodeProcessor::store_move_vertex(EMoveType type, EMovePathType path_type)
             machine.stop_times.push_back({ m_g1_line_id, 0.0f });
         }
     }
+
+    // Release the moves in batches, keeping the moves still referenced by the Z corrector.
+    if (m_moves_window > 0 && m_result.moves.size() >= 2 * m_moves_window && ! m_options_z_corrector.pending())
+        this->release_moves(m_moves_window);
 }
 
 void GCodeProcessor::set_extrusion_role(ExtrusionRole role)
@@ -6,9 +6,11 @@
 #include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/CustomGCode.hpp"
+#include "BinaryGCode.hpp"
 
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <vector>
 #include <mutex>
 #include <string>
@@ -17,6 +19,9 @@
 
 namespace Slic3r {
 
+class GCodeIndex;
+class MovesSpill;
+
 // slice warnings enum strings
 #define NOZZLE_HRC_CHECKER                                          "the_actual_nozzle_hrc_smaller_than_the_required_nozzle_hrc"
 #define BED_TEMP_TOO_HIGH_THAN_FILAMENT                             "bed_temperature_too_high_than_filament"
@@ -186,8 +191,13 @@ namespace Slic3r {
         std::string filename;
         unsigned int id;
         std::vector<MoveVertex> moves;
+        // Set by the bounded memory G-code export, see GCodeProcessor::set_moves_window(): the moves were spilled
+        // into a temporary file, moves stays empty until the spilled moves are loaded by load_spilled_moves().
+        std::shared_ptr<MovesSpill> moves_spill;
         // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
         std::vector<size_t> lines_ends;
+        // Random access index of the final text G-code if requested by GCodeProcessor::enable_gcode_index().
+        std::shared_ptr<GCodeIndex> gcode_index;
         Pointfs printable_area;
         //BBS: add bed exclude area
         Pointfs bed_exclude_area;
@@ -226,7 +236,9 @@ namespace Slic3r {
             filename = other.filename;
             id = other.id;
             moves = other.moves;
+            moves_spill = other.moves_spill;
             lines_ends = other.lines_ends;
+            gcode_index = other.gcode_index;
             printable_area = other.printable_area;
             bed_exclude_area = other.bed_exclude_area;
             toolpath_outside = other.toolpath_outside;
@@ -250,6 +262,8 @@ namespace Slic3r {
 #endif
             return *this;
         }
+        // Load the spilled moves [begin, end) into moves, replacing the moves loaded before.
+        void  load_spilled_moves(size_t begin = 0, size_t end = size_t(-1));
         void  lock() const { result_mutex.lock(); }
         void  unlock() const { result_mutex.unlock(); }
     };
@@ -281,6 +295,7 @@ namespace Slic3r {
             During_Print_Exhaust_Fan,
             Wipe_Tower_Start,
             Wipe_Tower_End,
+            Thumbnails_Placeholder,
         };
 
         static const std::string& reserved_tag(ETags tag) { return s_IsBBLPrinter ? Reserved_Tags[static_cast<unsigned char>(tag)] : Reserved_Tags_compatible[static_cast<unsigned char>(tag)]; }
@@ -479,6 +494,8 @@ namespace Slic3r {
             float filament_load_times;
             float filament_unload_times;
             bool  disable_m73;
+            // G-code comments with the thumbnails, replacing the thumbnails placeholder.
+            std::string thumbnails_gcode;
 
             std::array<TimeMachine, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)> machines;
 
@@ -486,7 +503,14 @@ namespace Slic3r {
 
             // post process the file with the given filename to add remaining time lines M73
             // and updates moves' gcode ids accordingly
-            void post_process(const std::string& filename, std::vector<GCodeProcessorResult::MoveVertex>& moves, std::vector<size_t>& lines_ends, size_t total_layer_num);
+            // If out_filename is empty, the file is replaced by its post processed copy, otherwise the post processed
+            // G-code is streamed into out_filename directly and the source file is left untouched.
+            // If binary_data is set, a binary G-code with the given metadata and thumbnails is written, lines_ends then
+            // refer to the decoded G-code. The spilled moves precede the moves, lines_ends are not collected if nullptr.
+            // If index is set, the line ends and the lines of the moves are indexed and the first lines of its layers are updated.
+            void post_process(const std::string& filename, const std::string& out_filename, std::vector<GCodeProcessorResult::MoveVertex>& moves,
+                MovesSpill* moves_spill, std::vector<size_t>* lines_ends, GCodeIndex* index, size_t total_layer_num,
+                const BinaryGCode::BinaryData* binary_data = nullptr);
         };
 
         struct UsedFilaments  // filaments per ColorChange
@@ -578,6 +602,9 @@ namespace Slic3r {
                 m_move_id.reset();
                 m_custom_gcode_per_print_z_id.reset();
             }
+
+            // The move to be updated is referenced by its index into GCodeProcessorResult::moves.
+            bool pending() const { return m_move_id.has_value(); }
         };
 
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
@@ -725,9 +752,18 @@ namespace Slic3r {
         TimeProcessor m_time_processor;
         UsedFilaments m_used_filaments;
 
+        // Export binary G-code, metadata and thumbnails to be written into the binary G-code.
+        bool m_binary_gcode { false };
+        BinaryGCode::BinaryData m_binary_data;
+
         GCodeProcessorResult m_result;
         static unsigned int s_result_id;
 
+        // Number of the moves kept in memory by the bounded memory export, 0 if all the moves are kept.
+        size_t m_moves_window { 0 };
+        // Index of m_result.moves.front() into all the moves, the preceding moves were spilled or dropped.
+        size_t m_moves_offset { 0 };
+
 #if ENABLE_GCODE_VIEWER_DATA_CHECKING
         DataChecker m_mm3_per_mm_compare{ "mm3_per_mm", 0.01f };
         DataChecker m_height_compare{ "height", 0.01f };
@@ -749,14 +785,38 @@ namespace Slic3r {
         GCodeProcessorResult& result() { return m_result; }
         GCodeProcessorResult&& extract_result() { return std::move(m_result); }
 
+        void enable_binary_gcode(bool enabled) { m_binary_gcode = enabled; }
+        // The thumbnails are compressed while the G-code is being generated, they are inserted by the post processing.
+        void set_thumbnails_gcode(std::string gcode) { m_time_processor.thumbnails_gcode = std::move(gcode); }
+        bool is_binary_gcode() const { return m_binary_gcode; }
+        // Bounded memory export of huge prints: keep only the last moves_window moves in memory. The older moves are spilled
+        // into a temporary file referenced by GCodeProcessorResult::moves_spill if spill_moves is set, otherwise they are
+        // dropped and only the aggregated statistics are kept. The line ends are not collected. Cleared by reset().
+        void set_moves_window(size_t moves_window, bool spill_moves);
+        // Index the final text G-code into GCodeProcessorResult::gcode_index, see GCodeIndex. A binary G-code is not indexed.
+        // The moves are not indexed if they were dropped by set_moves_window(). Cleared by reset().
+        void enable_gcode_index(bool enabled);
+        // To be filled in by the G-code generator, the print metadata are filled in by finalize().
+        BinaryGCode::BinaryData& binary_data() { return m_binary_data; }
+
         // Load a G-code into a stand-alone G-code viewer.
         // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
         void process_file(const std::string& filename, std::function<void()> cancel_callback = nullptr);
+        // Load the moves of the layers [first_layer, last_layer] of a text G-code indexed by GCodeIndex without parsing the rest of the G-code:
+        // the parsing resumes at the start of first_layer with the processor state stored into the index. The moves are the same
+        // as loaded by process_file() including their layer times, the time estimates and the statistics of the print are not calculated.
+        // Returns the index of the first loaded move into all the moves of the G-code. Throws Slic3r::RuntimeError on failure.
+        size_t process_layers(const std::string& filename, const GCodeIndex& index, size_t first_layer, size_t last_layer);
+        // Load the moves of the lines [first_line, last_line] of a text G-code indexed by GCodeIndex, resuming the parsing
+        // at the start of the layer containing first_line. Returns the index of the first loaded move as process_layers().
+        size_t process_lines(const std::string& filename, const GCodeIndex& index, size_t first_line, size_t last_line);
 
         // Streaming interface, for processing G-codes just generated by PrusaSlicer in a pipelined fashion.
         void initialize(const std::string& filename);
         void process_buffer(const std::string& buffer);
-        void finalize(bool post_process);
+        // If post_process_output is set, the G-code annotated with the estimated times is written there in a single pass
+        // instead of rewriting the file being processed.
+        void finalize(bool post_process, const std::string& post_process_output = std::string());
 
         float get_time(PrintEstimatedStatistics::ETimeMode mode) const;
         float get_prepare_time(PrintEstimatedStatistics::ETimeMode mode) const;
@@ -771,6 +831,20 @@ namespace Slic3r {
         void set_xy_offset(double x, double y) { m_x_offset = x; m_y_offset = y; }
 
     private:
+        // Number of all the moves including the spilled or dropped ones.
+        size_t moves_count() const { return m_moves_offset + m_result.moves.size(); }
+        // Spill or drop all the moves in memory but the last keep_last_n moves.
+        void release_moves(size_t keep_last_n);
+
+        void process_binary_file(const std::string& filename, std::function<void()> cancel_callback);
+        // Detect the producer of a text G-code and apply the config stored into it.
+        void apply_config_from_file(const std::string& filename);
+        // Store the processor state at the start of the current layer into the G-code index.
+        void store_gcode_index_layer();
+        // Restore the processor state at the start of a layer from the G-code index, to resume parsing there.
+        void restore_gcode_index_layer(const GCodeIndex& index, size_t layer_id);
+        // Load the moves of the lines [first_line, end_line) resuming the parsing at the start of the layer layer_id.
+        size_t process_gcode_index_range(const std::string& filename, const GCodeIndex& index, size_t layer_id, size_t first_line, size_t end_line);
         void apply_config(const DynamicPrintConfig& config);
         void apply_config_simplify3d(const std::string& filename);
         void apply_config_superslicer(const std::string& filename);
@@ -0,0 +1,215 @@
+#include "MovesSpill.hpp"
+#include "../Exception.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+namespace Slic3r {
+
+namespace {
+
+// MoveVertex without its interpolation points, which are referenced by index into the points file.
+struct MoveRecord
+{
+    uint32_t gcode_id;
+    uint8_t  type;
+    uint8_t  extrusion_role;
+    uint8_t  extruder_id;
+    uint8_t  cp_color_id;
+    float    position[3];
+    float    delta_extruder;
+    float    feedrate;
+    float    width;
+    float    height;
+    float    mm3_per_mm;
+    float    fan_speed;
+    float    temperature;
+    float    time;
+    float    layer_duration;
+    float    arc_center_position[3];
+    uint32_t move_path_type;
+    uint32_t num_points;
+    uint64_t first_point;
+};
+
+void to_record(const MovesSpill::MoveVertex &move, MoveRecord &record)
+{
+    record.gcode_id       = move.gcode_id;
+    record.type           = uint8_t(move.type);
+    record.extrusion_role = uint8_t(move.extrusion_role);
+    record.extruder_id    = move.extruder_id;
+    record.cp_color_id    = move.cp_color_id;
+    memcpy(record.position, move.position.data(), sizeof(record.position));
+    record.delta_extruder = move.delta_extruder;
+    record.feedrate       = move.feedrate;
+    record.width          = move.width;
+    record.height         = move.height;
+    record.mm3_per_mm     = move.mm3_per_mm;
+    record.fan_speed      = move.fan_speed;
+    record.temperature    = move.temperature;
+    record.time           = move.time;
+    record.layer_duration = move.layer_duration;
+    memcpy(record.arc_center_position, move.arc_center_position.data(), sizeof(record.arc_center_position));
+    record.move_path_type = uint32_t(move.move_path_type);
+}
+
+void from_record(const MoveRecord &record, MovesSpill::MoveVertex &move)
+{
+    move.gcode_id         = record.gcode_id;
+    move.type             = EMoveType(record.type);
+    move.extrusion_role   = ExtrusionRole(record.extrusion_role);
+    move.extruder_id      = record.extruder_id;
+    move.cp_color_id      = record.cp_color_id;
+    memcpy(move.position.data(), record.position, sizeof(record.position));
+    move.delta_extruder   = record.delta_extruder;
+    move.feedrate         = record.feedrate;
+    move.width            = record.width;
+    move.height           = record.height;
+    move.mm3_per_mm       = record.mm3_per_mm;
+    move.fan_speed        = record.fan_speed;
+    move.temperature      = record.temperature;
+    move.time             = record.time;
+    move.layer_duration   = record.layer_duration;
+    memcpy(move.arc_center_position.data(), record.arc_center_position, sizeof(record.arc_center_position));
+    move.move_path_type   = EMovePathType(record.move_path_type);
+}
+
+[[noreturn]] void throw_spill_error(const std::string &path, const char *what)
+{
+    throw Slic3r::RuntimeError(std::string("Failed to ") + what + " the G-code moves spill " + path + "\nIs the disk full?\n");
+}
+
+} // namespace
+
+MovesSpill::MovesSpill()
+{
+    boost::system::error_code ec;
+    boost::filesystem::path   temp_dir = boost::filesystem::temp_directory_path(ec);
+    if (ec)
+        throw Slic3r::RuntimeError("Failed to find the temporary directory for the G-code moves spill: " + ec.message());
+    const std::string base = (temp_dir / boost::filesystem::unique_path("orca_moves_%%%%-%%%%-%%%%-%%%%")).string();
+    m_moves_path  = base + ".moves";
+    m_points_path = base + ".points";
+    m_moves_file  = boost::nowide::fopen(m_moves_path.c_str(), "wb");
+    m_points_file = boost::nowide::fopen(m_points_path.c_str(), "wb");
+    if (m_moves_file == nullptr || m_points_file == nullptr) {
+        this->close_files();
+        boost::nowide::remove(m_moves_path.c_str());
+        boost::nowide::remove(m_points_path.c_str());
+        throw_spill_error(m_moves_path, "create");
+    }
+}
+
+MovesSpill::~MovesSpill()
+{
+    this->close_files();
+    boost::nowide::remove(m_moves_path.c_str());
+    boost::nowide::remove(m_points_path.c_str());
+}
+
+void MovesSpill::close_files()
+{
+    if (m_moves_file != nullptr) {
+        ::fclose(m_moves_file);
+        m_moves_file = nullptr;
+    }
+    if (m_points_file != nullptr) {
+        ::fclose(m_points_file);
+        m_points_file = nullptr;
+    }
+}
+
+void MovesSpill::append(const MoveVertex *begin, const MoveVertex *end)
+{
+    if (m_moves_file == nullptr) {
+        m_moves_file  = boost::nowide::fopen(m_moves_path.c_str(), "ab");
+        m_points_file = boost::nowide::fopen(m_points_path.c_str(), "ab");
+        if (m_moves_file == nullptr || m_points_file == nullptr) {
+            this->close_files();
+            throw_spill_error(m_moves_path, "open");
+        }
+    }
+    // Write in batches to limit the number of the calls into the C runtime.
+    static constexpr size_t batch_size = 4096;
+    std::vector<MoveRecord> records(std::min(batch_size, size_t(end - begin)));
+    while (begin != end) {
+        const size_t n = std::min(batch_size, size_t(end - begin));
+        memset(records.data(), 0, n * sizeof(MoveRecord));
+        for (size_t i = 0; i < n; ++ i) {
+            const MoveVertex &move   = begin[i];
+            MoveRecord       &record = records[i];
+            to_record(move, record);
+            record.num_points  = uint32_t(move.interpolation_points.size());
+            record.first_point = m_num_points;
+            if (! move.interpolation_points.empty()) {
+                if (::fwrite(move.interpolation_points.front().data(), sizeof(Vec3f), move.interpolation_points.size(), m_points_file) != move.interpolation_points.size())
+                    throw_spill_error(m_points_path, "write");
+                m_num_points += move.interpolation_points.size();
+            }
+        }
+        if (::fwrite(records.data(), sizeof(MoveRecord), n, m_moves_file) != n)
+            throw_spill_error(m_moves_path, "write");
+        m_size += n;
+        begin  += n;
+    }
+}
+
+void MovesSpill::update(const std::function<void(MoveVertex&)> &fn)
+{
+    if (m_size == 0)
+        return;
+    this->close_files();
+    boost::iostreams::mapped_file file;
+    try {
+        file.open(m_moves_path, boost::iostreams::mapped_file::readwrite);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << "Cannot map the G-code moves spill " << m_moves_path << ": " << ex.what();
+        throw_spill_error(m_moves_path, "map");
+    }
+    assert(file.size() == m_size * sizeof(MoveRecord));
+    MoveRecord *records = reinterpret_cast<MoveRecord*>(file.data());
+    MoveVertex  move;
+    for (size_t i = 0; i < m_size; ++ i) {
+        from_record(records[i], move);
+        fn(move);
+        to_record(move, records[i]);
+    }
+}
+
+void MovesSpill::read(size_t begin, size_t end, std::vector<MoveVertex> &out)
+{
+    end = std::min(end, m_size);
+    if (begin >= end)
+        return;
+    this->close_files();
+    boost::iostreams::mapped_file_source moves_file;
+    boost::iostreams::mapped_file_source points_file;
+    try {
+        moves_file.open(m_moves_path);
+        if (m_num_points > 0)
+            points_file.open(m_points_path);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << "Cannot map the G-code moves spill " << m_moves_path << ": " << ex.what();
+        throw_spill_error(m_moves_path, "map");
+    }
+    const MoveRecord *records = reinterpret_cast<const MoveRecord*>(moves_file.data());
+    const float      *points  = m_num_points > 0 ? reinterpret_cast<const float*>(points_file.data()) : nullptr;
+    out.reserve(out.size() + end - begin);
+    for (size_t i = begin; i < end; ++ i) {
+        const MoveRecord &record = records[i];
+        MoveVertex       &move   = out.emplace_back();
+        from_record(record, move);
+        if (record.num_points > 0) {
+            move.interpolation_points.assign(record.num_points, Vec3f::Zero());
+            memcpy(move.interpolation_points.front().data(), points + 3 * record.first_point, record.num_points * sizeof(Vec3f));
+        }
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,54 @@
+#ifndef slic3r_GCode_MovesSpill_hpp_
+#define slic3r_GCode_MovesSpill_hpp_
+
+#include "GCodeProcessor.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Moves of a GCodeProcessorResult spilled into temporary files by the bounded memory G-code export,
+// see GCodeProcessor::set_moves_window(). Each move is stored as a fixed size record, so that the moves may be
+// finalized in place through a memory mapping of the file and any range of moves may be loaded for the preview.
+// The interpolation points of the arcs are stored into a second file, referenced from the records.
+// The files are removed together with the MovesSpill.
+namespace Slic3r {
+
+class MovesSpill
+{
+public:
+    using MoveVertex = GCodeProcessorResult::MoveVertex;
+
+    // Creates the spill files in the temporary directory. Throws Slic3r::RuntimeError on failure.
+    MovesSpill();
+    ~MovesSpill();
+    MovesSpill(const MovesSpill &) = delete;
+    MovesSpill& operator=(const MovesSpill &) = delete;
+
+    // Number of the spilled moves.
+    size_t size() const { return m_size; }
+    const std::string& path() const { return m_moves_path; }
+
+    // Append moves to the end of the spill. Throws Slic3r::RuntimeError on failure.
+    void append(const MoveVertex *begin, const MoveVertex *end);
+    // Modify all the spilled moves in place. The interpolation points are not passed to fn and they cannot be modified.
+    void update(const std::function<void(MoveVertex&)> &fn);
+    // Read the spilled moves [begin, end) including their interpolation points, append them to out.
+    void read(size_t begin, size_t end, std::vector<MoveVertex> &out);
+
+private:
+    void close_files();
+
+    std::string m_moves_path;
+    std::string m_points_path;
+    // Opened for appending, closed before the files are mapped.
+    FILE       *m_moves_file  { nullptr };
+    FILE       *m_points_file { nullptr };
+    size_t      m_size        { 0 };
+    size_t      m_num_points  { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCode_MovesSpill_hpp_
@@ -4,6 +4,16 @@
 ///|/
 #include "Thumbnails.hpp"
 #include "../miniz_extension.hpp"
+#include "../Trace.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+
+#include <boost/format.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <qoi/qoi.h>
 #include <jpeglib.h>
@@ -101,7 +111,7 @@ std::unique_ptr<CompressedImageBuffer> compress_thumbnail_qoi(const ThumbnailDat
     desc.colorspace = QOI_SRGB;
 
     // Take vector of RGBA pixels and flip the image vertically
-    std::vector<uint8_t> rgba_pixels(data.pixels.size() * 4);
+    std::vector<uint8_t> rgba_pixels(data.pixels.size());
     size_t row_size = data.width * 4;
     for (size_t y = 0; y < data.height; ++ y)
         memcpy(rgba_pixels.data() + (data.height - y - 1) * row_size, data.pixels.data() + y * row_size, row_size);
@@ -193,4 +203,175 @@ std::unique_ptr<CompressedImageBuffer> compress_thumbnail(const ThumbnailData &d
     }
 }
 
+// Content addressed cache of the images compressed last.
+struct CompressedImageCache
+{
+    struct Entry
+    {
+        GCodeThumbnailsFormat    format;
+        unsigned int             width;
+        unsigned int             height;
+        size_t                   hash;
+        CompressedImageBufferPtr image;
+    };
+    // A G-code export compresses a handful of thumbnails, the 3MF export three per plate.
+    static constexpr size_t max_entries = 16;
+
+    std::mutex        mutex;
+    std::deque<Entry> entries;
+};
+
+static CompressedImageCache s_compressed_image_cache;
+
+CompressedImageBufferPtr compress_thumbnail_cached(const ThumbnailData &data, GCodeThumbnailsFormat format)
+{
+    const size_t hash = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(data.pixels.data()), data.pixels.size()));
+    auto         matches = [&data, format, hash](const CompressedImageCache::Entry &entry) {
+        return entry.hash == hash && entry.format == format && entry.width == data.width && entry.height == data.height;
+    };
+    {
+        std::scoped_lock<std::mutex> lock(s_compressed_image_cache.mutex);
+        auto it = std::find_if(s_compressed_image_cache.entries.begin(), s_compressed_image_cache.entries.end(), matches);
+        if (it != s_compressed_image_cache.entries.end())
+            return it->image;
+    }
+    // Compress outside of the lock, so that multiple thumbnails are compressed in parallel.
+    CompressedImageBufferPtr image = compress_thumbnail(data, format);
+    if (image->data != nullptr && image->size > 0) {
+        std::scoped_lock<std::mutex> lock(s_compressed_image_cache.mutex);
+        if (std::none_of(s_compressed_image_cache.entries.begin(), s_compressed_image_cache.entries.end(), matches)) {
+            s_compressed_image_cache.entries.push_back({ format, data.width, data.height, hash, image });
+            if (s_compressed_image_cache.entries.size() > CompressedImageCache::max_entries)
+                s_compressed_image_cache.entries.pop_front();
+        }
+    }
+    return image;
+}
+
+std::vector<CompressedImageBufferPtr> compress_thumbnails(const std::vector<const ThumbnailData*> &thumbnails, GCodeThumbnailsFormat format)
+{
+    std::vector<CompressedImageBufferPtr> out(thumbnails.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, thumbnails.size(), 1), [&thumbnails, &out, format](const tbb::blocked_range<size_t> &range) {
+        for (size_t i = range.begin(); i < range.end(); ++ i)
+            if (thumbnails[i] != nullptr && thumbnails[i]->is_valid()) {
+                CompressedImageBufferPtr image = compress_thumbnail_cached(*thumbnails[i], format);
+                if (image->data != nullptr && image->size > 0)
+                    out[i] = std::move(image);
+            }
+    });
+    return out;
+}
+
+std::string thumbnails_gcode(const ThumbnailsList &thumbnails, const std::vector<CompressedImageBufferPtr> &compressed, GCodeThumbnailsFormat format)
+{
+    assert(thumbnails.size() == compressed.size());
+    static constexpr const size_t max_row_length = 78;
+    std::string out;
+    short       i = 0;
+    for (size_t idx = 0; idx < thumbnails.size(); ++ idx) {
+        const ThumbnailData &data = thumbnails[idx];
+        if (! data.is_valid())
+            continue;
+        out += "; THUMBNAIL_BLOCK_START\n";
+        if (const CompressedImageBufferPtr &image = compressed[idx]; image) {
+            if (format == GCodeThumbnailsFormat::BTT_TFT) {
+                // write BTT_TFT header
+                out += ";" + rjust(get_hex(data.width), 4, '0') + rjust(get_hex(data.height), 4, '0') + "\r\n";
+                out += (const char *) image->data;
+                if (i == (thumbnails.size() - 1))
+                    out += "; bigtree thumbnail end\r\n\r\n";
+            } else {
+                std::string encoded;
+                encoded.resize(boost::beast::detail::base64::encoded_size(image->size));
+                encoded.resize(boost::beast::detail::base64::encode((void *) encoded.data(), (const void *) image->data, image->size));
+                out += (boost::format("\n;\n; %s begin %dx%d %d\n") % image->tag() % data.width % data.height % encoded.size()).str();
+                for (size_t pos = 0; pos < encoded.size(); pos += max_row_length) {
+                    out += "; ";
+                    out.append(encoded, pos, max_row_length);
+                    out += "\n";
+                }
+                out += (boost::format("; %s end\n") % image->tag()).str();
+            }
+        }
+        out += "; THUMBNAIL_BLOCK_END\n\n";
+        ++ i;
+    }
+    return out;
+}
+
+std::vector<BinaryGCode::Thumbnail> binary_thumbnails(const ThumbnailsList &thumbnails, const std::vector<CompressedImageBufferPtr> &compressed, GCodeThumbnailsFormat format)
+{
+    assert(thumbnails.size() == compressed.size());
+    // BTT_TFT is a text format, it is never stored into a binary G-code.
+    assert(format != GCodeThumbnailsFormat::BTT_TFT);
+    std::vector<BinaryGCode::Thumbnail> out;
+    for (size_t idx = 0; idx < thumbnails.size(); ++ idx)
+        if (const CompressedImageBufferPtr &image = compressed[idx]; image) {
+            BinaryGCode::Thumbnail thumbnail;
+            thumbnail.format = format == GCodeThumbnailsFormat::JPG ? BinaryGCode::EThumbnailFormat::JPG :
+                               format == GCodeThumbnailsFormat::QOI ? BinaryGCode::EThumbnailFormat::QOI :
+                                                                      BinaryGCode::EThumbnailFormat::PNG;
+            thumbnail.width  = uint16_t(thumbnails[idx].width);
+            thumbnail.height = uint16_t(thumbnails[idx].height);
+            thumbnail.data.assign(static_cast<const char*>(image->data), image->size);
+            out.emplace_back(std::move(thumbnail));
+        }
+    return out;
+}
+
+ThumbnailsCompressor::~ThumbnailsCompressor()
+{
+    // The export may be unwinding after an exception, the tasks must not outlive the data they compress.
+    try {
+        this->wait();
+    } catch (...) {
+    }
+}
+
+void ThumbnailsCompressor::start(ThumbnailsGeneratorCallback &thumbnail_cb, int plate_id, const std::vector<Vec2d> &sizes, GCodeThumbnailsFormat format)
+{
+    this->wait();
+    m_thumbnails.clear();
+    m_compressed.clear();
+    m_format = format;
+    if (thumbnail_cb == nullptr)
+        return;
+    m_thumbnails = thumbnail_cb(ThumbnailsParams{sizes, true, true, true, true, plate_id});
+    m_compressed.assign(m_thumbnails.size(), nullptr);
+    for (size_t idx = 0; idx < m_thumbnails.size(); ++ idx)
+        if (m_thumbnails[idx].is_valid())
+            m_tasks.run([this, idx]() {
+                SLIC3R_TRACE_SPAN("compress_thumbnail", "task");
+                CompressedImageBufferPtr image = compress_thumbnail_cached(m_thumbnails[idx], m_format);
+                if (image->data != nullptr && image->size > 0)
+                    m_compressed[idx] = std::move(image);
+            });
+    m_running = true;
+}
+
+void ThumbnailsCompressor::wait()
+{
+    if (m_running) {
+        m_running = false;
+        m_tasks.wait();
+    }
+}
+
+bool ThumbnailsCompressor::empty() const
+{
+    return std::none_of(m_thumbnails.begin(), m_thumbnails.end(), [](const ThumbnailData &data) { return data.is_valid(); });
+}
+
+std::string ThumbnailsCompressor::gcode()
+{
+    this->wait();
+    return thumbnails_gcode(m_thumbnails, m_compressed, m_format);
+}
+
+std::vector<BinaryGCode::Thumbnail> ThumbnailsCompressor::binary()
+{
+    this->wait();
+    return binary_thumbnails(m_thumbnails, m_compressed, m_format);
+}
+
 } // namespace Slic3r::GCodeThumbnails
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "../Point.hpp"
 #include "../PrintConfig.hpp"
 #include "ThumbnailData.hpp"
+#include "BinaryGCode.hpp"
 
 #include <vector>
 #include <memory>
@@ -15,6 +16,8 @@
 
 #include <boost/beast/core/detail/base64.hpp>
 
+#include <tbb/task_group.h>
+
 namespace Slic3r::GCodeThumbnails {
 
 struct CompressedImageBuffer
@@ -25,9 +28,49 @@ struct CompressedImageBuffer
     virtual std::string_view tag() const = 0;
 };
 
+using CompressedImageBufferPtr = std::shared_ptr<const CompressedImageBuffer>;
+
 std::string get_hex(const unsigned int input);
 std::string rjust(std::string input, unsigned int width, char fill_char);
 std::unique_ptr<CompressedImageBuffer> compress_thumbnail(const ThumbnailData &data, GCodeThumbnailsFormat format);
+// Same as compress_thumbnail(), but the images compressed last are cached by their content, so that a thumbnail
+// compressed for the G-code export is reused by the 3MF export and the other way around. Thread safe.
+CompressedImageBufferPtr compress_thumbnail_cached(const ThumbnailData &data, GCodeThumbnailsFormat format);
+// Compress the thumbnails in parallel. Invalid thumbnails or thumbnails failed to compress are returned as nullptr.
+std::vector<CompressedImageBufferPtr> compress_thumbnails(const std::vector<const ThumbnailData*> &thumbnails, GCodeThumbnailsFormat format);
+
+// G-code comments with the compressed thumbnails.
+std::string thumbnails_gcode(const ThumbnailsList &thumbnails, const std::vector<CompressedImageBufferPtr> &compressed, GCodeThumbnailsFormat format);
+// Thumbnails to be stored into the thumbnail blocks of a binary G-code.
+std::vector<BinaryGCode::Thumbnail> binary_thumbnails(const ThumbnailsList &thumbnails, const std::vector<CompressedImageBufferPtr> &compressed, GCodeThumbnailsFormat format);
+
+// Renders the thumbnails on the calling thread, as the rendering needs the OpenGL context of the caller,
+// then compresses them by background tasks, one task per thumbnail. The compression thus runs in parallel
+// with the G-code generation, the G-code export waits for it only once all the layers are generated.
+class ThumbnailsCompressor
+{
+public:
+    ThumbnailsCompressor() = default;
+    ThumbnailsCompressor(const ThumbnailsCompressor &) = delete;
+    ThumbnailsCompressor& operator=(const ThumbnailsCompressor &) = delete;
+    ~ThumbnailsCompressor();
+
+    void start(ThumbnailsGeneratorCallback &thumbnail_cb, int plate_id, const std::vector<Vec2d> &sizes, GCodeThumbnailsFormat format);
+    // Wait for the compression to finish. Exceptions thrown by the compression are rethrown.
+    void wait();
+    // No valid thumbnail was rendered.
+    bool empty() const;
+
+    std::string                         gcode();
+    std::vector<BinaryGCode::Thumbnail> binary();
+
+private:
+    ThumbnailsList                        m_thumbnails;
+    GCodeThumbnailsFormat                 m_format { GCodeThumbnailsFormat::PNG };
+    std::vector<CompressedImageBufferPtr> m_compressed;
+    tbb::task_group                       m_tasks;
+    bool                                  m_running { false };
+};
 
 template<typename WriteToOutput, typename ThrowIfCanceledCallback>
 inline void export_thumbnails_to_file(ThumbnailsGeneratorCallback &thumbnail_cb,
@@ -39,46 +82,13 @@ inline void export_thumbnails_to_file(ThumbnailsGeneratorCallback &thumbnail_cb,
 {
     // Write thumbnails using base64 encoding
     if (thumbnail_cb != nullptr) {
-        static constexpr const size_t max_row_length = 78;
-        ThumbnailsList                thumbnails     = thumbnail_cb(ThumbnailsParams{sizes, true, true, true, true, plate_id});
-        short                         i              = 0;
-        for (const ThumbnailData &data : thumbnails) {
-            if (data.is_valid()) {
-                output("; THUMBNAIL_BLOCK_START\n");
-                auto compressed = compress_thumbnail(data, format);
-                if (compressed->data && compressed->size) {
-                    if (format == GCodeThumbnailsFormat::BTT_TFT) {
-                        // write BTT_TFT header
-                        output((";" + rjust(get_hex(data.width), 4, '0') + rjust(get_hex(data.height), 4, '0') + "\r\n").c_str());
-                        output((char *) compressed->data);
-                        if (i == (thumbnails.size() - 1))
-                            output("; bigtree thumbnail end\r\n\r\n");
-                    } else {
-                        std::string encoded;
-                        encoded.resize(boost::beast::detail::base64::encoded_size(compressed->size));
-                        encoded.resize(boost::beast::detail::base64::encode((void *) encoded.data(), (const void *) compressed->data,
-                                                                            compressed->size));                        
-                        output((boost::format("\n;\n; %s begin %dx%d %d\n") % compressed->tag() % data.width % data.height % encoded.size())
-                                   .str()
-                                   .c_str());                        
-                        while (encoded.size() > max_row_length) {
-                            output((boost::format("; %s\n") % encoded.substr(0, max_row_length)).str().c_str());
-                            encoded = encoded.substr(max_row_length);
-                        }
-
-                        // Orca write remaining ecoded data
-                        if (encoded.size() > 0)
-                            output((boost::format("; %s\n") % encoded).str().c_str());
-
-                        output((boost::format("; %s end\n") % compressed->tag()).str().c_str());
-                    }
-                    throw_if_canceled();
-                }
-                output("; THUMBNAIL_BLOCK_END\n\n");
-
-                i++;
-            }
-        }
+        ThumbnailsList thumbnails = thumbnail_cb(ThumbnailsParams{sizes, true, true, true, true, plate_id});
+        std::vector<const ThumbnailData*> to_compress;
+        for (const ThumbnailData &data : thumbnails)
+            to_compress.emplace_back(&data);
+        std::vector<CompressedImageBufferPtr> compressed = compress_thumbnails(to_compress, format);
+        throw_if_canceled();
+        output(thumbnails_gcode(thumbnails, compressed, format).c_str());
     }
 }
 
@@ -10,6 +10,7 @@
 #include "GCodeProcessor.hpp"
 #include "BoundingBox.hpp"
 #include "LocalesUtils.hpp"
+#include "GCodeWriter.hpp"
 
 
 namespace Slic3r
@@ -76,19 +77,17 @@ public:
         m_gcode_flavor(flavor),
         m_filpar(filament_parameters)
         {
+            // A tool change emits a few kB of G-code, avoid growing the buffer move by move.
+            m_gcode.reserve(4096);
             // adds tag for analyzer:
-            std::ostringstream str;
-            str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Height) << std::to_string(m_layer_height) << "\n"; // don't rely on GCodeAnalyzer knowing the layer height - it knows nothing at priming
-            str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role) << ExtrusionEntity::role_to_string(erWipeTower) << "\n";
-            m_gcode += str.str();
+            m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Height) + std::to_string(m_layer_height) + "\n"; // don't rely on GCodeAnalyzer knowing the layer height - it knows nothing at priming
+            m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role) + ExtrusionEntity::role_to_string(erWipeTower) + "\n";
             change_analyzer_line_width(line_width);
     }
 
     WipeTowerWriter& change_analyzer_line_width(float line_width) {
         // adds tag for analyzer:
-        std::stringstream str;
-        str << ";" << GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Width) << std::to_string(line_width) << "\n";
-        m_gcode += str.str();
+        m_gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Width) + std::to_string(line_width) + "\n";
         return *this;
     }
 
@@ -152,14 +151,18 @@ public:
 	WipeTowerWriter& 			 feedrate(float f)
 	{
         if (f != m_current_feedrate) {
-			m_gcode += "G1" + set_format_F(f) + "\n";
+			m_gcode += "G1";
+			append_format_F(f);
+			m_gcode += "\n";
             m_current_feedrate = f;
         }
 		return *this;
 	}
 
 	const std::string&   gcode() const { return m_gcode; }
+	std::string&         gcode()       { return m_gcode; }
 	const std::vector<WipeTower::Extrusion>& extrusions() const { return m_extrusions; }
+	std::vector<WipeTower::Extrusion>&       extrusions()       { return m_extrusions; }
 	float                x()     const { return m_current_pos.x(); }
 	float                y()     const { return m_current_pos.y(); }
 	const Vec2f& 		 pos()   const { return m_current_pos; }
@@ -201,21 +204,21 @@ public:
 
 		m_gcode += "G1";
         if (std::abs(rot.x() - rotated_current_pos.x()) > (float)EPSILON)
-			m_gcode += set_format_X(rot.x());
+			append_format_X(rot.x());
 
         if (std::abs(rot.y() - rotated_current_pos.y()) > (float)EPSILON)
-			m_gcode += set_format_Y(rot.y());
+			append_format_Y(rot.y());
 
 
 		if (e != 0.f)
-			m_gcode += set_format_E(e);
+			append_format_E(e);
 
 		if (f != 0.f && f != m_current_feedrate) {
             if (limit_volumetric_flow) {
                 float e_speed = e / (((len == 0.f) ? std::abs(e) : len) / f * 60.f);
                 f /= std::max(1.f, e_speed / m_filpar[m_current_tool].max_e_speed);
             }
-			m_gcode += set_format_F(f);
+			append_format_F(f);
         }
 
         m_current_pos.x() = x;
@@ -326,9 +329,9 @@ public:
 			return *this;
 		m_gcode += "G1";
 		if (e != 0.f)
-			m_gcode += set_format_E(e);
+			append_format_E(e);
 		if (f != 0.f && f != m_current_feedrate)
-			m_gcode += set_format_F(f);
+			append_format_F(f);
 		m_gcode += "\n";
 		return *this;
 	}
@@ -356,9 +359,10 @@ public:
 	// Elevate the extruder head above the current print_z position.
 	WipeTowerWriter& z_hop(float hop, float f = 0.f)
 	{ 
-		m_gcode += std::string("G1") + set_format_Z(m_current_z + hop);
+		m_gcode += "G1";
+		append_format_Z(m_current_z + hop);
 		if (f != 0 && f != m_current_feedrate)
-			m_gcode += set_format_F(f);
+			append_format_F(f);
 		m_gcode += "\n";
 		return *this;
 	}
@@ -527,30 +531,28 @@ private:
     GCodeFlavor   m_gcode_flavor;
     const std::vector<WipeTower::FilamentParameters>& m_filpar;
 
-	std::string   set_format_X(float x)
-    {
+	// The numbers are formatted straight into m_gcode, the output is identical to float_to_string_decimal_point().
+	void          append_format_X(float x) {
         m_current_pos.x() = x;
-        return " X" + Slic3r::float_to_string_decimal_point(x, 3);
+        GCodeFormatter::append_fixed(m_gcode, 'X', x, 3);
 	}
 
-	std::string   set_format_Y(float y) {
+	void          append_format_Y(float y) {
         m_current_pos.y() = y;
-        return " Y" + Slic3r::float_to_string_decimal_point(y, 3);
+        GCodeFormatter::append_fixed(m_gcode, 'Y', y, 3);
 	}
 
-	std::string   set_format_Z(float z) {
-        return " Z" + Slic3r::float_to_string_decimal_point(z, 3);
+	void          append_format_Z(float z) {
+        GCodeFormatter::append_fixed(m_gcode, 'Z', z, 3);
 	}
 
-	std::string   set_format_E(float e) {
-        return " E" + Slic3r::float_to_string_decimal_point(e, 4);
+	void          append_format_E(float e) {
+        GCodeFormatter::append_fixed(m_gcode, 'E', e, 4);
 	}
 
-	std::string   set_format_F(float f) {
-        char buf[64];
-        sprintf(buf, " F%d", int(floor(f + 0.5f)));
+	void          append_format_F(float f) {
+        GCodeFormatter::append_fixed(m_gcode, 'F', floor(f + 0.5f), 0);
         m_current_feedrate = f;
-        return buf;
 	}
 
 	WipeTowerWriter& operator=(const WipeTowerWriter &rhs);
@@ -7,10 +7,6 @@
 #include <assert.h>
 #include <GCode/GCodeProcessor.hpp>
 
-#ifdef __APPLE__
-    #include <boost/spirit/include/karma.hpp>
-#endif
-
 #define FLAVOR_IS(val) this->config.gcode_flavor == val
 #define FLAVOR_IS_NOT(val) this->config.gcode_flavor != val
 
@@ -400,6 +396,13 @@ std::string GCodeWriter::set_speed(double F, const std::string &comment, const s
 }
 
 std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &comment)
+{
+    std::string gcode;
+    this->travel_to_xy(gcode, point, comment);
+    return gcode;
+}
+
+void GCodeWriter::travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
@@ -415,7 +418,7 @@ std::string GCodeWriter::travel_to_xy(const Vec2d &point, const std::string &com
     w.emit_f(speed * 60.0);
     //BBS
     w.emit_comment(GCodeWriter::full_gcode_comment, comment);
-    return w.string();
+    w.append_to(out);
 }
 
 std::string GCodeWriter::travel_to_xyz(const Vec3d &point, const std::string &comment)
@@ -620,6 +623,13 @@ bool GCodeWriter::will_move_z(double z) const
 }
 
 std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std::string &comment, bool force_no_extrusion)
+{
+    std::string gcode;
+    this->extrude_to_xy(gcode, point, dE, comment, force_no_extrusion);
+    return gcode;
+}
+
+void GCodeWriter::extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment, bool force_no_extrusion)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
@@ -638,13 +648,20 @@ std::string GCodeWriter::extrude_to_xy(const Vec2d &point, double dE, const std:
         w.emit_e(m_extruder->E());
     //BBS
     w.emit_comment(GCodeWriter::full_gcode_comment, comment);
-    return w.string();
+    w.append_to(out);
 }
 
 //BBS: generate G2 or G3 extrude which moves by arc
 //point is end point which means X and Y axis
 //center_offset is I and J axis
 std::string GCodeWriter::extrude_arc_to_xy(const Vec2d& point, const Vec2d& center_offset, double dE, const bool is_ccw, const std::string& comment, bool force_no_extrusion)
+{
+    std::string gcode;
+    this->extrude_arc_to_xy(gcode, point, center_offset, dE, is_ccw, comment, force_no_extrusion);
+    return gcode;
+}
+
+void GCodeWriter::extrude_arc_to_xy(std::string &out, const Vec2d& point, const Vec2d& center_offset, double dE, const bool is_ccw, const std::string& comment, bool force_no_extrusion)
 {
     m_pos(0) = point(0);
     m_pos(1) = point(1);
@@ -660,7 +677,7 @@ std::string GCodeWriter::extrude_arc_to_xy(const Vec2d& point, const Vec2d& cent
         w.emit_e(m_extruder->E());
     //BBS
     w.emit_comment(GCodeWriter::full_gcode_comment, comment);
-    return w.string();
+    w.append_to(out);
 }
 
 std::string GCodeWriter::extrude_to_xyz(const Vec3d &point, double dE, const std::string &comment, bool force_no_extrusion)
@@ -892,63 +909,103 @@ void GCodeWriter::add_object_change_labels(std::string& gcode)
     add_object_start_labels(gcode);
 }
 
-void GCodeFormatter::emit_axis(const char axis, const double v, size_t digits) {
+namespace {
+
+constexpr const std::array<uint64_t, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+// Write the fixed point number u / 10^frac_digits backwards, ending at end, two decimal digits at a time.
+// All the frac_digits fractional digits are written, the integer part is omitted if zero and omit_zero_int is set.
+// Returns the first character written.
+char* write_fixed_backwards(char *end, uint64_t u, size_t frac_digits, bool omit_zero_int)
+{
+    // Pairs of decimal digits.
+    static constexpr const char digit_pairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    char *it = end;
+    size_t n = frac_digits;
+    for (; n >= 2; n -= 2) {
+        const char *pair = digit_pairs + 2 * (u % 100);
+        u /= 100;
+        *-- it = pair[1];
+        *-- it = pair[0];
+    }
+    if (n > 0) {
+        *-- it = char('0' + u % 10);
+        u /= 10;
+    }
+    if (frac_digits > 0)
+        *-- it = '.';
+    if (u == 0) {
+        if (! omit_zero_int)
+            *-- it = '0';
+        return it;
+    }
+    while (u >= 100) {
+        const char *pair = digit_pairs + 2 * (u % 100);
+        u /= 100;
+        *-- it = pair[1];
+        *-- it = pair[0];
+    }
+    if (u >= 10) {
+        const char *pair = digit_pairs + 2 * u;
+        *-- it = pair[1];
+        *-- it = pair[0];
+    } else
+        *-- it = char('0' + u);
+    return it;
+}
+
+} // namespace
+
+char* GCodeFormatter::format_axis(char *ptr, double v, size_t digits)
+{
+    assert(digits <= 9);
+    auto v_int = int64_t(std::round(v * double(pow_10[digits])));
+    if (v_int == 0) {
+        *ptr ++ = '0';
+        return ptr;
+    }
+    if (v_int < 0)
+        *ptr ++ = '-';
+    // Magnitude of v_int, well defined for INT64_MIN as well.
+    uint64_t u = v_int < 0 ? uint64_t(0) - uint64_t(v_int) : uint64_t(v_int);
+
+    // Drop the trailing zeros of the fraction, they are never emitted.
+    size_t frac_digits = digits;
+    while (frac_digits > 0 && u % 10 == 0) {
+        u /= 10;
+        -- frac_digits;
+    }
+
+    // The integer part is omitted if zero.
+    char  tmp[32];
+    char *end = tmp + sizeof(tmp);
+    char *it  = write_fixed_backwards(end, u, frac_digits, true);
+    memcpy(ptr, it, end - it);
+    return ptr + (end - it);
+}
+
+char* GCodeFormatter::format_fixed(char *ptr, double v, size_t digits)
+{
     assert(digits <= 9);
-    static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
-    *ptr_err.ptr++ = ' '; *ptr_err.ptr++ = axis;
-
-    char *base_ptr = this->ptr_err.ptr;
-    auto  v_int    = int64_t(std::round(v * pow_10[digits]));
-    // Older stdlib on macOS doesn't support std::from_chars at all, so it is used boost::spirit::karma::generate instead of it.
-    // That is a little bit slower than std::to_chars but not much.
-#ifdef __APPLE__
-    boost::spirit::karma::generate(this->ptr_err.ptr, boost::spirit::karma::int_generator<int64_t>(), v_int);
-#else
-    // this->buf_end minus 1 because we need space for adding the extra decimal point.
-    this->ptr_err = std::to_chars(this->ptr_err.ptr, this->buf_end - 1, v_int);
-#endif
-    size_t writen_digits = (this->ptr_err.ptr - base_ptr) - (v_int < 0 ? 1 : 0);
-    if (writen_digits < digits) {
-        // Number is smaller than 10^digits, so that we will pad it with zeros.
-        size_t remaining_digits = digits - writen_digits;
-        // Move all newly inserted chars by remaining_digits to allocate space for padding with zeros.
-        for (char *from_ptr = this->ptr_err.ptr - 1, *to_ptr = from_ptr + remaining_digits; from_ptr >= this->ptr_err.ptr - writen_digits; --to_ptr, --from_ptr)
-            *to_ptr = *from_ptr;
-
-        memset(this->ptr_err.ptr - writen_digits, '0', remaining_digits);
-        this->ptr_err.ptr += remaining_digits;
-    }
-
-    // Move all newly inserted chars by one to allocate space for a decimal point.
-    for (char *to_ptr = this->ptr_err.ptr, *from_ptr = to_ptr - 1; from_ptr >= this->ptr_err.ptr - digits; --to_ptr, --from_ptr)
-        *to_ptr = *from_ptr;
-
-    *(this->ptr_err.ptr - digits) = '.';
-    for (size_t i = 0; i < digits; ++i) {
-        if (*this->ptr_err.ptr != '0')
-            break;
-        this->ptr_err.ptr--;
-    }
-    if (*this->ptr_err.ptr == '.')
-        this->ptr_err.ptr--;
-    if ((this->ptr_err.ptr + 1) == base_ptr || *this->ptr_err.ptr == '-')
-        *(++this->ptr_err.ptr) = '0';
-    this->ptr_err.ptr++;
-
-#if 0 // #ifndef NDEBUG
-    {
-        // Verify that the optimized formatter produces the same result as the standard sprintf().
-        double v1 = atof(std::string(base_ptr, this->ptr_err.ptr).c_str());
-        char buf[2048];
-        sprintf(buf, "%.*lf", int(digits), v);
-        double v2 = atof(buf);
-        // Numbers may differ when rounding at exactly or very close to 0.5 due to numerical issues when scaling the double to an integer.
-        // Thus the complex assert.
-//        assert(v1 == v2);
-        assert(std::abs(v1 - v) * pow_10[digits] < 0.50001);
-        assert(std::abs(v2 - v) * pow_10[digits] < 0.50001);
-    }
-#endif // NDEBUG
+    if (! (std::abs(v) < 1e9)) {
+        // Out of the range of the fixed point conversion below (or not finite at all), fall back to snprintf().
+        return ptr + std::min(std::snprintf(ptr, 64, "%.*f", int(digits), v), 63);
+    }
+
+    // A float has a 24 bit mantissa and the odd part of 10^9 (5^9) has 21 bits, thus the product below is exact for single precision inputs.
+    // std::nearbyint() then rounds the ties to even as printf() does with the exact decimal expansion.
+    uint64_t scaled = uint64_t(std::nearbyint(std::abs(v) * double(pow_10[digits])));
+    if (std::signbit(v))
+        *ptr ++ = '-';
+    char  tmp[32];
+    char *end = tmp + sizeof(tmp);
+    char *it  = write_fixed_backwards(end, scaled, digits, false);
+    memcpy(ptr, it, end - it);
+    return ptr + (end - it);
 }
 
 } // namespace Slic3r
@@ -67,6 +67,11 @@ public:
     // SoftFever NOTE: the returned speed is mm/minute
     double      get_current_speed() const { return m_current_speed;}
     std::string travel_to_xy(const Vec2d &point, const std::string &comment = std::string());
+    // Variants of the hot path moves appending the line to a caller supplied (pre-reserved) G-code buffer
+    // instead of returning a new string per move.
+    void        travel_to_xy(std::string &out, const Vec2d &point, const std::string &comment = std::string());
+    void        extrude_to_xy(std::string &out, const Vec2d &point, double dE, const std::string &comment = std::string(), bool force_no_extrusion = false);
+    void        extrude_arc_to_xy(std::string &out, const Vec2d &point, const Vec2d &center_offset, double dE, const bool is_ccw, const std::string &comment = std::string(), bool force_no_extrusion = false);
     std::string travel_to_xyz(const Vec3d &point, const std::string &comment = std::string());
     std::string travel_to_z(double z, const std::string &comment = std::string());
     bool        will_move_z(double z) const;
@@ -211,7 +216,27 @@ public:
     static double quantize_xyzf(double v) { return quantize(v, XYZF_EXPORT_DIGITS); }
     static double quantize_e(double v) { return quantize(v, E_EXPORT_DIGITS); }
 
-    void emit_axis(const char axis, const double v, size_t digits);
+    void emit_axis(const char axis, const double v, size_t digits) {
+        *ptr_err.ptr ++ = ' '; *ptr_err.ptr ++ = axis;
+        ptr_err.ptr = format_axis(ptr_err.ptr, v, digits);
+    }
+
+    // Write v rounded to "digits" decimal places in the compact G-code notation starting at ptr, return the end of the output.
+    // Trailing zeros of the fraction are dropped together with a trailing decimal point, a zero integer part is omitted
+    // (0.5 is written as ".5", -0.25 as "-.25") and a value rounding to zero is written as "0". Up to 22 characters are written.
+    static char* format_axis(char *ptr, double v, size_t digits);
+
+    // Write v with exactly "digits" decimal places (trailing zeros are kept) starting at ptr, return the end of the output.
+    // Up to 64 characters are written. For single precision input values the output matches printf("%.*f")
+    // byte for byte, including rounding of the ties to even.
+    static char* format_fixed(char *ptr, double v, size_t digits);
+    // Append " <axis><v>" formatted by format_fixed() to out.
+    static void  append_fixed(std::string &out, const char axis, double v, size_t digits) {
+        char buf[72];
+        buf[0] = ' ';
+        buf[1] = axis;
+        out.append(buf, format_fixed(buf + 2, v, digits) - buf);
+    }
 
     void emit_xy(const Vec2d &point) {
         this->emit_axis('X', point.x(), XYZF_EXPORT_DIGITS);
@@ -258,6 +283,12 @@ public:
         return std::string(this->buf, ptr_err.ptr - buf);
     }
 
+    // Terminate the line and append it to out, sparing the temporary string of string().
+    void append_to(std::string &out) {
+        *ptr_err.ptr ++ = '\n';
+        out.append(this->buf, ptr_err.ptr - buf);
+    }
+
 protected:
     static constexpr const size_t   buflen = 256;
     char                            buf[buflen];
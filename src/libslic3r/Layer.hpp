@@ -16,6 +16,7 @@ class LayerRegion;
 using LayerRegionPtrs = std::vector<LayerRegion*>;
 class PrintRegion;
 class PrintObject;
+struct MemoryUsage;
 
 namespace FillAdaptive {
     struct Octree;
@@ -94,6 +95,8 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     bool    has_extrusions() const { return ! this->perimeters.entities.empty() || ! this->fills.entities.empty(); }
+    // Free the extrusions once they were exported by the bounded memory G-code export.
+    void    release_extrusions() { this->perimeters.clear(); this->fills.clear(); this->thin_fills.clear(); }
     //BBS
     void    simplify_infill_extrusion_entity() { simplify_entity_collection(&fills); }
     void    simplify_wall_extrusion_entity() { simplify_entity_collection(&perimeters); }
@@ -195,6 +198,8 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool            has_extrusions() const { for (auto layerm : m_regions) if (layerm->has_extrusions()) return true; return false; }
+    // Free the extrusions once they were exported by the bounded memory G-code export, see Print::set_streaming_gcode_export().
+    virtual void            release_extrusions() { for (auto layerm : m_regions) layerm->release_extrusions(); }
 
     //BBS
     void simplify_wall_extrusion_path() { for (auto layerm : m_regions) layerm->simplify_wall_extrusion_entity();}
@@ -282,6 +287,7 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool                has_extrusions() const { return ! support_fills.empty(); }
+    void                        release_extrusions() override { Layer::release_extrusions(); support_fills.clear(); }
 
     // Zero based index of an interface layer, used for alternating direction of interface / contact layers.
     size_t                      interface_id() const { return m_interface_id; }
@@ -291,6 +297,7 @@ public:
 protected:
     friend class PrintObject;
     friend class TreeSupport;
+    friend void memory_used(const SupportLayer &layer, MemoryUsage &usage);
 
     // The constructor has been made public to be able to insert additional support layers for the skirt or a wipe tower
     // between the raft and the object first layer.
@@ -0,0 +1,149 @@
+#include "MemoryStats.hpp"
+#include "ExtrusionEntity.hpp"
+#include "ExtrusionEntityCollection.hpp"
+#include "Layer.hpp"
+#include "GCode/GCodeProcessor.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace Slic3r {
+
+const char* memory_category_name(MemoryCategory category)
+{
+    static constexpr const char *names[] = { "layers", "layer_regions", "extrusion_entities", "support_layers", "caches", "gcode_processor_result" };
+    static_assert(sizeof(names) / sizeof(names[0]) == size_t(MemoryCategory::Count));
+    return names[size_t(category)];
+}
+
+size_t MemoryUsage::total() const
+{
+    size_t out = 0;
+    for (size_t b : bytes)
+        out += b;
+    return out;
+}
+
+void MemoryUsage::update_peak(const MemoryUsage &rhs)
+{
+    for (size_t i = 0; i < bytes.size(); ++ i)
+        bytes[i] = std::max(bytes[i], rhs.bytes[i]);
+}
+
+template<typename T>
+static inline size_t vector_memory(const std::vector<T> &v) { return v.capacity() * sizeof(T); }
+
+static inline size_t memory_used(const MultiPoint &mp) { return vector_memory(mp.points); }
+static inline size_t memory_used(const Polyline &polyline) { return vector_memory(polyline.points) + vector_memory(polyline.fitting_result); }
+
+static inline size_t memory_used(const ExPolygon &expoly)
+{
+    size_t out = memory_used(expoly.contour) + vector_memory(expoly.holes);
+    for (const Polygon &hole : expoly.holes)
+        out += memory_used(hole);
+    return out;
+}
+
+template<typename T>
+static inline size_t vector_memory_deep(const std::vector<T> &v)
+{
+    size_t out = vector_memory(v);
+    for (const T &item : v)
+        out += memory_used(item);
+    return out;
+}
+
+size_t memory_used(const ExPolygons &expolygons)
+{
+    return vector_memory_deep(expolygons);
+}
+
+static inline size_t memory_used(const SurfaceCollection &surfaces)
+{
+    size_t out = vector_memory(surfaces.surfaces);
+    for (const Surface &surface : surfaces.surfaces)
+        out += memory_used(surface.expolygon);
+    return out;
+}
+
+// Node of a std::map, approximately.
+template<typename Key, typename Value>
+static inline size_t map_memory(const std::map<Key, Value> &map) { return map.size() * (sizeof(std::pair<const Key, Value>) + 4 * sizeof(void*)); }
+
+static inline size_t memory_used(const ExtrusionPath &path) { return memory_used(path.polyline); }
+
+static inline size_t memory_used(const ExtrusionPaths &paths)
+{
+    size_t out = vector_memory(paths);
+    for (const ExtrusionPath &path : paths)
+        out += memory_used(path);
+    return out;
+}
+
+size_t memory_used(const ExtrusionEntity &entity)
+{
+    if (auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        size_t out = vector_memory(collection->entities);
+        for (const ExtrusionEntity *child : collection->entities) {
+            if (dynamic_cast<const ExtrusionEntityCollection*>(child))
+                out += sizeof(ExtrusionEntityCollection);
+            else if (dynamic_cast<const ExtrusionLoop*>(child))
+                out += sizeof(ExtrusionLoop);
+            else if (dynamic_cast<const ExtrusionMultiPath*>(child))
+                out += sizeof(ExtrusionMultiPath);
+            else
+                out += sizeof(ExtrusionPathOriented);
+            out += memory_used(*child);
+        }
+        return out;
+    }
+    if (auto *path = dynamic_cast<const ExtrusionPath*>(&entity))
+        return memory_used(*path);
+    if (auto *loop = dynamic_cast<const ExtrusionLoop*>(&entity))
+        return memory_used(loop->paths);
+    if (auto *multi_path = dynamic_cast<const ExtrusionMultiPath*>(&entity))
+        return memory_used(multi_path->paths);
+    return 0;
+}
+
+static void memory_used_layer(const Layer &layer, size_t sizeof_layer, MemoryUsage &usage)
+{
+    usage[MemoryCategory::Layers] += sizeof_layer + vector_memory_deep(layer.lslices) + vector_memory(layer.lslices_bboxes) +
+        vector_memory_deep(layer.loverhangs) + vector_memory(layer.curled_lines) +
+        vector_memory_deep(layer.sharp_tails) + vector_memory_deep(layer.cantilevers) + map_memory(layer.sharp_tails_height) +
+        vector_memory(layer.regions());
+    for (const LayerRegion *layerm : layer.regions()) {
+        usage[MemoryCategory::LayerRegions] += sizeof(LayerRegion) + memory_used(layerm->slices) + vector_memory_deep(layerm->raw_slices) +
+            vector_memory_deep(layerm->fill_expolygons) + memory_used(layerm->fill_surfaces) + vector_memory_deep(layerm->fill_no_overlap_expolygons) +
+            vector_memory_deep(layerm->unsupported_bridge_edges);
+        usage[MemoryCategory::ExtrusionEntities] += memory_used(layerm->thin_fills) + memory_used(layerm->perimeters) + memory_used(layerm->fills);
+    }
+}
+
+void memory_used(const Layer &layer, MemoryUsage &usage)
+{
+    memory_used_layer(layer, sizeof(Layer), usage);
+}
+
+void memory_used(const SupportLayer &layer, MemoryUsage &usage)
+{
+    MemoryUsage layer_usage;
+    memory_used_layer(layer, sizeof(SupportLayer), layer_usage);
+    usage[MemoryCategory::SupportLayers] += layer_usage.total() +
+        vector_memory_deep(layer.support_islands) + memory_used(layer.support_fills) +
+        vector_memory_deep(layer.base_areas) + vector_memory_deep(layer.overhang_areas) +
+        vector_memory_deep(layer.roof_areas) + vector_memory_deep(layer.roof_1st_layer) +
+        vector_memory_deep(layer.floor_areas) + vector_memory_deep(layer.roof_gap_areas) +
+        vector_memory(layer.area_groups) + map_memory(layer.overhang_types);
+}
+
+size_t memory_used(const GCodeProcessorResult &result)
+{
+    size_t out = vector_memory(result.moves) + vector_memory(result.lines_ends) + vector_memory(result.spiral_vase_layers) +
+        vector_memory(result.custom_gcode_per_print_z) + vector_memory(result.warnings);
+    for (const GCodeProcessorResult::MoveVertex &move : result.moves)
+        out += vector_memory(move.interpolation_points);
+    return out;
+}
+
+} // namespace Slic3r
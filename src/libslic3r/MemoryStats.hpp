@@ -0,0 +1,79 @@
+#ifndef slic3r_MemoryStats_hpp_
+#define slic3r_MemoryStats_hpp_
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Accounting of the memory held by the slicing data structures. Unlike log_memory_info(), which reports the memory
+// of the whole process, the estimates tell which step of which object and which data structure holds the memory.
+// The estimates are computed by walking the data structures: capacities of the containers are accounted,
+// the overhead of the allocator is not.
+namespace Slic3r {
+
+class ExPolygon;
+class ExtrusionEntity;
+class Layer;
+class SupportLayer;
+struct GCodeProcessorResult;
+
+enum class MemoryCategory : int
+{
+    // Layer without its regions: layer islands, overhangs, curled lines, support detection data.
+    Layers,
+    // LayerRegion without its extrusions: slices, fill surfaces and polygons.
+    LayerRegions,
+    // Perimeters, infill and gap fill extrusions of the layer regions.
+    ExtrusionEntities,
+    // Support layers including their extrusions.
+    SupportLayers,
+    // Data kept between the steps, which may be released and regenerated on demand.
+    Caches,
+    // Sampled once after the G-code export, not per object step.
+    GCodeProcessorResult,
+    Count
+};
+
+const char* memory_category_name(MemoryCategory category);
+
+// Estimated heap memory in bytes per category.
+struct MemoryUsage
+{
+    std::array<size_t, size_t(MemoryCategory::Count)> bytes {};
+
+    size_t  operator[](MemoryCategory category) const { return bytes[size_t(category)]; }
+    size_t& operator[](MemoryCategory category) { return bytes[size_t(category)]; }
+    size_t  total() const;
+    // Element wise maximum.
+    void    update_peak(const MemoryUsage &rhs);
+};
+
+// Memory of a single PrintObject sampled after each of its steps.
+struct ObjectMemoryStats
+{
+    // Step name (a string literal) and the memory held by the object after the step finished.
+    std::vector<std::pair<const char*, MemoryUsage>> steps;
+    // Element wise maximum of the samples.
+    MemoryUsage     peak;
+    // Bytes of the caches released to keep the print within its memory budget.
+    size_t          released_caches { 0 };
+    // Total of the last sample, already accounted into the estimate of the whole print.
+    size_t          last_total { 0 };
+
+    void clear() { *this = ObjectMemoryStats(); }
+};
+
+// Heap memory of the polygons, not including sizeof(expolygons).
+size_t memory_used(const std::vector<ExPolygon> &expolygons);
+// Heap memory of an extrusion entity including its children, not including sizeof(entity).
+size_t memory_used(const ExtrusionEntity &entity);
+// Memory of a layer including its regions and extrusions, split into categories.
+void   memory_used(const Layer &layer, MemoryUsage &usage);
+void   memory_used(const SupportLayer &layer, MemoryUsage &usage);
+// Heap memory of the G-code processor result, not including sizeof(result).
+size_t memory_used(const GCodeProcessorResult &result);
+
+} // namespace Slic3r
+
+#endif // slic3r_MemoryStats_hpp_
@@ -6,6 +6,7 @@
 #include "Geometry/VoronoiVisualUtils.hpp"
 #include "MutablePolygon.hpp"
 #include "format.hpp"
+#include "Utils.hpp"
 
 #include <utility>
 #include <cfloat>
@@ -13,8 +14,7 @@
 
 #include <boost/log/trivial.hpp>
 #include <tbb/parallel_for.h>
-#include <mutex>
-#include <boost/thread/lock_guard.hpp>
+#include <tbb/enumerable_thread_specific.h>
 
 namespace Slic3r {
 struct ColoredLine {
@@ -80,17 +80,21 @@ static bool project_line_on_line(const Line &projection_l, const Line &projected
     return true;
 }
 
+// Millions of painted lines may be alive at once for heavily painted objects, thus the indices are stored in 32 bits.
 struct PaintedLine
 {
-    size_t contour_idx;
-    size_t line_idx;
-    Line   projected_line;
-    int    color;
+    uint32_t contour_idx;
+    uint32_t line_idx;
+    Line     projected_line;
+    int      color;
 };
 
+// Painted lines of all layers collected by a single thread, indexed by layer.
+using PaintedLinesPerLayer = std::vector<std::vector<PaintedLine>>;
+
 struct PaintedLineVisitor
 {
-    PaintedLineVisitor(const EdgeGrid::Grid &grid, std::vector<PaintedLine> &painted_lines, std::mutex &painted_lines_mutex, size_t reserve) : grid(grid), painted_lines(painted_lines), painted_lines_mutex(painted_lines_mutex)
+    PaintedLineVisitor(const EdgeGrid::Grid &grid, std::vector<PaintedLine> &painted_lines, size_t reserve) : grid(grid), painted_lines(painted_lines)
     {
         painted_lines_set.reserve(reserve);
     }
@@ -132,10 +136,7 @@ struct PaintedLineVisitor
                             line_to_test_projected.reverse();
 
                         painted_lines_set.insert(*it_contour_and_segment);
-                        {
-                            boost::lock_guard<std::mutex> lock(painted_lines_mutex);
-                            painted_lines.push_back({it_contour_and_segment->first, it_contour_and_segment->second, line_to_test_projected, this->color});
-                        }
+                        painted_lines.push_back({uint32_t(it_contour_and_segment->first), uint32_t(it_contour_and_segment->second), line_to_test_projected, this->color});
                     }
                 }
             }
@@ -145,8 +146,8 @@ struct PaintedLineVisitor
     }
 
     const EdgeGrid::Grid                                                                 &grid;
+    // Thread local, thus no locking is needed.
     std::vector<PaintedLine>                                                             &painted_lines;
-    std::mutex                                                                           &painted_lines_mutex;
     Line                                                                                  line_to_test;
     std::unordered_set<std::pair<size_t, size_t>, boost::hash<std::pair<size_t, size_t>>> painted_lines_set;
     int                                                                                   color             = -1;
@@ -1834,7 +1835,6 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
     std::vector<std::vector<ExPolygons>>  segmented_regions(num_layers);
     segmented_regions.assign(num_layers, std::vector<ExPolygons>(num_extruders + 1));
     std::vector<std::vector<PaintedLine>> painted_lines(num_layers);
-    std::array<std::mutex, 64>            painted_lines_mutex;
     std::vector<EdgeGrid::Grid>           edge_grids(num_layers);
     const ConstLayerPtrsAdaptor           layers = print_object.layers();
     std::vector<ExPolygons>               input_expolygons(num_layers);
@@ -1881,23 +1881,29 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
         layer_bboxes[layer_idx].merge(get_extents(input_expolygons[layer_idx]));
     }
 
-    for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
-        throw_on_cancel_callback();
-        BoundingBox bbox = layer_bboxes[layer_idx];
-        // Projected triangles could, in rare cases (as in GH issue #7299), belongs to polygons printed in the previous or the next layer.
-        // Let's merge the bounding box of the current layer with bounding boxes of the previous and the next layer to ensure that
-        // every projected triangle will be inside the resulting bounding box.
-        if (layer_idx > 1) bbox.merge(layer_bboxes[layer_idx - 1]);
-        if (layer_idx < num_layers - 1) bbox.merge(layer_bboxes[layer_idx + 1]);
-        // Projected triangles may slightly exceed the input polygons.
-        bbox.offset(20 * SCALED_EPSILON);
-        edge_grids[layer_idx].set_bbox(bbox);
-        edge_grids[layer_idx].create(input_expolygons[layer_idx], coord_t(scale_(10.)));
-    }
+    // The edge grids are built once per layer and shared by all the volumes and extruders projected onto that layer.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&layer_bboxes, &edge_grids, &input_expolygons, &num_layers, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+            throw_on_cancel_callback();
+            BoundingBox bbox = layer_bboxes[layer_idx];
+            // Projected triangles could, in rare cases (as in GH issue #7299), belongs to polygons printed in the previous or the next layer.
+            // Let's merge the bounding box of the current layer with bounding boxes of the previous and the next layer to ensure that
+            // every projected triangle will be inside the resulting bounding box.
+            if (layer_idx > 1) bbox.merge(layer_bboxes[layer_idx - 1]);
+            if (layer_idx < num_layers - 1) bbox.merge(layer_bboxes[layer_idx + 1]);
+            // Projected triangles may slightly exceed the input polygons.
+            bbox.offset(20 * SCALED_EPSILON);
+            edge_grids[layer_idx].set_bbox(bbox);
+            edge_grids[layer_idx].create(input_expolygons[layer_idx], coord_t(scale_(10.)));
+        }
+    }); // end of parallel_for
+
+    // Each thread collects painted lines into its own buffers, they are merged per layer once the projection is finished.
+    tbb::enumerable_thread_specific<PaintedLinesPerLayer> painted_lines_per_thread{ PaintedLinesPerLayer(num_layers) };
 
     BOOST_LOG_TRIVIAL(debug) << "MMU segmentation - projection of painted triangles - begin";
     for (const ModelVolume *mv : print_object.model_object()->volumes) {
-        tbb::parallel_for(tbb::blocked_range<size_t>(1, num_extruders + 1), [&mv, &print_object, &layers, &edge_grids, &painted_lines, &painted_lines_mutex, &input_expolygons, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(1, num_extruders + 1), [&mv, &print_object, &layers, &edge_grids, &painted_lines_per_thread, &input_expolygons, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
             for (size_t extruder_idx = range.begin(); extruder_idx < range.end(); ++extruder_idx) {
                 throw_on_cancel_callback();
                 const indexed_triangle_set custom_facets = mv->mmu_segmentation_facets.get_facets(*mv, EnforcerBlockerType(extruder_idx));
@@ -1905,7 +1911,8 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                     continue;
 
                 const Transform3f tr = print_object.trafo().cast<float>() * mv->get_matrix().cast<float>();
-                tbb::parallel_for(tbb::blocked_range<size_t>(0, custom_facets.indices.size()), [&tr, &custom_facets, &print_object, &layers, &edge_grids, &input_expolygons, &painted_lines, &painted_lines_mutex, &extruder_idx](const tbb::blocked_range<size_t> &range) {
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, custom_facets.indices.size()), [&tr, &custom_facets, &print_object, &layers, &edge_grids, &input_expolygons, &painted_lines_per_thread, &extruder_idx](const tbb::blocked_range<size_t> &range) {
+                    PaintedLinesPerLayer &painted_lines = painted_lines_per_thread.local();
                     for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++facet_idx) {
                         float min_z = std::numeric_limits<float>::max();
                         float max_z = std::numeric_limits<float>::lowest();
@@ -1968,10 +1975,7 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                                     continue;
                             }
 
-                            size_t mutex_idx = layer_idx & 0x3F;
-                            assert(mutex_idx < painted_lines_mutex.size());
-
-                            PaintedLineVisitor visitor(edge_grids[layer_idx], painted_lines[layer_idx], painted_lines_mutex[mutex_idx], 16);
+                            PaintedLineVisitor visitor(edge_grids[layer_idx], painted_lines[layer_idx], 16);
                             visitor.line_to_test = line_to_test;
                             visitor.color        = int(extruder_idx);
                             edge_grids[layer_idx].visit_cells_intersecting_line(line_to_test.a, line_to_test.b, visitor);
@@ -1982,6 +1986,32 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
         }); // end of parallel_for
     }
     BOOST_LOG_TRIVIAL(debug) << "MMU segmentation - projection of painted triangles - end";
+
+    // Merge the thread local painted lines, releasing the thread local buffers layer by layer.
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, num_layers), [&painted_lines, &painted_lines_per_thread](const tbb::blocked_range<size_t> &range) {
+        for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
+            size_t num_painted_lines = 0;
+            for (const PaintedLinesPerLayer &painted_lines_local : painted_lines_per_thread)
+                num_painted_lines += painted_lines_local[layer_idx].size();
+            painted_lines[layer_idx].reserve(num_painted_lines);
+            for (PaintedLinesPerLayer &painted_lines_local : painted_lines_per_thread) {
+                Slic3r::append(painted_lines[layer_idx], std::move(painted_lines_local[layer_idx]));
+                painted_lines_local[layer_idx] = std::vector<PaintedLine>();
+            }
+        }
+    }); // end of parallel_for
+    painted_lines_per_thread.clear();
+
+    {
+        // Edge grids and painted lines are released layer by layer during the segmentation below, thus the memory is at its peak here.
+        size_t edge_grids_memory = 0, painted_lines_memory = 0;
+        for (size_t layer_idx = 0; layer_idx < num_layers; ++layer_idx) {
+            edge_grids_memory    += edge_grids[layer_idx].memory_used();
+            painted_lines_memory += painted_lines[layer_idx].capacity() * sizeof(PaintedLine);
+        }
+        BOOST_LOG_TRIVIAL(info) << "MMU segmentation - peak memory of edge grids: " << format_memsize_MB(edge_grids_memory)
+                                << ", painted lines: " << format_memsize_MB(painted_lines_memory) << log_memory_info();
+    }
     BOOST_LOG_TRIVIAL(debug) << "MMU segmentation - painted layers count: "
                              << std::count_if(painted_lines.begin(), painted_lines.end(), [](const std::vector<PaintedLine> &pl) { return !pl.empty(); });
 
@@ -2042,6 +2072,10 @@ std::vector<std::vector<ExPolygons>> multi_material_segmentation_by_painting(con
                 }
 #endif // MMU_SEGMENTATION_DEBUG_REGIONS
             }
+            // Neither the edge grid nor the painted lines of this layer are needed anymore, release them right away
+            // to bound the memory consumption of the segmentation.
+            edge_grids[layer_idx]    = EdgeGrid::Grid();
+            painted_lines[layer_idx] = std::vector<PaintedLine>();
         }
     }); // end of parallel_for
     BOOST_LOG_TRIVIAL(debug) << "MMU segmentation - layers segmentation in parallel - end";
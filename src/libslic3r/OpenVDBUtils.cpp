@@ -15,6 +15,8 @@
 #include <openvdb/tools/Composite.h>
 #include <openvdb/tools/LevelSetRebuild.h>
 
+#include <tbb/parallel_for.h>
+
 //#include "MTUtils.hpp"
 
 namespace Slic3r {
@@ -61,16 +63,37 @@ openvdb::FloatGrid::Ptr mesh_to_grid(const indexed_triangle_set &    mesh,
 
     meshparts.erase(it, meshparts.end());
 
-    openvdb::FloatGrid::Ptr grid;
-    for (auto &m : meshparts) {
-        auto subgrid = openvdb::tools::meshToVolume<openvdb::FloatGrid>(
-            TriangleMeshDataAdapter{m, voxel_scale}, tr, exteriorBandWidth,
+    // Convert the parts in parallel. meshToVolume() is threaded internally as
+    // well, but most of its work is per part, so small parts would otherwise
+    // keep the other threads idle.
+    std::vector<openvdb::FloatGrid::Ptr> grids(meshparts.size());
+    tbb::parallel_for(size_t(0), meshparts.size(), [&](size_t i) {
+        grids[i] = openvdb::tools::meshToVolume<openvdb::FloatGrid>(
+            TriangleMeshDataAdapter{meshparts[i], voxel_scale}, tr, exteriorBandWidth,
             interiorBandWidth, flags);
-
-        if (grid && subgrid) openvdb::tools::csgUnion(*grid, *subgrid);
-        else if (subgrid) grid = std::move(subgrid);
+        // Release the part mesh as soon as it is not needed.
+        meshparts[i] = {};
+    });
+
+    // Merge the subgrids by a pairwise union, halving their count with each
+    // pass. The merged grid ends up in grids.front().
+    for (size_t step = 1; step < grids.size(); step *= 2) {
+        size_t npairs = (grids.size() + 2 * step - 1) / (2 * step);
+        tbb::parallel_for(size_t(0), npairs, [&grids, step](size_t pair) {
+            size_t a = 2 * step * pair, b = a + step;
+            if (b >= grids.size())
+                return;
+            if (grids[a] && grids[b])
+                openvdb::tools::csgUnion(*grids[a], *grids[b]);
+            else if (grids[b])
+                grids[a] = std::move(grids[b]);
+            grids[b].reset();
+        });
     }
 
+    openvdb::FloatGrid::Ptr grid = grids.empty() ? nullptr : grids.front();
+    grids.clear();
+
     if (grid) {
         grid = openvdb::tools::levelSetRebuild(*grid, 0., exteriorBandWidth,
                                                interiorBandWidth);
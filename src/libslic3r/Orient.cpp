@@ -4,6 +4,8 @@
 #include <ClipperUtils.hpp>
 #include <boost/geometry/index/rtree.hpp>
 #include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <chrono>
 
 #if defined(_MSC_VER) && defined(__clang__)
 #define BOOST_NO_CXX17_HDR_STRING_VIEW
@@ -63,10 +65,15 @@ public:
     Eigen::MatrixXf normals, normals_quantize, normals_hull, normals_hull_quantize;
     Eigen::VectorXf areas, areas_hull;
     Eigen::VectorXf is_apperance; // whether a facet is outer apperance
-    Eigen::MatrixXf z_projected;
-    Eigen::VectorXf z_max, z_max_hull;  // max of projected z
-    Eigen::VectorXf z_median;  // median of projected z
-    Eigen::VectorXf z_mean;  // mean of projected z
+    // Facet vertices packed column-wise (one row per facet), so that a whole batch of candidate
+    // orientations is projected by a few SIMD friendly matrix products instead of per facet dot products.
+    Eigen::MatrixXf vertices[3], vertices_hull[3];
+    // Projections of a batch of candidate orientations, one column per candidate.
+    // z_mean is only filled in when minimizing the support volume.
+    Eigen::MatrixXf normal_projections;
+    Eigen::MatrixXf z_max, z_mean, z_max_hull;
+    // Lowest projected vertex of each candidate of the batch.
+    Eigen::VectorXf z_min;
     std::vector<Vec3f> face_normals;
     std::vector<Vec3f> face_normals_hull;
     OrientParams params;
@@ -74,6 +81,15 @@ public:
 
     std::vector< Vec3f> orientations;  // Vec3f == stl_normal
     std::function<void(unsigned)> progressind = { };  // default empty indicator function
+    std::function<bool(void)>     stopcondition = { };
+
+    // Number of candidate orientations evaluated together by project_vertices().
+    static constexpr size_t BATCH_SIZE = 16;
+    // Upper bound of facets x candidates of a batch, so that the projections of a batch of a mesh
+    // with millions of facets take tens of MB, the batch gets smaller for such meshes.
+    static constexpr size_t BATCH_MAX_ELEMENTS = 4 * 1024 * 1024;
+    // Facets projected at once by project_vertices(), bounding its temporaries.
+    static constexpr Eigen::Index FACET_RANGE = 16 * 1024;
 
 public:
     AutoOrienter(OrientMesh* orient_mesh_,
@@ -85,6 +101,7 @@ public:
         mesh = &orient_mesh->mesh;
         params = params_;
         progressind = progressind_;
+        stopcondition = stopcond_;
         params.ASCENT = cos(PI - orient_mesh->overhang_angle * PI / 180); // use per-object overhang angle
         
         // BOOST_LOG_TRIVIAL(info) << orient_mesh->name << ", angle=" << orient_mesh->overhang_angle << ", params.ASCENT=" << params.ASCENT;
@@ -99,6 +116,14 @@ public:
         preprocess();
     }
 
+    AutoOrienter(TriangleMesh* mesh_, const OrientParams &params_)
+    {
+        mesh = mesh_;
+        params = params_;
+        stopcondition = params_.stopcondition;
+        preprocess();
+    }
+
     struct VecHash {
         size_t operator()(const Vec3f& n1) const {
             return std::hash<coord_t>()(int(n1(0)*100+100)) + std::hash<coord_t>()(int(n1(1)*100+100)) * 101 + std::hash<coord_t>()(int(n1(2)*100+100)) * 10221;
@@ -128,22 +153,43 @@ public:
             progressind(30);
 
         std::unordered_map<Vec3f, CostItems, VecHash> results;
-        BOOST_LOG_TRIVIAL(info) << CostItems::field_names();
-        std::cout << CostItems::field_names() << std::endl;
-        for (int i = 0; i < orientations.size();i++) {
-            auto orientation = -orientations[i];
+        BOOST_LOG_TRIVIAL(debug) << CostItems::field_names();
+        // The candidates are ordered by their expected quality (the original orientation first, then the largest
+        // flat areas), thus if the time budget runs out, the most promising ones have already been evaluated.
+        const auto   time_start = std::chrono::steady_clock::now();
+        const size_t batch_size = std::clamp<size_t>(BATCH_MAX_ELEMENTS / std::max<size_t>(mesh->facets_count(), 1), 1, BATCH_SIZE);
+        for (size_t batch_begin = 0; batch_begin < orientations.size(); batch_begin += batch_size) {
+            if (stopcondition && stopcondition())
+                break;
+            if (batch_begin > 0 && params.max_time_per_object > 0.f &&
+                std::chrono::duration<float>(std::chrono::steady_clock::now() - time_start).count() > params.max_time_per_object) {
+                BOOST_LOG_TRIVIAL(warning) << "Orienting " << (orient_mesh ? orient_mesh->name : std::string()) << ": time limit of "
+                                           << params.max_time_per_object << "s reached, evaluated " << batch_begin << " of "
+                                           << orientations.size() << " candidate orientations";
+                break;
+            }
+
+            const size_t batch_end = std::min(batch_begin + batch_size, orientations.size());
+            Eigen::MatrixXf batch(3, batch_end - batch_begin);
+            for (size_t i = batch_begin; i < batch_end; ++ i)
+                batch.col(i - batch_begin) = -orientations[i];
 
-            project_vertices(orientation);
+            project_vertices(batch);
 
-            auto cost_items = get_features(orientation, params.min_volume);
+            for (Eigen::Index col = 0; col < batch.cols(); ++ col) {
+                Vec3f orientation = batch.col(col);
 
-            float unprintability = target_function(cost_items, params.min_volume);
+                auto cost_items = get_features(col, params.min_volume);
 
-            results[orientation] = cost_items;
+                float unprintability = target_function(cost_items, params.min_volume);
 
-            BOOST_LOG_TRIVIAL(info) << std::fixed << std::setprecision(4) << "orientation:" << orientation.transpose() << ", cost:" << std::fixed << std::setprecision(4) << cost_items.field_values();
-            std::cout << std::fixed << std::setprecision(4) << "orientation:" << orientation.transpose() << ", cost:" << std::fixed << std::setprecision(4) << cost_items.field_values() << std::endl;
+                results[orientation] = cost_items;
+
+                BOOST_LOG_TRIVIAL(debug) << std::fixed << std::setprecision(4) << "orientation:" << orientation.transpose() << ", cost:" << std::fixed << std::setprecision(4) << cost_items.field_values();
+            }
         }
+        if (results.empty())
+            return Vec3d(0, 0, 1);
         if (progressind)
             progressind(60);
 
@@ -172,7 +218,6 @@ public:
         }
 
         BOOST_LOG_TRIVIAL(info) << std::fixed << std::setprecision(6) << "best:" << best_orientation.transpose() << ", costs:" << results_vector[0].second.field_values();
-        std::cout << std::fixed << std::setprecision(6) << "best:" << best_orientation.transpose() << ", costs:" << results_vector[0].second.field_values() << std::endl;
 
         return best_orientation.cast<double>();
     }
@@ -182,19 +227,20 @@ public:
         int count_apperance = 0;
         {
             int face_count = mesh->facets_count();
-            auto its = mesh->its;
+            const indexed_triangle_set &its = mesh->its;
             face_normals = its_face_normals(its);
             areas = Eigen::VectorXf::Zero(face_count);
             is_apperance = Eigen::VectorXf::Zero(face_count);
             normals = Eigen::MatrixXf::Zero(face_count, 3);
             normals_quantize = Eigen::MatrixXf::Zero(face_count, 3);
+            pack_vertices(its, vertices);
             for (size_t i = 0; i < face_count; i++)
             {
                 float area = its.facet_area(i);
                 normals.row(i) = face_normals[i];
                 normals_quantize.row(i) = quantize_vec3f(face_normals[i]);
                 areas(i) = area;
-                is_apperance(i) = (its.get_property(i).type == EnumFaceTypes::eExteriorAppearance);
+                is_apperance(i) = (mesh->its.get_property(i).type == EnumFaceTypes::eExteriorAppearance);
                 count_apperance += (is_apperance(i)==1);
             }
         }
@@ -208,12 +254,13 @@ public:
             //mesh_convex_hull.write_binary("convex_hull_debug.stl");
 
             int face_count = mesh_convex_hull.facets_count();
-            auto its = mesh_convex_hull.its;
+            const indexed_triangle_set &its = mesh_convex_hull.its;
             face_count_hull = mesh_convex_hull.facets_count();
             face_normals_hull = its_face_normals(its);
             areas_hull = Eigen::VectorXf::Zero(face_count);
             normals_hull = Eigen::MatrixXf::Zero(face_count_hull, 3);
             normals_hull_quantize = Eigen::MatrixXf::Zero(face_count_hull, 3);
+            pack_vertices(its, vertices_hull);
             for (size_t i = 0; i < face_count; i++)
             {
                 float area = its.facet_area(i);
@@ -225,6 +272,15 @@ public:
         }
     }
 
+    static void pack_vertices(const indexed_triangle_set &its, Eigen::MatrixXf (&out)[3])
+    {
+        for (int j = 0; j < 3; ++ j)
+            out[j].resize(its.indices.size(), 3);
+        for (size_t i = 0; i < its.indices.size(); ++ i)
+            for (int j = 0; j < 3; ++ j)
+                out[j].row(i) = its.get_vertex(i, j);
+    }
+
     void area_cumulation(const Eigen::MatrixXf& normals_, const Eigen::VectorXf& areas_, int num_directions = 10)
     {
         std::unordered_map<stl_normal, float, VecHash> alignments;
@@ -315,35 +371,36 @@ public:
         }
     }
 
-    void project_vertices(Vec3f orientation)
+    // Project the packed normals and vertices onto a batch of orientations (3 x K matrix, one candidate per column).
+    // The vertices are projected by ranges of facets, so that only the per facet results are stored for the whole mesh.
+    void project_vertices(const Eigen::MatrixXf &batch)
     {
-        int face_count = mesh->facets_count();
-        auto its = mesh->its;
-        z_projected.resize(face_count, 3);
-        z_max.resize(face_count, 1);
-        z_median.resize(face_count, 1);
-        z_mean.resize(face_count, 1);
-        for (size_t i = 0; i < face_count; i++)
-        {
-            float z0 = its.get_vertex(i,0).dot(orientation);
-            float z1 = its.get_vertex(i,1).dot(orientation);
-            float z2 = its.get_vertex(i,2).dot(orientation);
-            z_projected(i, 0) = z0;
-            z_projected(i, 1) = z1;
-            z_projected(i, 2) = z2;
-            z_max(i) = MAX3(z0,z1,z2);
-            z_median(i) = MEDIAN3(z0,z1,z2);
-            z_mean(i) = (z0 + z1 + z2) / 3;
+        normal_projections.noalias() = normals * batch;
+
+        const Eigen::Index facets = vertices[0].rows();
+        z_max.resize(facets, batch.cols());
+        z_mean.resize(params.min_volume ? facets : 0, batch.cols());
+        z_min = Eigen::VectorXf::Constant(batch.cols(), std::numeric_limits<float>::max());
+        Eigen::MatrixXf z0, z1, z2;
+        for (Eigen::Index begin = 0; begin < facets; begin += FACET_RANGE) {
+            const Eigen::Index n = std::min(FACET_RANGE, facets - begin);
+            z0.noalias() = vertices[0].middleRows(begin, n) * batch;
+            z1.noalias() = vertices[1].middleRows(begin, n) * batch;
+            z2.noalias() = vertices[2].middleRows(begin, n) * batch;
+            z_max.middleRows(begin, n) = z0.cwiseMax(z1).cwiseMax(z2);
+            z_min = z_min.cwiseMin(z0.cwiseMin(z1).cwiseMin(z2).colwise().minCoeff().transpose());
+            if (params.min_volume)
+                z_mean.middleRows(begin, n) = (z0 + z1 + z2) / 3;
         }
 
-        z_max_hull.resize(mesh_convex_hull.facets_count(), 1);
-        its = mesh_convex_hull.its;
-        for (size_t i = 0; i < z_max_hull.rows(); i++)
-        {
-            float z0 = its.get_vertex(i,0).dot(orientation);
-            float z1 = its.get_vertex(i,1).dot(orientation);
-            float z2 = its.get_vertex(i,2).dot(orientation);
-            z_max_hull(i) = MAX3(z0, z1, z2);
+        const Eigen::Index facets_hull = vertices_hull[0].rows();
+        z_max_hull.resize(facets_hull, batch.cols());
+        for (Eigen::Index begin = 0; begin < facets_hull; begin += FACET_RANGE) {
+            const Eigen::Index n = std::min(FACET_RANGE, facets_hull - begin);
+            z0.noalias() = vertices_hull[0].middleRows(begin, n) * batch;
+            z1.noalias() = vertices_hull[1].middleRows(begin, n) * batch;
+            z2.noalias() = vertices_hull[2].middleRows(begin, n) * batch;
+            z_max_hull.middleRows(begin, n) = z0.cwiseMax(z1).cwiseMax(z2);
         }
     }
 
@@ -371,15 +428,19 @@ public:
     }
 
     // previously calc_overhang
-    CostItems get_features(Vec3f orientation, bool min_volume = true)
+    // Evaluates the candidate stored in column col of the last batch passed to project_vertices().
+    CostItems get_features(Eigen::Index col, bool min_volume = true)
     {
+        auto z_max      = this->z_max.col(col);
+        auto z_max_hull = this->z_max_hull.col(col);
+
         CostItems costs;
         costs.area_total = mesh->bounding_box().area();
         costs.radius = mesh->bounding_box().radius();
         // volume
         costs.volume = mesh->stats().volume > 0 ? mesh->stats().volume : its_volume(mesh->its);
 
-        float total_min_z = z_projected.minCoeff();
+        float total_min_z = z_min(col);
         // filter bottom area
         auto bottom_condition = z_max.array() < total_min_z + this->params.FIRST_LAY_H - EPSILON;
         auto bottom_condition_hull = z_max_hull.array() < total_min_z + this->params.FIRST_LAY_H - EPSILON;
@@ -391,18 +452,14 @@ public:
         costs.bottom = bottom_condition.select(areas, 0).sum()*0.5 + bottom_condition_2nd.select(areas, 0).sum();
 
         // filter overhang
-        Eigen::VectorXf normal_projection(normals.rows(), 1);// = this->normals.dot(orientation);
-        for (size_t i = 0; i < normals.rows(); i++)
-        {
-            normal_projection(i) = normals.row(i).dot(orientation);
-        }
+        auto normal_projection = normal_projections.col(col);
         auto areas_appearance = areas.cwiseProduct((is_apperance * params.APPERANCE_FACE_SUPP + Eigen::VectorXf::Ones(is_apperance.rows(), is_apperance.cols())));
         auto overhang_areas = ((normal_projection.array() < params.ASCENT) * (!bottom_condition_2nd)).select(areas_appearance, 0);
         Eigen::MatrixXf inner = normal_projection.array() - params.ASCENT;
         inner = inner.cwiseMin(0).cwiseAbs();
         if (min_volume)
         {
-            Eigen::MatrixXf heights = z_mean.array() - total_min_z;
+            Eigen::MatrixXf heights = this->z_mean.col(col).array() - total_min_z;
             costs.overhang = (heights.array()* overhang_areas.array()*inner.array()).sum();
         }
         else {
@@ -488,16 +545,20 @@ void _orient(OrientMeshs& meshs_,
         }
     }
     else {
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, meshs_.size()), [&meshs_, &params, progressfn, stopfn](const tbb::blocked_range<size_t>& range) {
-            for (size_t i = range.begin(); i != range.end(); ++i) {
-                auto& mesh_ = meshs_[i];
-                progressfn(i, mesh_.name);
-                AutoOrienter orienter(&mesh_, params, {}, stopfn);
-                mesh_.orientation = orienter.process();
-                Geometry::rotation_from_two_vectors(mesh_.orientation, { 0,0,1 }, mesh_.axis, mesh_.angle, &mesh_.rotation_matrix);
-                mesh_.euler_angles = Geometry::extract_euler_angles(mesh_.rotation_matrix);
-                BOOST_LOG_TRIVIAL(debug) << "rotation_from_two_vectors: " << mesh_.orientation << "; " << mesh_.axis << "; " << mesh_.angle << "; euler: " << mesh_.euler_angles.transpose();
-            }});
+        // The progress is reported from the calling thread only, thus the meshes are oriented in chunks.
+        const size_t chunk = size_t(std::max(1, tbb::this_task_arena::max_concurrency()));
+        for (size_t begin = 0; begin < meshs_.size(); begin += chunk) {
+            progressfn(begin, meshs_[begin].name);
+            tbb::parallel_for(tbb::blocked_range<size_t>(begin, std::min(begin + chunk, meshs_.size())), [&meshs_, &params, stopfn](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    auto& mesh_ = meshs_[i];
+                    AutoOrienter orienter(&mesh_, params, {}, stopfn);
+                    mesh_.orientation = orienter.process();
+                    Geometry::rotation_from_two_vectors(mesh_.orientation, { 0,0,1 }, mesh_.axis, mesh_.angle, &mesh_.rotation_matrix);
+                    mesh_.euler_angles = Geometry::extract_euler_angles(mesh_.rotation_matrix);
+                    BOOST_LOG_TRIVIAL(debug) << "rotation_from_two_vectors: " << mesh_.orientation << "; " << mesh_.axis << "; " << mesh_.angle << "; euler: " << mesh_.euler_angles.transpose();
+                }});
+        }
     }
 }
 
@@ -515,15 +576,45 @@ void orient(OrientMeshs &      arrangables,
 
 void orient(ModelObject* obj)
 {
-    auto m = obj->mesh();
-    AutoOrienter orienter(&m);
-    Vec3d orientation = orienter.process();
-    Vec3d axis;
-    double angle;
-    Geometry::rotation_from_two_vectors(orientation, { 0,0,1 }, axis, angle);
+    orient(ModelObjectPtrs{ obj });
+}
+
+void orient(const ModelObjectPtrs &objects, const OrientParams &params)
+{
+    // Evaluate the orientations of all objects concurrently, each object is read only here.
+    std::vector<Vec3d> orientations(objects.size(), Vec3d(0, 0, 1));
+    auto orient_one = [&objects, &params, &orientations](size_t i) {
+        if (params.stopcondition && params.stopcondition())
+            return;
+        auto m = objects[i]->mesh();
+        AutoOrienter orienter(&m, params);
+        orientations[i] = orienter.process();
+    };
+    // The progress is reported from the calling thread only, thus the parallel evaluation runs in chunks of objects.
+    const size_t chunk = params.parallel ? size_t(std::max(1, tbb::this_task_arena::max_concurrency())) : 1;
+    for (size_t begin = 0; begin < objects.size(); begin += chunk) {
+        if (params.stopcondition && params.stopcondition())
+            break;
+        if (params.progressind)
+            params.progressind(unsigned(begin), objects[begin]->name);
+        const size_t end = std::min(begin + chunk, objects.size());
+        if (end - begin > 1)
+            tbb::parallel_for(tbb::blocked_range<size_t>(begin, end), [&orient_one](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    orient_one(i);
+            });
+        else
+            orient_one(begin);
+    }
 
-    obj->rotate(angle, axis);
-    obj->ensure_on_bed();
+    // Apply the rotations serially.
+    for (size_t i = 0; i < objects.size(); ++i) {
+        Vec3d axis;
+        double angle;
+        Geometry::rotation_from_two_vectors(orientations[i], { 0,0,1 }, axis, angle);
+        objects[i]->rotate(angle, axis);
+        objects[i]->ensure_on_bed();
+    }
 }
 
 void orient(ModelInstance* instance)
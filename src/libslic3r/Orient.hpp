@@ -135,6 +135,11 @@ struct OrientParams {
     /// A predicate returning true if abort is needed.
     std::function<bool(void)>     stopcondition = {};
 
+    // The fields above are shared with OrientParamsArea, which is copied over them by memcpy().
+    // Maximum time in seconds spent evaluating candidate orientations of a single object, 0 means unlimited.
+    // When exceeded, the best of the candidates evaluated so far is used.
+    float max_time_per_object = 0.f;
+
     OrientParams() = default;
 };
 
@@ -152,6 +157,9 @@ void orient(OrientMeshs &items, const OrientMeshs &excludes, const OrientParams
 // this function should be deleted, since rotating objects are so complicated that its inherited transformation may be a trouble
 void orient(ModelObject* obj);
 
+// Orients the objects, evaluating them concurrently if params.parallel is set.
+void orient(const ModelObjectPtrs &objects, const OrientParams &params = {});
+
 void orient(ModelInstance* instance);
 
 }} // namespace Slic3r::orientment
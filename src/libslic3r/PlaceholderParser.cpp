@@ -6,6 +6,8 @@
 #include <iomanip>
 #include <sstream>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #ifdef _MSC_VER
     #include <stdlib.h>  // provides **_environ
 #else
@@ -741,6 +743,9 @@ namespace client
         // If false, the macro_processor will evaluate a full macro.
         // If true, the macro processor will evaluate just a boolean condition using the full expressive power of the macro processor.
         bool                     just_boolean_expression = false;
+        // The whole template if the macro_processor parses just a part of it (see process_compiled_template()).
+        // Errors are reported relative to the whole template.
+        const std::string       *template_text          = nullptr;
         std::string              error_message;
 
         // Table to translate symbol tag to a human readable error message.
@@ -1076,8 +1081,13 @@ namespace client
         }
 
         template <typename Iterator>
-        static void process_error_message(const MyContext *context, const boost::spirit::info &info, const Iterator &it_begin, const Iterator &it_end, const Iterator &it_error)
+        static void process_error_message(const MyContext *context, const boost::spirit::info &info, Iterator it_begin, Iterator it_end, const Iterator &it_error)
         {
+            if constexpr (std::is_same_v<Iterator, std::string::const_iterator>)
+                if (context->template_text) {
+                    it_begin = context->template_text->begin();
+                    it_end   = context->template_text->end();
+                }
             std::string &msg = const_cast<MyContext*>(context)->error_message;
             std::string  first(it_begin, it_error);
             std::string  last(it_error, it_end);
@@ -1676,7 +1686,8 @@ namespace client
     };
 }
 
-static std::string process_macro(const std::string &templ, client::MyContext &context)
+// Parse and evaluate the template range <begin, end) into output.
+static void process_macro(std::string::const_iterator begin, std::string::const_iterator end, client::MyContext &context, std::string &output)
 {
     typedef std::string::const_iterator iterator_type;
     typedef client::macro_processor<iterator_type> macro_processor;
@@ -1687,17 +1698,185 @@ static std::string process_macro(const std::string &templ, client::MyContext &co
     // PlaceholderParser::process() runs.
     //FIXME this kind of initialization is not thread safe!
     static macro_processor      macro_processor_instance;
-    // Iterators over the source template.
-    std::string::const_iterator iter = templ.begin();
-    std::string::const_iterator end  = templ.end();
     // Accumulator for the processed template.
-    std::string                 output;
-    phrase_parse(iter, end, macro_processor_instance(&context), space, output);
+    std::string                 processed;
+    phrase_parse(begin, end, macro_processor_instance(&context), space, processed);
 	if (!context.error_message.empty()) {
         if (context.error_message.back() != '\n' && context.error_message.back() != '\r')
             context.error_message += '\n';
         throw Slic3r::PlaceholderParserError(context.error_message);
     }
+    output += processed;
+}
+
+static std::string process_macro(const std::string &templ, client::MyContext &context)
+{
+    std::string output;
+    process_macro(templ.begin(), templ.end(), context, output);
+    return output;
+}
+
+// A template split into its top level parts: runs of plain ASCII text, which are copied to the output verbatim,
+// and the rest (macros in {}, whole {if}...{endif} blocks, legacy [variables], non-ASCII text), which is parsed
+// and evaluated by the macro_processor grammar. The grammar evaluates while it parses, thus the macros themselves
+// can't be compiled, but the free-form text, which makes most of the custom G-code, is no longer run through
+// the grammar character by character, and templates without any macro are not parsed at all.
+struct CompiledTemplate
+{
+    struct Part {
+        size_t begin;
+        size_t end;
+        bool   verbatim;
+    };
+    // Empty if the template could not be split safely, then it is processed as a whole.
+    std::vector<Part> parts;
+    bool              split = false;
+};
+
+static bool is_identifier_char(char c) { return std::isalnum((unsigned char)c) || c == '_'; }
+
+// Keyword at the start of a {} macro, mimicking the macro_processor's kw[] directive.
+static bool macro_starts_with_keyword(const std::string &templ, size_t pos, size_t end, const char *keyword)
+{
+    while (pos < end && std::isspace((unsigned char)templ[pos]))
+        ++ pos;
+    size_t len = strlen(keyword);
+    return pos + len <= end && templ.compare(pos, len, keyword) == 0 && (pos + len == end || ! is_identifier_char(templ[pos + len]));
+}
+
+// Find the end of a {} macro starting at pos (pointing to '{'), that is the position after its closing '}'.
+// Returns std::string::npos if the macro is not terminated or it contains anything the simple scanner does not understand.
+static size_t find_macro_end(const std::string &templ, size_t pos)
+{
+    assert(templ[pos] == '{');
+    for (++ pos; pos < templ.size(); ++ pos) {
+        char c = templ[pos];
+        if (c == '}')
+            return pos + 1;
+        if (c == '{')
+            return std::string::npos;
+        if (c == '"') {
+            // String literal, which may contain braces and escaped characters.
+            for (++ pos; pos < templ.size() && templ[pos] != '"'; ++ pos)
+                if (templ[pos] == '\\')
+                    ++ pos;
+            if (pos >= templ.size())
+                return std::string::npos;
+        }
+    }
+    return std::string::npos;
+}
+
+static CompiledTemplate compile_template(const std::string &templ)
+{
+    CompiledTemplate out;
+    // Regular expressions may contain braces, which the scanner below would not tell from the macro delimiters.
+    if (templ.find("=~") != std::string::npos || templ.find("!~") != std::string::npos || templ.find("one_of") != std::string::npos)
+        return out;
+
+    auto add_part = [&out](size_t begin, size_t end, bool verbatim) {
+        // Adjacent parts to be parsed are parsed at once.
+        if (! verbatim && ! out.parts.empty() && ! out.parts.back().verbatim)
+            out.parts.back().end = end;
+        else
+            out.parts.push_back({ begin, end, verbatim });
+    };
+
+    // phrase_parse() skips the leading white space of a template with the space skipper, which the verbatim copy has to mimic.
+    // Each of the other parts processed by the grammar starts with a macro or with non-ASCII text following a macro.
+    size_t pos = templ.find_first_not_of(" \t\n\v\f\r");
+    if (pos == std::string::npos)
+        pos = templ.size();
+    for (; pos < templ.size();) {
+        char c = templ[pos];
+        if (c == '[') {
+            // Legacy variable expansion [variable] or [vector_variable[index]].
+            size_t end = pos + 1;
+            for (int depth = 1; end < templ.size() && depth > 0; ++ end)
+                if (templ[end] == '[')
+                    ++ depth;
+                else if (templ[end] == ']')
+                    -- depth;
+                else if (templ[end] == '{')
+                    return {};
+            if (templ[end - 1] != ']')
+                return {};
+            add_part(pos, end, false);
+            pos = end;
+        } else if (c == '{') {
+            size_t end = find_macro_end(templ, pos);
+            if (end == std::string::npos)
+                return {};
+            if (macro_starts_with_keyword(templ, pos + 1, end, "elsif") || macro_starts_with_keyword(templ, pos + 1, end, "else") ||
+                macro_starts_with_keyword(templ, pos + 1, end, "endif"))
+                // Let the grammar report the error.
+                return {};
+            if (macro_starts_with_keyword(templ, pos + 1, end, "if")) {
+                // Keep the whole {if}...{endif} block together, including the nested blocks.
+                for (int depth = 1; depth > 0;) {
+                    size_t next = templ.find_first_of("{[", end);
+                    if (next == std::string::npos)
+                        return {};
+                    if (templ[next] == '[') {
+                        // Skip a legacy variable inside the block, it can't contain braces.
+                        end = next + 1;
+                        continue;
+                    }
+                    end = find_macro_end(templ, next);
+                    if (end == std::string::npos)
+                        return {};
+                    if (macro_starts_with_keyword(templ, next + 1, end, "if"))
+                        ++ depth;
+                    else if (macro_starts_with_keyword(templ, next + 1, end, "endif"))
+                        -- depth;
+                }
+            }
+            add_part(pos, end, false);
+            pos = end;
+        } else {
+            size_t end = templ.find_first_of("{[", pos);
+            if (end == std::string::npos)
+                end = templ.size();
+            // Only ASCII text is copied verbatim, the grammar validates the UTF-8 sequences.
+            bool ascii = std::all_of(templ.begin() + pos, templ.begin() + end, [](char c) { return (unsigned char)c < 0x80; });
+            add_part(pos, end, ascii);
+            pos = end;
+        }
+    }
+    out.split = true;
+    return out;
+}
+
+// Templates are compiled once and cached by their text, they are processed repeatedly for each layer or tool change.
+static std::shared_ptr<const CompiledTemplate> compiled_template(const std::string &templ)
+{
+    static std::mutex                                                              mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const CompiledTemplate>> cache;
+    // Bound the cache for the unlikely case of an application generating many different templates.
+    static constexpr size_t                                                        max_cache_size = 1024;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (auto it = cache.find(templ); it != cache.end())
+        return it->second;
+    if (cache.size() >= max_cache_size)
+        cache.clear();
+    return cache.emplace(templ, std::make_shared<const CompiledTemplate>(compile_template(templ))).first->second;
+}
+
+static std::string process_compiled_template(const std::string &templ, client::MyContext &context)
+{
+    std::shared_ptr<const CompiledTemplate> compiled = compiled_template(templ);
+    if (! compiled->split)
+        return process_macro(templ, context);
+
+    std::string output;
+    output.reserve(templ.size());
+    context.template_text = &templ;
+    for (const CompiledTemplate::Part &part : compiled->parts)
+        if (part.verbatim)
+            output.append(templ, part.begin, part.end - part.begin);
+        else
+            process_macro(templ.begin() + part.begin, templ.begin() + part.end, context, output);
     return output;
 }
 
@@ -1710,7 +1889,7 @@ std::string PlaceholderParser::process(const std::string &templ, unsigned int cu
     context.config_outputs      = config_outputs;
     context.current_extruder_id = current_extruder_id;
     context.context_data        = context_data;
-    return process_macro(templ, context);
+    return process_compiled_template(templ, context);
 }
 
 // Evaluate a boolean expression using the full expressive power of the PlaceholderParser boolean expression syntax.
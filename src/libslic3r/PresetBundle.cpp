@@ -1,6 +1,7 @@
 #include <cassert>
 
 #include "PresetBundle.hpp"
+#include "SystemPresetIndex.hpp"
 #include "libslic3r.h"
 #include "Utils.hpp"
 #include "Model.hpp"
@@ -3314,6 +3315,48 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
     PresetCollection         *presets = nullptr;
     size_t                   presets_loaded = 0;
 
+    // System presets are loaded from the binary index of the flattened configs if the vendor JSON files did not change
+    // since the index was written, otherwise the index is rebuilt while parsing the JSON files below.
+    SystemPresetIndex        index;
+    std::string              index_path;
+    uint64_t                 index_checksum = 0;
+    if (flags.has(LoadConfigBundleAttribute::LoadSystem))
+        index_path = SystemPresetIndex::path(path, vendor_name, flags.has(LoadConfigBundleAttribute::LoadFilamentOnly));
+    if (! index_path.empty()) {
+        std::vector<std::string> source_files { root_file };
+        for (const auto *subfiles : { &machine_model_subfiles, &process_subfiles, &filament_subfiles, &machine_subfiles })
+            for (const std::pair<std::string, std::string> &subfile : *subfiles)
+                source_files.emplace_back(path + "/" + vendor_name + "/" + subfile.second);
+        index_checksum = SystemPresetIndex::checksum(source_files);
+        if (index.load(index_path, index_checksum)) {
+            auto load_from_index = [this, &path, &vendor_name, current_vendor_profile, &presets_loaded](SystemPresetIndex::Entries &entries, PresetCollection &presets_collection) {
+                for (SystemPresetIndex::Entry &entry : entries) {
+                    if (presets_collection.find_preset(entry.name, false) != nullptr) {
+                        BOOST_LOG_TRIVIAL(error) << "Error in a Vendor Config Bundle \"" << path << "\": The printer preset \"" <<
+                            entry.name << "\" has already been loaded from another Confing Bundle.";
+                        throw ConfigurationError((boost::format("Failed loading configuration file %1%\nSuggest cleaning the directory %2% firstly") %
+                            (path + "/" + vendor_name + "/" + entry.subpath) % path).str());
+                    }
+                    auto file_path = (boost::filesystem::path(data_dir()) / PRESET_SYSTEM_DIR / vendor_name / entry.subpath).make_preferred();
+                    Preset &loaded = presets_collection.load_preset(file_path.string(), entry.name, std::move(entry.config), false);
+                    loaded.is_system    = true;
+                    loaded.vendor       = current_vendor_profile;
+                    loaded.version      = current_vendor_profile->config_version;
+                    loaded.setting_id   = std::move(entry.setting_id);
+                    loaded.filament_id  = std::move(entry.filament_id);
+                    loaded.alias        = std::move(entry.alias);
+                    loaded.renamed_from = std::move(entry.renamed_from);
+                    ++ presets_loaded;
+                }
+            };
+            load_from_index(index.prints,    this->prints);
+            load_from_index(index.filaments, this->filaments);
+            load_from_index(index.printers,  this->printers);
+            BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(", finished from index %1%, presets_loaded %2%") % index_path % presets_loaded;
+            return std::make_pair(std::move(substitutions), presets_loaded);
+        }
+    }
+
     auto parse_subfile = [path, vendor_name, presets_loaded, current_vendor_profile](\
         ConfigSubstitutionContext& substitution_context,
         PresetsConfigSubstitutions& substitutions,
@@ -3322,6 +3365,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         std::map<std::string, DynamicPrintConfig>& config_maps,
         std::map<std::string, std::string>& filament_id_maps,
         PresetCollection* presets_collection,
+        SystemPresetIndex::Entries* index_entries,
         size_t& count) -> std::string {
 
         std::string subfile = path + "/" + vendor_name + "/" + subfile_iter.second;
@@ -3491,6 +3535,8 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
                 preset_name, presets_collection->type(), PresetConfigSubstitutions::Source::ConfigBundle,
                 std::string(), std::move(substitution_context.substitutions) });
         config_maps.emplace(preset_name, loaded.config);
+        if (index_entries != nullptr)
+            index_entries->push_back({ loaded.name, subfile_iter.second, loaded.alias, loaded.renamed_from, loaded.setting_id, loaded.filament_id, loaded.config });
         ++count;
         //BBS: add config related logs
         BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(", got preset %1%, from %2%")%loaded.name %subfile;
@@ -3505,7 +3551,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
     filament_id_maps.clear();
     for (auto& subfile : process_subfiles)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, presets_loaded);
+        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, index_path.empty() ? nullptr : &index.prints, presets_loaded);
         if (!reason.empty()) {
             //parse error
             std::string subfile_path = path + "/" + vendor_name + "/" + subfile.second;
@@ -3520,7 +3566,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
     filament_id_maps.clear();
     for (auto& subfile : filament_subfiles)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, presets_loaded);
+        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, index_path.empty() ? nullptr : &index.filaments, presets_loaded);
         if (!reason.empty()) {
             //parse error
             std::string subfile_path = path + "/" + vendor_name + "/" + subfile.second;
@@ -3535,7 +3581,7 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
     filament_id_maps.clear();
     for (auto& subfile : machine_subfiles)
     {
-        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, presets_loaded);
+        std::string reason = parse_subfile(substitution_context, substitutions, flags, subfile, configs, filament_id_maps, presets, index_path.empty() ? nullptr : &index.printers, presets_loaded);
         if (!reason.empty()) {
             //parse error
             std::string subfile_path = path + "/" + vendor_name + "/" + subfile.second;
@@ -3544,6 +3590,10 @@ std::pair<PresetsConfigSubstitutions, size_t> PresetBundle::load_vendor_configs_
         }
     }
 
+    // Presets with substituted values are not indexed, so that the substitutions are reported again on the next start.
+    if (! index_path.empty() && substitutions.empty())
+        index.save(index_path, index_checksum);
+
     //BBS: add config related logs
     BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << boost::format(", finished, presets_loaded %1%")%presets_loaded;
     return std::make_pair(std::move(substitutions), presets_loaded);
@@ -43,6 +43,7 @@
 #include <float.h>
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
 #include <unordered_set>
 #include <boost/filesystem/path.hpp>
@@ -1547,17 +1548,20 @@ void  PrintObject::set_shared_object(PrintObject *object)
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": this=%1%, found shared object from %2%")%this%m_shared_object;
 }
 
-void  PrintObject::clear_shared_object()
+bool  PrintObject::clear_shared_object()
 {
+    bool invalidated = false;
     if (m_shared_object) {
         BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": this=%1%, clear previous shared object data %2%")%this %m_shared_object;
+        // The layers are owned by the shared object, only drop the references.
         m_layers.clear();
         m_support_layers.clear();
 
         m_shared_object = nullptr;
 
-        invalidate_all_steps_without_cancel();
+        invalidated = invalidate_all_steps_without_cancel();
     }
+    return invalidated;
 }
 
 void  PrintObject::copy_layers_from_shared_object()
@@ -1566,28 +1570,16 @@ void  PrintObject::copy_layers_from_shared_object()
         m_layers.clear();
         m_support_layers.clear();
 
+        // The first layer slices are referenced through firstLayerObjSlice() / firstLayerObjGroups().
         firstLayerObjSliceByVolume.clear();
         firstLayerObjSliceByGroups.clear();
 
-        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": this=%1%, copied layers from object %2%")%this%m_shared_object;
+        // Only the pointers are copied, the layers including their overhangs are shared with m_shared_object
+        // and they are never modified through this object.
+        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": this=%1%, referencing %2% layers and %3% support layers of object %4%")
+            %this %m_shared_object->layers().size() %m_shared_object->support_layers().size() %m_shared_object;
         m_layers = m_shared_object->layers();
         m_support_layers = m_shared_object->support_layers();
-
-        firstLayerObjSliceByVolume = m_shared_object->firstLayerObjSlice();
-        firstLayerObjSliceByGroups = m_shared_object->firstLayerObjGroups();
-    }
-}
-
-void  PrintObject::copy_layers_overhang_from_shared_object()
-{
-    if (m_shared_object) {
-        for (size_t index = 0; index <  m_layers.size() && index <  m_shared_object->m_layers.size(); index++)
-        {
-            Layer* layer_src = m_layers[index];
-            layer_src->loverhangs = m_shared_object->m_layers[index]->loverhangs;
-            layer_src->loverhangs_bbox = m_shared_object->m_layers[index]->loverhangs_bbox;
-        }
-        BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": this=%1%, copied layer overhang from object %2%")%this%m_shared_object;
     }
 }
 
@@ -1642,6 +1634,17 @@ std::map<ObjectID, unsigned int> getObjectExtruderMap(const Print& print) {
 }
 
 // Slicing process, running at a background thread.
+// Run a single step of a PrintObject, log how long it took and account the memory held by the object after the step.
+template<typename StepFn>
+static void run_object_step(PrintObject &obj, const char *step_name, StepFn &&step)
+{
+    auto start = std::chrono::steady_clock::now();
+    step();
+    BOOST_LOG_TRIVIAL(info) << "Object " << obj.model_object()->name << ": " << step_name << " took "
+                            << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s";
+    obj.account_memory(step_name);
+}
+
 void Print::process(long long *time_cost_with_cache, bool use_cache)
 {
     long long start_time = 0, end_time = 0;
@@ -1658,6 +1661,14 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     for (PrintObject *obj : m_objects)
         obj->clear_shared_object();
 
+    m_memory_current = 0;
+    m_memory_peak    = 0;
+    for (PrintObject *obj : m_objects) {
+        obj->m_memory_stats.clear();
+        // Memory held by the steps finished by the previous process().
+        obj->account_memory("start");
+    }
+
     //add the print_object share check logic
     auto is_print_object_the_same = [this](const PrintObject* object1, const PrintObject* object2) -> bool{
         if (object1->trafo().matrix() != object2->trafo().matrix())
@@ -1698,8 +1709,20 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
         //    return false;
         if (model_obj1->config.get() != model_obj2->config.get())
             return false;
+        if (model_obj1->layer_height_profile.get() != model_obj2->layer_height_profile.get())
+            return false;
         return true;
     };
+    // Objects to be sliced, grouped by PrintObject::shared_object_fingerprint(). Only the objects with the same fingerprint
+    // need to be compared by is_print_object_the_same(), which keeps the detection linear in the number of objects.
+    std::unordered_map<size_t, std::vector<PrintObject*>> slicing_objects_by_fingerprint;
+    auto find_same_slicing_object = [&slicing_objects_by_fingerprint, &is_print_object_the_same](const PrintObject *obj) -> PrintObject* {
+        if (auto it = slicing_objects_by_fingerprint.find(obj->shared_object_fingerprint()); it != slicing_objects_by_fingerprint.end())
+            for (PrintObject *slicing_obj : it->second)
+                if (is_print_object_the_same(obj, slicing_obj))
+                    return slicing_obj;
+        return nullptr;
+    };
     int object_count = m_objects.size();
     std::set<PrintObject*> need_slicing_objects;
     std::set<PrintObject*> re_slicing_objects;
@@ -1707,36 +1730,31 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
         for (int index = 0; index < object_count; index++)
         {
             PrintObject *obj =  m_objects[index];
-            for (PrintObject *slicing_obj : need_slicing_objects)
-            {
-                if (is_print_object_the_same(obj, slicing_obj)) {
-                    obj->set_shared_object(slicing_obj);
-                    break;
-                }
-            }
-            if (!obj->get_shared_object())
+            if (PrintObject *slicing_obj = find_same_slicing_object(obj); slicing_obj)
+                obj->set_shared_object(slicing_obj);
+            else {
                 need_slicing_objects.insert(obj);
+                slicing_objects_by_fingerprint[obj->shared_object_fingerprint()].emplace_back(obj);
+            }
         }
     }
     else {
         for (int index = 0; index < object_count; index++)
         {
             PrintObject *obj =  m_objects[index];
-            if (obj->layer_count() > 0)
+            if (obj->layer_count() > 0) {
                 need_slicing_objects.insert(obj);
+                slicing_objects_by_fingerprint[obj->shared_object_fingerprint()].emplace_back(obj);
+            }
         }
         for (int index = 0; index < object_count; index++)
         {
             PrintObject *obj =  m_objects[index];
             bool found_shared = false;
             if (need_slicing_objects.find(obj) == need_slicing_objects.end()) {
-                for (PrintObject *slicing_obj : need_slicing_objects)
-                {
-                    if (is_print_object_the_same(obj, slicing_obj)) {
-                        obj->set_shared_object(slicing_obj);
-                        found_shared = true;
-                        break;
-                    }
+                if (PrintObject *slicing_obj = find_same_slicing_object(obj); slicing_obj) {
+                    obj->set_shared_object(slicing_obj);
+                    found_shared = true;
                 }
                 if (!found_shared) {
                     BOOST_LOG_TRIVIAL(warning) << boost::format("Also can not find the shared object, identify_id %1%, maybe shared object is skipped")%obj->model_object()->instances[0]->loaded_id;
@@ -1744,6 +1762,7 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
                     //don't report errot, set use_cache to false, and reslice these objects
                     need_slicing_objects.insert(obj);
                     re_slicing_objects.insert(obj);
+                    slicing_objects_by_fingerprint[obj->shared_object_fingerprint()].emplace_back(obj);
                     //use_cache = false;
                 }
             }
@@ -1753,71 +1772,46 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << boost::format(": total object counts %1% in current print, need to slice %2%")%m_objects.size()%need_slicing_objects.size();
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
     if (!use_cache) {
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->make_perimeters();
-            }
-            else {
-                if (obj->set_started(posSlice))
-                    obj->set_done(posSlice);
-                if (obj->set_started(posPerimeters))
-                    obj->set_done(posPerimeters);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->estimate_curled_extrusions();
-            }
-            else {
-                if (obj->set_started(posEstimateCurledExtrusions))
-                    obj->set_done(posEstimateCurledExtrusions);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->infill();
-            }
-            else {
-                if (obj->set_started(posPrepareInfill))
-                    obj->set_done(posPrepareInfill);
-                if (obj->set_started(posInfill))
-                    obj->set_done(posInfill);
-            }
-        }
-        for (PrintObject *obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->ironing();
-            }
-            else {
-                if (obj->set_started(posIroning))
-                    obj->set_done(posIroning);
+        // The objects are independent of each other once they are sliced, until the wipe tower and skirt / brim are planned,
+        // so after slicing every object runs its own chain of steps and different objects progress through the steps
+        // concurrently. The steps are parallel internally as well, TBB balances both levels, thus a plate
+        // of many small objects no longer waits for the serial parts of each step object by object.
+        // All the objects are sliced before any of them continues, as the support generators read the layer counts
+        // of all the objects to plan the skirt and brim layers (see TreeSupport::draw_circles()).
+        // Cancellation exceptions thrown by the steps propagate out of parallel_for().
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_objects.size(), 1),
+            [this, &need_slicing_objects](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i) {
+                    PrintObject *obj = m_objects[i];
+                    if (need_slicing_objects.count(obj) != 0)
+                        run_object_step(*obj, "slice", [obj]() { obj->slice(); });
+                    else if (obj->set_started(posSlice))
+                        obj->set_done(posSlice);
+                }
             }
-        }
-
-        tbb::parallel_for(tbb::blocked_range<int>(0, int(m_objects.size())),
-            [this, need_slicing_objects](const tbb::blocked_range<int>& range) {
-                for (int i = range.begin(); i < range.end(); i++) {
-                    PrintObject* obj = m_objects[i];
+        );
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, m_objects.size(), 1),
+            [this, &need_slicing_objects](const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i) {
+                    PrintObject *obj = m_objects[i];
                     if (need_slicing_objects.count(obj) != 0) {
-                        obj->generate_support_material();
+                        run_object_step(*obj, "make_perimeters", [obj]() { obj->make_perimeters(); });
+                        run_object_step(*obj, "estimate_curled_extrusions", [obj]() { obj->estimate_curled_extrusions(); });
+                        run_object_step(*obj, "prepare_infill", [obj]() { obj->prepare_infill(); });
+                        run_object_step(*obj, "infill", [obj]() { obj->infill(); });
+                        run_object_step(*obj, "ironing", [obj]() { obj->ironing(); });
+                        run_object_step(*obj, "generate_support_material", [obj]() { obj->generate_support_material(); });
+                        run_object_step(*obj, "detect_overhangs_for_lift", [obj]() { obj->detect_overhangs_for_lift(); });
                     }
                     else {
-                        if (obj->set_started(posSupportMaterial))
-                            obj->set_done(posSupportMaterial);
+                        for (PrintObjectStep step : { posPerimeters, posEstimateCurledExtrusions, posPrepareInfill, posInfill,
+                                                      posIroning, posSupportMaterial, posDetectOverhangsForLift })
+                            if (obj->set_started(step))
+                                obj->set_done(step);
                     }
                 }
             }
         );
-
-        for (PrintObject* obj : m_objects) {
-            if (need_slicing_objects.count(obj) != 0) {
-                obj->detect_overhangs_for_lift();
-            }
-            else {
-                if (obj->set_started(posDetectOverhangsForLift))
-                    obj->set_done(posDetectOverhangsForLift);
-            }
-        }
     }
     else {
         for (PrintObject *obj : m_objects) {
@@ -1850,11 +1844,12 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
 
     for (PrintObject *obj : m_objects)
     {
-        if (need_slicing_objects.count(obj) == 0) {
+        if (need_slicing_objects.count(obj) == 0)
             obj->copy_layers_from_shared_object();
-            obj->copy_layers_overhang_from_shared_object();
-        }
     }
+    if (need_slicing_objects.size() < m_objects.size())
+        BOOST_LOG_TRIVIAL(info) << m_objects.size() - need_slicing_objects.size() << " objects share the layers of "
+                                << need_slicing_objects.size() << " sliced objects" << log_memory_info();
 
     if (this->set_started(psWipeTower)) {
         m_wipe_tower_data.clear();
@@ -1969,7 +1964,7 @@ void Print::process(long long *time_cost_with_cache, bool use_cache)
     for (PrintObject *obj : m_objects) {
         if (((!use_cache)&&(need_slicing_objects.count(obj) != 0))
             || (use_cache &&(re_slicing_objects.count(obj) != 0))){
-            obj->simplify_extrusion_path();
+            run_object_step(*obj, "simplify_extrusion_path", [obj]() { obj->simplify_extrusion_path(); });
         }
         else {
             if (obj->set_started(posSimplifyPath))
@@ -2031,6 +2026,8 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
     } else
         message = L("Generating G-code");
     this->set_status(80, message);
+    if (m_exported_layers_released)
+        throw Slic3r::RuntimeError("The extrusions were released by the previous streaming G-code export, the print has to be processed again.");
 
     // The following line may die for multiple reasons.
     GCode gcode;
@@ -3505,6 +3502,9 @@ static void from_json(const json& j, groupedVolumeSlices& firstlayer_group)
 
 int Print::export_cached_data(const std::string& directory, bool with_space)
 {
+    if (m_exported_layers_released)
+        throw Slic3r::RuntimeError("The extrusions were released by the previous streaming G-code export, the print has to be processed again.");
+
     int ret = 0;
     boost::filesystem::path directory_path(directory);
 
@@ -17,10 +17,12 @@
 #include "GCode/ThumbnailData.hpp"
 #include "GCode/GCodeProcessor.hpp"
 #include "MultiMaterialSegmentation.hpp"
+#include "MemoryStats.hpp"
 #include "libslic3r.h"
 
 #include <Eigen/Geometry>
 
+#include <atomic>
 #include <functional>
 #include <set>
 
@@ -97,6 +99,26 @@ enum PrintObjectStep {
     posCount,
 };
 
+// Names of the steps in the traces, see Trace.hpp.
+inline const char* trace_step_name(PrintStep step)
+{
+    static constexpr const char *names[] = { "psWipeTower", "psSkirtBrim", "psGCodeExport", "psConflictCheck" };
+    static_assert(sizeof(names) / sizeof(names[0]) == psCount);
+    return names[step];
+}
+
+inline const char* trace_step_name(PrintObjectStep step)
+{
+    static constexpr const char *names[] = {
+        "posSlice", "posPerimeters", "posEstimateCurledExtrusions", "posPrepareInfill",
+        "posInfill", "posIroning", "posSupportMaterial", "posSimplifyPath", "posSimplifySupportPath",
+        "posDetectOverhangsForLift",
+        "posSimplifyWall", "posSimplifyInfill"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == posCount);
+    return names[step];
+}
+
 // A PrintRegion object represents a group of volumes to print
 // sharing the same config (including the same assigned extruder(s))
 class PrintRegion
@@ -334,9 +356,10 @@ public:
 
     // BBS
     void generate_support_preview();
-    const std::vector<VolumeSlices>& firstLayerObjSlice() const { return firstLayerObjSliceByVolume; }
+    // An object sharing the layers of another object refers to the first layer slices of that object as well.
+    const std::vector<VolumeSlices>& firstLayerObjSlice() const { return m_shared_object ? m_shared_object->firstLayerObjSliceByVolume : firstLayerObjSliceByVolume; }
     std::vector<VolumeSlices>& firstLayerObjSliceMod() { return firstLayerObjSliceByVolume; }
-    const std::vector<groupedVolumeSlices>& firstLayerObjGroups() const { return firstLayerObjSliceByGroups; }
+    const std::vector<groupedVolumeSlices>& firstLayerObjGroups() const { return m_shared_object ? m_shared_object->firstLayerObjSliceByGroups : firstLayerObjSliceByGroups; }
     std::vector<groupedVolumeSlices>& firstLayerObjGroupsMod() { return firstLayerObjSliceByGroups; }
 
     bool                         has_brim() const       {
@@ -379,6 +402,16 @@ public:
     std::shared_ptr<TreeSupportData> alloc_tree_support_preview_cache();
     void clear_tree_support_preview_cache() { m_tree_support_preview_cache.reset(); }
 
+    // Estimated memory held by the layers, support layers and caches of this object.
+    MemoryUsage     memory_usage() const;
+    const ObjectMemoryStats& memory_stats() const { return m_memory_stats; }
+    // Called by Print::process() after a step finished: sample the memory held by this object and if the estimate
+    // of the whole print exceeds its memory budget, release the caches of this object before continuing.
+    void            account_memory(const char *step_name);
+    // Release the data kept between the steps, which is regenerated if a step needing it is invalidated.
+    // Returns the estimated number of bytes released.
+    size_t          release_caches();
+
     size_t          support_layer_count() const { return m_support_layers.size(); }
     void            clear_support_layers();
     SupportLayer*   get_support_layer(int idx) { return m_support_layers[idx]; }
@@ -429,10 +462,16 @@ public:
     void         get_certain_layers(float start, float end, std::vector<LayerPtrs> &out, std::vector<BoundingBox> &boundingbox_objects);
     std::vector<Point> get_instances_shift_without_plate_offset();
     PrintObject* get_shared_object() const { return m_shared_object; }
+    // Hash of the meshes, volume transformations and settings which decide whether two objects would be sliced
+    // the same, thus whether they may share their layers. Calculated by Print::apply().
+    size_t       shared_object_fingerprint() const { return m_shared_object_fingerprint; }
     void         set_shared_object(PrintObject *object);
-    void         clear_shared_object();
+    // Drop the references to the layers of the shared object and invalidate all steps.
+    // Returns true if some step was invalidated.
+    bool         clear_shared_object();
+    // Reference (not copy) the layers and support layers of the shared object. The layers are owned by the shared object,
+    // which must outlive this object or call clear_shared_object() on it before being deleted.
     void         copy_layers_from_shared_object();
-    void         copy_layers_overhang_from_shared_object();
 
     // BBS: Boundingbox of the first layer
     BoundingBox                 firstLayerObjectBrimBoundingBox;
@@ -528,6 +567,9 @@ private:
 
     std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> m_adaptive_fill_octrees;
     FillLightning::GeneratorPtr m_lightning_generator;
+    // The octrees and the lightning generator were released by release_caches(), posInfill has to regenerate them.
+    bool                                    m_infill_data_released { false };
+    ObjectMemoryStats                       m_memory_stats;
 
     std::vector < VolumeSlices >            firstLayerObjSliceByVolume;
     std::vector<groupedVolumeSlices>        firstLayerObjSliceByGroups;
@@ -536,6 +578,7 @@ private:
     ExtrusionEntityCollection               m_skirt;
 
     PrintObject*                            m_shared_object{ nullptr };
+    size_t                                  m_shared_object_fingerprint{ 0 };
 
     
     // SoftFever
@@ -926,6 +969,24 @@ public:
     static StringObjectException sequential_print_clearance_valid(const Print &print, Polygons *polygons = nullptr, std::vector<std::pair<Polygon, float>>* height_polygons = nullptr);
     ConflictResultOpt            get_conflict_result() const { return m_conflict_result; }
 
+    // Estimate the memory held by the objects after each of their steps, see MemoryStats.hpp. If the estimate of the whole print
+    // exceeds the soft budget in bytes, the objects release their caches. Zero budget means no budget.
+    void                set_memory_accounting(bool enabled, size_t soft_budget = 0) { m_memory_accounting = enabled || soft_budget > 0; m_memory_budget = soft_budget; }
+    bool                memory_accounting() const { return m_memory_accounting; }
+    size_t              memory_budget() const { return m_memory_budget; }
+    // Estimated peak of the memory held by all the objects together during the last process().
+    size_t              memory_peak() const { return m_memory_peak; }
+
+    // Bounded memory G-code export of huge prints: the extrusions of the layers are released once they were exported
+    // and the G-code processor keeps only a window of the moves in memory. The older moves are spilled into a temporary
+    // file referenced by GCodeProcessorResult::moves_spill if spill_moves is set, otherwise only the aggregated statistics
+    // are kept. The extrusions are generated again by the next apply() and process().
+    void                set_streaming_gcode_export(bool enabled, bool spill_moves = true) { m_streaming_gcode_export = enabled; m_streaming_gcode_spill_moves = spill_moves; }
+    bool                streaming_gcode_export() const { return m_streaming_gcode_export; }
+    // Write the random access index of the exported text G-code next to it, see GCodeIndex.
+    void                set_export_gcode_index(bool enabled) { m_export_gcode_index = enabled; }
+    bool                export_gcode_index() const { return m_export_gcode_index; }
+
     // Return 4 wipe tower corners in the world coordinates (shifted and rotated), including the wipe tower brim.
     std::vector<Point>  first_layer_wipe_tower_corners(bool check_wipe_tower_existance=true) const;
 
@@ -1006,6 +1067,18 @@ private:
     //BBS
     ConflictResultOpt m_conflict_result;
     FakeWipeTower     m_fake_wipe_tower;
+
+    bool                m_memory_accounting { false };
+    size_t              m_memory_budget { 0 };
+    // Estimate of the memory held by all the objects, updated by the objects running their steps concurrently.
+    std::atomic<size_t> m_memory_current { 0 };
+    std::atomic<size_t> m_memory_peak { 0 };
+
+    bool                m_streaming_gcode_export { false };
+    bool                m_streaming_gcode_spill_moves { true };
+    // The streaming G-code export released the extrusions of the exported layers.
+    bool                m_exported_layers_released { false };
+    bool                m_export_gcode_index { false };
     
     //SoftFever: calibration
     Calib_Params m_calib_params;
@@ -1009,6 +1009,65 @@ static PrintObjectRegions* generate_print_object_regions(
     return out.release();
 }
 
+static size_t config_fingerprint(const DynamicPrintConfig &config)
+{
+    size_t seed = 0;
+    for (auto it = config.cbegin(); it != config.cend(); ++ it) {
+        boost::hash_combine(seed, it->first);
+        boost::hash_combine(seed, it->second->hash());
+    }
+    return seed;
+}
+
+static size_t facets_fingerprint(const FacetsAnnotation &facets)
+{
+    const std::pair<std::vector<std::pair<int, int>>, std::vector<bool>> &data = facets.get_data();
+    size_t seed = std::hash<std::vector<bool>>{}(data.second);
+    for (const std::pair<int, int> &triangle : data.first) {
+        boost::hash_combine(seed, triangle.first);
+        boost::hash_combine(seed, triangle.second);
+    }
+    return seed;
+}
+
+// Fingerprint of everything Print::process() compares to find objects which would be sliced the same.
+// Objects with a different fingerprint are never the same, equal fingerprints are verified by a full comparison.
+static size_t print_object_fingerprint(const PrintObject &print_object)
+{
+    const ModelObject *model_object = print_object.model_object();
+    size_t seed = 0;
+    for (Eigen::Index i = 0; i < print_object.trafo().matrix().size(); ++ i)
+        boost::hash_combine(seed, print_object.trafo().matrix().data()[i]);
+    boost::hash_combine(seed, config_fingerprint(model_object->config.get()));
+    for (coordf_t z : model_object->layer_height_profile.get())
+        boost::hash_combine(seed, z);
+    for (const ModelVolume *volume : model_object->volumes) {
+        boost::hash_combine(seed, int(volume->type()));
+        boost::hash_combine(seed, volume->mesh_ptr().get());
+        const Geometry::Transformation &trafo = volume->get_transformation();
+        boost::hash_combine(seed, std::hash<Vec3d>{}(trafo.get_offset()));
+        boost::hash_combine(seed, std::hash<Vec3d>{}(trafo.get_rotation()));
+        boost::hash_combine(seed, std::hash<Vec3d>{}(trafo.get_scaling_factor()));
+        boost::hash_combine(seed, std::hash<Vec3d>{}(trafo.get_mirror()));
+        boost::hash_combine(seed, config_fingerprint(volume->config.get()));
+        boost::hash_combine(seed, facets_fingerprint(volume->supported_facets));
+        boost::hash_combine(seed, facets_fingerprint(volume->seam_facets));
+        boost::hash_combine(seed, facets_fingerprint(volume->mmu_segmentation_facets));
+    }
+    return seed;
+}
+
+// PrintObjects referencing the layers of a deleted PrintObject (see PrintObject::set_shared_object())
+// must not keep the dangling layer pointers.
+static bool release_layers_shared_with(const PrintObjectPtrs &objects, const PrintObject *deleted)
+{
+    bool invalidated = false;
+    for (PrintObject *object : objects)
+        if (object->get_shared_object() == deleted)
+            invalidated |= object->clear_shared_object();
+    return invalidated;
+}
+
 Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_config)
 {
 #ifdef _DEBUG
@@ -1062,6 +1121,13 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
     // Grab the lock for the Print / PrintObject milestones.
 	std::scoped_lock<std::mutex> lock(this->state_mutex());
 
+    // The streaming G-code export released the extrusions of the exported layers, generate them again.
+    if (m_exported_layers_released) {
+        for (PrintObject *object : m_objects)
+            update_apply_status(object->invalidate_step(posPerimeters) | object->invalidate_step(posSupportMaterial));
+        m_exported_layers_released = false;
+    }
+
     // The following call may stop the background processing.
     if (! print_diff.empty())
         update_apply_status(this->invalidate_state_by_config_options(new_full_config, print_diff));
@@ -1190,6 +1256,9 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
                 PrintObjectPtrs print_objects_old = std::move(m_objects);
                 m_objects.clear();
                 m_objects.reserve(print_objects_old.size());
+                for (PrintObject *print_object : print_objects_old)
+                    if (model_object_status_db.get(*print_object->model_object()).status == ModelObjectStatus::Deleted)
+                        update_apply_status(release_layers_shared_with(print_objects_old, print_object));
                 for (PrintObject *print_object : print_objects_old) {
                     const ModelObjectStatus &status = model_object_status_db.get(*print_object->model_object());
                     if (status.status == ModelObjectStatus::Deleted) {
@@ -1397,6 +1466,7 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
             for (const PrintObjectStatus &pos : print_object_status_db)
                 if (pos.status == PrintObjectStatus::Unknown || pos.status == PrintObjectStatus::Deleted) {
                     update_apply_status(pos.print_object->invalidate_all_steps());
+                    update_apply_status(release_layers_shared_with(m_objects, pos.print_object));
                     delete pos.print_object;
 					deleted_objects = true;
                 }
@@ -1562,6 +1632,7 @@ Print::ApplyStatus Print::apply(const Model &model, DynamicPrintConfig new_full_
     for (PrintObject *object : m_objects)
     {
         object->update_slicing_parameters();
+        object->m_shared_object_fingerprint = print_object_fingerprint(*object);
         m_support_used |= object->config().enable_support;
     }
 
@@ -2,6 +2,7 @@
 #define slic3r_PrintBase_hpp_
 
 #include "libslic3r.h"
+#include <array>
 #include <set>
 #include <vector>
 #include <string>
@@ -13,6 +14,7 @@
 #include "Model.hpp"
 #include "PlaceholderParser.hpp"
 #include "PrintConfig.hpp"
+#include "Trace.hpp"
 
 namespace Slic3r {
 
@@ -585,11 +587,23 @@ public:
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintStepEnum step) const { return m_state.state_with_warnings(step, this->state_mutex()); }
 
 protected:
-    bool            set_started(PrintStepEnum step) { return m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); }); }
+    PrintBaseWithState() { m_trace_start.fill(-1); }
+
+    bool            set_started(PrintStepEnum step) {
+        bool started = m_state.set_started(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
+        if (started && Trace::enabled())
+            m_trace_start[step] = Trace::now();
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintStepEnum step) {
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, this->state_mutex(), [this](){ this->throw_if_canceled(); });
         if (status.second)
             this->status_update_warnings(static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
+        if (m_trace_start[step] >= 0) {
+            // trace_step_name() is found by argument dependent lookup next to the step enum.
+            Trace::complete(trace_step_name(step), "step", m_trace_start[step]);
+            m_trace_start[step] = -1;
+        }
         return status.first;
 	}
     bool            invalidate_step(PrintStepEnum step)
@@ -618,6 +632,8 @@ protected:
 
 private:
     PrintState<PrintStepEnum, COUNT> m_state;
+    // Start of the steps being traced, -1 if not traced.
+    std::array<int64_t, COUNT>       m_trace_start;
 };
 
 template<typename PrintType, typename PrintObjectStepEnum, const size_t COUNT>
@@ -633,14 +649,23 @@ public:
     PrintStateBase::StateWithWarnings  step_state_with_warnings(PrintObjectStepEnum step) const { return m_state.state_with_warnings(step, PrintObjectBase::state_mutex(m_print)); }
 
 protected:
-	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) {}
+	PrintObjectBaseWithState(PrintType *print, ModelObject *model_object) : PrintObjectBase(model_object), m_print(print) { m_trace_start.fill(-1); }
 
-    bool            set_started(PrintObjectStepEnum step)
-        { return m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); }); }
+    bool            set_started(PrintObjectStepEnum step) {
+        bool started = m_state.set_started(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
+        if (started && Trace::enabled())
+            m_trace_start[step] = Trace::now();
+        return started;
+    }
 	PrintStateBase::TimeStamp set_done(PrintObjectStepEnum step) {
 		std::pair<PrintStateBase::TimeStamp, bool> status = m_state.set_done(step, PrintObjectBase::state_mutex(m_print), [this](){ this->throw_if_canceled(); });
         if (status.second)
             this->status_update_warnings(m_print, static_cast<int>(step), PrintStateBase::WarningLevel::NON_CRITICAL, std::string());
+        if (m_trace_start[step] >= 0) {
+            // trace_step_name() is found by argument dependent lookup next to the step enum.
+            Trace::complete(trace_step_name(step), "step", m_trace_start[step], this->model_object()->name);
+            m_trace_start[step] = -1;
+        }
         return status.first;
 	}
 
@@ -678,6 +703,8 @@ protected:
 
 private:
     PrintState<PrintObjectStepEnum, COUNT>   m_state;
+    // Start of the steps being traced, -1 if not traced.
+    std::array<int64_t, COUNT>               m_trace_start;
 };
 
 } // namespace Slic3r
@@ -6387,6 +6387,13 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "If enabled, the arrange will allow multiple color on one plate";
     def->set_default_value(new ConfigOptionBool(true));
 
+    def = this->add("orient_time_limit", coFloat);
+    def->label = "Orient time limit";
+    def->tooltip = "Maximum time in seconds spent evaluating orientations of a single object when orienting. 0 means no limit.";
+    def->cli_params = "seconds";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionFloat(0));
+
     def = this->add("allow_rotations", coBool);
     def->label = "Allow rotatations when arrange";
     def->tooltip = "If enabled, the arrange will allow rotations when place object";
@@ -6402,6 +6409,40 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = "Skip the modified gcodes in 3mf from Printer or filament Presets";
     def->cli_params = "option";
     def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("trace", coString);
+    def->label = "Trace file";
+    def->tooltip = "Trace the slicing steps, the G-code export and their parallel tasks, write the trace to the given file "
+                   "in the Chrome trace format, to be opened by chrome://tracing or https://ui.perfetto.dev";
+    def->cli_params = "trace.json";
+    def->set_default_value(new ConfigOptionString());
+
+    def = this->add("memory_stats", coBool);
+    def->label = "Memory statistics";
+    def->tooltip = "Estimate the memory held by each object after each of its slicing steps, write the estimates per plate into result.json. "
+                   "The memory of the G-code processor result is sampled once, after the G-code export of the plate.";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("memory_budget", coInt);
+    def->label = "Memory budget";
+    def->tooltip = "Soft memory budget of the slicing data in MB. When the estimated memory of a plate exceeds the budget, "
+                   "the objects release their caches after each step. Implies --memory-stats. 0 means no budget.";
+    def->cli_params = "MB";
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("streaming_gcode_export", coBool);
+    def->label = "Streaming G-code export";
+    def->tooltip = "Export the G-code of huge prints with memory bounded by a window of layers: the toolpaths of a layer are released "
+                   "once its G-code was generated and the G-code processor keeps only the print statistics, not the moves for the preview. "
+                   "Ignored together with --export-slicedata, which needs the released toolpaths.";
+    def->set_default_value(new ConfigOptionBool(false));
+
+    def = this->add("gcode_index", coBool);
+    def->label = "G-code index";
+    def->tooltip = "Write a random access index next to the exported text G-code (<file>.gcode.index) with the line offsets, the layer boundaries "
+                   "and the lines of the moves, so that a range of layers or lines of a huge G-code may be loaded without parsing the whole G-code.";
+    def->set_default_value(new ConfigOptionBool(false));
 }
 
 const CLIActionsConfigDef    cli_actions_config_def;
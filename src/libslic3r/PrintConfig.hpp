@@ -485,16 +485,28 @@ protected:
     {
     public:
         // To be called during the StaticCache setup.
-        // Add one ConfigOption into m_map_name_to_offset.
+        // Add one ConfigOption into m_offset_by_id.
         template<typename T>
         void                opt_add(const std::string &name, const char *base_ptr, const T &opt)
         {
-            assert(m_map_name_to_offset.find(name) == m_map_name_to_offset.end());
-            m_map_name_to_offset[name] = (const char*)&opt - base_ptr;
+            t_config_option_id id = ConfigOptionKeys::intern(name);
+            if (size_t(id) >= m_offset_by_id.size())
+                m_offset_by_id.resize(id + 1, -1);
+            assert(m_offset_by_id[id] == -1);
+            m_offset_by_id[id] = (const char*)&opt - base_ptr;
+            ++ m_num_options;
         }
 
     protected:
-        std::map<std::string, ptrdiff_t>    m_map_name_to_offset;
+        // Offset of an option from the owner object, indexed by ConfigOptionKeys id, -1 if the option is not a member of the owner.
+        ptrdiff_t           offset(const std::string &name) const
+        {
+            t_config_option_id id = ConfigOptionKeys::find(name);
+            return id >= 0 && size_t(id) < m_offset_by_id.size() ? m_offset_by_id[id] : -1;
+        }
+
+        std::vector<ptrdiff_t>              m_offset_by_id;
+        size_t                              m_num_options { 0 };
     };
 
     // Parametrized by the type of the topmost class owning the options.
@@ -510,28 +522,28 @@ protected:
 
         ConfigOption*       optptr(const std::string &name, T *owner) const
         {
-            const auto it = m_map_name_to_offset.find(name);
-            return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<ConfigOption*>((char*)owner + it->second);
+            const ptrdiff_t off = this->offset(name);
+            return off == -1 ? nullptr : reinterpret_cast<ConfigOption*>((char*)owner + off);
         }
 
         const ConfigOption* optptr(const std::string &name, const T *owner) const
         {
-            const auto it = m_map_name_to_offset.find(name);
-            return (it == m_map_name_to_offset.end()) ? nullptr : reinterpret_cast<const ConfigOption*>((const char*)owner + it->second);
+            const ptrdiff_t off = this->offset(name);
+            return off == -1 ? nullptr : reinterpret_cast<const ConfigOption*>((const char*)owner + off);
         }
 
         const std::vector<std::string>& keys()      const { return m_keys; }
         const T&                        defaults()  const { return *m_defaults; }
 
         // To be called during the StaticCache setup.
-        // Collect option keys from m_map_name_to_offset,
+        // Collect option keys from m_offset_by_id,
         // assign default values to m_defaults.
         void                finalize(T *defaults, const ConfigDef *defs)
         {
             assert(defs != nullptr);
             m_defaults = defaults;
             m_keys.clear();
-            m_keys.reserve(m_map_name_to_offset.size());
+            m_keys.reserve(m_num_options);
             for (const auto &kvp : defs->options) {
                 // Find the option given the option name kvp.first by an offset from (char*)m_defaults.
                 ConfigOption *opt = this->optptr(kvp.first, m_defaults);
@@ -1461,8 +1473,10 @@ private:
             this->options.insert(cli_actions_config_def.options.begin(), cli_actions_config_def.options.end());
             this->options.insert(cli_transform_config_def.options.begin(), cli_transform_config_def.options.end());
             this->options.insert(cli_misc_config_def.options.begin(), cli_misc_config_def.options.end());
-            for (const auto &kvp : this->options)
+            for (const auto &kvp : this->options) {
                 this->by_serialization_key_ordinal[kvp.second.serialization_key_ordinal] = &kvp.second;
+                this->index(kvp.second);
+            }
         }
         // Do not release the default values, they are handled by print_config_def & cli_actions_config_def / cli_transform_config_def / cli_misc_config_def.
         ~PrintAndCLIConfigDef() { this->options.clear(); }
@@ -388,6 +388,7 @@ void PrintObject::make_perimeters()
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
         [this](const tbb::blocked_range<size_t>& range) {
+            SLIC3R_TRACE_SPAN("make_perimeters", "task");
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                 m_print->throw_if_canceled();
                 m_layers[layer_idx]->make_perimeters();
@@ -405,6 +406,7 @@ void PrintObject::prepare_infill()
     if (! this->set_started(posPrepareInfill))
         return;
     m_print->set_status(25, L("Generating infill regions"));
+    m_infill_data_released = false;
     if (m_typed_slices) {
         // To improve robustness of detect_surfaces_type() when reslicing (working with typed slices), see GH issue #7442.
         // The preceding step (perimeter generator) only modifies extra_perimeters and the extra perimeters are only used by discover_vertical_shells()
@@ -550,6 +552,7 @@ void PrintObject::infill()
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
+                SLIC3R_TRACE_SPAN("make_fills", "task");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
@@ -573,6 +576,7 @@ void PrintObject::ironing()
             // Ironing starting with layer 0 to support ironing all surfaces.
             tbb::blocked_range<size_t>(0, m_layers.size()),
             [this](const tbb::blocked_range<size_t>& range) {
+                SLIC3R_TRACE_SPAN("make_ironing", "task");
                 for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
                     m_print->throw_if_canceled();
                     m_layers[layer_idx]->make_ironing();
@@ -687,8 +691,14 @@ void PrintObject::estimate_curled_extrusions()
                                                  float(this->config().brim_width.getFloat())};
             SupportSpotsGenerator::estimate_malformations(this->layers(), params);
             m_print->throw_if_canceled();
+        } else {
+            // Don't leave the curled lines of a previous run with overhang speed enabled behind.
+            for (Layer *layer : m_layers)
+                layer->curled_lines.clear();
         }
-        //this->set_done(posEstimateCurledExtrusions);
+        // The curled lines depend on the perimeters and slices only, both of which invalidate this step when modified.
+        // Thus the result is reused by subsequent process() calls that only touch infill, support or G-code settings.
+        this->set_done(posEstimateCurledExtrusions);
     }
 }
 
@@ -856,6 +866,63 @@ std::shared_ptr<TreeSupportData> PrintObject::alloc_tree_support_preview_cache()
     return m_tree_support_preview_cache;
 }
 
+MemoryUsage PrintObject::memory_usage() const
+{
+    MemoryUsage usage;
+    for (const Layer *layer : m_layers)
+        memory_used(*layer, usage);
+    for (const SupportLayer *layer : m_support_layers)
+        memory_used(*layer, usage);
+    usage[MemoryCategory::Caches] += FillAdaptive::octree_memory_used(m_adaptive_fill_octrees.first.get()) +
+        FillAdaptive::octree_memory_used(m_adaptive_fill_octrees.second.get()) + FillLightning::generator_memory_used(m_lightning_generator.get());
+    if (m_tree_support_preview_cache)
+        usage[MemoryCategory::Caches] += m_tree_support_preview_cache->memory_used();
+    return usage;
+}
+
+void PrintObject::account_memory(const char *step_name)
+{
+    if (! m_print->m_memory_accounting)
+        return;
+    MemoryUsage usage = this->memory_usage();
+    size_t      total = usage.total();
+    // Unsigned arithmetic, the difference may be negative.
+    size_t      current = m_print->m_memory_current.fetch_add(total - m_memory_stats.last_total) + total - m_memory_stats.last_total;
+    m_memory_stats.last_total = total;
+    for (size_t peak = m_print->m_memory_peak.load(); current > peak && ! m_print->m_memory_peak.compare_exchange_weak(peak, current);) ;
+    m_memory_stats.steps.emplace_back(step_name, usage);
+    m_memory_stats.peak.update_peak(usage);
+
+    if (m_print->m_memory_budget > 0 && current > m_print->m_memory_budget) {
+        if (size_t released = this->release_caches(); released > 0) {
+            released = std::min(released, m_memory_stats.last_total);
+            m_print->m_memory_current -= released;
+            m_memory_stats.last_total -= released;
+            m_memory_stats.released_caches += released;
+            BOOST_LOG_TRIVIAL(warning) << "Object " << this->model_object()->name << ": estimated memory " << format_memsize_MB(current)
+                                       << " exceeds the budget " << format_memsize_MB(m_print->m_memory_budget) << " after " << step_name
+                                       << ", released caches of " << format_memsize_MB(released);
+        }
+    }
+}
+
+size_t PrintObject::release_caches()
+{
+    size_t released = 0;
+    if (this->is_step_done(posInfill) && (m_adaptive_fill_octrees.first || m_adaptive_fill_octrees.second || m_lightning_generator)) {
+        released += FillAdaptive::octree_memory_used(m_adaptive_fill_octrees.first.get()) +
+            FillAdaptive::octree_memory_used(m_adaptive_fill_octrees.second.get()) + FillLightning::generator_memory_used(m_lightning_generator.get());
+        m_adaptive_fill_octrees = {};
+        m_lightning_generator.reset();
+        m_infill_data_released = true;
+    }
+    if (this->is_step_done(posSupportMaterial) && m_tree_support_preview_cache) {
+        released += m_tree_support_preview_cache->memory_used();
+        this->clear_tree_support_preview_cache();
+    }
+    return released;
+}
+
 SupportLayer* PrintObject::add_tree_support_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
 {
     m_support_layers.emplace_back(new SupportLayer(id, 0, this, height, print_z, slice_z));
@@ -1170,15 +1237,18 @@ bool PrintObject::invalidate_step(PrintObjectStep step)
 
     // propagate to dependent steps
     if (step == posPerimeters) {
-		invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill, posIroning, posSimplifyPath, posSimplifyInfill });
+		invalidated |= this->invalidate_steps({ posEstimateCurledExtrusions, posPrepareInfill, posInfill, posIroning, posSimplifyPath, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
     } else if (step == posPrepareInfill) {
         invalidated |= this->invalidate_steps({ posInfill, posIroning, posSimplifyPath, posSimplifyInfill });
     } else if (step == posInfill) {
+        if (m_infill_data_released)
+            // The infill needs the octrees and the lightning generator of posPrepareInfill, which were released.
+            invalidated |= Inherited::invalidate_step(posPrepareInfill);
         invalidated |= this->invalidate_steps({ posIroning, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
     } else if (step == posSlice) {
-		invalidated |= this->invalidate_steps({ posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posSimplifyPath, posSimplifyInfill });
+		invalidated |= this->invalidate_steps({ posPerimeters, posEstimateCurledExtrusions, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posSimplifyPath, posSimplifyInfill });
         invalidated |= m_print->invalidate_steps({ psSkirtBrim });
         m_slicing_params.valid = false;
     } else if (step == posSupportMaterial) {
@@ -811,7 +811,11 @@ void PrintObject::slice()
     m_typed_slices = false;
     this->clear_layers();
     m_layers = new_layers(this, generate_object_layers(m_slicing_params, layer_height_profile));
-    this->slice_volumes();
+    Trace::counter("layers", int64_t(m_layers.size()));
+    {
+        SLIC3R_TRACE_SPAN("slice_volumes", "slicer", this->model_object()->name);
+        this->slice_volumes();
+    }
     m_print->throw_if_canceled();
     int firstLayerReplacedBy = 0;
 
@@ -124,6 +124,26 @@ InteriorPtr generate_interior(const TriangleMesh &   mesh,
     // max 8x upscale, min is native voxel size
     auto voxel_scale = MIN_OVERSAMPL + (MAX_OVERSAMPL - MIN_OVERSAMPL) * hc.quality;
 
+    // Only a narrow band around the surface is allocated, so the voxel count
+    // is roughly the surface area times the band width in voxels, growing with
+    // the third power of voxel_scale.
+    if (hc.max_voxel_count > 0) {
+        double area = 0.;
+        for (const Vec3i &face : mesh.its.indices) {
+            const Vec3f &a = mesh.its.vertices[face(0)];
+            area += 0.5 * double((mesh.its.vertices[face(1)] - a).cross(mesh.its.vertices[face(2)] - a).norm());
+        }
+
+        double band = 1.2 * hc.min_thickness + 1.1 * hc.closing_distance;
+        double voxels = area * band * std::pow(voxel_scale, 3);
+        if (voxels > double(hc.max_voxel_count)) {
+            double reduced = std::max(1., voxel_scale * std::cbrt(double(hc.max_voxel_count) / voxels));
+            BOOST_LOG_TRIVIAL(warning) << "Hollowing: estimated " << size_t(voxels) << " voxels exceed the budget of "
+                                       << hc.max_voxel_count << ", voxel scale reduced from " << voxel_scale << " to " << reduced;
+            voxel_scale = reduced;
+        }
+    }
+
     InteriorPtr interior =
         generate_interior_verbose(mesh, ctl, hc.min_thickness, voxel_scale,
                                   hc.closing_distance);
@@ -322,27 +342,34 @@ void hollow_mesh(TriangleMesh &mesh, const Interior &interior, int flags)
 // Get the distance of p to the interior's zero iso_surface. Interior should
 // have its zero isosurface positioned at offset + closing_distance inwards form
 // the model surface.
-static double get_distance_raw(const Vec3f &p, const Interior &interior)
+static double get_distance_raw(const Vec3f &p, const Interior &interior,
+                               const openvdb::FloatGrid::ConstAccessor &accessor)
 {
     assert(interior.gridptr);
 
-    if (!interior.accessor) interior.reset_accessor();
-
     auto v       = (p * interior.voxel_scale).cast<double>();
     auto grididx = interior.gridptr->transform().worldToIndexCellCentered(
         {v.x(), v.y(), v.z()});
 
-    return interior.accessor->getValue(grididx) ;
+    return accessor.getValue(grididx) ;
+}
+
+static double get_distance_raw(const Vec3f &p, const Interior &interior)
+{
+    if (!interior.accessor) interior.reset_accessor();
+
+    return get_distance_raw(p, interior, *interior.accessor);
 }
 
 struct TriangleBubble { Vec3f center; double R; };
 
 // Return the distance of bubble center to the interior boundary or NaN if the
 // triangle is too big to be measured.
-static double get_distance(const TriangleBubble &b, const Interior &interior)
+static double get_distance(const TriangleBubble &b, const Interior &interior,
+                           const openvdb::FloatGrid::ConstAccessor &accessor)
 {
     double R = b.R * interior.voxel_scale;
-    double D = get_distance_raw(b.center, interior);
+    double D = get_distance_raw(b.center, interior, accessor);
 
     return (D > 0. && R >= interior.nb_out) ||
            (D < 0. && R >= interior.nb_in)  ||
@@ -424,134 +451,121 @@ void remove_inside_triangles(TriangleMesh &mesh, const Interior &interior,
         return use_exclude_mask && exclude_mask[face_id];
     };
 
-    // TODO: Parallel mode not working yet
-    using exec_policy = ccr_seq;
-
-    // Info about the needed modifications on the input mesh.
-    struct MeshMods {
-
-        // Just a thread safe wrapper for a vector of triangles.
-        struct {
-            std::vector<std::array<Vec3f, 3>> data;
-            exec_policy::SpinningMutex        mutex;
-
-            void emplace_back(const std::array<Vec3f, 3> &pts)
-            {
-                std::lock_guard lk{mutex};
-                data.emplace_back(pts);
-            }
-
-            size_t size() const { return data.size(); }
-            const std::array<Vec3f, 3>& operator[](size_t idx) const
-            {
-                return data[idx];
-            }
+    if (! interior.gridptr)
+        return;
 
-        } new_triangles;
+    using exec_policy = ccr_par;
 
-        // A vector of bool for all faces signaling if it needs to be removed
-        // or not.
-        std::vector<bool> to_remove;
+    // The faces are processed in chunks, each one with its own grid accessor
+    // (accessors cache the last visited nodes and are not thread safe) and its
+    // own list of new triangles. Every face of the input mesh is visited by
+    // exactly one chunk, so the removal flags are never written concurrently.
+    static constexpr size_t ChunkSize = 1024;
+    const size_t chunk_cnt = (faces.size() + ChunkSize - 1) / ChunkSize;
 
-        MeshMods(const TriangleMesh &mesh):
-            to_remove(mesh.its.indices.size(), false) {}
+    // A flag for all faces signaling if it needs to be removed or not.
+    // Not using std::vector<bool> as neighboring bits are written from
+    // different threads.
+    std::vector<uint8_t> to_remove(faces.size(), false);
+    std::vector<std::vector<std::array<Vec3f, 3>>> new_triangles(chunk_cnt);
 
-        // Number of triangles that need to be removed.
-        size_t to_remove_cnt() const
-        {
-            return std::accumulate(to_remove.begin(), to_remove.end(), size_t(0));
-        }
+    exec_policy::for_each(size_t(0), chunk_cnt, [&](size_t chunk_idx) {
+        openvdb::FloatGrid::ConstAccessor accessor = interior.gridptr->getConstAccessor();
+        std::vector<std::array<Vec3f, 3>> &chunk_triangles = new_triangles[chunk_idx];
 
-    } mesh_mods{mesh};
+        // Must return true if further division of the face is needed.
+        auto divfn = [&interior, bb, &to_remove, &chunk_triangles, &accessor](const DivFace &f) {
+            BoundingBoxf3 facebb { f.verts.begin(), f.verts.end() };
 
-    // Must return true if further division of the face is needed.
-    auto divfn = [&interior, bb, &mesh_mods](const DivFace &f) {
-        BoundingBoxf3 facebb { f.verts.begin(), f.verts.end() };
-
-        // Face is certainly outside the cavity
-        if (! facebb.intersects(bb) && f.faceid != NEW_FACE) {
-            return false;
-        }
-
-        TriangleBubble bubble{facebb.center().cast<float>(), facebb.radius()};
+            // Face is certainly outside the cavity
+            if (! facebb.intersects(bb) && f.faceid != NEW_FACE) {
+                return false;
+            }
 
-        double D = get_distance(bubble, interior);
-        double R = bubble.R * interior.voxel_scale;
+            TriangleBubble bubble{facebb.center().cast<float>(), facebb.radius()};
 
-        if (std::isnan(D)) // The distance cannot be measured, triangle too big
-            return true;
+            double D = get_distance(bubble, interior, accessor);
+            double R = bubble.R * interior.voxel_scale;
 
-        // Distance of the bubble wall to the interior wall. Negative if the
-        // bubble is overlapping with the interior
-        double bubble_distance = D - R;
+            if (std::isnan(D)) // The distance cannot be measured, triangle too big
+                return true;
 
-        // The face is crossing the interior or inside, it must be removed and
-        // parts of it re-added, that are outside the interior
-        if (bubble_distance < 0.) {
-            if (f.faceid != NEW_FACE)
-                mesh_mods.to_remove[f.faceid] = true;
+            // Distance of the bubble wall to the interior wall. Negative if the
+            // bubble is overlapping with the interior
+            double bubble_distance = D - R;
 
-            if (f.parent != NEW_FACE) // Top parent needs to be removed as well
-                mesh_mods.to_remove[f.parent] = true;
+            // The face is crossing the interior or inside, it must be removed and
+            // parts of it re-added, that are outside the interior
+            if (bubble_distance < 0.) {
+                if (f.faceid != NEW_FACE)
+                    to_remove[f.faceid] = true;
 
-            // If the outside part is between the interior end the exterior
-            // (inside the wall being invisible), no further division is needed.
-            if ((R + D) < interior.thickness)
-                return false;
+                if (f.parent != NEW_FACE) // Top parent needs to be removed as well
+                    to_remove[f.parent] = true;
 
-            return true;
-        } else if (f.faceid == NEW_FACE) {
-            // New face completely outside needs to be re-added.
-            mesh_mods.new_triangles.emplace_back(f.verts);
-        }
+                // If the outside part is between the interior end the exterior
+                // (inside the wall being invisible), no further division is needed.
+                if ((R + D) < interior.thickness)
+                    return false;
 
-        return false;
-    };
+                return true;
+            } else if (f.faceid == NEW_FACE) {
+                // New face completely outside needs to be re-added.
+                chunk_triangles.emplace_back(f.verts);
+            }
 
-    interior.reset_accessor();
+            return false;
+        };
 
-    exec_policy::for_each(size_t(0), faces.size(), [&] (size_t face_idx) {
-        const Vec3i &face = faces[face_idx];
+        size_t face_end = std::min(faces.size(), (chunk_idx + 1) * ChunkSize);
+        for (size_t face_idx = chunk_idx * ChunkSize; face_idx < face_end; ++face_idx) {
+            const Vec3i &face = faces[face_idx];
 
-        // If the triangle is excluded, we need to keep it.
-        if (is_excluded(face_idx))
-            return;
+            // If the triangle is excluded, we need to keep it.
+            if (is_excluded(face_idx))
+                continue;
 
-        std::array<Vec3f, 3> pts =
-            { vertices[face(0)], vertices[face(1)], vertices[face(2)] };
+            std::array<Vec3f, 3> pts =
+                { vertices[face(0)], vertices[face(1)], vertices[face(2)] };
 
-        BoundingBoxf3 facebb { pts.begin(), pts.end() };
+            BoundingBoxf3 facebb { pts.begin(), pts.end() };
 
-        // Face is certainly outside the cavity
-        if (! facebb.intersects(bb)) return;
+            // Face is certainly outside the cavity
+            if (! facebb.intersects(bb)) continue;
 
-        DivFace df{face, pts, long(face_idx)};
+            DivFace df{face, pts, long(face_idx)};
 
-        if (divfn(df))
-            divide_triangle(df, divfn);
+            if (divfn(df))
+                divide_triangle(df, divfn);
+        }
+    }, 1);
 
-    }, exec_policy::max_concurreny());
+    size_t new_triangles_cnt = 0;
+    for (const std::vector<std::array<Vec3f, 3>> &chunk_triangles : new_triangles)
+        new_triangles_cnt += chunk_triangles.size();
+    size_t to_remove_cnt = std::accumulate(to_remove.begin(), to_remove.end(), size_t(0));
 
-    auto new_faces = reserve_vector<Vec3i>(faces.size() +
-                                           mesh_mods.new_triangles.size());
+    auto new_faces = reserve_vector<Vec3i>(faces.size() + new_triangles_cnt);
 
     for (size_t face_idx = 0; face_idx < faces.size(); ++face_idx) {
-        if (!mesh_mods.to_remove[face_idx])
+        if (!to_remove[face_idx])
             new_faces.emplace_back(faces[face_idx]);
     }
 
-    for(size_t i = 0; i < mesh_mods.new_triangles.size(); ++i) {
-        size_t o = vertices.size();
-        vertices.emplace_back(mesh_mods.new_triangles[i][0]);
-        vertices.emplace_back(mesh_mods.new_triangles[i][1]);
-        vertices.emplace_back(mesh_mods.new_triangles[i][2]);
-        new_faces.emplace_back(int(o), int(o + 1), int(o + 2));
-    }
+    vertices.reserve(vertices.size() + 3 * new_triangles_cnt);
+    for (const std::vector<std::array<Vec3f, 3>> &chunk_triangles : new_triangles)
+        for (const std::array<Vec3f, 3> &tri : chunk_triangles) {
+            size_t o = vertices.size();
+            vertices.emplace_back(tri[0]);
+            vertices.emplace_back(tri[1]);
+            vertices.emplace_back(tri[2]);
+            new_faces.emplace_back(int(o), int(o + 1), int(o + 2));
+        }
 
     BOOST_LOG_TRIVIAL(info)
-            << "Trimming: " << mesh_mods.to_remove_cnt() << " triangles removed";
+            << "Trimming: " << to_remove_cnt << " triangles removed";
     BOOST_LOG_TRIVIAL(info)
-            << "Trimming: " << mesh_mods.new_triangles.size() << " triangles added";
+            << "Trimming: " << new_triangles_cnt << " triangles added";
 
     faces.swap(new_faces);
     new_faces = {};
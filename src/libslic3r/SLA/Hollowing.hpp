@@ -15,6 +15,11 @@ struct HollowingConfig
     double quality          = 0.5;
     double closing_distance = 0.5;
     bool enabled = true;
+
+    // Upper limit of the estimated active voxel count of the interior grid.
+    // The sampling resolution is reduced for models which would exceed it.
+    // Zero means no limit.
+    size_t max_voxel_count = 256 * 1024 * 1024;
 };
 
 enum HollowingFlags { hfRemoveInsideTriangles = 0x1 };
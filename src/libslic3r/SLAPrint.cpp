@@ -5,7 +5,9 @@
 #include "Geometry.hpp"
 #include "MTUtils.hpp"
 #include "Thread.hpp"
+#include "Utils.hpp"
 
+#include <chrono>
 #include <unordered_set>
 #include <numeric>
 
@@ -718,7 +720,10 @@ void SLAPrint::process(long long *time_cost_with_cache, bool use_cache)
     Benchmark bench;
 #else
     struct {
-        void start() {} void stop() {} double getElapsedSec() { return .0; }
+        std::chrono::steady_clock::time_point t_start, t_stop;
+        void start() { t_start = std::chrono::steady_clock::now(); }
+        void stop() { t_stop = std::chrono::steady_clock::now(); }
+        double getElapsedSec() { return std::chrono::duration<double>(t_stop - t_start).count(); }
     } bench;
 #endif
 
@@ -746,6 +751,9 @@ void SLAPrint::process(long long *time_cost_with_cache, bool use_cache)
                     printsteps.execute(step, *po);
                     bench.stop();
                     step_times[step] += bench.getElapsedSec();
+                    BOOST_LOG_TRIVIAL(info) << "SLA object step \"" << printsteps.label(step) << "\" of "
+                                            << po->model_object()->name << " took " << bench.getElapsedSec() << " s"
+                                            << log_memory_info();
                     throw_if_canceled();
                     po->set_done(step);
                 }
@@ -771,6 +779,8 @@ void SLAPrint::process(long long *time_cost_with_cache, bool use_cache)
             printsteps.execute(currentstep);
             bench.stop();
             step_times[slaposCount + currentstep] += bench.getElapsedSec();
+            BOOST_LOG_TRIVIAL(info) << "SLA print step \"" << printsteps.label(currentstep) << "\" took "
+                                    << bench.getElapsedSec() << " s" << log_memory_info();
             throw_if_canceled();
             set_done(currentstep);
         }
@@ -29,6 +29,23 @@ enum SLAPrintObjectStep : unsigned int {
 	slaposCount
 };
 
+// Names of the steps in the traces, see Trace.hpp.
+inline const char* trace_step_name(SLAPrintStep step)
+{
+    static constexpr const char *names[] = { "slapsMergeSlicesAndEval", "slapsRasterize" };
+    static_assert(sizeof(names) / sizeof(names[0]) == slapsCount);
+    return names[step];
+}
+
+inline const char* trace_step_name(SLAPrintObjectStep step)
+{
+    static constexpr const char *names[] = {
+        "slaposHollowing", "slaposDrillHoles", "slaposObjectSlice", "slaposSupportPoints", "slaposSupportTree", "slaposPad", "slaposSliceSupports"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == slaposCount);
+    return names[step];
+}
+
 class SLAPrint;
 class GLCanvas;
 
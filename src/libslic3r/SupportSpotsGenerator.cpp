@@ -19,7 +19,9 @@
 #include "tbb/blocked_range2d.h"
 #include "tbb/parallel_reduce.h"
 #include <algorithm>
+#include <atomic>
 #include <boost/log/trivial.hpp>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
@@ -37,6 +39,17 @@
 #include "libslic3r/ClipperUtils.hpp"
 #include "Geometry/ConvexHull.hpp"
 
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 // #define DETAILED_DEBUG_LOGS
 // #define DEBUG_FILES
 
@@ -143,51 +156,116 @@ float estimate_curled_up_height(
     return curled_up_height;
 }
 
+namespace {
+
+// Geometry-only inputs of the curling estimate of a single layer. None of it depends on the curling estimated for the layers below,
+// thus the indices of several layers are built in parallel while the curling of the layer below is still being evaluated.
+struct LayerCurlIndex
+{
+    struct Perimeter
+    {
+        const ExtrusionEntity *extrusion { nullptr };
+        Points                 points;
+        float                  flow_width { 0.f };
+    };
+
+    Layer                                *layer { nullptr };
+    // Outline of the layer below, used to correct the sign of the distance to the extrusions of the layer below.
+    AABBTreeLines::LinesDistancer<Linef>  prev_layer_boundary;
+    std::vector<Perimeter>                external_perimeters;
+};
+
+LayerCurlIndex build_layer_curl_index(Layer *l)
+{
+    LayerCurlIndex out;
+    out.layer = l;
+    if (l->lower_layer != nullptr)
+        out.prev_layer_boundary = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(l->lower_layer->lslices)};
+    for (const LayerRegion *layer_region : l->regions())
+        for (const ExtrusionEntity *extrusion : layer_region->perimeters.flatten().entities)
+            if (extrusion->role() == Slic3r::erExternalPerimeter) {
+                LayerCurlIndex::Perimeter &perimeter = out.external_perimeters.emplace_back();
+                perimeter.extrusion  = extrusion;
+                perimeter.flow_width = get_flow_width(layer_region, extrusion->role());
+                extrusion->collect_points(perimeter.points);
+            }
+    return out;
+}
+
+} // namespace
+
 void estimate_malformations(LayerPtrs &layers, const Params &params)
 {
-	LD prev_layer_lines{};
-	for (Layer *l : layers) {
-        l->curled_lines.clear();
-        std::vector<Linef> boundary_lines = l->lower_layer != nullptr ? to_unscaled_linesf(l->lower_layer->lslices) : std::vector<Linef>();
-        AABBTreeLines::LinesDistancer<Linef> prev_layer_boundary{std::move(boundary_lines)};
-        std::vector<ExtrusionLine>           current_layer_lines;
-        for (const LayerRegion *layer_region : l->regions()) {
-			for (const ExtrusionEntity *extrusion : layer_region->perimeters.flatten().entities) {
-			    if (extrusion->role() != Slic3r::erExternalPerimeter)
-                    continue;
-				Points extrusion_pts;
-                extrusion->collect_points(extrusion_pts);
-				float flow_width       = get_flow_width(layer_region, extrusion->role());
-				auto  annotated_points = estimate_points_properties<true, true, false, false>(extrusion_pts, prev_layer_lines, flow_width,
-                                                                                             params.bridge_distance);
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point t_start = Clock::now();
+    // Summed over all worker threads.
+    std::atomic<int64_t>    index_time_us { 0 };
+    int64_t                 curling_time_us = 0;
+
+	LD     prev_layer_lines{};
+    size_t next_layer_idx = 0;
+
+    const auto generator = tbb::make_filter<void, Layer*>(slic3r_tbb_filtermode::serial_in_order,
+        [&layers, &next_layer_idx](tbb::flow_control &fc) -> Layer* {
+            if (next_layer_idx == layers.size()) {
+                fc.stop();
+                return nullptr;
+            }
+            return layers[next_layer_idx ++];
+        });
+    const auto index_builder = tbb::make_filter<Layer*, LayerCurlIndex>(slic3r_tbb_filtermode::parallel,
+        [&index_time_us](Layer *l) -> LayerCurlIndex {
+            const Clock::time_point t = Clock::now();
+            LayerCurlIndex out = build_layer_curl_index(l);
+            index_time_us += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t).count();
+            return out;
+        });
+    // The curling of a line depends on the curling of the line below it, thus the layers have to be processed bottom up.
+    const auto curling = tbb::make_filter<LayerCurlIndex, void>(slic3r_tbb_filtermode::serial_in_order,
+        [&params, &prev_layer_lines, &curling_time_us](LayerCurlIndex in) {
+            const Clock::time_point t = Clock::now();
+            Layer *l = in.layer;
+            l->curled_lines.clear();
+            std::vector<ExtrusionLine> current_layer_lines;
+            for (const LayerCurlIndex::Perimeter &perimeter : in.external_perimeters) {
+                const float flow_width       = perimeter.flow_width;
+                auto        annotated_points = estimate_points_properties<true, true, false, false>(perimeter.points, prev_layer_lines, flow_width,
+                                                                                                  params.bridge_distance);
                 for (size_t i = 0; i < annotated_points.size(); ++i) {
-                	const ExtendedPoint &a = i > 0 ? annotated_points[i - 1] : annotated_points[i];
+                    const ExtendedPoint &a = i > 0 ? annotated_points[i - 1] : annotated_points[i];
                     const ExtendedPoint &b = annotated_points[i];
                     ExtrusionLine line_out{a.position.cast<float>(), b.position.cast<float>(), float((a.position - b.position).norm()),
-                                           extrusion};
+                                           perimeter.extrusion};
                     Vec2f middle                               = 0.5 * (line_out.a + line_out.b);
                     auto [middle_distance, bottom_line_idx, x] = prev_layer_lines.distance_from_lines_extra<false>(middle);
                     ExtrusionLine bottom_line                  = prev_layer_lines.get_lines().empty() ? ExtrusionLine{} :
                                                                                                         prev_layer_lines.get_line(bottom_line_idx);
 
                     // correctify the distance sign using slice polygons
-                    float sign = (prev_layer_boundary.distance_from_lines<true>(middle.cast<double>()) + 0.5f * flow_width) < 0.0f ? -1.0f : 1.0f;
+                    float sign = (in.prev_layer_boundary.distance_from_lines<true>(middle.cast<double>()) + 0.5f * flow_width) < 0.0f ? -1.0f : 1.0f;
 
                     line_out.curled_up_height = estimate_curled_up_height(middle_distance * sign, 0.5 * (a.curvature + b.curvature),
                                                                           l->height, flow_width, bottom_line.curled_up_height, params);
 
                     current_layer_lines.push_back(line_out);
                 }
-			}
-        }
-        for (const ExtrusionLine &line : current_layer_lines) {
-            if (line.curled_up_height > params.curling_tolerance_limit) {
-                l->curled_lines.push_back(CurledLine{Point::new_scale(line.a), Point::new_scale(line.b), line.curled_up_height});
             }
-        }
-        
-        prev_layer_lines = LD{current_layer_lines};
-    }
+            for (const ExtrusionLine &line : current_layer_lines) {
+                if (line.curled_up_height > params.curling_tolerance_limit) {
+                    l->curled_lines.push_back(CurledLine{Point::new_scale(line.a), Point::new_scale(line.b), line.curled_up_height});
+                }
+            }
+
+            prev_layer_lines = LD{current_layer_lines};
+            curling_time_us += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - t).count();
+        });
+
+    // Bounded number of layer indices in flight, the indices of a tall object would not fit into memory at once.
+    tbb::parallel_pipeline(12, generator & index_builder & curling);
+
+    BOOST_LOG_TRIVIAL(debug) << "estimate_malformations: " << layers.size() << " layers, index building "
+                             << index_time_us.load() / 1000 << " ms (all threads), curling " << curling_time_us / 1000 << " ms, total "
+                             << std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t_start).count() << " ms";
 }
 
 /*
@@ -0,0 +1,159 @@
+#include "SystemPresetIndex.hpp"
+#include "Exception.hpp"
+#include "Utils.hpp"
+#include "libslic3r_version.h"
+
+#include <atomic>
+#include <cstdio>
+
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/archives/binary.hpp>
+
+namespace Slic3r {
+
+static constexpr uint32_t INDEX_MAGIC          = 0x49505053; // "SPPI"
+// Increment whenever the layout of the index changes.
+static constexpr uint32_t INDEX_FORMAT_VERSION = 1;
+
+static std::atomic<bool> s_index_enabled { true };
+
+// 64bit FNV-1a
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static constexpr uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+static inline uint64_t fnv1a(uint64_t hash, const char *data, size_t size)
+{
+    for (const char *end = data + size; data != end; ++ data)
+        hash = (hash ^ uint64_t(uint8_t(*data))) * FNV_PRIME;
+    return hash;
+}
+
+// The configs are stored by the serialization ordinals of print_config_def, which are only stable within a single build.
+// SLIC3R_BUILD_ID is not unique for development builds, thus the definitions of the options are hashed as well:
+// a key added, removed or renamed, a changed type, default value or enum shifts the ordinals or the meaning of the values.
+static std::string build_fingerprint_uncached()
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    auto hash_string = [&hash](const std::string &str) {
+        // Hash the length as well, so that the boundaries of the consecutive strings are part of the hash.
+        const uint64_t len = str.size();
+        hash = fnv1a(hash, reinterpret_cast<const char*>(&len), sizeof(len));
+        hash = fnv1a(hash, str.data(), str.size());
+    };
+    auto hash_value = [&hash](uint64_t value) {
+        hash = fnv1a(hash, reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    for (const auto &[opt_key, def] : print_config_def.options) {
+        hash_string(opt_key);
+        hash_value(uint64_t(def.type));
+        hash_value(uint64_t(def.serialization_key_ordinal));
+        hash_string(def.default_value ? def.default_value->serialize() : std::string());
+        for (const std::string &enum_value : def.enum_values)
+            hash_string(enum_value);
+    }
+    return (boost::format("%1%+%2%/%3%/%4$016x") % SLIC3R_VERSION % SLIC3R_BUILD_ID % print_config_def.options.size() % hash).str();
+}
+
+static const std::string& build_fingerprint()
+{
+    static const std::string fingerprint = build_fingerprint_uncached();
+    return fingerprint;
+}
+
+void SystemPresetIndex::set_enabled(bool enabled) { s_index_enabled = enabled; }
+bool SystemPresetIndex::enabled() { return s_index_enabled; }
+
+uint64_t SystemPresetIndex::checksum(const std::vector<std::string> &files)
+{
+    uint64_t          hash = FNV_OFFSET_BASIS;
+    std::vector<char> buffer(65536);
+    for (const std::string &file : files) {
+        FILE *f = boost::nowide::fopen(file.c_str(), "rb");
+        if (f == nullptr)
+            return 0;
+        // Hash the file name as well, so that swapping content of two files changes the checksum.
+        hash = fnv1a(hash, file.data(), file.size());
+        for (size_t len; (len = ::fread(buffer.data(), 1, buffer.size(), f)) > 0;)
+            hash = fnv1a(hash, buffer.data(), len);
+        bool failed = ::ferror(f) != 0;
+        ::fclose(f);
+        if (failed)
+            return 0;
+    }
+    // 0 is reserved for "unknown".
+    return hash == 0 ? 1 : hash;
+}
+
+std::string SystemPresetIndex::path(const std::string &vendor_dir, const std::string &vendor_name, bool filaments_only)
+{
+    if (! enabled() || data_dir().empty())
+        return {};
+    // The same vendor may be loaded from the data directory and from the resources, keep their indices apart.
+    uint64_t dir_hash = fnv1a(FNV_OFFSET_BASIS, vendor_dir.data(), vendor_dir.size());
+    std::string file_name = (boost::format("%1%.%2$016x%3%.bin") % vendor_name % dir_hash % (filaments_only ? ".filaments" : "")).str();
+    return (boost::filesystem::path(data_dir()) / "cache" / "presets" / file_name).make_preferred().string();
+}
+
+bool SystemPresetIndex::load(const std::string &path, uint64_t checksum)
+{
+    this->clear();
+    if (path.empty() || checksum == 0 || ! boost::filesystem::exists(path))
+        return false;
+    try {
+        boost::nowide::ifstream ifs(path, std::ios::binary);
+        cereal::BinaryInputArchive archive(ifs);
+        uint32_t    magic, format_version;
+        std::string fingerprint;
+        uint64_t    index_checksum;
+        archive(magic, format_version);
+        if (magic != INDEX_MAGIC || format_version != INDEX_FORMAT_VERSION)
+            return false;
+        archive(fingerprint, index_checksum);
+        if (fingerprint != build_fingerprint() || index_checksum != checksum) {
+            BOOST_LOG_TRIVIAL(info) << __FUNCTION__ << ": stale preset index " << path;
+            return false;
+        }
+        archive(this->prints, this->filaments, this->printers);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed reading preset index " << path << ", reason = " << ex.what();
+        this->clear();
+        return false;
+    }
+    return true;
+}
+
+bool SystemPresetIndex::save(const std::string &path, uint64_t checksum) const
+{
+    if (path.empty() || checksum == 0)
+        return false;
+    // Write into a temporary file first, so that a concurrently starting instance never reads a partial index.
+    boost::filesystem::path path_tmp(path + boost::filesystem::unique_path(".%%%%-%%%%.tmp").string());
+    try {
+        boost::filesystem::create_directories(path_tmp.parent_path());
+        {
+            boost::nowide::ofstream ofs(path_tmp.string(), std::ios::binary);
+            cereal::BinaryOutputArchive archive(ofs);
+            archive(INDEX_MAGIC, INDEX_FORMAT_VERSION, build_fingerprint(), checksum);
+            archive(this->prints, this->filaments, this->printers);
+            ofs.close();
+            if (! ofs)
+                throw Slic3r::RuntimeError("write error");
+        }
+        boost::filesystem::rename(path_tmp, path);
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(error) << __FUNCTION__ << ": failed writing preset index " << path << ", reason = " << ex.what();
+        boost::system::error_code ec;
+        boost::filesystem::remove(path_tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,64 @@
+#ifndef slic3r_SystemPresetIndex_hpp_
+#define slic3r_SystemPresetIndex_hpp_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PrintConfig.hpp"
+
+namespace Slic3r {
+
+// Binary index of the system presets of a single vendor with their "inherits" chains resolved.
+// Loading a vendor from JSON parses each process / filament / machine file and flattens it over its parents,
+// which dominates the application startup with some two thousand vendor files. The index stores the flattened
+// configs as a cereal binary archive together with a checksum of the vendor JSON files it was produced from,
+// therefore it is reused until either the JSON files or the application build change.
+// The index is stored per vendor, so only the vendors actually being loaded are read from disk.
+class SystemPresetIndex
+{
+public:
+    struct Entry
+    {
+        std::string              name;
+        // Path of the source JSON file relative to the vendor directory.
+        std::string              subpath;
+        std::string              alias;
+        std::vector<std::string> renamed_from;
+        std::string              setting_id;
+        std::string              filament_id;
+        // Normalized config with the inherited values applied.
+        DynamicPrintConfig       config;
+
+        template<class Archive> void serialize(Archive &ar) { ar(name, subpath, alias, renamed_from, setting_id, filament_id, config); }
+    };
+    // Presets of a single PresetCollection in the order they were loaded.
+    using Entries = std::vector<Entry>;
+
+    Entries prints;
+    Entries filaments;
+    Entries printers;
+
+    bool        empty() const { return prints.empty() && filaments.empty() && printers.empty(); }
+    void        clear() { prints.clear(); filaments.clear(); printers.clear(); }
+
+    // Load the index from path if it was produced by this build from sources with the same checksum.
+    // Returns false if the index does not exist, is stale or corrupted, this is left empty in that case.
+    bool        load(const std::string &path, uint64_t checksum);
+    // Save the index atomically, failures are logged and ignored as the index is just a cache.
+    bool        save(const std::string &path, uint64_t checksum) const;
+
+    // Checksum of the content of the files, 0 if any of them could not be read.
+    static uint64_t    checksum(const std::vector<std::string> &files);
+    // Path of the index of a vendor loaded from vendor_dir, empty if the index is disabled or there is no data directory.
+    // Filament only loads get an index of their own, as they skip the process and machine presets.
+    static std::string path(const std::string &vendor_dir, const std::string &vendor_name, bool filaments_only);
+
+    // The index may be disabled, for example to benchmark loading of the JSON files.
+    static void        set_enabled(bool enabled);
+    static bool        enabled();
+};
+
+} // namespace Slic3r
+
+#endif /* slic3r_SystemPresetIndex_hpp_ */
@@ -0,0 +1,195 @@
+#include "Trace.hpp"
+#include "Thread.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+namespace Slic3r::Trace {
+
+std::atomic<bool> detail::g_enabled { false };
+
+namespace {
+
+struct Event
+{
+    const char  *name;
+    const char  *category;
+    // 'X' for a complete event, 'C' for a counter.
+    char         phase;
+    int64_t      timestamp;
+    // Duration of a complete event, value of a counter.
+    int64_t      value;
+    std::string  detail;
+};
+
+// Events are recorded into per thread buffers, so that threads recording events do not contend.
+// The mutex of a buffer is only contended while exporting or clearing.
+struct ThreadBuffer
+{
+    uint32_t           thread_id;
+    std::string        thread_name;
+    std::mutex         mutex;
+    std::vector<Event> events;
+};
+
+// Limit the memory consumed by tracing a long running application, the excess events are dropped.
+static constexpr size_t max_events_per_thread = 1 << 20;
+
+std::mutex                                 s_buffers_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> s_buffers;
+const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+ThreadBuffer& this_thread_buffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        if (std::optional<std::string> name = get_current_thread_name(); name && ! name->empty())
+            buffer->thread_name = std::move(*name);
+        std::scoped_lock<std::mutex> lock(s_buffers_mutex);
+        buffer->thread_id = uint32_t(s_buffers.size() + 1);
+        if (buffer->thread_name.empty())
+            buffer->thread_name = "thread_" + std::to_string(buffer->thread_id);
+        s_buffers.emplace_back(buffer);
+        return buffer;
+    }();
+    return *buffer;
+}
+
+void record(Event &&event)
+{
+    ThreadBuffer &buffer = this_thread_buffer();
+    std::scoped_lock<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() < max_events_per_thread)
+        buffer.events.emplace_back(std::move(event));
+}
+
+void append_escaped(std::string &out, const char *str)
+{
+    for (; *str != 0; ++ str) {
+        char c = *str;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", int(c));
+            out += buf;
+        } else
+            out += c;
+    }
+}
+
+} // namespace
+
+void set_enabled(bool enabled)
+{
+    detail::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+void complete(const char *name, const char *category, int64_t start, std::string detail)
+{
+    record({ name, category, 'X', start, now() - start, std::move(detail) });
+}
+
+void counter(const char *name, int64_t value)
+{
+    if (enabled())
+        record({ name, "counter", 'C', now(), value, std::string() });
+}
+
+void clear()
+{
+    std::scoped_lock<std::mutex> lock(s_buffers_mutex);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : s_buffers) {
+        std::scoped_lock<std::mutex> lock_buffer(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+size_t num_events()
+{
+    size_t num = 0;
+    std::scoped_lock<std::mutex> lock(s_buffers_mutex);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : s_buffers) {
+        std::scoped_lock<std::mutex> lock_buffer(buffer->mutex);
+        num += buffer->events.size();
+    }
+    return num;
+}
+
+std::map<std::string, int64_t> total_durations(const char *category)
+{
+    std::map<std::string, int64_t> out;
+    std::scoped_lock<std::mutex> lock(s_buffers_mutex);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : s_buffers) {
+        std::scoped_lock<std::mutex> lock_buffer(buffer->mutex);
+        for (const Event &event : buffer->events)
+            if (event.phase == 'X' && strcmp(event.category, category) == 0)
+                out[event.name] += event.value;
+    }
+    return out;
+}
+
+std::string chrome_trace_json()
+{
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool        first = true;
+    auto        separator = [&out, &first]() { if (! first) out += ",\n"; first = false; };
+    std::scoped_lock<std::mutex> lock(s_buffers_mutex);
+    for (const std::shared_ptr<ThreadBuffer> &buffer : s_buffers) {
+        std::scoped_lock<std::mutex> lock_buffer(buffer->mutex);
+        const std::string tid = std::to_string(buffer->thread_id);
+        separator();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"";
+        append_escaped(out, buffer->thread_name.c_str());
+        out += "\"}}";
+        for (const Event &event : buffer->events) {
+            separator();
+            out += "{\"name\":\"";
+            append_escaped(out, event.name);
+            out += "\",\"cat\":\"";
+            append_escaped(out, event.category);
+            out += "\",\"ph\":\"";
+            out += event.phase;
+            out += "\",\"pid\":1,\"tid\":" + tid + ",\"ts\":" + std::to_string(event.timestamp);
+            if (event.phase == 'X') {
+                out += ",\"dur\":" + std::to_string(event.value);
+                if (! event.detail.empty()) {
+                    out += ",\"args\":{\"detail\":\"";
+                    append_escaped(out, event.detail.c_str());
+                    out += "\"}";
+                }
+            } else
+                out += ",\"args\":{\"value\":" + std::to_string(event.value) + "}";
+            out += "}";
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool export_chrome_trace(const std::string &path)
+{
+    std::string json = chrome_trace_json();
+    FILE *f = boost::nowide::fopen(path.c_str(), "wb");
+    bool  ok = f != nullptr && ::fwrite(json.data(), 1, json.size(), f) == json.size();
+    if (f != nullptr && ::fclose(f) != 0)
+        ok = false;
+    if (! ok)
+        BOOST_LOG_TRIVIAL(error) << "Failed to write the trace to " << path;
+    return ok;
+}
+
+} // namespace Slic3r::Trace
@@ -0,0 +1,66 @@
+#ifndef slic3r_Trace_hpp_
+#define slic3r_Trace_hpp_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Lightweight tracing of the slicing process: scoped spans and counters recorded per thread,
+// exported in the Chrome trace event format (chrome://tracing, https://ui.perfetto.dev).
+// Unlike the Shiny profiler enabled by SLIC3R_PROFILE, the tracing is always compiled in and it is enabled
+// at runtime. While disabled, a span costs a single relaxed atomic load.
+// Names and categories are not copied, they have to be string literals.
+namespace Slic3r::Trace {
+
+namespace detail {
+    extern std::atomic<bool> g_enabled;
+}
+
+void        set_enabled(bool enabled);
+inline bool enabled() { return detail::g_enabled.load(std::memory_order_relaxed); }
+
+// Microseconds since the start of the application.
+int64_t     now();
+
+// Record a span, which started at start and ended now. Detail is exported as the "detail" argument of the span.
+void        complete(const char *name, const char *category, int64_t start, std::string detail = std::string());
+// Record a value of a counter.
+void        counter(const char *name, int64_t value);
+
+// Drop all the recorded events.
+void        clear();
+// Number of the recorded events.
+size_t      num_events();
+// Sum of the durations of the spans of a category recorded so far by span name, in microseconds.
+std::map<std::string, int64_t> total_durations(const char *category);
+// Events recorded so far in the Chrome trace JSON format.
+std::string chrome_trace_json();
+// Write the events recorded so far in the Chrome trace JSON format. Returns false on failure.
+bool        export_chrome_trace(const std::string &path);
+
+// Records a span from construction until destruction, if tracing was enabled at construction.
+class Span
+{
+public:
+    explicit Span(const char *name, const char *category = "slicer") : m_name(name), m_category(category), m_start(enabled() ? now() : -1) {}
+    Span(const char *name, const char *category, std::string detail) : Span(name, category) { if (m_start >= 0) m_detail = std::move(detail); }
+    ~Span() { if (m_start >= 0) complete(m_name, m_category, m_start, std::move(m_detail)); }
+    Span(const Span &) = delete;
+    Span& operator=(const Span &) = delete;
+
+private:
+    const char  *m_name;
+    const char  *m_category;
+    int64_t      m_start;
+    std::string  m_detail;
+};
+
+} // namespace Slic3r::Trace
+
+#define SLIC3R_TRACE_CONCAT_IMPL(a, b) a##b
+#define SLIC3R_TRACE_CONCAT(a, b) SLIC3R_TRACE_CONCAT_IMPL(a, b)
+// Trace the rest of the enclosing scope.
+#define SLIC3R_TRACE_SPAN(...) ::Slic3r::Trace::Span SLIC3R_TRACE_CONCAT(slic3r_trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif // slic3r_Trace_hpp_
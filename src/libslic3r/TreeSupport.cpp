@@ -10,6 +10,7 @@
 #include "SVG.hpp"
 #include "ShortestPath.hpp"
 #include "I18N.hpp"
+#include "MemoryStats.hpp"
 #include <libnest2d/backends/libslic3r/geometries.hpp>
 
 #define _L(s) Slic3r::I18N::translate(s)
@@ -3621,6 +3622,22 @@ const ExPolygons& TreeSupportData::get_avoidance(coordf_t radius, size_t layer_n
     return avoidance;
 }
 
+size_t TreeSupportData::memory_used() const
+{
+    size_t out = layer_heights.capacity() * sizeof(LayerHeightData) + tree_nodes.capacity() * sizeof(TreeNode);
+    for (const TreeNode &node : tree_nodes)
+        out += (node.children.capacity() + node.parents.capacity()) * sizeof(int);
+    for (const std::vector<ExPolygons> *outlines : { &m_layer_outlines, &m_layer_outlines_below }) {
+        out += outlines->capacity() * sizeof(ExPolygons);
+        for (const ExPolygons &expolys : *outlines)
+            out += Slic3r::memory_used(expolys);
+    }
+    for (const auto *cache : { &m_collision_cache, &m_avoidance_cache })
+        for (const auto &[key, expolys] : *cache)
+            out += sizeof(RadiusLayerPair) + sizeof(ExPolygons) + Slic3r::memory_used(expolys);
+    return out;
+}
+
 Polygons TreeSupportData::get_contours(size_t layer_nr) const
 {
     Polygons contours;
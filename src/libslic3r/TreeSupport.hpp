@@ -98,6 +98,9 @@ public:
     Polygons get_contours(size_t layer_nr) const;
     Polygons get_contours_with_holes(size_t layer_nr) const;
 
+    // Estimated heap memory of the layer outlines, the collision and avoidance caches and the tree nodes.
+    size_t memory_used() const;
+
     std::vector<LayerHeightData> layer_heights;
 
     std::vector<TreeNode> tree_nodes;
@@ -484,6 +484,12 @@ void GCodeViewer::SequentialView::GCodeWindow::load_gcode(const std::string& fil
     if (m_file.is_open())
         return;
 
+    // The lines of a binary G-code are compressed, they cannot be read from a file mapping.
+    if (BinaryGCode::is_binary_gcode(filename)) {
+        BOOST_LOG_TRIVIAL(info) << "Binary G-code " << filename << ". Cannot show G-code window.";
+        return;
+    }
+
     m_filename   = filename;
     m_lines_ends = lines_ends;
 
@@ -169,7 +169,8 @@ void OrientJob::process()
     orientation::OrientParams params;
     orientation::OrientParamsArea params_area;
     if (settings.min_area) {
-        memcpy(&params, &params_area, sizeof(params));
+        // OrientParamsArea has the layout of the leading fields of OrientParams.
+        memcpy(&params, &params_area, sizeof(params_area));
         params.min_volume = false;
     }
     else {
@@ -1,4 +1,5 @@
 #include "UndoRedo.hpp"
+#include "UndoRedoChunkStore.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -48,6 +49,9 @@ static inline std::string ptr_to_string(const void* ptr)
 
 static std::string topmost_snapshot_name = "@@@ Topmost @@@";
 
+// Serialized data not referenced by this number of the most recent snapshots gets compressed.
+static constexpr size_t cold_snapshot_age = 4;
+
 bool Snapshot::is_topmost() const
 {
 	return this->name == topmost_snapshot_name;
@@ -342,26 +346,34 @@ private:
 	{
 		// Reference counter of this data chunk. We may have used shared_ptr, but the shared_ptr is thread safe
 		// with the associated cost of CPU cache invalidation on refcount change.
-		size_t		refcnt;
-		size_t		size;
-		char 		data[1];
+		size_t				refcnt;
+		size_t				size;
+		// Copy of the first 8 bytes of the serialized data, where the objects with a reliable timestamp store it.
+		uint64_t			head;
+		// The serialized data is split into chunks shared by all objects of the Undo / Redo stack.
+		ChunkStore		   *store;
+		ChunkStore::Chunks	chunks;
 
 		// The serialized data matches the data stored here.
-		bool 		matches(const std::string& rhs) { return this->size == rhs.size() && memcmp(this->data, rhs.data(), this->size) == 0; }
+		bool 		matches(const std::string& rhs) { return this->size == rhs.size() && store->matches(this->chunks, rhs); }
 
 		// The timestamp matches the timestamp serialized in the data stored here.
-		bool 		matches_timestamp(uint64_t timestamp) { assert(timestamp > 0);  assert(this->size > 8); return memcmp(this->data, &timestamp, 8) == 0; }
+		bool 		matches_timestamp(uint64_t timestamp) { assert(timestamp > 0);  assert(this->size > 8); return this->head == timestamp; }
 	};
 
 	Interval    m_interval;
 	Data	   *m_data;
 
 public:
-	MutableHistoryInterval(const Interval &interval, const std::string &input_data) : m_interval(interval), m_data(nullptr) {
-		m_data = (Data*)new char[offsetof(Data, data) + input_data.size()];
+	MutableHistoryInterval(const Interval &interval, const std::string &input_data, ChunkStore &store) : m_interval(interval), m_data(nullptr) {
+		m_data = new Data;
 		m_data->refcnt = 1;
 		m_data->size = input_data.size();
-		memcpy(m_data->data, input_data.data(), input_data.size());
+		m_data->head = 0;
+		memcpy(&m_data->head, input_data.data(), std::min(input_data.size(), sizeof(uint64_t)));
+		m_data->store = &store;
+		// The interval ends just after the snapshot being taken.
+		m_data->chunks = store.store(input_data, interval.end() - 1);
 	}
 
 	MutableHistoryInterval(const Interval &interval, MutableHistoryInterval &other) : m_interval(interval), m_data(other.m_data) {
@@ -375,8 +387,10 @@ public:
 	MutableHistoryInterval& operator=(MutableHistoryInterval&& rhs) { m_interval = rhs.m_interval; m_data = rhs.m_data; rhs.m_data = nullptr; return *this; }
 
 	~MutableHistoryInterval() {
-		if (m_data != nullptr && -- m_data->refcnt == 0)
-			delete[] (char*)m_data;
+		if (m_data != nullptr && -- m_data->refcnt == 0) {
+			m_data->store->release(m_data->chunks);
+			delete m_data;
+		}
 	}
 
 	const Interval& interval() const { return m_interval; }
@@ -390,17 +404,23 @@ public:
 	bool		operator<(const MutableHistoryInterval& rhs) const { return m_interval < rhs.m_interval; }
 	bool 		operator==(const MutableHistoryInterval& rhs) const { return m_interval == rhs.m_interval; }
 
-	const char* data() const { return m_data->data; }
+	// Identity of the data shared by multiple intervals.
+	const void* data_id() const { return m_data; }
+	std::string data() const { return m_data->store->load(m_data->chunks); }
 	size_t  	size() const { return m_data->size; }
 	size_t		refcnt() const { return m_data->refcnt; }
 	bool		matches(const std::string& data) { return m_data->matches(data); }
 	bool		matches_timestamp(uint64_t timestamp) { return m_data->matches_timestamp(timestamp); }
+	// The data is referenced by the snapshot taken at time, thus it is not cold.
+	void 		touch(size_t time) { ChunkStore::touch(m_data->chunks, time); }
 	size_t 		memsize() const {
+		// Size of the chunks after compression, the chunks shared with other data are divided by their reference count.
+		size_t memsize = sizeof(Data) + ChunkStore::memsize(m_data->chunks);
 		return m_data->refcnt == 1 ?
 			// Count just the size of the snapshot data.
-			m_data->size :
+			memsize :
 			// Count the size of the snapshot data divided by the number of references, rounded up.
-			(m_data->size + m_data->refcnt - 1) / m_data->refcnt;
+			(memsize + m_data->refcnt - 1) / m_data->refcnt;
 	}
 
 private:
@@ -449,30 +469,33 @@ public:
 				// Just extend the last interval using the old data.
 				m_history.back().extend_end(current_time + 1);
 			}
+			m_history.back().touch(current_time);
 			return true;
 		}
 		// The timestamp is not valid, the caller has to call this->save() with the serialized data.
 		return false;
 	}
 
-	void save(size_t active_snapshot_time, size_t current_time, const std::string &data) {
+	void save(size_t active_snapshot_time, size_t current_time, const std::string &data, ChunkStore &store) {
 		assert(m_history.empty() || m_history.back().end() <= active_snapshot_time);
 		if (m_history.empty() || m_history.back().end() < active_snapshot_time) {
-			if (! m_history.empty() && m_history.back().matches(data))
+			if (! m_history.empty() && m_history.back().matches(data)) {
 				// Share the previous data by reference counting.
 				m_history.emplace_back(Interval(current_time, current_time + 1), m_history.back());
-			else
+				m_history.back().touch(current_time);
+			} else
 				// Allocate new data.
-				m_history.emplace_back(Interval(current_time, current_time + 1), data);
+				m_history.emplace_back(Interval(current_time, current_time + 1), data, store);
 		} else {
 			assert(! m_history.empty());
 			assert(m_history.back().end() == active_snapshot_time);
-			if (m_history.back().matches(data))
+			if (m_history.back().matches(data)) {
 				// Just extend the last interval using the old data.
 				m_history.back().extend_end(current_time + 1);
-			else
+				m_history.back().touch(current_time);
+			} else
 				// Allocate new data time continuous with the previous data.
-				m_history.emplace_back(Interval(active_snapshot_time, current_time + 1), data);
+				m_history.emplace_back(Interval(active_snapshot_time, current_time + 1), data, store);
 		}
 	}
 
@@ -485,7 +508,7 @@ public:
 				--it;
 		}
 		//assert(timestamp >= it->begin() && timestamp < it->end());
-		return std::string(it->data(), it->data() + it->size());
+		return it->data();
 	}
 
 	// Currently all mutable snapshots are mandatory.
@@ -497,7 +520,7 @@ public:
 	std::string format() override {
 		std::string out = typeid(T).name();
 		for (const MutableHistoryInterval &interval : m_history)
-			out += std::string(", ptr:") + ptr_to_string(interval.data()) + " len:" + std::to_string(interval.size()) + " <" + std::to_string(interval.begin()) + "," + std::to_string(interval.end()) + ")";
+			out += std::string(", ptr:") + ptr_to_string(interval.data_id()) + " len:" + std::to_string(interval.size()) + " <" + std::to_string(interval.begin()) + "," + std::to_string(interval.end()) + ")";
 		return out;
 	}
 #endif /* SLIC3R_UNDOREDO_DEBUG */
@@ -527,16 +550,16 @@ bool MutableObjectHistory<T>::valid()
 {
 	// Verify that the history intervals are sorted and do not overlap, and that the data reference counters are correct.
 	if (! m_history.empty()) {
-		std::map<const char*, size_t> refcntrs;
-		assert(m_history.front().data() != nullptr);
-		++ refcntrs[m_history.front().data()];
+		std::map<const void*, size_t> refcntrs;
+		assert(m_history.front().data_id() != nullptr);
+		++ refcntrs[m_history.front().data_id()];
 		for (size_t i = 1; i < m_history.size(); ++ i) {
 			assert(m_history[i - 1].interval().strictly_before(m_history[i].interval()));
-			++ refcntrs[m_history[i].data()];
+			++ refcntrs[m_history[i].data_id()];
 		}
 		for (const auto &hi : m_history) {
-			assert(hi.data() != nullptr);
-			assert(refcntrs[hi.data()] == hi.refcnt());
+			assert(hi.data_id() != nullptr);
+			assert(refcntrs[hi.data_id()] == hi.refcnt());
 		}
 	}
 	return true;
@@ -679,6 +702,9 @@ private:
 	// Maximum memory allowed to be occupied by the Undo / Redo stack. If the limit is exceeded,
 	// least recently used snapshots will be released.
 	size_t 													m_memory_limit;
+	// Serialized data of the mutable objects, deduplicated by content over all objects and snapshots.
+	// Declared before m_objects, as the object histories release their chunks when being destroyed.
+	ChunkStore 												m_chunks;
 	// Each individual object (Model, ModelObject, ModelInstance, ModelVolume, Selection, TriangleMesh)
 	// is stored with its own history, referenced by the ObjectID. Immutable objects do not provide
 	// their own IDs, therefore there are temporary IDs generated for them and stored to m_shared_ptr_to_object_id.
@@ -852,7 +878,7 @@ template<typename T> ObjectID StackImpl::save_mutable_object(const T &object)
 			Slic3r::UndoRedo::OutputArchive archive(*this, oss);
 			archive(object);
 		}
-		object_history->save(m_active_snapshot_time, m_current_time, oss.str());
+		object_history->save(m_active_snapshot_time, m_current_time, oss.str(), m_chunks);
 	}
 	return object.id();
 }
@@ -961,6 +987,9 @@ void StackImpl::take_snapshot(const std::string& snapshot_name, const Slic3r::Mo
 	m_snapshots.emplace_back(topmost_snapshot_name, m_active_snapshot_time, 0, snapshot_data);
 	// Release empty objects from the history.
 	this->collect_garbage();
+	// Compress the data not referenced by the last few snapshots. Such data is only needed when jumping further back in history.
+	if (m_current_time > cold_snapshot_age)
+		m_chunks.compress_cold(m_current_time - cold_snapshot_age);
 	assert(this->valid());
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	std::cout << "After snapshot" << std::endl;
@@ -1189,6 +1218,10 @@ void StackImpl::release_least_recently_used()
 #ifdef SLIC3R_UNDOREDO_DEBUG
 	bool released = false;
 #endif
+	// The memory limit applies to the compressed data. Compress everything first, even the data of the recent snapshots,
+	// before releasing any snapshot.
+	if (current_memsize > m_memory_limit && m_chunks.compress_cold(size_t(-1)) > 0)
+		current_memsize = this->memsize();
 	// First try to release the optional immutable data (for example the convex hulls),
 	// or the shared vertices of triangle meshes.
 	for (auto it = m_objects.begin(); current_memsize > m_memory_limit && it != m_objects.end();) {
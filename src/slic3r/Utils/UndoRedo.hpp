@@ -123,7 +123,8 @@ public:
 	void clear();
 	bool empty() const;
 
-	// Set maximum memory threshold. If the threshold is exceeded, least recently used snapshots are released.
+	// Set maximum memory threshold. If the threshold is exceeded, the snapshot data is compressed first,
+	// then least recently used snapshots are released. The threshold applies to the compressed size.
 	void set_memory_limit(size_t memsize);
 	size_t get_memory_limit() const;
 
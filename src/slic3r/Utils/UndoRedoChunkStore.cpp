@@ -0,0 +1,211 @@
+#include "UndoRedoChunkStore.hpp"
+#include "minilzo_extension.hpp"
+
+#include <libslic3r/Exception.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+namespace Slic3r {
+namespace UndoRedo {
+
+// Random table of the gear rolling hash, generated by splitmix64 to be stable between runs.
+static const std::array<uint64_t, 256>& gear_table()
+{
+	static const std::array<uint64_t, 256> table = []() {
+		std::array<uint64_t, 256> out;
+		uint64_t state = 0x9E3779B97F4A7C15ull;
+		for (uint64_t &v : out) {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			v = z ^ (z >> 31);
+		}
+		return out;
+	}();
+	return table;
+}
+
+// 64bit FNV-1a
+static uint64_t chunk_hash(const char *data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (const char *p = data; p != data + size; ++ p)
+		hash = (hash ^ uint64_t((unsigned char)*p)) * 0x100000001b3ull;
+	return hash;
+}
+
+// Find the end of a chunk starting at begin.
+static size_t chunk_end(const std::string &data, size_t begin)
+{
+	const std::array<uint64_t, 256> &gear = gear_table();
+	const size_t end = std::min(data.size(), begin + ChunkStore::max_chunk_size);
+	uint64_t     h   = 0;
+	for (size_t i = begin + ChunkStore::min_chunk_size; i < end; ++ i) {
+		h = (h << 1) + gear[(unsigned char)data[i]];
+		if ((h & ChunkStore::boundary_mask) == 0)
+			return i + 1;
+	}
+	return end;
+}
+
+ChunkStore::Chunks ChunkStore::store(const std::string &data, size_t time)
+{
+	Chunks out;
+	out.reserve(data.size() / (min_chunk_size + boundary_mask) + 1);
+	for (size_t begin = 0; begin < data.size();) {
+		size_t end = chunk_end(data, begin);
+		out.emplace_back(this->acquire(data.data() + begin, end - begin, time));
+		begin = end;
+	}
+	return out;
+}
+
+ChunkStore::Chunk* ChunkStore::acquire(const char *data, size_t size, size_t time)
+{
+	const uint64_t hash = chunk_hash(data, size);
+	auto range = m_chunks.equal_range(hash);
+	std::string tmp;
+	for (auto it = range.first; it != range.second; ++ it) {
+		Chunk &chunk = *it->second;
+		if (chunk.size != size)
+			continue;
+		const std::string *uncompressed = &chunk.data;
+		if (chunk.compressed) {
+			decompress(chunk, tmp);
+			uncompressed = &tmp;
+		}
+		if (memcmp(uncompressed->data(), data, size) == 0) {
+			++ chunk.refcnt;
+			chunk.last_used = std::max(chunk.last_used, time);
+			return &chunk;
+		}
+	}
+	auto chunk = std::make_unique<Chunk>();
+	chunk->hash 	  = hash;
+	chunk->refcnt 	  = 1;
+	chunk->size 	  = size;
+	chunk->last_used  = time;
+	chunk->compressed = false;
+	chunk->incompressible = false;
+	chunk->data.assign(data, size);
+	return m_chunks.emplace(hash, std::move(chunk))->second.get();
+}
+
+void ChunkStore::release(const Chunks &chunks)
+{
+	for (Chunk *chunk : chunks) {
+		assert(chunk->refcnt > 0);
+		if (-- chunk->refcnt == 0) {
+			auto range = m_chunks.equal_range(chunk->hash);
+			auto it = std::find_if(range.first, range.second, [chunk](const auto &kvp){ return kvp.second.get() == chunk; });
+			assert(it != range.second);
+			m_chunks.erase(it);
+		}
+	}
+}
+
+void ChunkStore::touch(const Chunks &chunks, size_t time)
+{
+	for (Chunk *chunk : chunks)
+		chunk->last_used = std::max(chunk->last_used, time);
+}
+
+void ChunkStore::decompress(const Chunk &chunk, std::string &out)
+{
+	assert(chunk.compressed);
+	out.resize(chunk.size);
+	uint64_t out_len = chunk.size;
+	if (lzo_decompress((unsigned char*)chunk.data.data(), chunk.data.size(), (unsigned char*)out.data(), &out_len) != 0 || out_len != chunk.size)
+		throw Slic3r::RuntimeError("Undo / Redo stack: Failed to decompress snapshot data");
+}
+
+std::string ChunkStore::load(const Chunks &chunks) const
+{
+	size_t size = 0;
+	for (const Chunk *chunk : chunks)
+		size += chunk->size;
+	std::string out;
+	out.reserve(size);
+	std::string tmp;
+	for (const Chunk *chunk : chunks)
+		if (chunk->compressed) {
+			decompress(*chunk, tmp);
+			out += tmp;
+		} else
+			out += chunk->data;
+	return out;
+}
+
+bool ChunkStore::matches(const Chunks &chunks, const std::string &data) const
+{
+	size_t size = 0;
+	for (const Chunk *chunk : chunks)
+		size += chunk->size;
+	if (size != data.size())
+		return false;
+	// The chunk boundaries only depend on the content, thus matching data is split the same way.
+	size_t begin = 0;
+	std::string tmp;
+	for (const Chunk *chunk : chunks) {
+		size_t end = chunk_end(data, begin);
+		if (end - begin != chunk->size || chunk_hash(data.data() + begin, chunk->size) != chunk->hash)
+			return false;
+		const std::string *uncompressed = &chunk->data;
+		if (chunk->compressed) {
+			decompress(*chunk, tmp);
+			uncompressed = &tmp;
+		}
+		if (memcmp(uncompressed->data(), data.data() + begin, chunk->size) != 0)
+			return false;
+		begin = end;
+	}
+	return true;
+}
+
+size_t ChunkStore::compress_cold(size_t time_threshold)
+{
+	if (! m_compression)
+		return 0;
+	size_t 		saved = 0;
+	std::string buffer;
+	for (auto &kvp : m_chunks) {
+		Chunk &chunk = *kvp.second;
+		if (chunk.compressed || chunk.incompressible || chunk.last_used >= time_threshold)
+			continue;
+		// Worst case expansion of LZO1X.
+		buffer.resize(chunk.size + chunk.size / 16 + 64 + 3);
+		uint64_t out_len = buffer.size();
+		if (lzo_compress((unsigned char*)chunk.data.data(), chunk.size, (unsigned char*)buffer.data(), &out_len) == 0 && out_len < chunk.size) {
+			saved += chunk.data.size() - out_len;
+			// Allocate exactly the compressed size.
+			chunk.data 		 = std::string(buffer.data(), out_len);
+			chunk.compressed = true;
+		} else
+			// Don't try again, the content of a chunk never changes.
+			chunk.incompressible = true;
+	}
+	return saved;
+}
+
+size_t ChunkStore::memsize(const Chunks &chunks)
+{
+	size_t memsize = chunks.size() * sizeof(Chunk*);
+	for (const Chunk *chunk : chunks)
+		// Count the size of the chunk divided by the number of references, rounded up.
+		memsize += (chunk->memsize() + chunk->refcnt - 1) / chunk->refcnt;
+	return memsize;
+}
+
+size_t ChunkStore::memsize() const
+{
+	size_t memsize = 0;
+	for (const auto &kvp : m_chunks)
+		memsize += kvp.second->memsize();
+	return memsize;
+}
+
+} // namespace UndoRedo
+} // namespace Slic3r
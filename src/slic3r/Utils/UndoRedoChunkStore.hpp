@@ -0,0 +1,90 @@
+#ifndef slic3r_Utils_UndoRedoChunkStore_hpp_
+#define slic3r_Utils_UndoRedoChunkStore_hpp_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Slic3r {
+namespace UndoRedo {
+
+// Content addressed storage of the serialized mutable objects captured by the Undo / Redo stack.
+// A serialized object is split into content defined chunks, each chunk is stored just once and shared
+// by reference counting between the snapshots of all objects of a single stack. Thus a large painted
+// TriangleSelector with a small stroke added, or the same config stored with many objects, only costs
+// the chunks that actually differ.
+// Chunks not referenced by recent snapshots are cold and they are compressed with LZO.
+class ChunkStore
+{
+public:
+	struct Chunk
+	{
+		uint64_t 	hash;
+		size_t 		refcnt;
+		// Size of the uncompressed data.
+		size_t 		size;
+		// Logical time of the last snapshot storing this chunk.
+		size_t 		last_used;
+		bool 		compressed;
+		// LZO failed to reduce the size of the chunk.
+		bool 		incompressible;
+		// Either the uncompressed data or the LZO compressed data.
+		std::string data;
+
+		// Memory occupied by the chunk.
+		size_t 		memsize() const { return sizeof(Chunk) + data.size(); }
+	};
+	using Chunks = std::vector<Chunk*>;
+
+	ChunkStore() = default;
+	~ChunkStore() = default;
+	ChunkStore(const ChunkStore &) = delete;
+	ChunkStore& operator=(const ChunkStore &) = delete;
+
+	// Split data into chunks, share the chunks already stored, reference all of them.
+	// time is the logical time of the snapshot being taken, it is used to find the cold chunks.
+	Chunks 			store(const std::string &data, size_t time);
+	// Release references to the chunks, free the unreferenced chunks.
+	void 			release(const Chunks &chunks);
+	// Concatenate the chunks, decompressing the cold ones.
+	std::string 	load(const Chunks &chunks) const;
+	// Mark the chunks as referenced by a snapshot taken at time.
+	static void 	touch(const Chunks &chunks, size_t time);
+	// Does the concatenation of chunks match data? Cheaper than store() followed by comparison of the chunks.
+	bool 			matches(const Chunks &chunks, const std::string &data) const;
+
+	// Compress chunks not stored since time_threshold. Returns the amount of memory saved.
+	size_t 			compress_cold(size_t time_threshold);
+	// Compression of the cold chunks may be disabled, then compress_cold() is a no-op.
+	void 			set_compression(bool enable) { m_compression = enable; }
+	bool 			compression() const { return m_compression; }
+
+	// Memory occupied by the chunks referenced by chunks, shared chunks are divided by their reference count.
+	static size_t 	memsize(const Chunks &chunks);
+	// Memory occupied by all the chunks.
+	size_t 			memsize() const;
+	size_t 			num_chunks() const { return m_chunks.size(); }
+	bool 			empty() const { return m_chunks.empty(); }
+
+	// Content defined chunking parameters. Chunks are cut where a rolling hash of the last 64 bytes matches a mask,
+	// thus inserting or removing a few bytes only modifies the chunks around the edit.
+	static constexpr size_t min_chunk_size = 2048;
+	static constexpr size_t max_chunk_size = 65536;
+	// Average chunk size is min_chunk_size + (boundary_mask + 1), thus ~10kB.
+	static constexpr uint64_t boundary_mask = (uint64_t(1) << 13) - 1;
+
+private:
+	Chunk* 			acquire(const char *data, size_t size, size_t time);
+	static void 	decompress(const Chunk &chunk, std::string &out);
+
+	std::unordered_multimap<uint64_t, std::unique_ptr<Chunk>> m_chunks;
+	bool 													  m_compression { true };
+};
+
+} // namespace UndoRedo
+} // namespace Slic3r
+
+#endif /* slic3r_Utils_UndoRedoChunkStore_hpp_ */
@@ -0,0 +1,341 @@
+// Headless slicing benchmark over a fixed corpus of models and configurations.
+//
+// Each case is sliced --repeat times, the median wall clock time of each PrintObjectStep and PrintStep
+// (summed over all objects), of the G-code export and of a standalone GCodeProcessor pass over the exported
+// G-code is reported in milliseconds. The results are written as JSON with --output, the same file may later
+// be passed as --baseline to detect regressions:
+//
+//   slicer_benchmark --output baseline.json
+//   slicer_benchmark --baseline baseline.json --threshold 15 --output results.json
+//
+// A metric regressed if it is slower than the baseline by more than the threshold (in percent) and by more
+// than --min-delta milliseconds, which filters out the noise of very short steps. Thresholds of individual
+// metrics may be overridden by the "thresholds" object of the baseline, keyed by "case/metric".
+// Exit code: 0 - no regression, 1 - regression detected, 2 - error.
+
+#include "libslic3r/libslic3r.h"
+#include "libslic3r/Model.hpp"
+#include "libslic3r/ModelArrange.hpp"
+#include "libslic3r/Print.hpp"
+#include "libslic3r/PrintConfig.hpp"
+#include "libslic3r/Trace.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+#include "libslic3r/TriangleSelector.hpp"
+#include "libslic3r/Format/OBJ.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+#include "nlohmann/json.hpp"
+
+using namespace Slic3r;
+
+namespace {
+
+// Version of the layout of the results.
+constexpr int RESULTS_FORMAT = 1;
+
+struct BenchmarkCase
+{
+    const char                                    *name;
+    // Fills in the model, objects are arranged and dropped to the bed afterwards.
+    std::function<void(Model &model)>              make_model;
+    std::vector<ConfigBase::SetDeserializeItem>    config;
+};
+
+TriangleMesh load_test_mesh(const char *file_name)
+{
+    std::string  path = std::string(TEST_DATA_DIR) + "/" + file_name;
+    TriangleMesh mesh;
+    std::string  message;
+    if (! load_obj(path.c_str(), &mesh, message))
+        throw Slic3r::RuntimeError("Failed to load " + path + ": " + message);
+    return mesh;
+}
+
+void add_object(Model &model, const char *name, TriangleMesh &&mesh)
+{
+    ModelObject *object = model.add_object();
+    object->name = name;
+    object->add_volume(std::move(mesh));
+    object->add_instance();
+}
+
+// Paint the upper half of the volume with the second filament and the facets facing +X with the third filament.
+void paint_mmu_segmentation(ModelVolume &volume)
+{
+    const TriangleMesh        &mesh = volume.mesh();
+    const indexed_triangle_set &its = mesh.its;
+    const float                z_mid = float(0.5 * (mesh.bounding_box().min.z() + mesh.bounding_box().max.z()));
+    TriangleSelector           selector(mesh);
+    for (int facet_idx = 0; facet_idx < int(its.indices.size()); ++ facet_idx) {
+        const stl_triangle_vertex_indices &face = its.indices[facet_idx];
+        Vec3f centroid = (its.vertices[face(0)] + its.vertices[face(1)] + its.vertices[face(2)]) / 3.f;
+        if (centroid.x() > 0.f && its_face_normal(its, facet_idx).x() > 0.5f)
+            selector.set_facet(facet_idx, EnforcerBlockerType::Extruder3);
+        else if (centroid.z() > z_mid)
+            selector.set_facet(facet_idx, EnforcerBlockerType::Extruder2);
+    }
+    volume.mmu_segmentation_facets.set(selector);
+}
+
+const std::vector<BenchmarkCase>& benchmark_cases()
+{
+    static const std::vector<BenchmarkCase> cases {
+        { "dense_sphere",
+          [](Model &model) { add_object(model, "sphere", make_sphere(50, PI / 243.0)); },
+          { { "sparse_infill_density", "15%" } } },
+        { "organic_support",
+          [](Model &model) { add_object(model, "frog_legs", load_test_mesh("frog_legs.obj")); },
+          { { "enable_support", 1 }, { "support_type", "tree(auto)" }, { "support_style", "organic" } } },
+        { "many_objects",
+          [](Model &model) {
+              const char *files[] = { "A.obj", "extruder_idler.obj", "two_hollow_squares.obj", "overhang.obj" };
+              for (int i = 0; i < 32; ++ i)
+                  add_object(model, files[i % 4], load_test_mesh(files[i % 4]));
+          },
+          { { "sparse_infill_density", "20%" } } },
+        { "mmu_painted",
+          [](Model &model) {
+              add_object(model, "painted_sphere", make_sphere(25, PI / 120.0));
+              paint_mmu_segmentation(*model.objects.front()->volumes.front());
+          },
+          // The prime tower is disabled, the case measures the segmentation of the painted regions.
+          { { "filament_colour", "#FFFFFF;#FF0000;#0000FF" }, { "filament_diameter", "1.75,1.75,1.75" },
+            { "filament_type", "PLA;PLA;PLA" }, { "enable_prime_tower", 0 } } },
+        { "arachne_walls",
+          [](Model &model) {
+              add_object(model, "A", load_test_mesh("A.obj"));
+              add_object(model, "sloping_hole", load_test_mesh("sloping_hole.obj"));
+              add_object(model, "small_dorito", load_test_mesh("small_dorito.obj"));
+          },
+          { { "wall_generator", "arachne" }, { "wall_loops", 4 }, { "sparse_infill_density", "0%" } } },
+    };
+    return cases;
+}
+
+using Metrics = std::map<std::string, double>;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Metrics run_once(const Model &model, const DynamicPrintConfig &config, const std::string &gcode_path)
+{
+    Metrics metrics;
+    Print   print;
+    print.set_status_silent();
+    print.apply(model, config);
+    if (StringObjectException err = print.validate(); ! err.string.empty())
+        throw Slic3r::RuntimeError("Invalid print: " + err.string);
+
+    Trace::clear();
+    Trace::set_enabled(true);
+    auto start = std::chrono::steady_clock::now();
+    print.process();
+    metrics["process"] = elapsed_ms(start);
+    Trace::set_enabled(false);
+    for (const auto &[step, duration] : Trace::total_durations("step"))
+        metrics[step] = double(duration) / 1000.;
+    // The G-code export step is measured as a whole below.
+    metrics.erase("psGCodeExport");
+    Trace::clear();
+
+    start = std::chrono::steady_clock::now();
+    GCodeProcessorResult result;
+    print.export_gcode(gcode_path, &result, nullptr);
+    metrics["gcode_export"] = elapsed_ms(start);
+
+    start = std::chrono::steady_clock::now();
+    GCodeProcessor processor;
+    processor.process_file(gcode_path);
+    metrics["gcode_processor"] = elapsed_ms(start);
+
+    metrics["total"] = metrics["process"] + metrics["gcode_export"];
+    return metrics;
+}
+
+Metrics median(const std::vector<Metrics> &runs)
+{
+    Metrics out;
+    for (const auto &[name, value] : runs.front()) {
+        std::vector<double> values;
+        for (const Metrics &run : runs)
+            if (auto it = run.find(name); it != run.end())
+                values.emplace_back(it->second);
+        std::sort(values.begin(), values.end());
+        out[name] = values[values.size() / 2];
+    }
+    return out;
+}
+
+struct Options
+{
+    std::string output;
+    std::string baseline;
+    std::string case_filter;
+    int         repeat    { 3 };
+    double      threshold { 10. };
+    double      min_delta { 5. };
+};
+
+void print_usage()
+{
+    std::cout << "Usage: slicer_benchmark [--output results.json] [--baseline baseline.json] [--threshold percent]\n"
+                 "                        [--min-delta ms] [--repeat count] [--case name] [--list]\n";
+}
+
+// Returns the number of regressions.
+int compare(const nlohmann::json &results, const nlohmann::json &baseline, const Options &options)
+{
+    const nlohmann::json thresholds = baseline.value("thresholds", nlohmann::json::object());
+    const double         default_threshold = thresholds.value("default", options.threshold);
+    int                  regressions = 0;
+    for (const auto &[case_name, metrics] : results["cases"].items()) {
+        if (! baseline["cases"].contains(case_name)) {
+            std::cout << case_name << ": not in the baseline\n";
+            continue;
+        }
+        const nlohmann::json &base_metrics = baseline["cases"][case_name];
+        for (const auto &[metric, value] : metrics.items()) {
+            if (! base_metrics.contains(metric))
+                continue;
+            const double base      = base_metrics[metric];
+            const double current   = value;
+            const double threshold = thresholds.value(case_name + "/" + metric, default_threshold);
+            const double change    = base > 0. ? 100. * (current - base) / base : 0.;
+            const bool   regressed = change > threshold && current - base > options.min_delta;
+            std::cout << std::left << std::setw(18) << case_name << std::setw(30) << metric << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << base << std::setw(12) << current << std::setw(9) << std::showpos << change << "%" << std::noshowpos
+                      << (regressed ? "  REGRESSION" : "") << "\n";
+            if (regressed)
+                ++ regressions;
+        }
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++ i) {
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc)
+                throw Slic3r::InvalidArgument(std::string("Missing value of ") + argv[i]);
+            return argv[++ i];
+        };
+        try {
+            if (strcmp(argv[i], "--output") == 0)
+                options.output = next();
+            else if (strcmp(argv[i], "--baseline") == 0)
+                options.baseline = next();
+            else if (strcmp(argv[i], "--case") == 0)
+                options.case_filter = next();
+            else if (strcmp(argv[i], "--repeat") == 0)
+                options.repeat = std::max(1, std::stoi(next()));
+            else if (strcmp(argv[i], "--threshold") == 0)
+                options.threshold = std::stod(next());
+            else if (strcmp(argv[i], "--min-delta") == 0)
+                options.min_delta = std::stod(next());
+            else if (strcmp(argv[i], "--list") == 0) {
+                for (const BenchmarkCase &c : benchmark_cases())
+                    std::cout << c.name << "\n";
+                return 0;
+            } else {
+                print_usage();
+                return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+            }
+        } catch (const std::exception &ex) {
+            std::cerr << ex.what() << "\n";
+            return 2;
+        }
+    }
+
+    boost::log::core::get()->set_filter(boost::log::trivial::severity >= boost::log::trivial::warning);
+
+    nlohmann::json results;
+    results["format"]  = RESULTS_FORMAT;
+    results["repeat"]  = options.repeat;
+    results["threads"] = std::thread::hardware_concurrency();
+    results["cases"]   = nlohmann::json::object();
+    const std::string gcode_path = boost::filesystem::unique_path("slicer_benchmark-%%%%-%%%%.gcode").string();
+    try {
+        for (const BenchmarkCase &benchmark_case : benchmark_cases()) {
+            if (! options.case_filter.empty() && options.case_filter != benchmark_case.name)
+                continue;
+            DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+            for (const ConfigBase::SetDeserializeItem &item : benchmark_case.config)
+                config.set_deserialize_strict(item.opt_key, item.opt_value);
+            Model model;
+            benchmark_case.make_model(model);
+            arrange_objects(model, InfiniteBed{}, ArrangeParams{ scaled(min_object_distance(config)) });
+            Print print;
+            for (ModelObject *object : model.objects) {
+                object->ensure_on_bed();
+                print.auto_assign_extruders(object);
+            }
+
+            std::vector<Metrics> runs;
+            for (int i = 0; i < options.repeat; ++ i)
+                runs.emplace_back(run_once(model, config, gcode_path));
+            Metrics metrics = median(runs);
+            std::cout << benchmark_case.name << ": " << std::fixed << std::setprecision(1) << metrics["total"] << " ms\n";
+            nlohmann::json &json_case = results["cases"][benchmark_case.name];
+            for (const auto &[name, value] : metrics)
+                json_case[name] = std::round(value * 10.) / 10.;
+        }
+    } catch (const std::exception &ex) {
+        boost::filesystem::remove(gcode_path);
+        std::cerr << "Benchmark failed: " << ex.what() << "\n";
+        return 2;
+    }
+    boost::filesystem::remove(gcode_path);
+
+    if (! options.output.empty()) {
+        boost::nowide::ofstream ofs(options.output);
+        ofs << std::setw(4) << results << "\n";
+        if (! ofs) {
+            std::cerr << "Failed to write " << options.output << "\n";
+            return 2;
+        }
+    }
+
+    if (! options.baseline.empty()) {
+        nlohmann::json baseline;
+        try {
+            boost::nowide::ifstream ifs(options.baseline);
+            baseline = nlohmann::json::parse(ifs);
+        } catch (const std::exception &ex) {
+            std::cerr << "Failed to read the baseline " << options.baseline << ": " << ex.what() << "\n";
+            return 2;
+        }
+        if (baseline.value("format", 0) != RESULTS_FORMAT || ! baseline.contains("cases")) {
+            std::cerr << "Unsupported baseline " << options.baseline << "\n";
+            return 2;
+        }
+        if (int regressions = compare(results, baseline, options); regressions > 0) {
+            std::cout << regressions << " regression(s) detected\n";
+            return 1;
+        }
+    }
+    return 0;
+}
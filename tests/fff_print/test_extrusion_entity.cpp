@@ -7,6 +7,9 @@
 #include "libslic3r/Point.hpp"
 #include "libslic3r/libslic3r.h"
 
+#include <oneapi/tbb/parallel_for.h>
+#include <oneapi/tbb/scalable_allocator.h>
+
 #include "test_data.hpp"
 
 using namespace Slic3r;
@@ -83,3 +86,71 @@ SCENARIO("ExtrusionEntityCollection: Polygon flattening", "[ExtrusionEntity]") {
         }
     }
 }
+
+SCENARIO("ExtrusionEntityCollection: entities allocated and released by different threads", "[ExtrusionEntity]") {
+    GIVEN("Collections filled concurrently by worker threads") {
+        std::vector<ExtrusionEntityCollection> collections(64);
+        tbb::parallel_for(size_t(0), collections.size(), [&collections](size_t i) {
+            ExtrusionEntityCollection loops;
+            for (size_t j = 0; j < 50; ++ j)
+                loops.append(ExtrusionLoop(random_paths(3, 5)));
+            collections[i].append(random_paths(20, 5));
+            collections[i].append(std::move(loops));
+        }, tbb::simple_partitioner());
+        for (const ExtrusionEntityCollection &c : collections) {
+            REQUIRE(c.entities.size() == 21);
+            REQUIRE(c.items_count() == 20 + 50);
+        }
+        WHEN("The collections are released by other threads") {
+            tbb::parallel_for(size_t(0), collections.size(), [&collections](size_t i) {
+                collections[collections.size() - 1 - i].clear();
+            });
+            THEN("All the collections are empty") {
+                for (const ExtrusionEntityCollection &c : collections)
+                    CHECK(c.empty());
+            }
+        }
+    }
+}
+
+SCENARIO("ExtrusionEntity: entities are allocated from the TBB pool", "[ExtrusionEntity]") {
+    GIVEN("The extrusion entity types") {
+        THEN("All of them are allocated and released by the pooled operators of ExtrusionEntity") {
+            REQUIRE((&ExtrusionPath::operator new == &ExtrusionEntity::operator new));
+            REQUIRE((&ExtrusionPathOriented::operator new == &ExtrusionEntity::operator new));
+            REQUIRE((&ExtrusionMultiPath::operator new == &ExtrusionEntity::operator new));
+            REQUIRE((&ExtrusionLoop::operator new == &ExtrusionEntity::operator new));
+            REQUIRE((&ExtrusionEntityCollection::operator new == &ExtrusionEntity::operator new));
+            REQUIRE((&ExtrusionPath::operator delete == &ExtrusionEntity::operator delete));
+            REQUIRE((&ExtrusionEntityCollection::operator delete == &ExtrusionEntity::operator delete));
+        }
+    }
+    GIVEN("Entities of all types allocated by worker threads") {
+        std::vector<ExtrusionEntity*> entities(4000, nullptr);
+        tbb::parallel_for(size_t(0), entities.size(), [&entities](size_t i) {
+            switch (i % 4) {
+            case 0:  entities[i] = new ExtrusionPath(random_path(5)); break;
+            case 1:  entities[i] = new ExtrusionMultiPath(random_paths(3, 5)); break;
+            case 2:  entities[i] = new ExtrusionLoop(random_paths(3, 5)); break;
+            default: entities[i] = new ExtrusionEntityCollection(random_paths(3, 5)); break;
+            }
+        }, tbb::simple_partitioner());
+        THEN("They are blocks of the pool") {
+            for (size_t i = 0; i < entities.size(); ++ i) {
+                REQUIRE(entities[i] != nullptr);
+                REQUIRE(scalable_msize(entities[i]) >= sizeof(ExtrusionPath));
+            }
+        }
+        WHEN("They are released by other threads") {
+            tbb::parallel_for(size_t(0), entities.size(), [&entities](size_t i) {
+                delete entities[entities.size() - 1 - i];
+                entities[entities.size() - 1 - i] = nullptr;
+            });
+            THEN("All of them are released") {
+                REQUIRE(size_t(std::count(entities.begin(), entities.end(), nullptr)) == entities.size());
+            }
+        }
+        for (ExtrusionEntity *entity : entities)
+            delete entity;
+    }
+}
@@ -1,8 +1,20 @@
 #include <catch2/catch.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+
+#include "libslic3r/ExtrusionEntity.hpp"
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCode/BinaryGCode.hpp"
+#include "libslic3r/GCode/GCodeIndex.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+#include "libslic3r/GCode/MovesSpill.hpp"
+#include "libslic3r/GCode/Thumbnails.hpp"
 
 using namespace Slic3r;
 
@@ -20,3 +32,507 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+// Synthetic G-code with the time estimate placeholders around num_moves extrusion moves zig-zagging over the bed.
+static std::string synthetic_gcode(size_t num_moves)
+{
+    std::string gcode;
+    gcode.reserve(num_moves * 32 + 256);
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::First_Line_M73_Placeholder) + "\n";
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Estimated_Printing_Time_Placeholder) + "\n";
+    gcode += "G28\nG90\nM83\nG1 Z0.2 F600\n";
+    char buf[64];
+    for (size_t i = 0; i < num_moves; ++ i) {
+        sprintf(buf, "G1 X%d Y%d E0.05 F%d\n", int(i % 2 == 0 ? 20 : 200), int(20 + (i / 2) % 180), 1200 + int(i % 7) * 600);
+        gcode += buf;
+    }
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Last_Line_M73_Placeholder) + "\n";
+    return gcode;
+}
+
+// Synthetic G-code of num_layers layers of moves_per_layer external perimeter moves with a fan speed changing per layer.
+static std::string layered_gcode(size_t num_layers, size_t moves_per_layer)
+{
+    std::string gcode;
+    gcode.reserve(num_layers * (moves_per_layer * 32 + 64) + 256);
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::First_Line_M73_Placeholder) + "\n";
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Estimated_Printing_Time_Placeholder) + "\n";
+    gcode += "G28\nG90\nM83\n";
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Role) + ExtrusionEntity::role_to_string(erExternalPerimeter) + "\n";
+    char buf[64];
+    for (size_t layer = 0; layer < num_layers; ++ layer) {
+        gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Layer_Change) + "\n";
+        sprintf(buf, "G1 Z%.2f F600\nM106 S%d\n", 0.2 * double(layer + 1), int(layer * 37 % 256));
+        gcode += buf;
+        for (size_t i = 0; i < moves_per_layer; ++ i) {
+            sprintf(buf, "G1 X%d Y%d E0.05 F%d\n", int(i % 2 == 0 ? 20 : 200), int(20 + (i / 2) % 180), 1200 + int((i + layer) % 7) * 600);
+            gcode += buf;
+        }
+    }
+    gcode += ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Last_Line_M73_Placeholder) + "\n";
+    return gcode;
+}
+
+static std::string read_file(const std::string &path)
+{
+    std::string data;
+    FILE *f = boost::nowide::fopen(path.c_str(), "rb");
+    REQUIRE(f != nullptr);
+    char buf[65536];
+    for (size_t len; (len = fread(buf, 1, sizeof(buf), f)) > 0;)
+        data.append(buf, len);
+    fclose(f);
+    return data;
+}
+
+static void write_file(const std::string &path, const std::string &data)
+{
+    FILE *f = boost::nowide::fopen(path.c_str(), "wb");
+    REQUIRE(f != nullptr);
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+// Process the G-code written into path, post process it in place or into out_path if not empty.
+static void process_gcode(const std::string &path, const std::string &gcode, const std::string &out_path, GCodeProcessorResult &result, bool binary = false)
+{
+    write_file(path, gcode);
+    GCodeProcessor processor;
+    processor.enable_binary_gcode(binary);
+    if (binary)
+        processor.binary_data().file_metadata.emplace_back("Producer", "test");
+    processor.initialize(path);
+    processor.process_buffer(gcode);
+    processor.finalize(true, out_path);
+    result = processor.extract_result();
+}
+
+SCENARIO("Time estimates are streamed into the output file", "[GCode]") {
+    GIVEN("G-code with the time estimate placeholders") {
+        const std::string       gcode    = synthetic_gcode(20000);
+        boost::filesystem::path tmp      = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string             in_place = tmp.string() + ".in_place.gcode";
+        std::string             spool    = tmp.string() + ".spool";
+        std::string             streamed = tmp.string() + ".streamed.gcode";
+        WHEN("The G-code is post processed in place and streamed into another file") {
+            GCodeProcessorResult result_in_place;
+            GCodeProcessorResult result_streamed;
+            process_gcode(in_place, gcode, std::string(), result_in_place);
+            process_gcode(spool, gcode, streamed, result_streamed);
+            THEN("Both outputs and their line ends and move line ids are the same.") {
+                std::string data = read_file(in_place);
+                REQUIRE(data.size() > gcode.size());
+                REQUIRE(data.find("M73 P0 R") != std::string::npos);
+                REQUIRE(data == read_file(streamed));
+                REQUIRE(result_in_place.lines_ends == result_streamed.lines_ends);
+                REQUIRE(result_in_place.moves.size() == result_streamed.moves.size());
+                for (size_t i = 0; i < result_in_place.moves.size(); ++ i)
+                    REQUIRE(result_in_place.moves[i].gcode_id == result_streamed.moves[i].gcode_id);
+            }
+            THEN("The streamed source is left untouched.") {
+                REQUIRE(read_file(spool) == gcode);
+            }
+        }
+        boost::nowide::remove(in_place.c_str());
+        boost::nowide::remove(spool.c_str());
+        boost::nowide::remove(streamed.c_str());
+    }
+}
+
+SCENARIO("Moves are spilled by the bounded memory export", "[GCode]") {
+    GIVEN("G-code with the time estimate placeholders") {
+        const std::string       gcode    = synthetic_gcode(5000);
+        boost::filesystem::path tmp      = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string             full     = tmp.string() + ".full.gcode";
+        std::string             windowed = tmp.string() + ".windowed.gcode";
+        WHEN("The G-code is processed with and without a window of moves spilled to a file") {
+            GCodeProcessorResult result_full;
+            process_gcode(full, gcode, std::string(), result_full);
+            write_file(windowed, gcode);
+            GCodeProcessor processor;
+            processor.initialize(windowed);
+            processor.set_moves_window(64, true);
+            processor.process_buffer(gcode);
+            processor.finalize(true);
+            GCodeProcessorResult result_windowed;
+            result_windowed = processor.extract_result();
+            THEN("The moves are kept in the spill only and the output is the same.") {
+                REQUIRE(read_file(full) == read_file(windowed));
+                REQUIRE(result_windowed.moves.empty());
+                REQUIRE(result_windowed.lines_ends.empty());
+                REQUIRE(result_windowed.moves_spill);
+                REQUIRE(result_windowed.moves_spill->size() == result_full.moves.size());
+            }
+            THEN("The spilled moves are finalized the same way as the moves kept in memory.") {
+                result_windowed.load_spilled_moves();
+                REQUIRE(result_windowed.moves.size() == result_full.moves.size());
+                for (size_t i = 0; i < result_full.moves.size(); ++ i) {
+                    REQUIRE(result_windowed.moves[i].gcode_id == result_full.moves[i].gcode_id);
+                    REQUIRE(result_windowed.moves[i].position == result_full.moves[i].position);
+                    REQUIRE(result_windowed.moves[i].time == result_full.moves[i].time);
+                    REQUIRE(result_windowed.moves[i].layer_duration == result_full.moves[i].layer_duration);
+                }
+            }
+        }
+        boost::nowide::remove(full.c_str());
+        boost::nowide::remove(windowed.c_str());
+    }
+}
+
+SCENARIO("G-code index", "[GCode]") {
+    GIVEN("A layered G-code post processed with its index") {
+        const size_t            num_layers = 20;
+        const std::string       gcode      = layered_gcode(num_layers, 500);
+        boost::filesystem::path tmp        = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string             path       = tmp.string() + ".gcode";
+        std::string             index_path = GCodeIndex::path_for(path);
+        write_file(path, gcode);
+        GCodeProcessor processor;
+        processor.enable_gcode_index(true);
+        processor.initialize(path);
+        processor.process_buffer(gcode);
+        processor.finalize(true);
+        GCodeProcessorResult result;
+        result = processor.extract_result();
+        REQUIRE(result.gcode_index);
+        result.gcode_index->save(index_path, path);
+        std::unique_ptr<GCodeIndex> index = GCodeIndex::load(index_path, path);
+        REQUIRE(index);
+        const std::string data = read_file(path);
+        std::vector<std::string> lines;
+        for (size_t begin = 0; begin < data.size();) {
+            size_t end = std::min(data.find('\n', begin), data.size() - 1) + 1;
+            lines.emplace_back(data.substr(begin, end - begin));
+            begin = end;
+        }
+        // The count lines starting at line (1 based) concatenated.
+        auto lines_at = [&lines](size_t line, size_t count) {
+            std::string out;
+            for (size_t i = line - 1; i < std::min(line - 1 + count, lines.size()); ++ i)
+                out += lines[i];
+            return out;
+        };
+        WHEN("Windows of lines are read through the index") {
+            THEN("They are the lines of the G-code.") {
+                REQUIRE(index->lines_count() == lines.size());
+                for (size_t line : { size_t(1), GCodeIndex::LinesStride, GCodeIndex::LinesStride + 1, lines.size() / 2, lines.size() - 3 })
+                    REQUIRE(index->read_lines(path, line, 7) == lines_at(line, 7));
+                std::string chunks;
+                index->read_lines(path, 300, lines.size() + 1, [&chunks](const std::string &chunk) { chunks += chunk; });
+                REQUIRE(chunks == lines_at(300, lines.size()));
+            }
+        }
+        WHEN("The lines of the moves and the layers are looked up in the index") {
+            THEN("They match the processed G-code.") {
+                REQUIRE(index->moves_count() == result.moves.size());
+                for (size_t i = 0; i < result.moves.size(); ++ i)
+                    REQUIRE(index->move_line(i) == result.moves[i].gcode_id);
+                REQUIRE(index->layers().size() == num_layers + 1);
+                for (size_t layer = 1; layer <= num_layers; ++ layer) {
+                    REQUIRE(lines_at(index->layers()[layer].first_line - 1, 1) == ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Layer_Change) + "\n");
+                    REQUIRE(index->line_layer(index->layers()[layer].first_line) == layer);
+                }
+            }
+        }
+        auto require_moves = [&result](const GCodeProcessorResult &partial, size_t first_move, size_t count) {
+            REQUIRE(partial.moves.size() == count);
+            for (size_t i = 0; i < count; ++ i) {
+                const GCodeProcessorResult::MoveVertex &move     = partial.moves[i];
+                const GCodeProcessorResult::MoveVertex &expected = result.moves[first_move + i];
+                REQUIRE(move.gcode_id == expected.gcode_id);
+                REQUIRE(move.type == expected.type);
+                REQUIRE(move.extrusion_role == expected.extrusion_role);
+                REQUIRE(move.position == expected.position);
+                REQUIRE(move.delta_extruder == expected.delta_extruder);
+                REQUIRE(move.feedrate == expected.feedrate);
+                REQUIRE(move.width == expected.width);
+                REQUIRE(move.height == expected.height);
+                REQUIRE(move.fan_speed == expected.fan_speed);
+                REQUIRE(move.time == expected.time);
+                REQUIRE(move.layer_duration == expected.layer_duration);
+            }
+        };
+        WHEN("A range of layers is loaded through the index") {
+            GCodeProcessor partial_processor;
+            const size_t first_move = partial_processor.process_layers(path, *index, 5, 7);
+            GCodeProcessorResult partial;
+            partial = partial_processor.extract_result();
+            THEN("The moves are the moves of the layers in the fully processed G-code.") {
+                REQUIRE(first_move == index->layers()[5].first_move);
+                require_moves(partial, first_move, index->layers()[8].first_move - first_move);
+            }
+        }
+        WHEN("A window of lines in the middle of a layer is loaded through the index") {
+            const size_t first_line = index->layers()[10].first_line + 100;
+            const size_t last_line  = index->layers()[11].first_line + 50;
+            GCodeProcessor partial_processor;
+            const size_t first_move = partial_processor.process_lines(path, *index, first_line, last_line);
+            GCodeProcessorResult partial;
+            partial = partial_processor.extract_result();
+            THEN("The moves are the moves of the lines in the fully processed G-code.") {
+                auto begin = std::find_if(result.moves.begin(), result.moves.end(), [first_line](const auto &move) { return move.gcode_id >= first_line; });
+                auto end   = std::find_if(begin, result.moves.end(), [last_line](const auto &move) { return move.gcode_id > last_line; });
+                REQUIRE(first_move == size_t(begin - result.moves.begin()));
+                require_moves(partial, first_move, size_t(end - begin));
+            }
+        }
+        WHEN("The G-code is modified after its index was written") {
+            write_file(path, data + "M117 Modified\n");
+            THEN("The index is not loaded.") {
+                REQUIRE(! GCodeIndex::load(index_path, path));
+            }
+        }
+        WHEN("A byte of the index past its header is damaged") {
+            std::string index_data = read_file(index_path);
+            index_data[index_data.size() / 2] ^= 0x10;
+            write_file(index_path, index_data);
+            THEN("The index is not loaded.") {
+                REQUIRE(! GCodeIndex::load(index_path, path));
+            }
+        }
+        WHEN("The index is truncated") {
+            std::string index_data = read_file(index_path);
+            write_file(index_path, index_data.substr(0, index_data.size() - 1));
+            THEN("The index is not loaded.") {
+                REQUIRE(! GCodeIndex::load(index_path, path));
+            }
+        }
+        boost::nowide::remove(path.c_str());
+        boost::nowide::remove(index_path.c_str());
+    }
+}
+
+SCENARIO("Binary G-code", "[GCode]") {
+    GIVEN("G-code with comments and characters outside of the nibble table") {
+        const std::string gcode = synthetic_gcode(20000) + "; comment with Unicode \xc3\xa9 and tabs\t\r\nM117 Done\n";
+        WHEN("The G-code is nibble packed and unpacked") {
+            std::string encoded = BinaryGCode::pack_nibbles(gcode);
+            THEN("The encoding is lossless and smaller.") {
+                REQUIRE(encoded.size() < gcode.size());
+                REQUIRE(BinaryGCode::unpack_nibbles(encoded, gcode.size()) == gcode);
+            }
+        }
+        boost::filesystem::path tmp    = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string             text   = tmp.string() + ".gcode";
+        std::string             spool  = tmp.string() + ".spool";
+        std::string             binary = tmp.string() + ".bin";
+        WHEN("The G-code is post processed into a text and into a binary G-code") {
+            GCodeProcessorResult result_text;
+            GCodeProcessorResult result_binary;
+            process_gcode(text, gcode, std::string(), result_text);
+            process_gcode(spool, gcode, binary, result_binary, true);
+            THEN("The binary G-code is smaller and decodes to the text G-code.") {
+                std::string data = read_file(text);
+                REQUIRE(! BinaryGCode::is_binary_gcode(text));
+                REQUIRE(BinaryGCode::is_binary_gcode(binary));
+                REQUIRE(boost::filesystem::file_size(binary) * 2 < data.size());
+                BinaryGCode::Reader reader(binary);
+                REQUIRE(reader.data().file_metadata.size() == 1);
+                REQUIRE(! reader.data().print_metadata.empty());
+                REQUIRE(reader.read_gcode() == data);
+            }
+            THEN("The line ends and move line ids are the same.") {
+                REQUIRE(result_text.lines_ends == result_binary.lines_ends);
+                REQUIRE(result_text.moves.size() == result_binary.moves.size());
+                for (size_t i = 0; i < result_text.moves.size(); ++ i)
+                    REQUIRE(result_text.moves[i].gcode_id == result_binary.moves[i].gcode_id);
+            }
+            THEN("Loading the binary G-code produces the same moves as loading the text G-code.") {
+                GCodeProcessor processor_text;
+                processor_text.process_file(text);
+                GCodeProcessor processor_binary;
+                processor_binary.process_file(binary);
+                REQUIRE(processor_binary.get_result().moves.size() == processor_text.get_result().moves.size());
+                REQUIRE(processor_binary.get_result().lines_ends == processor_text.get_result().lines_ends);
+            }
+        }
+        boost::nowide::remove(text.c_str());
+        boost::nowide::remove(spool.c_str());
+        boost::nowide::remove(binary.c_str());
+    }
+    GIVEN("A bgcode of libbgcode") {
+        // File header and a file metadata block laid out as specified by libbgcode: magic "GCDE", version 1, CRC32 checksums,
+        // block header of an uncompressed block, uint16 INI encoding, the metadata and CRC32 of the block.
+        auto append_le = [](std::string &out, uint32_t value, size_t size) {
+            for (size_t i = 0; i < size; ++ i)
+                out.push_back(char((value >> (8 * i)) & 0xFF));
+        };
+        const std::string metadata = "Producer=PrusaSlicer 2.7.0\n";
+        std::string       block;
+        append_le(block, 0, 2);
+        append_le(block, 0, 2);
+        append_le(block, uint32_t(metadata.size()), 4);
+        append_le(block, 0, 2);
+        block += metadata;
+        boost::crc_32_type crc;
+        crc.process_bytes(block.data(), block.size());
+        append_le(block, crc.checksum(), 4);
+        std::string bgcode = "GCDE";
+        append_le(bgcode, 1, 4);
+        append_le(bgcode, 1, 2);
+        bgcode += block;
+
+        std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string() + ".bgcode";
+        {
+            FILE *f = boost::nowide::fopen(path.c_str(), "wb");
+            REQUIRE(f != nullptr);
+            REQUIRE(::fwrite(bgcode.data(), 1, bgcode.size(), f) == bgcode.size());
+            ::fclose(f);
+        }
+        THEN("It is not taken for a binary G-code of our own.") {
+            REQUIRE(BinaryGCode::is_bgcode(path));
+            REQUIRE(! BinaryGCode::is_binary_gcode(path));
+            REQUIRE_THROWS_AS(BinaryGCode::Reader(path), Slic3r::RuntimeError);
+        }
+        THEN("Loading it reports the unsupported format instead of parsing it as a text G-code.") {
+            GCodeProcessor processor;
+            REQUIRE_THROWS_AS(processor.process_file(path), Slic3r::RuntimeError);
+        }
+        boost::nowide::remove(path.c_str());
+    }
+}
+
+// Thumbnails with a gradient, so that they compress to something non-trivial.
+static ThumbnailsList synthetic_thumbnails(const ThumbnailsParams &params)
+{
+    ThumbnailsList thumbnails;
+    for (const Vec2d &size : params.sizes) {
+        ThumbnailData &data = thumbnails.emplace_back();
+        data.set((unsigned int)size.x(), (unsigned int)size.y());
+        for (size_t i = 0; i < data.pixels.size(); ++ i)
+            data.pixels[i] = (unsigned char)((i % 4 == 3) ? 255 : (i / 4 + i % 4 * 85) % 256);
+    }
+    return thumbnails;
+}
+
+SCENARIO("Thumbnails are compressed in the background", "[GCode]") {
+    GIVEN("Thumbnails of multiple sizes") {
+        ThumbnailsGeneratorCallback thumbnail_cb = synthetic_thumbnails;
+        const std::vector<Vec2d>    sizes        = { Vec2d(48, 48), Vec2d(300, 300), Vec2d(64, 32) };
+        for (GCodeThumbnailsFormat format : { GCodeThumbnailsFormat::PNG, GCodeThumbnailsFormat::JPG, GCodeThumbnailsFormat::QOI, GCodeThumbnailsFormat::BTT_TFT }) {
+            WHEN("The thumbnails are compressed in the background") {
+                std::string exported;
+                GCodeThumbnails::export_thumbnails_to_file(thumbnail_cb, 0, sizes, format, [&exported](const char *sz) { exported += sz; }, []() {});
+                GCodeThumbnails::ThumbnailsCompressor compressor;
+                compressor.start(thumbnail_cb, 0, sizes, format);
+                THEN("The G-code is the same as of the thumbnails exported directly.") {
+                    REQUIRE(! compressor.empty());
+                    REQUIRE(compressor.gcode() == exported);
+                    REQUIRE(std::count(exported.begin(), exported.end(), '\n') > 3);
+                }
+            }
+        }
+        WHEN("The same thumbnail is compressed twice") {
+            ThumbnailsList thumbnails = synthetic_thumbnails(ThumbnailsParams{ sizes, true, true, true, true, 0 });
+            auto first  = GCodeThumbnails::compress_thumbnail_cached(thumbnails[1], GCodeThumbnailsFormat::PNG);
+            auto second = GCodeThumbnails::compress_thumbnail_cached(thumbnails[1], GCodeThumbnailsFormat::PNG);
+            THEN("The compressed image is reused.") {
+                REQUIRE(first->size > 0);
+                REQUIRE(first == second);
+                REQUIRE(GCodeThumbnails::compress_thumbnail_cached(thumbnails[1], GCodeThumbnailsFormat::QOI) != first);
+            }
+        }
+    }
+    GIVEN("G-code with the thumbnails placeholder") {
+        const std::string       gcode     = ";" + GCodeProcessor::reserved_tag(GCodeProcessor::ETags::Thumbnails_Placeholder) + "\n" + synthetic_gcode(1000);
+        const std::string       thumbnail = "; THUMBNAIL_BLOCK_START\n; thumbnail\n; THUMBNAIL_BLOCK_END\n\n";
+        boost::filesystem::path tmp       = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        std::string             with      = tmp.string() + ".with.gcode";
+        std::string             without   = tmp.string() + ".without.gcode";
+        WHEN("The G-code is post processed with and without the thumbnails") {
+            auto process = [&gcode](const std::string &path, const std::string &thumbnails) {
+                write_file(path, gcode);
+                GCodeProcessor processor;
+                processor.initialize(path);
+                processor.process_buffer(gcode);
+                processor.set_thumbnails_gcode(thumbnails);
+                processor.finalize(true);
+                return processor.extract_result().moves;
+            };
+            auto moves_with    = process(with, thumbnail);
+            auto moves_without = process(without, std::string());
+            THEN("The placeholder is replaced and the move line ids account for the thumbnail lines.") {
+                REQUIRE(read_file(with).find(thumbnail) == 0);
+                REQUIRE(read_file(without).find("THUMBNAIL") == std::string::npos);
+                REQUIRE(moves_with.size() == moves_without.size());
+                for (size_t i = 1; i < moves_with.size(); ++ i)
+                    REQUIRE(moves_with[i].gcode_id == moves_without[i].gcode_id + 4);
+            }
+        }
+        boost::nowide::remove(with.c_str());
+        boost::nowide::remove(without.c_str());
+    }
+}
+
+// Run explicitly with "[Benchmark]" to compare the time to file of the in place post processing and of the streamed one.
+// Set the output directory by the ORCA_GCODE_BENCHMARK_DIR environment variable to measure on a network storage.
+TEST_CASE("Time to file of post processed G-code", "[.][Benchmark]") {
+    const std::string       gcode   = synthetic_gcode(15000000);
+    const char             *out_dir = getenv("ORCA_GCODE_BENCHMARK_DIR");
+    boost::filesystem::path tmp     = (out_dir ? boost::filesystem::path(out_dir) : boost::filesystem::temp_directory_path()) / boost::filesystem::unique_path();
+    std::string             output  = tmp.string() + ".gcode";
+    std::string             spool   = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string() + ".spool";
+
+    GCodeProcessorResult result;
+    auto start_in_place = std::chrono::steady_clock::now();
+    process_gcode(output, gcode, std::string(), result);
+    auto start_streamed = std::chrono::steady_clock::now();
+    process_gcode(spool, gcode, output, result);
+    auto end            = std::chrono::steady_clock::now();
+
+    auto ms = [](auto t1, auto t2) { return std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count(); };
+    WARN(gcode.size() / (1024 * 1024) << " MB of G-code: in place " << ms(start_in_place, start_streamed) << " ms, streamed "
+         << ms(start_streamed, end) << " ms");
+    boost::nowide::remove(output.c_str());
+    boost::nowide::remove(spool.c_str());
+}
+
+TEST_CASE("Loading layers of a large G-code through its index", "[.][Benchmark]") {
+    // About 300 MB of G-code.
+    const size_t            num_layers = 1000;
+    const std::string       gcode      = layered_gcode(num_layers, 10000);
+    const char             *out_dir    = getenv("ORCA_GCODE_BENCHMARK_DIR");
+    boost::filesystem::path tmp        = (out_dir ? boost::filesystem::path(out_dir) : boost::filesystem::temp_directory_path()) / boost::filesystem::unique_path();
+    std::string             path       = tmp.string() + ".gcode";
+    std::string             index_path = GCodeIndex::path_for(path);
+    write_file(path, gcode);
+    {
+        GCodeProcessor processor;
+        processor.enable_gcode_index(true);
+        processor.initialize(path);
+        processor.process_buffer(gcode);
+        processor.finalize(true);
+        processor.result().gcode_index->save(index_path, path);
+    }
+
+    auto start_full = std::chrono::steady_clock::now();
+    size_t full_moves = 0;
+    {
+        GCodeProcessor processor;
+        processor.process_file(path);
+        full_moves = processor.result().moves.size();
+    }
+    auto start_index = std::chrono::steady_clock::now();
+    std::unique_ptr<GCodeIndex> index = GCodeIndex::load(index_path, path);
+    REQUIRE(index);
+    auto start_layers = std::chrono::steady_clock::now();
+    size_t layer_moves = 0;
+    {
+        GCodeProcessor processor;
+        processor.process_layers(path, *index, num_layers / 2, num_layers / 2 + 9);
+        layer_moves = processor.result().moves.size();
+    }
+    auto start_lines = std::chrono::steady_clock::now();
+    const std::string lines = index->read_lines(path, index->lines_count() / 2, 1000);
+    auto end = std::chrono::steady_clock::now();
+
+    REQUIRE(full_moves == index->moves_count());
+    REQUIRE(layer_moves == index->layers()[num_layers / 2 + 10].first_move - index->layers()[num_layers / 2].first_move);
+    REQUIRE(std::count(lines.begin(), lines.end(), '\n') == 1000);
+    auto ms = [](auto t1, auto t2) { return std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count(); };
+    WARN(gcode.size() / (1024 * 1024) << " MB of G-code: full parse " << ms(start_full, start_index) << " ms, index load "
+         << ms(start_index, start_layers) << " ms, 10 layers " << ms(start_layers, start_lines) << " ms, 1000 lines "
+         << ms(start_lines, end) << " ms");
+    boost::nowide::remove(path.c_str());
+    boost::nowide::remove(index_path.c_str());
+}
@@ -1,8 +1,17 @@
 #include <catch2/catch.hpp>
 
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <random>
 
 #include "libslic3r/GCodeWriter.hpp"
+#include "libslic3r/GCode/WipeTower.hpp"
 
 using namespace Slic3r;
 
@@ -94,3 +103,174 @@ SCENARIO("set_speed emits values with fixed-point output.", "[GCodeWriter]") {
         }
     }
 }
+
+TEST_CASE("GCodeFormatter::format_fixed matches printf", "[GCodeWriter]") {
+    auto check = [](double v, int digits) {
+        char expected[128];
+        char buf[72];
+        ::snprintf(expected, sizeof(expected), "%.*f", digits, v);
+        char *end = GCodeFormatter::format_fixed(buf, v, size_t(digits));
+        return std::string(buf, end) == std::string(expected);
+    };
+    SECTION("Special values") {
+        for (double v : { 0., -0., 1., -1., 0.5, 1.5, 2.5, -2.5, 0.125, 0.0625, 999999999., 1e12, -1e15 })
+            for (int digits = 0; digits <= 5; ++ digits)
+                REQUIRE(check(v, digits));
+    }
+    SECTION("Random single precision values") {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> dist(-1000.f, 1000.f);
+        for (size_t i = 0; i < 100000; ++ i) {
+            float v = dist(rng);
+            for (int digits = 0; digits <= 5; ++ digits)
+                REQUIRE(check(double(v), digits));
+        }
+    }
+    SECTION("append_fixed prefixes a space and the axis") {
+        std::string out = "G1";
+        GCodeFormatter::append_fixed(out, 'X', 12.3456, 3);
+        GCodeFormatter::append_fixed(out, 'E', -0.5, 5);
+        REQUIRE(out == "G1 X12.346 E-0.50000");
+    }
+}
+
+// The to_chars() based axis formatter GCodeFormatter::emit_axis() used before format_axis(), kept as the reference.
+static std::string reference_format_axis(double v, size_t digits)
+{
+    static constexpr const std::array<int, 10> pow_10{1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    char  buf[64];
+    char *base_ptr = buf;
+    auto  v_int    = int64_t(std::round(v * pow_10[digits]));
+    char *ptr      = std::to_chars(buf, buf + sizeof(buf) - 1, v_int).ptr;
+    size_t writen_digits = (ptr - base_ptr) - (v_int < 0 ? 1 : 0);
+    if (writen_digits < digits) {
+        size_t remaining_digits = digits - writen_digits;
+        for (char *from_ptr = ptr - 1, *to_ptr = from_ptr + remaining_digits; from_ptr >= ptr - writen_digits; --to_ptr, --from_ptr)
+            *to_ptr = *from_ptr;
+        memset(ptr - writen_digits, '0', remaining_digits);
+        ptr += remaining_digits;
+    }
+    for (char *to_ptr = ptr, *from_ptr = to_ptr - 1; from_ptr >= ptr - digits; --to_ptr, --from_ptr)
+        *to_ptr = *from_ptr;
+    *(ptr - digits) = '.';
+    for (size_t i = 0; i < digits; ++i) {
+        if (*ptr != '0')
+            break;
+        ptr--;
+    }
+    if (*ptr == '.')
+        ptr--;
+    if ((ptr + 1) == base_ptr || *ptr == '-')
+        *(++ptr) = '0';
+    ptr++;
+    return std::string(base_ptr, ptr);
+}
+
+TEST_CASE("GCodeFormatter::format_axis matches the reference formatter", "[GCodeWriter]") {
+    static constexpr const std::array<double, 10> pow_10 { 1., 10., 100., 1000., 10000., 100000., 1000000., 10000000., 100000000., 1000000000. };
+    // Number of values, for which the output differs from the reference or does not parse back to the quantized input.
+    auto mismatches = [](double v, size_t digits, std::string &first_mismatch) {
+        char  buf[32];
+        char *end = GCodeFormatter::format_axis(buf, v, digits);
+        std::string out(buf, end);
+        bool ok = out == reference_format_axis(v, digits) &&
+            std::round(std::strtod(out.c_str(), nullptr) * pow_10[digits]) == std::round(v * pow_10[digits]);
+        if (! ok && first_mismatch.empty())
+            first_mismatch = out + " (" + std::to_string(v) + ", " + std::to_string(digits) + " digits)";
+        return ok ? 0 : 1;
+    };
+    std::string first_mismatch;
+    size_t      failed = 0;
+    SECTION("Every XYZF value of +-2000mm") {
+        for (int64_t i = -2000000; i <= 2000000; ++ i)
+            failed += mismatches(double(i) * 0.001, GCodeFormatter::XYZF_EXPORT_DIGITS, first_mismatch);
+    }
+    SECTION("Every E value of +-20mm") {
+        for (int64_t i = -2000000; i <= 2000000; ++ i)
+            failed += mismatches(double(i) * 0.00001, GCodeFormatter::E_EXPORT_DIGITS, first_mismatch);
+    }
+    SECTION("Random values of all magnitudes and precisions") {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> mantissa(-1., 1.);
+        std::uniform_int_distribution<int>     exponent(-10, 9);
+        for (size_t i = 0; i < 1000000; ++ i) {
+            double v = mantissa(rng) * std::pow(10., exponent(rng));
+            for (size_t digits = 0; digits <= 9; ++ digits)
+                // Stay within the 53 bits of the mantissa, so that the output parses back exactly.
+                if (std::abs(v) * pow_10[digits] < 1e15)
+                    failed += mismatches(v, digits, first_mismatch);
+        }
+    }
+    SECTION("Special values") {
+        for (double v : { 0., -0., 0.0004, -0.0004, 0.0005, -0.0005, 0.5, -0.5, 1., -1., 10., -10.25, 123456.789, 1e9, -1e9 })
+            for (size_t digits = 0; digits <= 9; ++ digits)
+                failed += mismatches(v, digits, first_mismatch);
+    }
+    INFO("First mismatch: " << first_mismatch);
+    REQUIRE(failed == 0);
+}
+
+SCENARIO("GCodeWriter appends moves into a caller supplied buffer", "[GCodeWriter]") {
+    GIVEN("Two writers in the same state") {
+        GCodeWriter writer, writer_append;
+        for (GCodeWriter *w : { &writer, &writer_append }) {
+            w->set_extruders({ 0 });
+            w->set_extruder(0);
+        }
+        WHEN("The same moves are emitted as strings and into a buffer") {
+            std::string expected;
+            expected += writer.travel_to_xy(Vec2d(10., 20.5), "travel");
+            expected += writer.extrude_to_xy(Vec2d(12.25, 20.5), 0.0345, "extrude");
+            expected += writer.extrude_arc_to_xy(Vec2d(14., 22.), Vec2d(1., -1.), 0.05, true, "arc");
+            expected += writer.extrude_to_xy(Vec2d(0.5, -0.125), 0., "no extrusion");
+            std::string buffer;
+            buffer.reserve(1024);
+            writer_append.travel_to_xy(buffer, Vec2d(10., 20.5), "travel");
+            writer_append.extrude_to_xy(buffer, Vec2d(12.25, 20.5), 0.0345, "extrude");
+            writer_append.extrude_arc_to_xy(buffer, Vec2d(14., 22.), Vec2d(1., -1.), 0.05, true, "arc");
+            writer_append.extrude_to_xy(buffer, Vec2d(0.5, -0.125), 0., "no extrusion");
+            THEN("The G-code is identical") {
+                REQUIRE(buffer == expected);
+                REQUIRE(writer_append.get_position() == writer.get_position());
+            }
+        }
+    }
+}
+
+// Run explicitly with "[Benchmark]" to measure the wipe tower G-code emission.
+TEST_CASE("Wipe tower generation of 4 extruders and 1000 toolchanges", "[.][Benchmark]") {
+    PrintConfig config;
+    config.apply(DynamicPrintConfig::full_print_config(), true);
+    const size_t num_extruders = 4;
+    const size_t num_layers    = 250;
+    const float  layer_height  = 0.2f;
+
+    auto start = std::chrono::steady_clock::now();
+    WipeTower wipe_tower(config, 0, Vec3d::Zero(), float(config.prime_volume.value), 0, float(num_layers) * layer_height);
+    for (size_t i = 0; i < num_extruders; ++ i)
+        wipe_tower.set_extruder(i, config);
+    size_t current_extruder = 0;
+    for (size_t layer = 0; layer < num_layers; ++ layer) {
+        float print_z = float(layer + 1) * layer_height;
+        wipe_tower.plan_toolchange(print_z, layer_height, current_extruder, current_extruder);
+        for (size_t i = 0; i < num_extruders; ++ i) {
+            size_t new_extruder = (current_extruder + 1) % num_extruders;
+            wipe_tower.plan_toolchange(print_z, layer_height, current_extruder, new_extruder, float(config.prime_volume.value), 100.f);
+            current_extruder = new_extruder;
+        }
+    }
+    std::vector<std::vector<WipeTower::ToolChangeResult>> tool_changes;
+    wipe_tower.generate(tool_changes);
+    auto end = std::chrono::steady_clock::now();
+
+    size_t num_toolchanges = 0;
+    size_t gcode_size      = 0;
+    for (const std::vector<WipeTower::ToolChangeResult> &layer : tool_changes)
+        for (const WipeTower::ToolChangeResult &tcr : layer) {
+            ++ num_toolchanges;
+            gcode_size += tcr.gcode.size();
+        }
+    WARN("Wipe tower: " << num_toolchanges << " tool change results, " << gcode_size << " bytes of G-code in "
+         << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms");
+    REQUIRE(num_toolchanges >= num_layers * num_extruders);
+}
@@ -3,6 +3,14 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/GCode/ConflictChecker.hpp"
+#include "libslic3r/Trace.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
 
 #include "test_data.hpp"
 
@@ -30,6 +38,61 @@ SCENARIO("PrintObject: Perimeter generation", "[PrintObject]") {
     }
 }
 
+SCENARIO("PrintObject: Steps are traced", "[PrintObject]") {
+    GIVEN("20mm cube and default config") {
+        WHEN("The print is processed with tracing enabled")  {
+            Trace::clear();
+            Trace::set_enabled(true);
+            Slic3r::Print print;
+            Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, { { "fill_density", 0 } });
+            Trace::set_enabled(false);
+            const std::string json = Trace::chrome_trace_json();
+            Trace::clear();
+            THEN("The object steps and their parallel tasks are traced") {
+                REQUIRE(json.find("\"name\":\"posSlice\"") != std::string::npos);
+                REQUIRE(json.find("\"name\":\"posPerimeters\"") != std::string::npos);
+                REQUIRE(json.find("\"name\":\"posInfill\"") != std::string::npos);
+                REQUIRE(json.find("\"name\":\"make_perimeters\",\"cat\":\"task\"") != std::string::npos);
+                REQUIRE(json.find("\"name\":\"psSkirtBrim\"") != std::string::npos);
+            }
+        }
+    }
+}
+
+SCENARIO("PrintObject: Memory is accounted after each step", "[PrintObject]") {
+    GIVEN("20mm cube and adaptive cubic infill") {
+        WHEN("The print is processed with memory accounting enabled")  {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            print.set_memory_accounting(true);
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, { { "sparse_infill_pattern", "adaptivecubic" } });
+            print.process();
+            const ObjectMemoryStats &stats = print.objects().front()->memory_stats();
+            THEN("The steps are sampled and the caches are kept") {
+                REQUIRE(! stats.steps.empty());
+                REQUIRE(stats.peak[MemoryCategory::LayerRegions] > 0);
+                REQUIRE(stats.peak[MemoryCategory::ExtrusionEntities] > 0);
+                REQUIRE(stats.peak[MemoryCategory::Caches] > 0);
+                REQUIRE(stats.released_caches == 0);
+                REQUIRE(print.memory_peak() >= stats.peak.total());
+            }
+        }
+        WHEN("The print is processed with a memory budget of 1 byte")  {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            print.set_memory_accounting(false, 1);
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, { { "sparse_infill_pattern", "adaptivecubic" } });
+            print.process();
+            const PrintObject &object = *print.objects().front();
+            THEN("The octrees are released once the infill is generated") {
+                REQUIRE(object.memory_stats().released_caches > 0);
+                REQUIRE(object.memory_usage()[MemoryCategory::Caches] == 0);
+                REQUIRE(object.is_step_done(posInfill));
+            }
+        }
+    }
+}
+
 SCENARIO("Print: Skirt generation", "[Print]") {
     GIVEN("20mm cube and default config") {
         WHEN("Skirts is set to 2 loops")  {
@@ -126,3 +189,160 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+// Export the G-code of a processed print, the line with the time stamp is left out.
+static std::string export_gcode_without_timestamp(Print &print)
+{
+    std::string path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string() + ".gcode";
+    GCodeProcessorResult result;
+    print.export_gcode(path, &result, nullptr);
+    std::string gcode;
+    {
+        boost::nowide::ifstream ifs(path);
+        for (std::string line; std::getline(ifs, line);)
+            if (! boost::starts_with(line, "; generated by "))
+                gcode += line + "\n";
+    }
+    boost::nowide::remove(path.c_str());
+    return gcode;
+}
+
+SCENARIO("Print: Streaming G-code export", "[Print]") {
+    GIVEN("A cube with supports") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "enable_support", 1 } });
+        const std::string gcode = [&config]() {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+            print.process();
+            return export_gcode_without_timestamp(print);
+        }();
+        REQUIRE(! gcode.empty());
+
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, config);
+        print.set_streaming_gcode_export(true);
+        print.process();
+        WHEN("The G-code is exported with streaming") {
+            std::string streamed = export_gcode_without_timestamp(print);
+            THEN("The G-code is the same and the extrusions of the exported layers are released") {
+                REQUIRE(streamed == gcode);
+                for (const Layer *layer : print.objects().front()->layers())
+                    REQUIRE(! layer->has_extrusions());
+            }
+            THEN("Exporting the G-code or the slicing data again throws") {
+                GCodeProcessorResult result;
+                REQUIRE_THROWS_AS(print.export_gcode((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string() + ".gcode", &result, nullptr), Slic3r::RuntimeError);
+                REQUIRE_THROWS_AS(print.export_cached_data((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string(), false), Slic3r::RuntimeError);
+            }
+            THEN("The print applied and processed again exports the same G-code") {
+                print.set_streaming_gcode_export(false);
+                print.apply(model, config);
+                print.process();
+                for (const Layer *layer : print.objects().front()->layers())
+                    REQUIRE(layer->has_extrusions());
+                REQUIRE(export_gcode_without_timestamp(print) == gcode);
+            }
+        }
+    }
+}
+
+SCENARIO("Print: Identical objects share their layers", "[Print]") {
+    GIVEN("10 copies of a 20mm cube as separate objects") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        Model model;
+        ModelObject *object = model.add_object();
+        object->name = "cube.stl";
+        object->add_volume(mesh(TestMesh::cube_20x20x20));
+        object->add_instance();
+        for (int i = 1; i < 10; ++ i)
+            model.add_object(*object)->instances.front()->set_offset(Vec3d(30. * i, 0., 0.));
+        for (ModelObject *mo : model.objects)
+            mo->ensure_on_bed();
+
+        Print print;
+        print.apply(model, config);
+        print.set_status_silent();
+        print.process();
+
+        THEN("Only the first object is sliced, the others reference its layers") {
+            REQUIRE(print.objects().size() == 10);
+            const PrintObject &sliced = *print.objects().front();
+            REQUIRE(sliced.get_shared_object() == nullptr);
+            REQUIRE(! sliced.layers().empty());
+            for (size_t i = 1; i < print.objects().size(); ++ i) {
+                const PrintObject &copy = *print.objects()[i];
+                REQUIRE(copy.get_shared_object() == &sliced);
+                REQUIRE(copy.layer_count() == sliced.layer_count());
+                for (size_t layer_idx = 0; layer_idx < sliced.layer_count(); ++ layer_idx)
+                    REQUIRE(copy.get_layer(int(layer_idx)) == sliced.get_layer(int(layer_idx)));
+                REQUIRE(&copy.firstLayerObjGroups() == &sliced.firstLayerObjGroups());
+            }
+        }
+        WHEN("The sliced object is deleted") {
+            model.delete_object(size_t(0));
+            print.apply(model, config);
+            THEN("The remaining objects no longer reference its layers") {
+                for (const PrintObject *copy : print.objects()) {
+                    REQUIRE(copy->get_shared_object() == nullptr);
+                    REQUIRE(copy->layers().empty());
+                }
+            }
+        }
+    }
+}
+
+// The conflict check without the pruning: the lines of all the objects are checked layer by layer from the bottom.
+static ConflictResultOpt serial_conflict_check(const PrintObjectPtrs &objects)
+{
+    LinesBucketQueue queue;
+    for (PrintObject *object : objects) {
+        ObjectExtrusions extrusions = getAllLayersExtrusionPathsFromObject(object);
+        queue.emplace_back_bucket(std::move(extrusions.perimeters), object, object->instances().front().shift);
+        queue.emplace_back_bucket(std::move(extrusions.support), object, object->instances().front().shift);
+    }
+    while (queue.valid()) {
+        LineWithIDs lines    = queue.getCurLines();
+        float       bottom_z = queue.getCurrBottomZ();
+        if (ConflictComputeOpt conflict = ConflictChecker::find_inter_of_lines(lines))
+            return std::make_optional<ConflictResult>(std::string(), std::string(), bottom_z, conflict->_obj1, conflict->_obj2);
+    }
+    return {};
+}
+
+SCENARIO("Print: Conflicts between objects", "[Print]") {
+    GIVEN("A plate of six cubes") {
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "enable_support", 0 } });
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::cube_20x20x20, TestMesh::cube_20x20x20,
+                                   TestMesh::cube_20x20x20, TestMesh::cube_20x20x20, TestMesh::cube_20x20x20 }, print, model, config);
+        WHEN("The cubes are arranged apart") {
+            print.process();
+            THEN("No conflict is found, as by the serial check.") {
+                REQUIRE(! serial_conflict_check(print.objects_mutable()).has_value());
+                REQUIRE(! ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {}).has_value());
+            }
+        }
+        WHEN("A cube is moved to overlap another one") {
+            ModelInstance *moved = model.objects.back()->instances.front();
+            moved->set_offset(model.objects.front()->instances.front()->get_offset() + Vec3d(10., 5., 0.));
+            print.apply(model, config);
+            print.process();
+            THEN("The same conflict is found as by the serial check.") {
+                ConflictResultOpt serial = serial_conflict_check(print.objects_mutable());
+                ConflictResultOpt pruned = ConflictChecker::find_inter_of_lines_in_diff_objs(print.objects_mutable(), {});
+                REQUIRE(serial.has_value());
+                REQUIRE(pruned.has_value());
+                REQUIRE(pruned->_height == Approx(serial->_height));
+                REQUIRE(std::minmax(pruned->_obj1, pruned->_obj2) == std::minmax(serial->_obj1, serial->_obj2));
+                const void *first = print.objects().front();
+                const void *last  = print.objects().back();
+                REQUIRE(std::minmax(pruned->_obj1, pruned->_obj2) == std::minmax(first, last));
+            }
+        }
+    }
+}
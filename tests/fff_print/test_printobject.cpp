@@ -1,5 +1,7 @@
 #include <catch2/catch.hpp>
 
+#include <chrono>
+
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
@@ -87,3 +89,19 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+// Run explicitly with "[Benchmark]" to compare the wall generators on a large flat part.
+TEST_CASE("Arachne and classic walls of a large flat part", "[.][Benchmark]") {
+    for (const char *wall_generator : { "classic", "arachne" }) {
+        Slic3r::Print print;
+        auto start = std::chrono::steady_clock::now();
+        Slic3r::Test::init_and_process_print({ Slic3r::Test::mesh(TestMesh::gt2_teeth, Vec3d::Zero(), Vec3d(8., 8., 0.5)) }, print, {
+            { "wall_generator",        wall_generator },
+            { "wall_loops",            4 },
+            { "sparse_infill_density", "0%" }
+        });
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        WARN(wall_generator << " walls of " << print.objects().front()->layers().size() << " layers: " << duration << " ms");
+        REQUIRE(! print.objects().front()->layers().empty());
+    }
+}
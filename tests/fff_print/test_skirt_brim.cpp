@@ -3,6 +3,8 @@
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Geometry.hpp"
+#include "libslic3r/Brim.hpp"
+#include "libslic3r/ClipperUtils.hpp"
 
 #include <boost/algorithm/string.hpp>
 
@@ -265,3 +267,162 @@ SCENARIO("Original Slic3r Skirt/Brim tests", "[SkirtBrim]") {
         }
     }
 }
+
+// Reference brim areas of the objects, computed one object after the other the way make_brim() did before
+// the brim areas were computed per object in parallel. Only outer brims of objects without supports are covered.
+static std::map<ObjectID, ExPolygons> outer_brim_areas_serial(const Print &print, const std::vector<std::pair<ObjectID, unsigned int>> &objPrintVec)
+{
+    const float scaled_flow_width = print.brim_flow().scaled_spacing();
+    const double flowWidth = scaled_flow_width * SCALING_FACTOR;
+
+    std::map<ObjectID, ExPolygons> brimAreaMap;
+    ExPolygons brim_area;
+    ExPolygons no_brim_area;
+    ExPolygons objectIslands;
+    for (const auto &objectWithExtruder : objPrintVec) {
+        const PrintObject *object = print.get_object(objectWithExtruder.first);
+        const float brim_offset = scale_(object->config().brim_object_gap.value);
+        const float brim_width = scale_(floor(object->config().brim_width.value / flowWidth / 2) * flowWidth * 2);
+        const float brim_width_mod = floor(brim_width / scaled_flow_width / 2) * scaled_flow_width * 2;
+
+        ExPolygons brim_area_object;
+        ExPolygons no_brim_area_object;
+        for (const auto &volumeGroup : object->firstLayerObjGroups())
+            for (const ExPolygon &ex_poly : volumeGroup.slices) {
+                ExPolygons innerExpoly = offset_ex(ex_poly.contour, brim_offset, jtRound, SCALED_RESOLUTION);
+                append(brim_area_object, diff_ex(offset_ex(innerExpoly, brim_width_mod, jtRound, SCALED_RESOLUTION), innerExpoly));
+                Polygons ex_poly_holes_reversed = ex_poly.holes;
+                polygons_reverse(ex_poly_holes_reversed);
+                append(no_brim_area_object, diff_ex(ex_poly_holes_reversed, offset_ex(ex_poly_holes_reversed, -scale_(5.))));
+            }
+        ExPolygons objectIsland = offset_ex(object->layers().front()->lslices, brim_offset, jtRound, SCALED_RESOLUTION);
+        append(no_brim_area_object, objectIsland);
+
+        for (const PrintInstance &instance : object->instances()) {
+            auto translated = [shift = instance.shift_without_plate_offset()](ExPolygons expolys) {
+                for (ExPolygon &expoly : expolys)
+                    expoly.translate(shift);
+                return expolys;
+            };
+            if (! brim_area_object.empty())
+                append(brimAreaMap[object->id()], diff_ex(translated(brim_area_object), brim_area));
+            append(no_brim_area, translated(no_brim_area_object));
+            append(objectIslands, translated(objectIsland));
+        }
+        if (auto it = brimAreaMap.find(object->id()); it != brimAreaMap.end())
+            expolygons_append(brim_area, it->second);
+    }
+
+    const Polygon bedPoly = Model::getBedPolygon();
+    const ExPolygons bedExPoly = diff_ex(offset(bedPoly, scale_(30.), jtRound, SCALED_RESOLUTION), { bedPoly });
+    if (! bedExPoly.empty())
+        no_brim_area.push_back(bedExPoly.front());
+    for (auto &[object_id, object_brim] : brimAreaMap)
+        object_brim = diff_ex(object_brim, no_brim_area);
+
+    // The brim has to touch an object island, another part of its own brim or the brim of another object.
+    for (const PrintObject *object : print.objects()) {
+        auto it = brimAreaMap.find(object->id());
+        if (it == brimAreaMap.end())
+            continue;
+        ExPolygons otherExPolys;
+        for (const auto &[other_id, other_brim] : brimAreaMap)
+            if (other_id != object->id())
+                expolygons_append(otherExPolys, other_brim);
+        ExPolygons tempArea = std::move(it->second);
+        it->second.clear();
+        for (size_t ia = 0; ia < tempArea.size(); ++ ia) {
+            ExPolygons otherExPoly;
+            for (size_t iao = 0; iao < tempArea.size(); ++ iao)
+                if (iao != ia)
+                    otherExPoly.push_back(tempArea[iao]);
+            ExPolygons offsetedTa = offset_ex(tempArea[ia], scaled_flow_width * 2, jtRound, SCALED_RESOLUTION);
+            if (! intersection_ex(offsetedTa, objectIslands).empty() ||
+                ! intersection_ex(offsetedTa, otherExPoly).empty() ||
+                ! intersection_ex(offsetedTa, otherExPolys).empty())
+                it->second.push_back(tempArea[ia]);
+        }
+    }
+    return brimAreaMap;
+}
+
+// Exposes make_try_cancel() to call make_brim() on a processed print.
+class BrimTestPrint : public Slic3r::Print
+{
+public:
+    using Slic3r::Print::make_try_cancel;
+};
+
+TEST_CASE("Brim is generated around each of many small objects", "[SkirtBrim]") {
+    DynamicPrintConfig config = Slic3r::DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({
+        { "brim_type",  "outer_only" },
+        { "brim_width", 3 }
+    });
+    std::vector<TriangleMesh> meshes(25, Slic3r::Test::mesh(TestMesh::cube_20x20x20, Vec3d::Zero(), 0.25));
+
+    BrimTestPrint print;
+    Slic3r::Model model;
+    Slic3r::Test::init_print(std::move(meshes), print, model, config);
+    // Pack the objects closer than twice the brim width, so that the brims of the neighbours clip each other.
+    const Vec3d origin = model.objects.front()->instances.front()->get_offset();
+    for (size_t i = 0; i < model.objects.size(); ++ i)
+        model.objects[i]->instances.front()->set_offset(origin + Vec3d(9. * double(i % 5), 9. * double(i / 5), 0.));
+    print.apply(model, config);
+    print.process();
+
+    std::vector<std::pair<ObjectID, unsigned int>> objPrintVec;
+    for (const PrintObject *object : print.objects()) {
+        REQUIRE(! object->has_support_material());
+        objPrintVec.emplace_back(object->id(), 1);
+    }
+    std::vector<unsigned int> printExtruders { 0 };
+    Polygons islands_area;
+    std::map<ObjectID, ExtrusionEntityCollection> brims, support_brims;
+    make_brim(print, print.make_try_cancel(), islands_area, brims, support_brims, objPrintVec, printExtruders);
+    REQUIRE(support_brims.empty());
+
+    const std::map<ObjectID, ExPolygons> brim_areas = outer_brim_areas_serial(print, objPrintVec);
+    ExPolygons brim_area;
+    for (const auto &[object_id, object_brim] : brim_areas)
+        append(brim_area, object_brim);
+    const Vec3d plate_offset = print.get_plate_origin();
+    for (ExPolygon &expoly : brim_area)
+        expoly.translate(Point(scaled(plate_offset.x()), scaled(plate_offset.y())));
+    // The islands covered by the brims match the reference areas.
+    const double eps = scaled<double>(0.01) * scaled<double>(0.01);
+    REQUIRE(std::abs(area(union_ex(islands_area)) - area(union_ex(brim_area))) < eps);
+    REQUIRE(area(diff_ex(islands_area, brim_area)) < eps);
+    REQUIRE(area(diff_ex(brim_area, islands_area)) < eps);
+
+    REQUIRE(brims.size() == print.objects().size());
+    REQUIRE(brim_areas.size() == print.objects().size());
+    double min_area = std::numeric_limits<double>::max();
+    double max_area = 0.;
+    for (const PrintObject *object : print.objects()) {
+        auto it = brims.find(object->id());
+        REQUIRE(it != brims.end());
+        REQUIRE(! it->second.empty());
+        // The brim surrounds the object.
+        BoundingBox bbox_brim = get_extents(it->second.polygons_covered_by_width());
+        BoundingBox bbox_object;
+        for (const PrintInstance &instance : object->instances())
+            for (const ExPolygon &expoly : object->layers().front()->lslices) {
+                Polygon contour = expoly.contour;
+                contour.translate(instance.shift_without_plate_offset());
+                bbox_object.merge(get_extents(contour));
+            }
+        REQUIRE(bbox_brim.contains(bbox_object.min));
+        REQUIRE(bbox_brim.contains(bbox_object.max));
+        // The brim is extruded inside the reference area of its object.
+        const ExPolygons &object_brim_area = brim_areas.at(object->id());
+        Polylines brim_lines;
+        for (const ExtrusionEntity *entity : it->second.flatten().entities)
+            append(brim_lines, entity->as_polylines());
+        REQUIRE(diff_pl(brim_lines, offset(object_brim_area, scaled<float>(0.01))).empty());
+        min_area = std::min(min_area, area(object_brim_area));
+        max_area = std::max(max_area, area(object_brim_area));
+    }
+    // The brims of the neighbours overlap before being clipped, thus the brims of some objects were trimmed.
+    REQUIRE(min_area < 0.999 * max_area);
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+
+#include <libslic3r/Polygon.hpp>
+#include <libslic3r/Arachne/WallToolPaths.hpp>
+
+using namespace Slic3r;
+
+static Arachne::WallToolPathsParams make_test_params(double nozzle_diameter)
+{
+    Arachne::WallToolPathsParams params;
+    params.min_bead_width                   = float(0.85 * nozzle_diameter);
+    params.min_feature_size                 = float(0.25 * nozzle_diameter);
+    params.wall_transition_length           = float(nozzle_diameter);
+    params.wall_transition_angle            = 10.f;
+    params.wall_transition_filter_deviation = float(0.25 * nozzle_diameter);
+    params.wall_distribution_count          = 1;
+    return params;
+}
+
+// Number of the extrusion lines and their total length per inset index.
+static std::vector<std::pair<size_t, int64_t>> toolpaths_statistics(const std::vector<Arachne::VariableWidthLines> &toolpaths)
+{
+    std::vector<std::pair<size_t, int64_t>> out;
+    for (const Arachne::VariableWidthLines &lines : toolpaths)
+        for (const Arachne::ExtrusionLine &line : lines) {
+            if (out.size() <= line.inset_idx)
+                out.resize(line.inset_idx + 1, { 0, 0 });
+            ++ out[line.inset_idx].first;
+            out[line.inset_idx].second += line.getLength();
+        }
+    return out;
+}
+
+TEST_CASE("Arachne walls of disjoint islands are generated independently", "[Arachne]") {
+    const Arachne::WallToolPathsParams params      = make_test_params(0.4);
+    const coord_t                      bead_width  = scaled<coord_t>(0.42);
+    const size_t                       inset_count = 3;
+
+    // 36 circles of 80 points, together above Arachne::parallel_islands_min_points.
+    Polygons islands;
+    for (int i = 0; i < 6; ++ i)
+        for (int j = 0; j < 6; ++ j) {
+            Polygon circle = make_circle_num_segments(scaled<double>(3.) + scaled<double>(0.1) * (i + j), 80);
+            circle.translate(scaled<coord_t>(10. * i), scaled<coord_t>(10. * j));
+            islands.emplace_back(std::move(circle));
+        }
+    REQUIRE(count_points(islands) >= Arachne::parallel_islands_min_points);
+
+    Arachne::WallToolPaths all_at_once(islands, bead_width, bead_width, inset_count, 0, 0.2, params);
+    std::vector<std::pair<size_t, int64_t>> stats = toolpaths_statistics(all_at_once.getToolPaths());
+
+    std::vector<std::pair<size_t, int64_t>> stats_expected;
+    for (const Polygon &island : islands) {
+        Polygons               outline { island };
+        Arachne::WallToolPaths one_island(outline, bead_width, bead_width, inset_count, 0, 0.2, params);
+        std::vector<std::pair<size_t, int64_t>> island_stats = toolpaths_statistics(one_island.getToolPaths());
+        if (stats_expected.size() < island_stats.size())
+            stats_expected.resize(island_stats.size(), { 0, 0 });
+        for (size_t inset_idx = 0; inset_idx < island_stats.size(); ++ inset_idx) {
+            stats_expected[inset_idx].first  += island_stats[inset_idx].first;
+            stats_expected[inset_idx].second += island_stats[inset_idx].second;
+        }
+    }
+
+    REQUIRE(stats.size() == inset_count);
+    REQUIRE(stats == stats_expected);
+}
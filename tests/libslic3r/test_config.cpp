@@ -2,12 +2,19 @@
 
 #include "libslic3r/PrintConfig.hpp"
 #include "libslic3r/LocalesUtils.hpp"
+#include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/SystemPresetIndex.hpp"
+#include "libslic3r/Utils.hpp"
 
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/string.hpp> 
 #include <cereal/types/vector.hpp> 
 #include <cereal/archives/binary.hpp>
 
+#include <chrono>
+
+#include <boost/filesystem.hpp>
+
 using namespace Slic3r;
 
 SCENARIO("Generic config validation performs as expected.", "[Config]") {
@@ -237,3 +244,219 @@ SCENARIO("DynamicPrintConfig serialization", "[Config]") {
         }
     }
 }
+
+SCENARIO("Interned option keys", "[Config]") {
+    GIVEN("Keys of the print config definition") {
+        THEN("Each defined key is interned to the id stored with its definition.") {
+            for (const auto &kvp : print_config_def.options) {
+                REQUIRE(kvp.second.id != ConfigOptionKeys::invalid_id);
+                REQUIRE(ConfigOptionKeys::find(kvp.first) == kvp.second.id);
+                REQUIRE(print_config_def.get(kvp.second.id) == &kvp.second);
+            }
+        }
+        THEN("Unknown keys are not interned by a lookup.") {
+            size_t num_keys = ConfigOptionKeys::size();
+            REQUIRE(ConfigOptionKeys::find("no_such_option_key") == ConfigOptionKeys::invalid_id);
+            REQUIRE(! print_config_def.has("no_such_option_key"));
+            REQUIRE(ConfigOptionKeys::size() == num_keys);
+        }
+        THEN("Interning a key twice returns the same id.") {
+            t_config_option_id id = ConfigOptionKeys::intern("test_interned_option_key");
+            REQUIRE(id != ConfigOptionKeys::invalid_id);
+            REQUIRE(ConfigOptionKeys::intern("test_interned_option_key") == id);
+            REQUIRE(ConfigOptionKeys::find("test_interned_option_key") == id);
+        }
+    }
+    GIVEN("A DynamicConfig without a definition") {
+        DynamicConfig config;
+        config.set_key_value("zzz_custom", new ConfigOptionInt(5));
+        config.set_key_value("aaa_custom", new ConfigOptionInt(6));
+        THEN("Options are accessible by their keys, keys are sorted alphabetically.") {
+            REQUIRE(config.opt_int("zzz_custom") == 5);
+            REQUIRE(config.opt_int("aaa_custom") == 6);
+            REQUIRE(config.keys() == t_config_option_keys{ "aaa_custom", "zzz_custom" });
+        }
+        WHEN("An option is erased") {
+            REQUIRE(config.erase("zzz_custom"));
+            THEN("Only the other option is left.") {
+                REQUIRE(config.size() == 1);
+                REQUIRE(config.option("zzz_custom") == nullptr);
+                REQUIRE(! config.erase("zzz_custom"));
+            }
+        }
+    }
+    GIVEN("Two full print configs differing in three options") {
+        DynamicPrintConfig config1 = DynamicPrintConfig::full_print_config();
+        DynamicPrintConfig config2 = config1;
+        // brim_width is defined after layer_height, thus the option ids are not in the alphabetical order.
+        config2.set_key_value("layer_height", new ConfigOptionFloat(0.33));
+        config2.set_key_value("brim_width", new ConfigOptionFloat(7.));
+        config2.set_key_value("sparse_infill_density", new ConfigOptionPercent(33));
+        THEN("Both DynamicConfig and ConfigBase diff report exactly the three options in the alphabetical order.") {
+            const t_config_option_keys expected { "brim_width", "layer_height", "sparse_infill_density" };
+            REQUIRE(config1 != config2);
+            REQUIRE(config1.diff(config2) == expected);
+            REQUIRE(static_cast<const ConfigBase&>(config1).diff(config2) == expected);
+            t_config_option_keys equal = config1.equal(config2);
+            REQUIRE(equal.size() + 3 == config1.size());
+            REQUIRE(std::is_sorted(equal.begin(), equal.end()));
+        }
+        WHEN("The differing options are moved to the first config") {
+            DynamicPrintConfig delta;
+            delta.set_key_value("layer_height", new ConfigOptionFloat(0.33));
+            delta.set_key_value("brim_width", new ConfigOptionFloat(7.));
+            delta.set_key_value("sparse_infill_density", new ConfigOptionPercent(33));
+            config1 += std::move(delta);
+            THEN("The configs are equal.") {
+                REQUIRE(config1 == config2);
+                REQUIRE(delta.empty());
+            }
+        }
+        THEN("A static config applied from the dynamic config reads the modified value.") {
+            PrintObjectConfig object_config;
+            object_config.apply(config2, true);
+            REQUIRE(object_config.layer_height.value == Approx(0.33));
+            REQUIRE(object_config.option("layer_height")->getFloat() == Approx(0.33));
+        }
+    }
+}
+
+// Run explicitly with "[Benchmark]" to measure the option lookup, apply and diff of full print configs.
+TEST_CASE("Lookup, apply and diff of full print configs", "[.][Benchmark]") {
+    const DynamicPrintConfig  full_config = DynamicPrintConfig::full_print_config();
+    const t_config_option_keys keys       = full_config.keys();
+    const size_t              num_loops   = 1000;
+
+    auto   start_lookup = std::chrono::steady_clock::now();
+    size_t num_found    = 0;
+    for (size_t i = 0; i < num_loops; ++ i)
+        for (const t_config_option_key &key : keys)
+            num_found += full_config.option(key) != nullptr;
+    auto   start_apply  = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_loops; ++ i) {
+        PrintConfig config;
+        config.apply(full_config, true);
+    }
+    auto   start_diff   = std::chrono::steady_clock::now();
+    DynamicPrintConfig modified = full_config;
+    modified.set_key_value("layer_height", new ConfigOptionFloat(0.33));
+    size_t num_diffs    = 0;
+    for (size_t i = 0; i < num_loops; ++ i)
+        num_diffs += full_config.diff(modified).size();
+    auto   end          = std::chrono::steady_clock::now();
+
+    auto ms = [](auto t1, auto t2) { return std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count(); };
+    WARN("Config of " << keys.size() << " options, " << num_loops << " loops: lookup " << ms(start_lookup, start_apply)
+         << " ms, apply " << ms(start_apply, start_diff) << " ms, diff " << ms(start_diff, end) << " ms");
+    REQUIRE(num_found == num_loops * keys.size());
+    REQUIRE(num_diffs == num_loops);
+}
+
+static const std::string system_profiles_dir() { return (boost::filesystem::path(TEST_DATA_DIR) / ".." / ".." / "resources" / "profiles").string(); }
+
+// Loads the system presets of the vendors into a fresh PresetBundle, using a preset index inside a temporary data directory.
+struct SystemPresetIndexFixture
+{
+    SystemPresetIndexFixture() : old_data_dir(data_dir()), tmp_data_dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(tmp_data_dir);
+        set_data_dir(tmp_data_dir.string());
+    }
+    ~SystemPresetIndexFixture()
+    {
+        set_data_dir(old_data_dir);
+        SystemPresetIndex::set_enabled(true);
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(tmp_data_dir, ec);
+    }
+
+    size_t load(PresetBundle &bundle, const std::vector<std::string> &vendors, bool use_index)
+    {
+        SystemPresetIndex::set_enabled(use_index);
+        size_t num_presets = 0;
+        for (const std::string &vendor : vendors)
+            num_presets += bundle.load_vendor_configs_from_json(system_profiles_dir(), vendor, PresetBundle::LoadSystem,
+                                                                ForwardCompatibilitySubstitutionRule::EnableSilent).second;
+        return num_presets;
+    }
+
+    std::string             old_data_dir;
+    boost::filesystem::path tmp_data_dir;
+};
+
+static void require_same_presets(const PresetCollection &lhs, const PresetCollection &rhs)
+{
+    REQUIRE(lhs.size() == rhs.size());
+    for (size_t i = 0; i < lhs.size(); ++ i) {
+        const Preset &l = lhs.preset(i);
+        const Preset &r = rhs.preset(i);
+        REQUIRE(l.name == r.name);
+        REQUIRE(l.file == r.file);
+        REQUIRE(l.is_system == r.is_system);
+        REQUIRE(l.alias == r.alias);
+        REQUIRE(l.renamed_from == r.renamed_from);
+        REQUIRE(l.setting_id == r.setting_id);
+        REQUIRE(l.filament_id == r.filament_id);
+        REQUIRE(l.config == r.config);
+    }
+}
+
+SCENARIO("System preset index", "[Config]") {
+    SystemPresetIndexFixture fixture;
+    GIVEN("System presets of a vendor loaded from JSON") {
+        PresetBundle from_json;
+        size_t       num_presets = fixture.load(from_json, { "Anker" }, false);
+        REQUIRE(num_presets > 0);
+        WHEN("The presets are loaded twice with the index enabled") {
+            PresetBundle cold;
+            PresetBundle warm;
+            REQUIRE(fixture.load(cold, { "Anker" }, true) == num_presets);
+            std::string index_path = SystemPresetIndex::path(system_profiles_dir(), "Anker", false);
+            REQUIRE(boost::filesystem::exists(index_path));
+            REQUIRE(fixture.load(warm, { "Anker" }, true) == num_presets);
+            THEN("The presets loaded from the index match the presets loaded from JSON.") {
+                require_same_presets(from_json.prints,    warm.prints);
+                require_same_presets(from_json.filaments, warm.filaments);
+                require_same_presets(from_json.printers,  warm.printers);
+            }
+            THEN("The index is rejected if the checksum of its sources changed.") {
+                SystemPresetIndex index;
+                REQUIRE(! index.load(index_path, 1));
+                REQUIRE(index.empty());
+            }
+        }
+    }
+}
+
+// Run explicitly with "[Benchmark]" to measure the startup cost of loading all system presets.
+TEST_CASE("Loading of all system presets from JSON and from the preset index", "[.][Benchmark]") {
+    SystemPresetIndexFixture fixture;
+    std::vector<std::string> vendors;
+    for (const auto &entry : boost::filesystem::directory_iterator(system_profiles_dir()))
+        if (is_json_file(entry.path().string()) && entry.path().stem() != "blacklist")
+            vendors.emplace_back(entry.path().stem().string());
+    std::sort(vendors.begin(), vendors.end());
+
+    // Each vendor is loaded into a bundle of its own, as PresetBundle::load_system_presets_from_json() does before merging them.
+    auto load_all = [&fixture, &vendors](bool use_index) {
+        size_t num_presets = 0;
+        for (const std::string &vendor : vendors) {
+            PresetBundle bundle;
+            num_presets += fixture.load(bundle, { vendor }, use_index);
+        }
+        return num_presets;
+    };
+    auto   start_json = std::chrono::steady_clock::now();
+    size_t num_json   = load_all(false);
+    auto   start_cold = std::chrono::steady_clock::now();
+    size_t num_cold   = load_all(true);
+    auto   start_warm = std::chrono::steady_clock::now();
+    size_t num_warm   = load_all(true);
+    auto   end        = std::chrono::steady_clock::now();
+
+    auto ms = [](auto t1, auto t2) { return std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count(); };
+    WARN(vendors.size() << " vendors, " << num_json << " presets: JSON " << ms(start_json, start_cold) << " ms, cold index "
+         << ms(start_cold, start_warm) << " ms, warm index " << ms(start_warm, end) << " ms");
+    REQUIRE(num_cold == num_json);
+    REQUIRE(num_warm == num_json);
+}
@@ -19,3 +19,24 @@ TEST_CASE("Hollow two overlapping spheres") {
     sphere1.WriteOBJFile("twospheres.obj");
 }
 
+
+TEST_CASE("Hollow disjoint spheres with a limited voxel budget") {
+    using namespace Slic3r;
+
+    TriangleMesh spheres;
+    for (int i = 0; i < 4; ++i) {
+        TriangleMesh sphere = make_sphere(10., 2 * PI / 20.);
+        sphere.translate(float(i) * 30.f, 0.f, 0.f);
+        spheres.merge(sphere);
+    }
+
+    sla::HollowingConfig cfg;
+    cfg.max_voxel_count = 100000;
+
+    sla::InteriorPtr interior = sla::generate_interior(spheres, cfg);
+    REQUIRE(interior);
+    REQUIRE(! sla::get_mesh(*interior).empty());
+
+    // Every sphere gets its own cavity.
+    REQUIRE(its_split(sla::get_mesh(*interior)).size() == 4);
+}
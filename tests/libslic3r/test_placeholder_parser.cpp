@@ -113,4 +113,37 @@ SCENARIO("Placeholder parser scripting", "[PlaceholderParser]") {
     SECTION("complex expression") { REQUIRE(boolean_expression("printer_notes=~/.*PRINTER_VENDOR_PRUSA3D.*/ and printer_notes=~/.*PRINTER_MODEL_MK2.*/ and nozzle_diameter[0]==0.6 and num_extruders>1")); }
     SECTION("complex expression2") { REQUIRE(boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.6 and num_extruders>1)")); }
     SECTION("complex expression3") { REQUIRE(! boolean_expression("printer_notes=~/.*PRINTER_VEwerfNDOR_PRUSA3D.*/ or printer_notes=~/.*PRINTertER_MODEL_MK2.*/ or (nozzle_diameter[0]==0.3 and num_extruders>1)")); }
+
+    // Templates are split into verbatim text and parsed macros once and cached, the results must not change.
+    SECTION("plain text is kept verbatim") { REQUIRE(parser.process("G28 ; home\n  G1 Z5 F5000 \n") == "G28 ; home\n  G1 Z5 F5000 \n"); }
+    SECTION("empty template") { REQUIRE(parser.process("").empty()); }
+    SECTION("text around macros") { REQUIRE(parser.process("M104 S{temperature[foo]} ; T[foo]\nM109 S[temperature_[foo]]\n") == "M104 S357 ; T0\nM109 S357\n"); }
+    SECTION("non-ASCII text") { REQUIRE(parser.process("; \xc5\xa1 {bar} \xc5\xa1") == "; \xc5\xa1 2 \xc5\xa1"); }
+    SECTION("string literal with braces") { REQUIRE(parser.process("a{\"{x}\"}b") == "a{x}b"); }
+    SECTION("if block") { REQUIRE(parser.process("A\n{if foo == 0}B{bar}\n{elsif bar == 2}C\n{else}D\n{endif}E") == "A\nB2\nE"); }
+    SECTION("nested if blocks") { REQUIRE(parser.process("{if bar == 2}x{if foo == 1}y{else}z{endif}w{endif}!") == "xzw!"); }
+    SECTION("regex inside a template") { REQUIRE(parser.process("{if printer_notes =~ /.*MK2.*/}mk2{endif}") == "mk2"); }
+    SECTION("repeated processing of a cached template") {
+        for (int i = 0; i < 3; ++ i)
+            REQUIRE(parser.process("T{bar} [foo]\n") == "T2 0\n");
+    }
+    SECTION("error position is relative to the whole template") {
+        std::string error;
+        try {
+            parser.process("G1\nG2 {foo + }\nG3");
+        } catch (const std::exception &ex) {
+            error = ex.what();
+        }
+        REQUIRE(error.find("Parsing error at line 2") != std::string::npos);
+        REQUIRE(error.find("G2 {foo + }") != std::string::npos);
+    }
+    SECTION("stray endif is an error") { REQUIRE_THROWS(parser.process("a{endif}b")); }
+    SECTION("leading white space is skipped as by the grammar") {
+        // A regular expression makes the whole template go through the grammar, the if block itself emits nothing.
+        auto interpreted = [&parser](const std::string &templ) { return parser.process(templ + "{if printer_notes =~ /x/}{endif}"); };
+        for (const std::string templ : { "  G28\n", "\n\t G1 {bar}\n", " \r\n[foo] ", "   ", " \n\t\n", "\n\xc5\xa1 x" })
+            REQUIRE(parser.process(templ) == interpreted(templ));
+        REQUIRE(parser.process("  G28\n") == "G28\n");
+        REQUIRE(parser.process(" \n\t\n").empty());
+    }
 }
@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+
+#include "libslic3r/Trace.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+using namespace Slic3r;
+
+TEST_CASE("Spans are recorded only while tracing is enabled", "[Trace]") {
+    Trace::clear();
+    Trace::set_enabled(false);
+    {
+        SLIC3R_TRACE_SPAN("disabled");
+        Trace::counter("disabled_counter", 1);
+    }
+    REQUIRE(Trace::num_events() == 0);
+
+    Trace::set_enabled(true);
+    {
+        SLIC3R_TRACE_SPAN("outer", "test", "detail with \"quotes\"\n");
+        SLIC3R_TRACE_SPAN("inner", "test");
+        Trace::counter("layers", 42);
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++ i)
+        threads.emplace_back([]() { SLIC3R_TRACE_SPAN("worker", "test"); });
+    for (std::thread &thread : threads)
+        thread.join();
+    Trace::set_enabled(false);
+    REQUIRE(Trace::num_events() == 3 + 4);
+
+    SECTION("The Chrome trace is valid JSON with a thread id per thread") {
+        nlohmann::json json = nlohmann::json::parse(Trace::chrome_trace_json());
+        std::vector<int64_t> worker_tids;
+        int64_t outer_tid = -1, inner_tid = -1;
+        for (const nlohmann::json &event : json["traceEvents"]) {
+            const std::string name = event["name"];
+            if (name == "worker")
+                worker_tids.emplace_back(event["tid"].get<int64_t>());
+            else if (name == "outer") {
+                outer_tid = event["tid"];
+                REQUIRE(event["ph"] == "X");
+                REQUIRE(event["args"]["detail"] == "detail with \"quotes\"\n");
+            } else if (name == "inner") {
+                inner_tid = event["tid"];
+                REQUIRE(event["dur"].get<int64_t>() >= 0);
+            } else if (name == "layers") {
+                REQUIRE(event["ph"] == "C");
+                REQUIRE(event["args"]["value"] == 42);
+            }
+        }
+        REQUIRE(outer_tid == inner_tid);
+        REQUIRE(worker_tids.size() == 4);
+        std::sort(worker_tids.begin(), worker_tids.end());
+        REQUIRE(std::unique(worker_tids.begin(), worker_tids.end()) == worker_tids.end());
+        REQUIRE(std::find(worker_tids.begin(), worker_tids.end(), outer_tid) == worker_tids.end());
+    }
+    SECTION("Span durations are summed by name") {
+        std::map<std::string, int64_t> durations = Trace::total_durations("test");
+        REQUIRE(durations.size() == 3);
+        REQUIRE(durations.count("worker") == 1);
+        REQUIRE(durations["outer"] >= durations["inner"]);
+        REQUIRE(Trace::total_durations("counter").empty());
+    }
+    Trace::clear();
+    REQUIRE(Trace::num_events() == 0);
+}
@@ -1,6 +1,9 @@
 #include <catch_main.hpp>
 
 #include "slic3r/Utils/Http.hpp"
+#include "slic3r/Utils/UndoRedoChunkStore.hpp"
+
+#include <random>
 
 TEST_CASE("Check SSL certificates paths", "[Http][NotWorking]") {
     
@@ -58,3 +61,57 @@ TEST_CASE("Http basic authentication", "[Http][NotWorking]") {
     REQUIRE(status == 200);
 }
 
+
+// Scripted painting session: a large painted mesh modified by small strokes, with an unchanged config stored with every snapshot.
+// Measures the memory occupied by the snapshot data.
+static size_t undo_redo_painting_session(bool compression)
+{
+    using namespace Slic3r::UndoRedo;
+    std::mt19937 rng(42);
+    // Serialized TriangleSelector stores a few states per triangle, thus the data is compressible.
+    std::string painting(256 * 1024, 0);
+    for (char &c : painting)
+        c = char(rng() % 4);
+    const std::string config(3000, 'c');
+
+    ChunkStore store;
+    store.set_compression(compression);
+    std::vector<std::string>        states;
+    std::vector<ChunkStore::Chunks> snapshots;
+    size_t                          raw_size = 0;
+    const size_t                    num_strokes = 64;
+    for (size_t time = 0; time < num_strokes; ++ time) {
+        // A stroke subdivides some triangles, which inserts data in the middle of the serialized stream.
+        std::string stroke(100, 0);
+        for (char &c : stroke)
+            c = char(rng() % 4);
+        painting.insert(rng() % painting.size(), stroke);
+        states.emplace_back(painting);
+        snapshots.emplace_back(store.store(painting, time));
+        snapshots.emplace_back(store.store(config, time));
+        raw_size += painting.size() + config.size();
+        if (time > 4)
+            store.compress_cold(time - 4);
+    }
+
+    // Each stroke only adds a few chunks.
+    REQUIRE(store.memsize() < raw_size / 4);
+    for (size_t i = 0; i < states.size(); ++ i) {
+        REQUIRE(store.load(snapshots[2 * i]) == states[i]);
+        REQUIRE(store.matches(snapshots[2 * i], states[i]));
+        REQUIRE(store.load(snapshots[2 * i + 1]) == config);
+    }
+    REQUIRE(! store.matches(snapshots.front(), states.back()));
+
+    size_t memsize = store.memsize();
+    for (const ChunkStore::Chunks &chunks : snapshots)
+        store.release(chunks);
+    REQUIRE(store.empty());
+    return memsize;
+}
+
+TEST_CASE("Undo / Redo stack data deduplication", "[UndoRedo]") {
+    size_t memsize_uncompressed = undo_redo_painting_session(false);
+    size_t memsize_compressed   = undo_redo_painting_session(true);
+    REQUIRE(memsize_compressed < memsize_uncompressed);
+}